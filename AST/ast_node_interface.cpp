@@ -1,5 +1,66 @@
 #include "ast_node_interface.hpp"
 #include "statement.hpp"
+#include <iostream>
+#include <mutex>
+
+// Destino y ubicación actuales de cada hilo. El mutex es común porque los
+// hilos que no redirigen sus errores comparten el destino por omisión
+static thread_local SemanticErrorSink* error_sink = nullptr;
+static thread_local SourceLocation current_location;
+static std::mutex error_sink_mutex;
+
+SemanticErrorMessage::~SemanticErrorMessage() noexcept{
+    std::lock_guard<std::mutex> lock{error_sink_mutex};
+    semantic_error_sink().report(current_location, this->text.str());
+}
+
+StreamErrorSink::StreamErrorSink(std::ostream& out) noexcept
+    : out{&out}{}
+
+void StreamErrorSink::report(SourceLocation, const std::string& message) noexcept{
+    *this->out << message;
+}
+
+void BufferedErrorSink::report(SourceLocation location, const std::string& message) noexcept{
+    this->messages.push_back(Message{location, message});
+}
+
+void BufferedErrorSink::replay(SemanticErrorSink& sink) noexcept{
+    std::lock_guard<std::mutex> lock{error_sink_mutex};
+    for (const auto& message : this->messages)
+    {
+        sink.report(message.location, message.text);
+    }
+    this->messages.clear();
+}
+
+SemanticErrorSink& semantic_error_sink() noexcept{
+    static StreamErrorSink standard_error{std::cerr};
+    return (error_sink != nullptr) ? *error_sink : standard_error;
+}
+
+SemanticErrorRedirect::SemanticErrorRedirect(std::ostream& out) noexcept
+    : stream_sink{out}, previous{error_sink}{
+    error_sink = &this->stream_sink;
+}
+
+SemanticErrorRedirect::SemanticErrorRedirect(SemanticErrorSink& sink) noexcept
+    : stream_sink{std::cerr}, previous{error_sink}{
+    error_sink = &sink;
+}
+
+SemanticErrorRedirect::~SemanticErrorRedirect() noexcept{
+    error_sink = this->previous;
+}
+
+SourceLocationScope::SourceLocationScope(SourceLocation location) noexcept
+    : previous{current_location}{
+    current_location = location;
+}
+
+SourceLocationScope::~SourceLocationScope() noexcept{
+    current_location = this->previous;
+}
 
 void destroy_program_body(ProgramBody& body) noexcept{
     while (!body.empty())
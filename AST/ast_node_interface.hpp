@@ -4,10 +4,12 @@
 #include <string_view>
 #include <forward_list>
 #include <ostream>
+#include <sstream>
+#include <vector>
 
 
 class Declaration;
-class Expression;
+class MusicExpression;
 class Statement;
 class SymbolTable;
 
@@ -33,4 +35,102 @@ public:
 using ProgramBody = std::forward_list<Statement*>;
 
 // Función auxiliar para destruir todos los elementos en un cuerpo
-void destroy_program_body(ProgramBody& body) noexcept; 
\ No newline at end of file
+void destroy_program_body(ProgramBody& body) noexcept; 
+
+// Ubicación de una sentencia o declaración en el archivo fuente (línea y
+// columna desde 1; 0 si no se conoce)
+struct SourceLocation{
+    int line{0};
+    int column{0};
+};
+
+// Destino de los errores semánticos: recibe cada mensaje completo junto con
+// la ubicación de la sentencia que se estaba analizando
+class SemanticErrorSink{
+public:
+    virtual ~SemanticErrorSink() noexcept = default;
+    virtual void report(SourceLocation location, const std::string& message) noexcept = 0;
+};
+
+// Mensaje de error del análisis semántico. Se arma con << y, al destruirse,
+// se entrega completo al destino de errores del hilo actual, de modo que
+// los mensajes de hilos distintos no se mezclan.
+class SemanticErrorMessage{
+public:
+    SemanticErrorMessage() noexcept = default;
+    ~SemanticErrorMessage() noexcept;
+
+    template <typename T>
+    SemanticErrorMessage& operator<<(const T& value) noexcept{
+        text << value;
+        return *this;
+    }
+
+private:
+    std::ostringstream text;
+};
+
+// Destino que escribe cada mensaje en un flujo, sin la ubicación
+class StreamErrorSink final : public SemanticErrorSink{
+public:
+    explicit StreamErrorSink(std::ostream& out) noexcept;
+    void report(SourceLocation location, const std::string& message) noexcept override;
+
+private:
+    std::ostream* out;
+};
+
+// Destino que guarda cada mensaje con su ubicación para entregarlos después
+// a otro destino. Permite que varios hilos analicen por separado y que sus
+// errores se informen en un orden que no depende de cuál termina primero.
+class BufferedErrorSink final : public SemanticErrorSink{
+public:
+    void report(SourceLocation location, const std::string& message) noexcept override;
+
+    // Entrega los mensajes guardados a sink, en el orden en que llegaron, y
+    // los descarta
+    void replay(SemanticErrorSink& sink) noexcept;
+
+private:
+    struct Message{
+        SourceLocation location;
+        std::string text;
+    };
+
+    std::vector<Message> messages;
+};
+
+// Destino de los errores semánticos del hilo actual (por omisión, un
+// StreamErrorSink sobre std::cerr)
+SemanticErrorSink& semantic_error_sink() noexcept;
+
+// Redirige los errores semánticos del hilo actual mientras el objeto exista,
+// a un flujo (sin la ubicación) o a otro destino. Permite que un servidor
+// devuelva los errores de cada petición a su cliente.
+class SemanticErrorRedirect{
+public:
+    explicit SemanticErrorRedirect(std::ostream& out) noexcept;
+    explicit SemanticErrorRedirect(SemanticErrorSink& sink) noexcept;
+    ~SemanticErrorRedirect() noexcept;
+
+    SemanticErrorRedirect(const SemanticErrorRedirect&) = delete;
+    SemanticErrorRedirect& operator=(const SemanticErrorRedirect&) = delete;
+
+private:
+    StreamErrorSink stream_sink;
+    SemanticErrorSink* previous;
+};
+
+// Ubicación que se adjunta a los errores semánticos del hilo actual mientras
+// el objeto exista: la de la sentencia de nivel superior que se analiza
+class SourceLocationScope{
+public:
+    explicit SourceLocationScope(SourceLocation location) noexcept;
+    ~SourceLocationScope() noexcept;
+
+    SourceLocationScope(const SourceLocationScope&) = delete;
+    SourceLocationScope& operator=(const SourceLocationScope&) = delete;
+
+private:
+    SourceLocation previous;
+};
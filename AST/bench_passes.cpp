@@ -0,0 +1,159 @@
+/*
+    Compilador Musical: Pases fusionados con el gestor de pases
+
+    Construye dos veces la misma partitura grande (la melodía de
+    test/valid_test_01.mus repetida) y ejecuta sobre cada una la validación,
+    la escritura en texto y la transposición: en una, con los métodos de
+    MusicProgram, un recorrido de las sentencias por pase; en la otra, con el
+    gestor de pases, que los fusiona en un solo recorrido. Ambas deben
+    producir el mismo texto y el mismo ABC.
+
+    Después mide la emisión de cada formato por separado y la de todos
+    juntos en un solo recorrido (EmissionPass), y verifica que el ABC y el
+    texto de EmissionPass sean los de to_abc y to_string.
+
+    Uso: ./bench_passes [cantidad_de_notas]
+*/
+
+#include "declaration.hpp"
+#include "note_pool.hpp"
+#include "output_sink.hpp"
+#include "program_passes.hpp"
+#include "statement.hpp"
+#include "transpose.hpp"
+#include "../Semantic_Analysis/symbol_table.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+// Mide el tiempo en milisegundos de una función
+template <typename Function>
+double measure_ms(Function&& function) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static MusicProgram* build_program(long note_count) {
+    struct { const char* name; int octave; DurationType duration; } melody[] = {
+        {"Sol", 4, DurationType::CORCHEA}, {"La", 4, DurationType::CORCHEA},
+        {"Si", 4, DurationType::CORCHEA}, {"Do#", 5, DurationType::CORCHEA},
+        {"Re", 5, DurationType::CORCHEA}, {"Mi", 5, DurationType::CORCHEA},
+        {"Fa#", 4, DurationType::NEGRA}, {"Sol#", 4, DurationType::CORCHEA},
+        {"Si", 4, DurationType::NEGRA}, {"Do#", 5, DurationType::SEMICORCHEA},
+    };
+    const long melody_size = sizeof(melody) / sizeof(melody[0]);
+
+    MusicProgram* program = new MusicProgram();
+    program->set_note_pool(std::make_shared<NotePool>());
+    program->add_declaration(new TempoDeclaration(60));
+    program->add_declaration(new TimeSignatureDeclaration(7, 8));
+    program->add_declaration(new KeyDeclaration("Si", KeyMode::MAYOR));
+    for (long i = 0; i < note_count; ++i) {
+        const auto& note = melody[i % melody_size];
+        program->add_statement(program->get_note_pool()->make_note(note.name, note.octave, note.duration));
+    }
+    return program;
+}
+
+static std::string program_abc(const MusicProgram& program) {
+    std::ostringstream abc;
+    double beat = 0.0;
+    program.to_abc(abc, beat);
+    return abc.str();
+}
+
+int main(int argc, char* argv[]) {
+    long note_count = (argc > 1) ? std::atol(argv[1]) : 1000000;
+    const int semitones = 2;
+    std::cout << "Notas: " << note_count << "\n";
+
+    // Un recorrido por pase
+    MusicProgram* separate = build_program(note_count);
+    SymbolTable separate_table;
+    bool separate_valid = false;
+    std::string separate_text;
+    double resolve_ms = measure_ms([&] { separate_valid = separate->resolve_names(separate_table); });
+    double text_ms = measure_ms([&] { separate_text = separate->to_string(); });
+    double transpose_ms = measure_ms([&] {
+        separate_valid = separate_valid && transpose_program(*separate, semitones);
+    });
+    double separate_ms = resolve_ms + text_ms + transpose_ms;
+    std::cout << "por separado: resolve_names " << resolve_ms << " ms, to_string " << text_ms
+              << " ms, transponer " << transpose_ms << " ms, total " << separate_ms << " ms\n";
+
+    // Los mismos pases en un solo recorrido
+    MusicProgram* fused = build_program(note_count);
+    SymbolTable fused_table;
+    std::string fused_text;
+    ValidationPass validation{fused_table};
+    TextPass text{fused_text};
+    TranspositionPass transposition{semitones};
+    PassManager passes;
+    passes.add(&validation);
+    passes.add(&text);
+    passes.add(&transposition);
+    bool fused_valid = false;
+    double fused_ms = measure_ms([&] { fused_valid = passes.run(*fused); });
+    std::cout << "gestor de pases: " << passes.traversal_count() << " recorrido(s), total " << fused_ms
+              << " ms (x" << (fused_ms > 0.0 ? separate_ms / fused_ms : 0.0) << ")\n";
+    writePassTimings(std::cout, passes.timings());
+
+    bool same = separate_valid && fused_valid && separate_text == fused_text &&
+                program_abc(*separate) == program_abc(*fused);
+    std::cout << (same ? "Ambas ejecuciones producen la misma salida.\n"
+                       : "Error: las ejecuciones producen salidas distintas.\n");
+
+    // Cada formato por separado y todos en un solo recorrido
+    const char* formats[] = {"programa.abc", "programa.txt", "programa.mid", "programa.json"};
+    double formats_ms = 0.0;
+    for (const char* format : formats) {
+        OutputSink* sink = make_output_sink(format);
+        EmissionPass emission;
+        emission.add(sink);
+        double ms = measure_ms([&] {
+            emission.begin(*fused);
+            for (const auto& stmt : fused->get_statements()) {
+                emission.visit(*stmt);
+            }
+            emission.finish(*fused);
+        });
+        std::cout << "emitir " << format << ": " << ms << " ms\n";
+        formats_ms += ms;
+        delete sink;
+    }
+
+    std::vector<OutputSink*> sinks;
+    EmissionPass emission;
+    for (const char* format : formats) {
+        sinks.push_back(make_output_sink(format));
+        emission.add(sinks.back());
+    }
+    PassManager emit;
+    emit.add(&emission);
+    double emission_ms = measure_ms([&] { emit.run(*fused); });
+    std::cout << "emitir todos en un recorrido: " << emission_ms << " ms, por separado "
+              << formats_ms << " ms (x" << (emission_ms > 0.0 ? formats_ms / emission_ms : 0.0) << ")\n";
+
+    std::ostringstream sink_abc;
+    std::ostringstream sink_text;
+    sinks[0]->write(sink_abc);
+    sinks[1]->write(sink_text);
+    bool same_sinks = sink_abc.str() == program_abc(*fused) && sink_text.str() == fused->to_string();
+    std::cout << (same_sinks ? "Las salidas de EmissionPass coinciden con to_abc y to_string.\n"
+                             : "Error: las salidas de EmissionPass no coinciden con to_abc y to_string.\n");
+    for (const auto& sink : sinks) {
+        delete sink;
+    }
+    same = same && same_sinks;
+
+    separate->destroy();
+    delete separate;
+    fused->destroy();
+    delete fused;
+    return same ? 0 : 1;
+}
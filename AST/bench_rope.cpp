@@ -0,0 +1,224 @@
+/*
+    Compilador Musical: Edición de una partitura grande con ScoreRope
+
+    Construye una partitura grande repitiendo la melodía de
+    test/valid_test_01.mus, la pasa a una EditableScore y verifica que escriba
+    el mismo ABC que el MusicProgram. Luego mide ediciones en posiciones al
+    azar (reemplazos de una nota por otra de la misma duración, e inserciones
+    y borrados) contra las mismas ediciones sobre un std::vector, y la
+    reescritura después de los reemplazos, que solo genera los bloques
+    editados. El resultado debe coincidir con el del programa reconstruido.
+
+    Uso: ./bench_rope [cantidad_de_notas] [cantidad_de_ediciones]
+*/
+
+#include "declaration.hpp"
+#include "expression.hpp"
+#include "statement.hpp"
+#include "score_rope.hpp"
+#include "voice.hpp"
+#include "../Semantic_Analysis/symbol_table.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Mide el tiempo en milisegundos de una función
+template <typename Function>
+double measure_ms(Function&& function) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static void add_header(MusicProgram& program) {
+    program.add_declaration(new TempoDeclaration(60));
+    program.add_declaration(new TimeSignatureDeclaration(7, 8));
+    program.add_declaration(new KeyDeclaration("Si", KeyMode::MAYOR));
+}
+
+static std::string program_abc(MusicProgram& program) {
+    std::ostringstream abc;
+    double beat = 0.0;
+    program.to_abc(abc, beat);
+    return abc.str();
+}
+
+static std::string score_abc(EditableScore& score) {
+    std::ostringstream abc;
+    score.to_abc(abc);
+    return abc.str();
+}
+
+// Reconstruye el programa, lo valida, lo escribe y vuelve a armar la partitura
+static bool round_trip(EditableScore*& score, std::string& abc) {
+    MusicProgram* program = score->to_program();
+    delete score;
+    SymbolTable table;
+    bool valid = program->resolve_names(table);
+    abc = program_abc(*program);
+    score = EditableScore::from_program(*program);
+    program->destroy();
+    delete program;
+    return valid && score != nullptr;
+}
+
+int main(int argc, char* argv[]) {
+    long note_count = (argc > 1) ? std::atol(argv[1]) : 1000000;
+    long edit_count = (argc > 2) ? std::atol(argv[2]) : 10000;
+
+    struct { const char* name; int octave; DurationType duration; } melody[] = {
+        {"Sol", 4, DurationType::CORCHEA}, {"La", 4, DurationType::CORCHEA},
+        {"Si", 4, DurationType::CORCHEA}, {"Do#", 5, DurationType::CORCHEA},
+        {"Re", 5, DurationType::CORCHEA}, {"Mi", 5, DurationType::CORCHEA},
+        {"Fa#", 4, DurationType::NEGRA}, {"Sol#", 4, DurationType::CORCHEA},
+        {"Si", 4, DurationType::NEGRA}, {"Do#", 5, DurationType::SEMICORCHEA},
+    };
+    const long melody_size = sizeof(melody) / sizeof(melody[0]);
+
+    MusicProgram* program = new MusicProgram();
+    add_header(*program);
+    for (long i = 0; i < note_count; ++i) {
+        const auto& note = melody[i % melody_size];
+        program->add_statement(new NoteStatement(
+            new NoteExpression(note.name, note.octave),
+            new DurationExpression(note.duration)
+        ));
+    }
+    std::cout << "Notas: " << note_count << ", ediciones: " << edit_count << "\n";
+
+    SymbolTable table;
+    bool same = program->resolve_names(table);
+    std::string expected = program_abc(*program);
+
+    // Conversión y primera escritura: se generan todos los bloques
+    EditableScore* score = nullptr;
+    double convert_ms = measure_ms([&] { score = EditableScore::from_program(*program); });
+    program->destroy();
+    delete program;
+    if (score == nullptr) {
+        std::cout << "Error: el programa no se pudo convertir.\n";
+        return 1;
+    }
+    ScoreRope& rope = score->voice(0);
+
+    std::string abc;
+    double write_ms = measure_ms([&] { abc = score_abc(*score); });
+    same = same && abc == expected;
+    std::cout << "from_program: " << convert_ms << " ms, " << rope.measure_count() << " compases\n";
+    std::cout << "to_abc inicial: " << write_ms << " ms, " << rope.regenerated_blocks()
+              << " bloques generados" << (abc == expected ? "" : " (Error: difiere del programa)") << "\n";
+
+    // Las notas nuevas se validan con las mismas declaraciones
+    SymbolTable edit_table;
+    MusicProgram header;
+    add_header(header);
+    header.resolve_names(edit_table);
+
+    // Reemplazos de la misma duración: las barras no se mueven
+    std::mt19937 random{42};
+    std::uniform_int_distribution<long> position{0, note_count - 1};
+    double replace_ms = measure_ms([&] {
+        for (long i = 0; i < edit_count; ++i) {
+            long index = position(random);
+            NoteStatement* note = new NoteStatement(
+                new NoteExpression("Mi", 4),
+                new DurationExpression(melody[index % melody_size].duration)
+            );
+            note->resolve_names(edit_table);
+            Statement* previous = rope.replace(index, note);
+            previous->destroy();
+            delete previous;
+        }
+    });
+    double rewrite_ms = measure_ms([&] { abc = score_abc(*score); });
+    std::cout << "replace: " << replace_ms * 1000.0 / edit_count << " us por edición\n";
+    std::cout << "to_abc después de los reemplazos: " << rewrite_ms << " ms, "
+              << rope.regenerated_blocks() << " bloques generados\n";
+
+    std::string rebuilt;
+    bool rebuilt_valid = round_trip(score, rebuilt);
+    same = same && rebuilt_valid && abc == rebuilt;
+    std::cout << (rebuilt_valid && abc == rebuilt ? "La partitura editada coincide con el programa reconstruido.\n"
+                                                  : "Error: la partitura editada difiere del programa reconstruido.\n");
+
+    // Inserción y borrado en la misma posición, contra un std::vector
+    ScoreRope& edited = score->voice(0);
+    std::vector<Statement*> statements(note_count, nullptr);
+    double rope_ms = measure_ms([&] {
+        for (long i = 0; i < edit_count; ++i) {
+            long index = position(random);
+            edited.insert(index, edited.erase(index));
+        }
+    });
+    double vector_ms = measure_ms([&] {
+        for (long i = 0; i < edit_count; ++i) {
+            long index = position(random);
+            Statement* statement = statements[index];
+            statements.erase(statements.begin() + index);
+            statements.insert(statements.begin() + index, statement);
+        }
+    });
+    std::cout << "borrar e insertar: cuerda " << rope_ms * 1000.0 / edit_count << " us, vector "
+              << vector_ms * 1000.0 / edit_count << " us por edición\n";
+
+    // Posición de una barra: el compás del medio
+    long middle = (edited.measure_count() + 1) / 2;
+    std::size_t start = 0;
+    double query_ms = measure_ms([&] {
+        for (long i = 0; i < edit_count; ++i) {
+            start = edited.measure_start(middle);
+        }
+    });
+    long barline = (middle - 1) * 14;
+    bool query_ok = edited.tick_of(start) <= barline && edited.tick_of(start + 1) > barline;
+    same = same && query_ok;
+    std::cout << "measure_start: " << query_ms * 1000.0 / edit_count << " us por consulta"
+              << (query_ok ? "" : " (Error: posición incorrecta)") << "\n";
+
+    // Una corchea insertada al comienzo mueve todas las barras posteriores
+    NoteStatement* note = new NoteStatement(new NoteExpression("Mi", 4), new DurationExpression(DurationType::CORCHEA));
+    note->resolve_names(edit_table);
+    edited.insert(0, note);
+    write_ms = measure_ms([&] { abc = score_abc(*score); });
+    std::cout << "to_abc después de insertar al comienzo: " << write_ms << " ms, "
+              << edited.regenerated_blocks() << " bloques generados\n";
+    rebuilt_valid = round_trip(score, rebuilt);
+    same = same && rebuilt_valid && abc == rebuilt;
+
+    // Un programa con voces y motivos también se escribe igual
+    program = new MusicProgram();
+    add_header(*program);
+    ProgramBody phrase;
+    phrase.push_front(new NoteStatement(new NoteExpression("La", 4), new DurationExpression(DurationType::CORCHEA)));
+    phrase.push_front(new NoteStatement(new NoteExpression("Sol", 4), new DurationExpression(DurationType::NEGRA)));
+    program->add_statement(new MotifStatement("Frase", phrase));
+    for (const char* name : {"Alta", "Baja"}) {
+        MusicVoice* voice = new MusicVoice(name);
+        for (long i = 0; i < 28; ++i) {
+            voice->add_statement(new NoteStatement(new NoteExpression(melody[i % 6].name, melody[i % 6].octave),
+                                                   new DurationExpression(DurationType::CORCHEA)));
+        }
+        voice->add_statement(new MotifReferenceStatement("Frase"));
+        voice->add_statement(new NoteStatement(new NoteExpression("Si", 4), new DurationExpression(DurationType::NEGRA)));
+        program->add_voice(voice);
+    }
+    SymbolTable voices_table;
+    bool voices_valid = program->resolve_names(voices_table);
+    expected = program_abc(*program);
+    EditableScore* voices = EditableScore::from_program(*program);
+    program->destroy();
+    delete program;
+    bool voices_same = voices_valid && voices != nullptr && score_abc(*voices) == expected;
+    same = same && voices_same;
+    std::cout << (voices_same ? "Las voces se escriben igual que en el programa.\n"
+                              : "Error: las voces se escriben distinto que en el programa.\n");
+
+    delete voices;
+    delete score;
+    return same ? 0 : 1;
+}
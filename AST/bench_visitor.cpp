@@ -0,0 +1,134 @@
+/*
+    Compilador Musical: Comparación de despacho virtual contra visitación
+
+    Construye una partitura grande repitiendo la melodía de
+    test/valid_test_01.mus y mide los pases to_string, resolve_names y to_abc
+    sobre el AST con despacho virtual (MusicProgram) y sobre la representación
+    plana con std::variant (FlatProgram). Ambos recorridos deben producir la
+    misma salida. También mide la transposición sobre alturas MIDI (ida y
+    vuelta), que debe dejar el programa igual, y los mismos pases con las
+    notas compartidas de un NotePool.
+
+    Uso: ./bench_visitor [cantidad_de_notas]
+*/
+
+#include "declaration.hpp"
+#include "expression.hpp"
+#include "statement.hpp"
+#include "flat_program.hpp"
+#include "note_pool.hpp"
+#include "transpose.hpp"
+#include "../Semantic_Analysis/symbol_table.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Mide el tiempo en milisegundos de una función
+template <typename Function>
+double measure_ms(Function&& function) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void report(const std::string& pass, double virtual_ms, double visitor_ms) {
+    std::cout << pass << ": virtual " << virtual_ms << " ms, visitante " << visitor_ms
+              << " ms (x" << (visitor_ms > 0.0 ? virtual_ms / visitor_ms : 0.0) << ")\n";
+}
+
+int main(int argc, char* argv[]) {
+    long note_count = (argc > 1) ? std::atol(argv[1]) : 1000000;
+
+    struct { const char* name; int octave; DurationType duration; } melody[] = {
+        {"Sol", 4, DurationType::CORCHEA}, {"La", 4, DurationType::CORCHEA},
+        {"Si", 4, DurationType::CORCHEA}, {"Do#", 5, DurationType::CORCHEA},
+        {"Re", 5, DurationType::CORCHEA}, {"Mi", 5, DurationType::CORCHEA},
+        {"Fa#", 4, DurationType::NEGRA}, {"Sol#", 4, DurationType::CORCHEA},
+        {"Si", 4, DurationType::NEGRA}, {"Do#", 5, DurationType::SEMICORCHEA},
+    };
+    const long melody_size = sizeof(melody) / sizeof(melody[0]);
+
+    MusicProgram* program = new MusicProgram();
+    program->add_declaration(new TempoDeclaration(60));
+    program->add_declaration(new TimeSignatureDeclaration(7, 8));
+    program->add_declaration(new KeyDeclaration("Si", KeyMode::MAYOR));
+    for (long i = 0; i < note_count; ++i) {
+        const auto& note = melody[i % melody_size];
+        program->add_statement(new NoteStatement(
+            new NoteExpression(note.name, note.octave),
+            new DurationExpression(note.duration)
+        ));
+    }
+
+    FlatProgram flat{*program};
+    std::cout << "Notas: " << note_count << "\n";
+
+    // to_string
+    std::string virtual_text, visitor_text;
+    double virtual_ms = measure_ms([&] { virtual_text = program->to_string(); });
+    double visitor_ms = measure_ms([&] { visitor_text = flat.to_string(); });
+    report("to_string", virtual_ms, visitor_ms);
+
+    // resolve_names
+    bool virtual_valid = false, visitor_valid = false;
+    virtual_ms = measure_ms([&] { SymbolTable table; virtual_valid = program->resolve_names(table); });
+    visitor_ms = measure_ms([&] { SymbolTable table; visitor_valid = flat.resolve_names(table); });
+    report("resolve_names", virtual_ms, visitor_ms);
+
+    // to_abc
+    std::ostringstream virtual_abc, visitor_abc;
+    virtual_ms = measure_ms([&] { double beat = 0.0; program->to_abc(virtual_abc, beat); });
+    visitor_ms = measure_ms([&] { double beat = 0.0; flat.to_abc(visitor_abc, beat); });
+    report("to_abc", virtual_ms, visitor_ms);
+
+    bool same = virtual_text == visitor_text && virtual_valid == visitor_valid &&
+                virtual_abc.str() == visitor_abc.str();
+    std::cout << (same ? "Ambos recorridos producen la misma salida.\n"
+                       : "Error: los recorridos producen salidas distintas.\n");
+
+    // Transposición sobre las alturas MIDI: ida y vuelta debe dejar el programa igual
+    bool transposed = false;
+    double transpose_ms = measure_ms([&] {
+        transposed = transpose_program(*program, 2) && transpose_program(*program, -2);
+    });
+    bool round_trip = transposed && program->to_string() == virtual_text;
+    std::cout << "transponer +2 y -2: " << transpose_ms << " ms"
+              << (round_trip ? "" : " (Error: el programa cambió)") << "\n";
+    same = same && round_trip;
+
+    // Las mismas notas con nodos compartidos: la altura se valida y se
+    // escribe en ABC una vez por nodo
+    MusicProgram* shared = new MusicProgram();
+    shared->set_note_pool(std::make_shared<NotePool>());
+    NotePool& pool = *shared->get_note_pool();
+    shared->add_declaration(new TempoDeclaration(60));
+    shared->add_declaration(new TimeSignatureDeclaration(7, 8));
+    shared->add_declaration(new KeyDeclaration("Si", KeyMode::MAYOR));
+    double build_ms = measure_ms([&] {
+        for (long i = 0; i < note_count; ++i) {
+            const auto& note = melody[i % melody_size];
+            shared->add_statement(pool.make_note(note.name, note.octave, note.duration));
+        }
+    });
+    bool shared_valid = false;
+    double resolve_ms = measure_ms([&] { SymbolTable table; shared_valid = shared->resolve_names(table); });
+    std::ostringstream shared_abc;
+    double abc_ms = measure_ms([&] { double beat = 0.0; shared->to_abc(shared_abc, beat); });
+    std::cout << "notas compartidas: armado " << build_ms << " ms, resolve_names " << resolve_ms
+              << " ms, to_abc " << abc_ms << " ms\n";
+    writeNotePoolStats(std::cout, pool.stats());
+    bool shared_same = shared_valid == virtual_valid && shared_abc.str() == virtual_abc.str();
+    std::cout << (shared_same ? "Las notas compartidas producen la misma salida.\n"
+                              : "Error: las notas compartidas producen otra salida.\n");
+    same = same && shared_same;
+
+    shared->destroy();
+    delete shared;
+    program->destroy();
+    delete program;
+
+    return same ? 0 : 1;
+}
@@ -1,9 +1,21 @@
 #include "declaration.hpp"
 #include "statement.hpp"
+#include "voice.hpp"
+#include "expression.hpp"
 #include "../Semantic_Analysis/symbol_table.hpp"
+#include <algorithm>
+#include <cstdlib>
 #include <vector>
-#include <iostream>
-#include <cmath>
+#include <sstream>
+
+// Declaration implementacion
+void Declaration::set_source_location(SourceLocation location) noexcept{
+    this->source_location = location;
+}
+
+SourceLocation Declaration::get_source_location() const noexcept{
+    return this->source_location;
+}
 
 // TempoDeclaration implementacion
 TempoDeclaration::TempoDeclaration(int tempo_value) noexcept
@@ -25,12 +37,11 @@ void TempoDeclaration::destroy() noexcept {
 bool TempoDeclaration::resolve_names(SymbolTable& table) noexcept{
     if (table.contains("__tempo__"))
     {
-        std::cerr << "Error: Tempo declarado más de una vez.\n";
+        SemanticErrorMessage{} << "Error: Tempo declarado más de una vez.\n";
         return false;
     }
     
-    if (tempo_value < 20 || tempo_value > 200){
-        std::cerr << "Error: El tempo debe estar en el rango de Larghissimo a Prestissimo.\n";
+    if (!TempoDeclaration::check_tempo(tempo_value)){
         return false;
     }
     
@@ -38,6 +49,14 @@ bool TempoDeclaration::resolve_names(SymbolTable& table) noexcept{
     return true;
 }
 
+bool TempoDeclaration::check_tempo(int tempo_value) noexcept{
+    if (!valid_tempo(tempo_value)){
+        SemanticErrorMessage{} << "Error: El tempo debe estar en el rango de Larghissimo a Prestissimo.\n";
+        return false;
+    }
+    return true;
+}
+
 // Implementación de to_abc para TempoDeclaration
 void TempoDeclaration::to_abc(std::ostream& out, double& /*beatCounter*/) const noexcept {
     out << "Q:1/4=" << tempo_value << "\n";
@@ -55,6 +74,11 @@ int TimeSignatureDeclaration::get_denominator() const noexcept {
     return denominator;
 }
 
+double TimeSignatureDeclaration::bar_length() const noexcept {
+    // Una corchea es 1/8 de redonda
+    return numerator * 8.0 / denominator;
+}
+
 std::string TimeSignatureDeclaration::to_string() const noexcept {
     return "Compas " + std::to_string(numerator) + "/" + std::to_string(denominator);
 }
@@ -67,22 +91,29 @@ void TimeSignatureDeclaration::destroy() noexcept {
 bool TimeSignatureDeclaration::resolve_names(SymbolTable& table) noexcept{
     if (table.contains("__time_signature__"))
     {
-        std::cerr << "Error: Compás declarado más de una vez.\n";
+        SemanticErrorMessage{} << "Error: Compás declarado más de una vez.\n";
         return false;
     }
     
-    if (numerator <= 1 || numerator > 12){
-        std::cerr << "Error: El numerador del compás debe ser mayor a 1 y menor a 12.\n";
+    if (!TimeSignatureDeclaration::check_time_signature(numerator, denominator)){
         return false;
     }
     
-    if (denominator != 2 && denominator != 4 && denominator != 8 && denominator != 16)
-    {
-        std::cerr << "Error: El denominador del compás debe ser 2, 4, 8 o 16.\n";
+    table.insert("__time_signature__");
+    return true;
+}
+
+bool TimeSignatureDeclaration::check_time_signature(int numerator, int denominator) noexcept{
+    if (!valid_numerator(numerator)){
+        SemanticErrorMessage{} << "Error: El numerador del compás debe ser mayor a 1 y menor a 12.\n";
         return false;
     }
     
-    table.insert("__time_signature__");
+    if (!valid_denominator(denominator))
+    {
+        SemanticErrorMessage{} << "Error: El denominador del compás debe ser 2, 4, 8 o 16.\n";
+        return false;
+    }
     return true;
 }
 
@@ -116,33 +147,16 @@ void KeyDeclaration::destroy() noexcept {
 bool KeyDeclaration::resolve_names(SymbolTable& table) noexcept{
     if (table.contains("__key__"))
     {
-        std::cerr << "Error: Tonalidad declarada más de una vez.\n";
+        SemanticErrorMessage{} << "Error: Tonalidad declarada más de una vez.\n";
         return false;
     }
     
     // Verificar que la nota raíz sea válida
-    // Lista de notas musicales válidas
-    std::vector<std::string> valid_notes = {"Do", "Re", "Mi", "Fa", "Sol", "La", "Si", 
-                                          "Do#", "Re#", "Fa#", "Sol#", "La#", "Si#",
-                                          "Dob", "Reb", "Mib", "Solb", "Lab", "Sib",
-                                          "C", "D", "E", "F", "G", "A", "B",
-                                          "Cb", "Db", "Eb", "Gb", "Ab", "Bb",
-                                          "C#", "D#", "F#", "G#", "A#", "B#"
-                                          };
-    
-    bool valid_root = false;
-    for (const auto& note : valid_notes)
-    {
-        if (root_note == note)
-        {
-            valid_root = true;
-            break;
-        }
-    }
+    bool valid_root = is_valid_note_name(root_note);
     
     if (!valid_root)
     {
-        std::cerr << "Error: Nota raíz inválida: " << root_note << ".\n";
+        SemanticErrorMessage{} << "Error: Nota raíz inválida: " << root_note << ".\n";
         return false;
     }
     
@@ -152,29 +166,132 @@ bool KeyDeclaration::resolve_names(SymbolTable& table) noexcept{
 
 // Implementación de to_abc para KeyDeclaration
 void KeyDeclaration::to_abc(std::ostream& out, double& /*beatCounter*/) const noexcept {
-    // Convertir la nota base de una tonalidad a formato ABC
-    std::string abc_note;
-    if (root_note == "Do" || root_note == "C") abc_note = "C";
-    else if (root_note == "Re" || root_note == "D") abc_note = "D";
-    else if (root_note == "Mi" || root_note == "E") abc_note = "E";
-    else if (root_note == "Fa" || root_note == "F") abc_note = "F";
-    else if (root_note == "Sol" || root_note == "G") abc_note = "G";
-    else if (root_note == "La" || root_note == "A") abc_note = "A";
-    else if (root_note == "Si" || root_note == "B") abc_note = "B";
-    
-    // Manejar sostenidos y bemoles
-    if (root_note.find('#') != std::string::npos || root_note.find("is") != std::string::npos) {
-        abc_note += "maj"; // Mayor con sostenido
-    } else if (root_note.find('b') != std::string::npos || root_note.find("es") != std::string::npos) {
-        abc_note += "min"; // Menor con bemol
-    } else {
-        // Determinar el modo
-        abc_note += (mode == KeyMode::MAYOR) ? "maj" : "min";
+    // Convertir la nota base de una tonalidad a formato ABC ("K:F#min", "K:Bbmaj")
+    static const char* const abc_letters[7] = {"C", "D", "E", "F", "G", "A", "B"};
+    NoteSpelling spelling{0, 0};
+    parse_note_name(root_note, spelling);
+
+    std::string abc_note = abc_letters[spelling.letter];
+    if (spelling.accidental > 0) {
+        abc_note += "#";
+    } else if (spelling.accidental < 0) {
+        abc_note += "b";
     }
-    
+    abc_note += (mode == KeyMode::MAYOR) ? "maj" : "min";
+
     out << "K:" << abc_note << "\n";
 }
 
+// Posición en el círculo de quintas de la tonalidad mayor de cada letra
+static const int letter_fifths[7] = {0, 2, 4, -1, 1, 3, 5};
+
+// Armadura de una tonalidad: cada sostenido de la raíz suma siete quintas y
+// el modo menor está tres quintas por debajo de su homónimo mayor
+static int spelling_fifths(const NoteSpelling& spelling, KeyMode mode) noexcept {
+    return letter_fifths[spelling.letter] + 7 * spelling.accidental - (mode == KeyMode::MENOR ? 3 : 0);
+}
+
+int KeyDeclaration::fifths() const noexcept {
+    NoteSpelling spelling{0, 0};
+    parse_note_name(root_note, spelling);
+    return spelling_fifths(spelling, mode);
+}
+
+std::array<NoteSpelling, 12> KeyDeclaration::pitch_spellings() const noexcept {
+    static const int sharp_order[7] = {3, 0, 4, 1, 5, 2, 6};   // Fa Do Sol Re La Mi Si
+    static const int flat_order[7] = {6, 2, 5, 1, 4, 0, 3};    // Si Mi La Re Sol Do Fa
+    static const NoteSpelling sharp_spellings[12] = {
+        {0, 0}, {0, 1}, {1, 0}, {1, 1}, {2, 0}, {3, 0}, {3, 1}, {4, 0}, {4, 1}, {5, 0}, {5, 1}, {6, 0}
+    };
+    static const NoteSpelling flat_spellings[12] = {
+        {0, 0}, {1, -1}, {1, 0}, {2, -1}, {2, 0}, {3, 0}, {4, -1}, {4, 0}, {5, -1}, {5, 0}, {6, -1}, {6, 0}
+    };
+
+    int signature = fifths();
+    std::array<NoteSpelling, 12> spellings;
+    const NoteSpelling* chromatic = (signature < 0) ? flat_spellings : sharp_spellings;
+    std::copy(chromatic, chromatic + 12, spellings.begin());
+
+    // Las siete letras con las alteraciones de la armadura
+    int letter_accidentals[7] = {0, 0, 0, 0, 0, 0, 0};
+    for (int i = 0; i < std::min(std::abs(signature), 7); ++i) {
+        if (signature > 0) {
+            letter_accidentals[sharp_order[i]] = 1;
+        } else {
+            letter_accidentals[flat_order[i]] = -1;
+        }
+    }
+    for (int letter = 0; letter < 7; ++letter) {
+        NoteSpelling spelling{letter, letter_accidentals[letter]};
+        spellings[(spelling.semitones() + 12) % 12] = spelling;
+    }
+    return spellings;
+}
+
+void KeyDeclaration::transpose(int semitones) noexcept {
+    NoteSpelling spelling{0, 0};
+    parse_note_name(root_note, spelling);
+    int current = spelling_fifths(spelling, mode);
+    int pitch_class = (((spelling.semitones() + semitones) % 12) + 12) % 12;
+
+    // Entre las grafías de la nueva raíz, la de menos alteraciones en la
+    // armadura; en empate (Fa# y Solb mayor) se conserva el lado actual
+    NoteSpelling best{0, 0};
+    int best_fifths = 100;
+    for (int letter = 0; letter < 7; ++letter) {
+        for (int accidental = -1; accidental <= 1; ++accidental) {
+            NoteSpelling candidate{letter, accidental};
+            if ((candidate.semitones() + 12) % 12 != pitch_class) {
+                continue;
+            }
+
+            int candidate_fifths = spelling_fifths(candidate, mode);
+            bool better = std::abs(candidate_fifths) < std::abs(best_fifths) ||
+                          (std::abs(candidate_fifths) == std::abs(best_fifths) &&
+                           (candidate_fifths < 0) == (current < 0));
+            if (better) {
+                best = candidate;
+                best_fifths = candidate_fifths;
+            }
+        }
+    }
+    root_note = best.name();
+}
+
+// TransposeDeclaration implementacion
+TransposeDeclaration::TransposeDeclaration(int semitones) noexcept
+    : semitones{semitones} {}
+
+int TransposeDeclaration::get_semitones() const noexcept {
+    return semitones;
+}
+
+std::string TransposeDeclaration::to_string() const noexcept {
+    return "Transponer " + std::string(semitones > 0 ? "+" : "") + std::to_string(semitones);
+}
+
+void TransposeDeclaration::destroy() noexcept {
+    // No hay memoria que liberar
+}
+
+// Implementación del método resolve_names para TransposeDeclaration. El
+// rango de las notas transpuestas se verifica en el pase de transposición
+bool TransposeDeclaration::resolve_names(SymbolTable& table) noexcept{
+    if (table.contains("__transpose__"))
+    {
+        SemanticErrorMessage{} << "Error: Transposición declarada más de una vez.\n";
+        return false;
+    }
+
+    table.insert("__transpose__");
+    return true;
+}
+
+// Implementación de to_abc para TransposeDeclaration
+void TransposeDeclaration::to_abc(std::ostream& /*out*/, double& /*beatCounter*/) const noexcept {
+    // Las notas ya se escriben transpuestas: no hay campo ABC
+}
+
 // Implementación de la clase MusicProgram configuracion musical
 MusicProgram::MusicProgram() noexcept{
 }
@@ -201,11 +318,139 @@ const std::vector<Declaration*>& MusicProgram::get_declarations() const noexcept
     return this->declarations;
 }
 
+void MusicProgram::add_voice(MusicVoice* voice) noexcept{
+    if (voice != nullptr)
+    {
+        this->voices.push_back(voice);
+    }
+}
+
 const std::vector<Statement*>& MusicProgram::get_statements() const noexcept{
     return this->statements;
 }
 
+const std::vector<MusicVoice*>& MusicProgram::get_voices() const noexcept{
+    return this->voices;
+}
+
+void MusicProgram::release(std::vector<Declaration*>& declarations, std::vector<Statement*>& statements,
+                           std::vector<MusicVoice*>& voices) noexcept{
+    declarations = std::move(this->declarations);
+    statements = std::move(this->statements);
+    voices = std::move(this->voices);
+    this->declarations.clear();
+    this->statements.clear();
+    this->voices.clear();
+    this->tempo_map = TempoMap{};
+}
+
+void MusicProgram::set_note_pool(std::shared_ptr<NotePool> pool) noexcept{
+    this->note_pool = std::move(pool);
+}
+
+const std::shared_ptr<NotePool>& MusicProgram::get_note_pool() const noexcept{
+    return this->note_pool;
+}
+
+double MusicProgram::bar_length() const noexcept{
+    for (const auto& decl : this->declarations)
+    {
+        if (auto time_signature = dynamic_cast<const TimeSignatureDeclaration*>(decl))
+        {
+            return time_signature->bar_length();
+        }
+    }
+    return 0.0;
+}
+
+int MusicProgram::get_transposition() const noexcept{
+    for (const auto& decl : this->declarations)
+    {
+        if (auto transpose = dynamic_cast<const TransposeDeclaration*>(decl))
+        {
+            return transpose->get_semitones();
+        }
+    }
+    return 0;
+}
+
+const TempoMap& MusicProgram::get_tempo_map() const noexcept{
+    return this->tempo_map;
+}
+
+void MusicProgram::trim(long from, long to) noexcept{
+    trim_statements(this->statements, from, to);
+}
+
+// Agrega al mapa los cambios de una secuencia de sentencias. Los cambios solo
+// aparecen en el nivel superior de una voz, así que la posición es la suma de
+// lo que suena antes de ellos
+static void collect_tempo_changes(const std::vector<Statement*>& statements, TempoMap& tempo_map) noexcept{
+    long position = 0;
+    for (const auto& stmt : statements)
+    {
+        if (auto tempo = dynamic_cast<const TempoChangeStatement*>(stmt))
+        {
+            tempo_map.add_tempo_change(position, tempo->get_tempo_value());
+        }
+        else if (auto time_signature = dynamic_cast<const TimeSignatureChangeStatement*>(stmt))
+        {
+            tempo_map.add_time_signature_change(position, time_signature->get_numerator(),
+                                                time_signature->get_denominator());
+        }
+        else
+        {
+            position += TempoMap::ticks_from_beats(stmt->played_beats());
+        }
+    }
+}
+
+bool MusicProgram::build_tempo_map() noexcept{
+    this->tempo_map = TempoMap{};
+
+    const TempoDeclaration* tempo = nullptr;
+    const TimeSignatureDeclaration* time_signature = nullptr;
+    for (const auto& decl : this->declarations)
+    {
+        if (auto found = dynamic_cast<const TempoDeclaration*>(decl))
+        {
+            tempo = found;
+        }
+        else if (auto found = dynamic_cast<const TimeSignatureDeclaration*>(decl))
+        {
+            time_signature = found;
+        }
+    }
+
+    // Si falta alguna, check_required_declarations lo reporta
+    if (tempo == nullptr || time_signature == nullptr)
+    {
+        return true;
+    }
+
+    this->tempo_map.reset(tempo->get_tempo_value(), time_signature->get_numerator(),
+                          time_signature->get_denominator());
+    collect_tempo_changes(this->statements, this->tempo_map);
+    for (const auto& voice : this->voices)
+    {
+        collect_tempo_changes(voice->get_statements(), this->tempo_map);
+    }
+    return this->tempo_map.build();
+}
+
 std::string MusicProgram::to_string() const noexcept{
+    std::string result = this->header_to_string();
+
+    // Imprimir todos los statements
+    for (const auto& stmt : this->statements)
+    {
+        result += "  " + stmt->to_string() + "\n";
+    }
+
+    return result + this->voices_to_string();
+}
+
+std::string MusicProgram::header_to_string() const noexcept{
     std::string result = "Programa musical:\n";
 
     // Imprimir todas las declaraciones
@@ -215,13 +460,21 @@ std::string MusicProgram::to_string() const noexcept{
         result += "  " + decl->to_string() + "\n";
     }
 
-    // Imprimir todos los statements
     result += "Sentencias:\n";
-    for (const auto& stmt : this->statements)
+    return result;
+}
+
+std::string MusicProgram::voices_to_string() const noexcept{
+    // Imprimir las voces, si el programa tiene más de una parte
+    std::string result;
+    if (!this->voices.empty())
     {
-        result += "  " + stmt->to_string() + "\n";
+        result += "Voces:\n";
+        for (const auto& voice : this->voices)
+        {
+            result += "  " + voice->to_string();
+        }
     }
-
     return result;
 }
 
@@ -247,51 +500,209 @@ void MusicProgram::destroy() noexcept{
         }
     }
     this->statements.clear();
+
+    // Destruir todas las voces
+    for (auto& voice : this->voices)
+    {
+        if (voice != nullptr)
+        {
+            voice->destroy();
+            delete voice;
+        }
+    }
+    this->voices.clear();
 }
 
 bool MusicProgram::resolve_names(SymbolTable& table) noexcept{
     // Primero procesar todas las declaraciones
+    if (!this->resolve_declarations(table))
+    {
+        return false;
+    }
+
+    // Luego procesar todos los statements
+    for (const auto& stmt : this->statements)
+    {
+        SourceLocationScope location{stmt->get_source_location()};
+        if (!stmt->resolve_names(table))
+        {
+            return false;
+        }
+    }
+
+    return this->resolve_voices(table);
+}
+
+bool MusicProgram::resolve_declarations(SymbolTable& table) noexcept{
     for (const auto& decl : this->declarations)
     {
+        SourceLocationScope location{decl->get_source_location()};
         if (!decl->resolve_names(table))
         {
             return false;
         }
     }
+    return true;
+}
 
-    // Luego procesar todos los statements
-    for (const auto& stmt : this->statements)
+bool MusicProgram::resolve_voices(SymbolTable& table) noexcept{
+    if (!this->voices.empty())
     {
-        if (!stmt->resolve_names(table))
+        if (!this->declare_voices(table, 0))
+        {
+            return false;
+        }
+
+        // Cada voz se analiza en su propio hilo, con una copia de la tabla que
+        // ya contiene las declaraciones (vector<char> y no vector<bool>, para
+        // que cada hilo escriba en su propio byte)
+        std::vector<char> valid(this->voices.size(), 0);
+        parallel_for_each_index(this->voices.size(), [&](std::size_t i) {
+            SymbolTable voice_table{table};
+            valid[i] = this->voices[i]->resolve_names(voice_table);
+        });
+
+        if (std::find(valid.begin(), valid.end(), 0) != valid.end())
+        {
+            return false;
+        }
+
+        if (!this->check_voices())
         {
             return false;
         }
     }
+    else if (!this->build_tempo_map())
+    {
+        return false;
+    }
 
     // Verificar que las declaraciones obligatorias existan
+    return MusicProgram::check_required_declarations(table);
+}
+
+bool MusicProgram::declare_voices(SymbolTable& table, std::size_t first) noexcept{
+    if (first == 0)
+    {
+        // Fuera de las voces solo puede haber definiciones de motivos, que no suenan
+        bool plays_notes = std::any_of(this->statements.begin(), this->statements.end(),
+                                       [](const Statement* stmt) { return stmt->played_beats() > 0.0; });
+        if (plays_notes)
+        {
+            SemanticErrorMessage{} << "Error: Hay notas fuera de una voz en un programa con voces.\n";
+            return false;
+        }
+    }
+
+    for (std::size_t i = first; i < this->voices.size(); ++i)
+    {
+        if (!table.insert("__voice_" + this->voices[i]->get_name() + "__"))
+        {
+            SemanticErrorMessage{} << "Error: Voz declarada más de una vez: " << this->voices[i]->get_name() << ".\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MusicProgram::check_voices() noexcept{
+    // La rejilla depende de los cambios de compás de todas las voces,
+    // así que se verifica cuando todas están resueltas
+    if (!this->build_tempo_map())
+    {
+        return false;
+    }
+
+    std::vector<char> valid(this->voices.size(), 0);
+    parallel_for_each_index(this->voices.size(), [&](std::size_t i) {
+        valid[i] = this->voices[i]->check_bar_grid(this->tempo_map);
+    });
+
+    if (std::find(valid.begin(), valid.end(), 0) != valid.end())
+    {
+        return false;
+    }
+
+    return this->check_voice_alignment(this->tempo_map);
+}
+
+bool MusicProgram::check_required_declarations(SymbolTable& table) noexcept{
     if (!table.contains("__tempo__"))
     {
-        std::cerr << "Error: Falta declaración de tempo.\n";
+        SemanticErrorMessage{} << "Error: Falta declaración de tempo.\n";
         return false;
     }
 
     if (!table.contains("__time_signature__"))
     {
-        std::cerr << "Error: Falta declaración de compás.\n";
+        SemanticErrorMessage{} << "Error: Falta declaración de compás.\n";
         return false;
     }
 
     if (!table.contains("__key__"))
     {
-        std::cerr << "Error: Falta declaración de tonalidad.\n";
+        SemanticErrorMessage{} << "Error: Falta declaración de tonalidad.\n";
         return false;
     }
 
     return true;
 }
 
+bool MusicProgram::check_voice_alignment(const TempoMap& tempo_map) const noexcept{
+    if (this->voices.size() < 2 || tempo_map.empty())
+    {
+        return true;
+    }
+
+    std::vector<long> ticks;
+    for (const auto& voice : this->voices)
+    {
+        ticks.push_back(TempoMap::ticks_from_beats(voice->total_beats()));
+    }
+    return this->check_voice_alignment(tempo_map, ticks);
+}
+
+bool MusicProgram::check_voice_alignment(const TempoMap& tempo_map, const std::vector<long>& ticks) const noexcept{
+    if (this->voices.size() < 2 || tempo_map.empty())
+    {
+        return true;
+    }
+
+    // Todas las voces comienzan en la primera barra de la rejilla, así que
+    // quedan alineadas si terminan en el mismo punto
+    const MusicVoice* first = this->voices.front();
+    for (std::size_t i = 0; i < this->voices.size(); ++i)
+    {
+        if (ticks[i] != ticks.front())
+        {
+            SemanticErrorMessage{} << "Error: Las voces no están alineadas: " << first->get_name() << " dura "
+                      << tempo_map.measures_at(ticks.front()) << " compases y " << this->voices[i]->get_name()
+                      << " dura " << tempo_map.measures_at(ticks[i]) << ".\n";
+            return false;
+        }
+    }
+    return true;
+}
+
 // Implementación de to_abc para MusicProgram
 void MusicProgram::to_abc(std::ostream& out, double& beatCounter) const noexcept {
+    this->write_abc_header(out, beatCounter);
+
+    if (voices.empty()) {
+        // Procesar todas las notas
+        AbcBarState state;
+        this->start_abc_statements(state);
+        statements_to_abc(statements, out, beatCounter, state);
+
+        // Finalizar la partitura con una barra final
+        finish_abc_bars(out, state);
+        return;
+    }
+
+    this->write_abc_voices(out, beatCounter);
+}
+
+void MusicProgram::write_abc_header(std::ostream& out, double& beatCounter) const noexcept {
     // Cabecera mínima ABC
     out << "X:1\n";
     out << "T:Generated\n";
@@ -300,17 +711,29 @@ void MusicProgram::to_abc(std::ostream& out, double& beatCounter) const noexcept
     for (const auto& decl : declarations) {
         decl->to_abc(out, beatCounter);
     }
-    
-    // Procesar todas las notas
-    for (const auto& stmt : statements) {
-        stmt->to_abc(out, beatCounter);
-        
-        // Insertar barra de compás cuando se completa un compás
-        if (std::fmod(beatCounter, 7.0) == 0.0) {
-            out << "| ";
-        }
+}
+
+void MusicProgram::start_abc_statements(AbcBarState& state) const noexcept {
+    // Las barras siguen la rejilla del compás declarado y, si resolve_names
+    // armó el mapa, sus cambios de compás y de tempo
+    state = AbcBarState{this->bar_length()};
+    start_abc_bars(state, this->tempo_map.empty() ? nullptr : &this->tempo_map, true);
+}
+
+void MusicProgram::write_abc_voices(std::ostream& out, double& beatCounter) const noexcept {
+    double bar = this->bar_length();
+    const TempoMap* map = this->tempo_map.empty() ? nullptr : &this->tempo_map;
+
+    // Cada voz se genera en su propio hilo y buffer, y se escriben en orden
+    std::vector<std::ostringstream> buffers(voices.size());
+    std::vector<double> beats(voices.size(), 0.0);
+    parallel_for_each_index(voices.size(), [&](std::size_t i) {
+        // El tempo es uno solo para toda la partitura: lo escribe la primera voz
+        voices[i]->to_abc(buffers[i], beats[i], bar, map, i == 0);
+    });
+
+    for (const auto& buffer : buffers) {
+        out << buffer.str();
     }
-    
-    // Finalizar la partitura con una barra final
-    out << "|\n";
+    beatCounter += *std::max_element(beats.begin(), beats.end());
 } 
\ No newline at end of file
@@ -1,6 +1,10 @@
 #pragma once
 
 #include "ast_node_interface.hpp"
+#include "expression.hpp"
+#include "tempo_map.hpp"
+#include <array>
+#include <memory>
 #include <string>
 #include <vector>
 #include <iostream>
@@ -11,10 +15,17 @@ enum class KeyMode {
 };
 
 class Declaration : public ASTNodeInterface{
+public:
+    // Ubicación en el archivo fuente, si el front end la conoce
+    void set_source_location(SourceLocation location) noexcept;
+    SourceLocation get_source_location() const noexcept;
+
+private:
+    SourceLocation source_location;
 };
 
 // Declaración de tempo
-class TempoDeclaration : public Declaration{
+class TempoDeclaration final : public Declaration{
 public:
     TempoDeclaration(int tempo_value) noexcept;
 
@@ -24,34 +35,58 @@ public:
     bool resolve_names(SymbolTable& table) noexcept override;
     void to_abc(std::ostream& out, double &beatCounter) const noexcept override;
 
+    // Verifica el rango del tempo (también el de los cambios de tempo)
+    static bool check_tempo(int tempo_value) noexcept;
+
 private:
     int tempo_value;
 };
 
 // Declaración de compás
-class TimeSignatureDeclaration : public Declaration{
+class TimeSignatureDeclaration final : public Declaration{
 public:
     TimeSignatureDeclaration(int numerator, int denominator) noexcept;
 
     int get_numerator() const noexcept;
     int get_denominator() const noexcept;
+
+    // Duración de un compás en la unidad de DurationExpression::beats() (corcheas):
+    // es el paso de la rejilla de barras común a todas las voces
+    double bar_length() const noexcept;
+
     std::string to_string() const noexcept override;
     void destroy() noexcept override;
     bool resolve_names(SymbolTable& table) noexcept override;
     void to_abc(std::ostream& out, double &beatCounter) const noexcept override;
 
+    // Verifica numerador y denominador (también los de los cambios de compás)
+    static bool check_time_signature(int numerator, int denominator) noexcept;
+
 private:
     int numerator;
     int denominator;
 };
 
 // Declaración de clave (tonalidad)
-class KeyDeclaration : public Declaration{
+class KeyDeclaration final : public Declaration{
 public:
     KeyDeclaration(const std::string& root_note, KeyMode mode) noexcept;
 
     std::string get_root_note() const noexcept;
     KeyMode get_mode() const noexcept;
+
+    // Armadura en el círculo de quintas: sostenidos (positivo) o bemoles
+    // (negativo). Indica cómo escribir las alteraciones en esta tonalidad
+    int fifths() const noexcept;
+
+    // Grafía de cada clase de altura (0 = Do, ..., 11 = Si) en esta
+    // tonalidad: las notas de la escala con las alteraciones de la armadura y
+    // las demás con sostenidos o bemoles, según el lado de la armadura
+    std::array<NoteSpelling, 12> pitch_spellings() const noexcept;
+
+    // Mueve la nota raíz, con la grafía de menos alteraciones
+    void transpose(int semitones) noexcept;
+
     std::string to_string() const noexcept override;
     void destroy() noexcept override;
     bool resolve_names(SymbolTable& table) noexcept override;
@@ -62,8 +97,26 @@ private:
     KeyMode mode;
 };
 
-// Forward declaration de Statement
+// Declaración de transposición de toda la partitura, en semitonos
+class TransposeDeclaration final : public Declaration{
+public:
+    TransposeDeclaration(int semitones) noexcept;
+
+    int get_semitones() const noexcept;
+    std::string to_string() const noexcept override;
+    void destroy() noexcept override;
+    bool resolve_names(SymbolTable& table) noexcept override;
+    void to_abc(std::ostream& out, double &beatCounter) const noexcept override;
+
+private:
+    int semitones;
+};
+
+// Forward declaration de Statement, MusicVoice y NotePool
 class Statement;
+class MusicVoice;
+class NotePool;
+struct AbcBarState;
 
 // Clase que representa el nodo raíz del AST
 class MusicProgram : public ASTNodeInterface{
@@ -74,10 +127,38 @@ public:
     // Añadir declaraciones y statements al programa
     void add_declaration(Declaration* declaration) noexcept;
     void add_statement(Statement* statement) noexcept;
+    void add_voice(MusicVoice* voice) noexcept;
 
-    // Acceso a las declaraciones y statements
+    // Acceso a las declaraciones, statements y voces
     const std::vector<Declaration*>& get_declarations() const noexcept;
     const std::vector<Statement*>& get_statements() const noexcept;
+    const std::vector<MusicVoice*>& get_voices() const noexcept;
+
+    // Entrega las declaraciones, sentencias y voces al llamador y deja el
+    // programa vacío (por ejemplo, para pasarlas a una EditableScore)
+    void release(std::vector<Declaration*>& declarations, std::vector<Statement*>& statements,
+                 std::vector<MusicVoice*>& voices) noexcept;
+
+    // Pool de nodos de nota que comparten las sentencias del programa (ver
+    // NotePool), o nullptr si cada nota tiene los suyos. El programa lo
+    // mantiene vivo mientras tenga sentencias
+    void set_note_pool(std::shared_ptr<NotePool> pool) noexcept;
+    const std::shared_ptr<NotePool>& get_note_pool() const noexcept;
+
+    // Duración de un compás según la declaración de compás (0 si no hay)
+    double bar_length() const noexcept;
+
+    // Semitonos de la declaración de transposición (0 si no hay)
+    int get_transposition() const noexcept;
+
+    // Mapa de tempo y compás que arma resolve_names: las declaraciones de la
+    // cabecera y los cambios de todas las voces. Vacío si falta el tempo o el
+    // compás, o antes de resolve_names
+    const TempoMap& get_tempo_map() const noexcept;
+
+    // Deja en las sentencias fuera de las voces (las notas de un programa sin
+    // voces) solo lo que suena en [from, to), como MusicVoice::trim
+    void trim(long from, long to) noexcept;
 
     // Métodos de la interfaz ASTNodeInterface
     std::string to_string() const noexcept override;
@@ -85,7 +166,48 @@ public:
     bool resolve_names(SymbolTable& table) noexcept override;
     void to_abc(std::ostream& out, double &beatCounter) const noexcept override;
 
+    // Verifica que las declaraciones obligatorias existan en la tabla
+    static bool check_required_declarations(SymbolTable& table) noexcept;
+
+    // Fases de resolve_names, para quien recorre las sentencias por su cuenta
+    // (ver ValidationPass): las declaraciones, y lo que sigue a las
+    // sentencias: las voces, el mapa de tempo y las declaraciones obligatorias
+    bool resolve_declarations(SymbolTable& table) noexcept;
+    bool resolve_voices(SymbolTable& table) noexcept;
+
+    // Fases de resolve_voices, para quien resuelve cada voz por su cuenta
+    // (ver pipeline.hpp). declare_voices agrega a la tabla las voces desde
+    // first y, si first es la primera, verifica que fuera de ellas nada
+    // suene. check_voices, con las voces ya resueltas, arma el mapa de tempo
+    // y verifica la rejilla de cada voz y la alineación
+    bool declare_voices(SymbolTable& table, std::size_t first) noexcept;
+    bool check_voices() noexcept;
+
+    // Fases de to_abc (ver AbcPass): la cabecera con las declaraciones, el
+    // estado de la rejilla para las sentencias de un programa sin voces, y
+    // las voces, cada una en su propio hilo
+    void write_abc_header(std::ostream& out, double& beatCounter) const noexcept;
+    void start_abc_statements(AbcBarState& state) const noexcept;
+    void write_abc_voices(std::ostream& out, double& beatCounter) const noexcept;
+
+    // Fases de to_string (ver TextPass): hasta el título de las sentencias, y las voces
+    std::string header_to_string() const noexcept;
+    std::string voices_to_string() const noexcept;
+
+    // Verifica que todas las voces duren lo mismo sobre la rejilla de barras
+    bool check_voice_alignment(const TempoMap& tempo_map) const noexcept;
+
+    // Lo mismo con la duración de cada voz (en semicorcheas, una por voz) ya
+    // calculada, para quien no guarda las sentencias en las voces
+    bool check_voice_alignment(const TempoMap& tempo_map, const std::vector<long>& ticks) const noexcept;
+
 private:
+    // Arma el mapa con los cambios en la posición en que aparecen en cada voz
+    bool build_tempo_map() noexcept;
+
     std::vector<Declaration*> declarations;
     std::vector<Statement*> statements;
+    std::vector<MusicVoice*> voices;
+    TempoMap tempo_map;
+    std::shared_ptr<NotePool> note_pool;
 }; 
\ No newline at end of file
@@ -1,121 +1,66 @@
 #include "expression.hpp"
 #include "../Semantic_Analysis/symbol_table.hpp"
-#include <iostream>
 #include <vector>
 #include <cctype>
 
-// implementacion de NoteExpression 
-NoteExpression::NoteExpression(const std::string& note_name, int octave) noexcept
-    : note_name{note_name}, octave{octave} {}
-
-std::string NoteExpression::get_note_name() const noexcept {
-    return note_name;
-}
-
-int NoteExpression::get_octave() const noexcept {
-    return octave;
-}
-
-std::string NoteExpression::to_string() const noexcept {
-    return note_name + std::to_string(octave);
-}
-
-void NoteExpression::destroy() noexcept {
-    // No hay memoria que liberar
-}
-
-// implementacion de DurationExpression 
-DurationExpression::DurationExpression(DurationType type) noexcept
-    : duration_type{type} {}
-
-DurationType DurationExpression::get_duration_type() const noexcept {
-    return duration_type;
+// implementacion de NoteSpelling
+std::string NoteSpelling::name() const noexcept {
+    std::string result{letter_names[letter]};
+    if (accidental > 0) {
+        result += "#";
+    } else if (accidental < 0) {
+        result += "b";
+    }
+    return result;
 }
 
-std::string DurationExpression::to_string() const noexcept {
-    switch (duration_type) {
-        case DurationType::SEMICORCHEA: return "Semicorchea";
-        case DurationType::CORCHEA: return "Corchea";
-        case DurationType::NEGRA: return "Negra";
-        case DurationType::BLANCA: return "Blanca";
-        default: return "Unknown";
-    }
+bool parse_note_name(std::string_view note_name, NoteSpelling& spelling) noexcept {
+    return spell_note_name(note_name, spelling);
 }
 
-void DurationExpression::destroy() noexcept {
- 
+bool is_valid_note_name(std::string_view note_name) noexcept {
+    return valid_note_name(note_name);
 }
 
-// implementacion del metodo resolve_names (verificacion semantica) para NoteExpression
-bool NoteExpression::resolve_names(SymbolTable& table) noexcept{
+bool check_note(std::string_view note_name, int octave) noexcept {
     // Verificar que la nota sea válida
-    std::vector<std::string> valid_notes = {"Do", "Re", "Mi", "Fa", "Sol", "La", "Si", 
-                                          "Do#", "Re#", "Fa#", "Sol#", "La#", "Si#",
-                                          "Dob", "Reb", "Mib", "Solb", "Lab", "Sib",
-                                          "C", "D", "E", "F", "G", "A", "B",
-                                          "Cb", "Db", "Eb", "Gb", "Ab", "Bb",
-                                          "C#", "D#", "F#", "G#", "A#", "B#"
-                                          };
-    
-    bool valid_note = false;
-    for (const auto& note : valid_notes)
-    {
-        if (note_name == note)
-        {
-            valid_note = true;
-            break;
-        }
-    }
-    
-    if (!valid_note)
+    if (!is_valid_note_name(note_name))
     {
-        std::cerr << "Error: Nota inválida: " << note_name << ".\n";
+        SemanticErrorMessage{} << "Error: Nota inválida: " << note_name << ".\n";
         return false;
     }
-    
+
     // Verificar que la octava esté en un rango válido (1-8)
-    if (octave < 1 || octave > 8)
+    if (!valid_octave(octave))
     {
-        std::cerr << "Error: Octava fuera de rango (1-8): " << octave << ".\n";
+        SemanticErrorMessage{} << "Error: Octava fuera de rango (1-8): " << octave << ".\n";
         return false;
     }
-    
-    return true;
-}
 
-// implementacion del metodo resolve_names (verificacion semantica) para DurationExpression
-bool DurationExpression::resolve_names(SymbolTable& /*table*/) noexcept{
-    // Todas las duraciones son válidas porque están definidas como enum
     return true;
 }
 
-// Implementación de to_abc para NoteExpression
-void NoteExpression::to_abc(std::ostream& /*out*/, double& /*beatCounter*/) const noexcept {
-    //se usa as_abc()
-}
-
-// Implementación del método auxiliar as_abc() para NoteExpression
-std::string NoteExpression::as_abc() const noexcept {
+std::string note_abc(std::string_view note_name, int octave) noexcept {
     std::string abc_note;
-    std::string base_note = note_name;
+    std::string_view base_note = note_name;
     bool has_sharp = false;
     bool has_flat = false;
     
     // Detectar sostenidos y bemoles
-    if (note_name.find('#') != std::string::npos || note_name.find("is") != std::string::npos) {
+    if (note_name.find('#') != std::string_view::npos || note_name.find("is") != std::string_view::npos) {
         has_sharp = true;
         // Eliminar el sostenido del nombre para obtener la nota base
-        if (note_name.find('#') != std::string::npos) {
+        if (note_name.find('#') != std::string_view::npos) {
             base_note = note_name.substr(0, note_name.find('#'));
-        } else if (note_name.find("is") != std::string::npos) {
+        } else if (note_name.find("is") != std::string_view::npos) {
             base_note = note_name.substr(0, note_name.find("is"));
         }
-    } else if (note_name.find('b') != std::string::npos || note_name.find("es") != std::string::npos) {
+    } else if (note_name.find('b') != std::string_view::npos || note_name.find("es") != std::string_view::npos) {
         has_flat = true;
         // Eliminar el bemol del nombre para obtener la nota base
-        if (note_name.find('b') != std::string::npos) {
+        if (note_name.find('b') != std::string_view::npos) {
             base_note = note_name.substr(0, note_name.find('b'));
-        } else if (note_name.find("es") != std::string::npos) {
+        } else if (note_name.find("es") != std::string_view::npos) {
             base_note = note_name.substr(0, note_name.find("es"));
         }
     }
@@ -144,9 +89,9 @@ std::string NoteExpression::as_abc() const noexcept {
         }
     } else if (octave >= 5) {
         // Notas altas (c para octava 5, c' para octava 6, etc.)
-        // Convertir primera letra a minúscula
-        char firstChar = std::tolower(abc_note[0]);
-        abc_note = firstChar + abc_note.substr(1);
+        // Convertir la letra (tras la alteración, si la hay) a minúscula
+        std::size_t letter = abc_note.size() - 1;
+        abc_note[letter] = static_cast<char>(std::tolower(abc_note[letter]));
         
         for (int i = 0; i < octave - 5; ++i) {
             abc_note += "'";
@@ -156,6 +101,96 @@ std::string NoteExpression::as_abc() const noexcept {
     return abc_note;
 }
 
+int note_midi_number(std::string_view note_name, int octave) noexcept {
+    NoteSpelling spelling{0, 0};
+    parse_note_name(note_name, spelling);
+    return pitch_number(spelling, octave);
+}
+
+// implementacion de NoteExpression 
+NoteExpression::NoteExpression(const std::string& note_name, int octave) noexcept
+    : note_name{note_name}, octave{octave} {}
+
+std::string NoteExpression::get_note_name() const noexcept {
+    return note_name;
+}
+
+int NoteExpression::get_octave() const noexcept {
+    return octave;
+}
+
+std::string NoteExpression::to_string() const noexcept {
+    return note_name + std::to_string(octave);
+}
+
+void NoteExpression::destroy() noexcept {
+    // No hay memoria que liberar
+}
+
+// implementacion de DurationExpression 
+DurationExpression::DurationExpression(DurationType type) noexcept
+    : duration_type{type} {}
+
+DurationType DurationExpression::get_duration_type() const noexcept {
+    return duration_type;
+}
+
+std::string DurationExpression::to_string() const noexcept {
+    switch (duration_type) {
+        case DurationType::SEMICORCHEA: return "Semicorchea";
+        case DurationType::CORCHEA: return "Corchea";
+        case DurationType::NEGRA: return "Negra";
+        case DurationType::BLANCA: return "Blanca";
+        default: return "Unknown";
+    }
+}
+
+void DurationExpression::destroy() noexcept {
+ 
+}
+
+// implementacion del metodo resolve_names (verificacion semantica) para NoteExpression
+bool NoteExpression::resolve_names(SymbolTable& /*table*/) noexcept{
+    // Una nota congelada inválida se vuelve a verificar para reportar el error
+    if (frozen && valid) {
+        return true;
+    }
+    return check_note(note_name, octave);
+}
+
+// implementacion del metodo resolve_names (verificacion semantica) para DurationExpression
+bool DurationExpression::resolve_names(SymbolTable& /*table*/) noexcept{
+    // Todas las duraciones son válidas porque están definidas como enum
+    return true;
+}
+
+// Implementación de to_abc para NoteExpression
+void NoteExpression::to_abc(std::ostream& /*out*/, double& /*beatCounter*/) const noexcept {
+    //se usa as_abc()
+}
+
+// Implementación del método auxiliar as_abc() para NoteExpression
+std::string NoteExpression::as_abc() const noexcept {
+    return frozen ? abc : note_abc(note_name, octave);
+}
+
+int NoteExpression::midi_number() const noexcept {
+    return note_midi_number(note_name, octave);
+}
+
+void NoteExpression::set_midi_number(int midi, const NoteSpelling& spelling) noexcept {
+    note_name = spelling.name();
+    octave = (midi - spelling.semitones()) / 12 - 1;
+    frozen = false;
+}
+
+void NoteExpression::freeze() noexcept {
+    // La verificación no debe reportar nada aquí: se reporta en resolve_names
+    valid = is_valid_note_name(note_name) && valid_octave(octave);
+    abc = note_abc(note_name, octave);
+    frozen = true;
+}
+
 // Implementación de to_abc para DurationExpression
 void DurationExpression::to_abc(std::ostream& /*out*/, double& /*beatCounter*/) const noexcept {
     // se usa abc_suffix() y beats()
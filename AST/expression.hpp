@@ -1,20 +1,35 @@
 #pragma once
 
 #include "ast_node_interface.hpp"
+#include "music_rules.hpp"
 #include <string>
+#include <string_view>
 
-// Enumeración para el tipo de duración
-enum class DurationType {
-    SEMICORCHEA,   // Semicorchea
-    CORCHEA,       // Corchea
-    NEGRA,         // Negra
-    BLANCA         // Blanca
+// Clase base para las expresiones musicales (MusicExpression, como MusicProgram,
+// para no chocar con la clase Expression del parser)
+class MusicExpression : public ASTNodeInterface{
 };
 
-class Expression : public ASTNodeInterface{
-};
+// Descompone un nombre de nota latino o inglés ("Sol#", "Bb"); devuelve
+// false si el nombre no es válido
+bool parse_note_name(std::string_view note_name, NoteSpelling& spelling) noexcept;
+
+// Indica si el nombre está en la lista de notas aceptadas, latinas o inglesas
+// (valid_note_names, sin Mi#, Fab, E# ni Fb). La comparten la verificación de notas, la
+// de tonalidades y el modo --check del compilador
+bool is_valid_note_name(std::string_view note_name) noexcept;
+
+// Verifica una nota escrita: nombre válido y octava en 1-8. Reporta el error
+// con SemanticErrorMessage. La comparten NoteExpression y los acordes
+bool check_note(std::string_view note_name, int octave) noexcept;
+
+// Nota en formato ABC, sin la duración ("^c'" para Do#6)
+std::string note_abc(std::string_view note_name, int octave) noexcept;
+
+// Altura como número MIDI (Do4 = 60)
+int note_midi_number(std::string_view note_name, int octave) noexcept;
 
-class NoteExpression : public Expression{
+class NoteExpression final : public MusicExpression{
 public:
     NoteExpression(const std::string& note_name, int octave) noexcept;
 
@@ -28,12 +43,29 @@ public:
     // Método auxiliar para obtener la nota en formato ABC
     std::string as_abc() const noexcept;
 
+    // Altura como número MIDI (Do4 = 60), para los pases que operan sobre
+    // alturas en lugar de nombres
+    int midi_number() const noexcept;
+
+    // Reescribe la nota a partir de una altura MIDI con la grafía dada, que
+    // debe corresponder a esa altura (la octava se ajusta para Si# y Dob)
+    void set_midi_number(int midi, const NoteSpelling& spelling) noexcept;
+
+    // Calcula una sola vez el texto ABC y la validez de la nota, para un nodo
+    // compartido por muchas sentencias (ver NotePool): as_abc y resolve_names
+    // los devuelven sin volver a calcularlos
+    void freeze() noexcept;
+
 private:
     std::string note_name;
     int octave;
+
+    bool frozen{false};
+    bool valid{false};
+    std::string abc;
 };
 
-class DurationExpression : public Expression{
+class DurationExpression final : public MusicExpression{
 public:
     DurationExpression(DurationType type) noexcept;
 
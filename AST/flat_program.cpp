@@ -0,0 +1,150 @@
+#include "flat_program.hpp"
+#include "../Semantic_Analysis/symbol_table.hpp"
+#include <cmath>
+
+namespace {
+
+// Pase de representación en string
+struct ToStringVisitor {
+    std::string result;
+
+    template <typename Decl>
+    void operator()(const Decl& decl) {
+        result += "  " + decl.to_string() + "\n";
+    }
+
+    void operator()(const NoteNode& node) {
+        result += "  " + node.note.to_string() + " " + node.duration.to_string() + "\n";
+    }
+};
+
+// Pase de análisis semántico
+struct ResolveNamesVisitor {
+    SymbolTable& table;
+    bool valid{true};
+    bool declarations_checked{false};
+
+    template <typename Decl>
+    void operator()(Decl& decl) {
+        if (valid) {
+            valid = decl.resolve_names(table);
+        }
+    }
+
+    void operator()(NoteNode& node) {
+        if (!valid) {
+            return;
+        }
+
+        // Las declaraciones obligatorias se verifican una sola vez, antes de la primera nota
+        if (!declarations_checked) {
+            declarations_checked = true;
+            valid = NoteStatement::check_declarations(table);
+            if (!valid) {
+                return;
+            }
+        }
+
+        valid = node.note.resolve_names(table) && node.duration.resolve_names(table);
+    }
+};
+
+// Pase de generación de notación ABC
+struct AbcVisitor {
+    std::ostream& out;
+    double& beatCounter;
+    double bar_length{0.0};
+
+    template <typename Decl>
+    void operator()(const Decl& decl) {
+        decl.to_abc(out, beatCounter);
+    }
+
+    // El compás declarado define la rejilla de barras
+    void operator()(const TimeSignatureDeclaration& decl) {
+        bar_length = decl.bar_length();
+        decl.to_abc(out, beatCounter);
+    }
+
+    void operator()(const NoteNode& node) {
+        out << node.note.as_abc() << node.duration.abc_suffix() << " ";
+        beatCounter += node.duration.beats();
+
+        // Insertar barra de compás cuando se completa un compás
+        if (bar_length > 0.0 && std::fmod(beatCounter, bar_length) == 0.0) {
+            out << "| ";
+        }
+    }
+};
+
+} // namespace
+
+FlatProgram::FlatProgram(const MusicProgram& program) noexcept {
+    declarations.reserve(program.get_declarations().size());
+    for (const auto& decl : program.get_declarations()) {
+        if (auto tempo = dynamic_cast<const TempoDeclaration*>(decl)) {
+            declarations.emplace_back(*tempo);
+        } else if (auto time_signature = dynamic_cast<const TimeSignatureDeclaration*>(decl)) {
+            declarations.emplace_back(*time_signature);
+        } else if (auto key = dynamic_cast<const KeyDeclaration*>(decl)) {
+            declarations.emplace_back(*key);
+        }
+    }
+
+    // Las repeticiones se copian expandidas: la representación plana no tiene
+    // nodos compuestos (tampoco acordes, que se omiten)
+    notes.reserve(program.get_statements().size());
+    for (const auto& stmt : program.get_statements()) {
+        stmt->for_each_played_note([this](const SoundingStatement& sound) {
+            if (auto note = dynamic_cast<const NoteStatement*>(&sound)) {
+                notes.push_back(NoteNode{*note->get_note(), *note->get_duration()});
+            }
+        });
+    }
+}
+
+const std::vector<DeclarationNode>& FlatProgram::get_declarations() const noexcept {
+    return declarations;
+}
+
+const std::vector<NoteNode>& FlatProgram::get_notes() const noexcept {
+    return notes;
+}
+
+std::string FlatProgram::to_string() const noexcept {
+    // Mismo formato que MusicProgram::to_string()
+    ToStringVisitor visitor;
+    visitor.result = "Programa musical:\nDeclaraciones:\n";
+    for (const auto& decl : declarations) {
+        std::visit(visitor, decl);
+    }
+    visitor.result += "Sentencias:\n";
+    for (const auto& note : notes) {
+        visitor(note);
+    }
+    return visitor.result;
+}
+
+bool FlatProgram::resolve_names(SymbolTable& table) noexcept {
+    ResolveNamesVisitor visitor{table};
+    accept(visitor);
+
+    if (!visitor.valid) {
+        return false;
+    }
+
+    // Verificar que las declaraciones obligatorias existan
+    return MusicProgram::check_required_declarations(table);
+}
+
+void FlatProgram::to_abc(std::ostream& out, double& beatCounter) const noexcept {
+    // Cabecera mínima ABC
+    out << "X:1\n";
+    out << "T:Generated\n";
+
+    AbcVisitor visitor{out, beatCounter};
+    accept(visitor);
+
+    // Finalizar la partitura con una barra final
+    out << "|\n";
+}
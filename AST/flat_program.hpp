@@ -0,0 +1,62 @@
+#pragma once
+
+#include "declaration.hpp"
+#include "expression.hpp"
+#include "statement.hpp"
+#include <ostream>
+#include <string>
+#include <variant>
+#include <vector>
+
+// Declaración almacenada por valor: conjunto cerrado de alternativas,
+// despachado con std::visit en lugar de llamadas virtuales
+using DeclarationNode = std::variant<TempoDeclaration, TimeSignatureDeclaration, KeyDeclaration>;
+
+// Nota almacenada por valor, sin nodos hijos en el heap
+struct NoteNode {
+    NoteExpression note;
+    DurationExpression duration;
+};
+
+// Representación plana del programa musical: los nodos se guardan de forma
+// contigua y cada pase se escribe como un visitante cuyas llamadas se
+// resuelven en tiempo de compilación (las clases concretas son final)
+class FlatProgram {
+public:
+    // Copia las declaraciones y notas de un MusicProgram
+    explicit FlatProgram(const MusicProgram& program) noexcept;
+
+    const std::vector<DeclarationNode>& get_declarations() const noexcept;
+    const std::vector<NoteNode>& get_notes() const noexcept;
+
+    // Aplica el visitante a cada declaración y luego a cada nota, en orden.
+    // El visitante debe aceptar cada alternativa de DeclarationNode y NoteNode.
+    template <typename Visitor>
+    void accept(Visitor& visitor) {
+        for (auto& decl : declarations) {
+            std::visit(visitor, decl);
+        }
+        for (auto& note : notes) {
+            visitor(note);
+        }
+    }
+
+    template <typename Visitor>
+    void accept(Visitor& visitor) const {
+        for (const auto& decl : declarations) {
+            std::visit(visitor, decl);
+        }
+        for (const auto& note : notes) {
+            visitor(note);
+        }
+    }
+
+    // Mismos pases que MusicProgram, implementados como visitantes
+    std::string to_string() const noexcept;
+    bool resolve_names(SymbolTable& table) noexcept;
+    void to_abc(std::ostream& out, double& beatCounter) const noexcept;
+
+private:
+    std::vector<DeclarationNode> declarations;
+    std::vector<NoteNode> notes;
+};
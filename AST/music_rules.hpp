@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Reglas del lenguaje como constantes y funciones constexpr. Las usan el
+// análisis semántico del AST, la verificación rápida (validator.cpp) y el
+// parser constexpr de partituras embebidas (embedded_score.hpp), así que
+// las tres aplican los mismos rangos y la misma lista de notas.
+
+// Enumeración para el tipo de duración
+enum class DurationType {
+    SEMICORCHEA,   // Semicorchea
+    CORCHEA,       // Corchea
+    NEGRA,         // Negra
+    BLANCA         // Blanca
+};
+
+// Semicorcheas de cada duración
+constexpr int duration_ticks(DurationType duration) noexcept {
+    switch (duration) {
+        case DurationType::SEMICORCHEA: return 1;
+        case DurationType::CORCHEA: return 2;
+        case DurationType::NEGRA: return 4;
+        case DurationType::BLANCA: return 8;
+    }
+    return 2;
+}
+
+// Tempo en negras por minuto, de Larghissimo a Prestissimo
+constexpr int MIN_TEMPO = 20;
+constexpr int MAX_TEMPO = 200;
+
+constexpr bool valid_tempo(int tempo) noexcept {
+    return tempo >= MIN_TEMPO && tempo <= MAX_TEMPO;
+}
+
+// Compás: numerador de 2 a 12 y denominador 2, 4, 8 o 16
+constexpr bool valid_numerator(int numerator) noexcept {
+    return numerator > 1 && numerator <= 12;
+}
+
+constexpr bool valid_denominator(int denominator) noexcept {
+    return denominator == 2 || denominator == 4 || denominator == 8 || denominator == 16;
+}
+
+// Octavas que se pueden escribir, y sus alturas MIDI extremas (Do1 y Si8),
+// que también limitan la transposición
+constexpr int MIN_OCTAVE = 1;
+constexpr int MAX_OCTAVE = 8;
+constexpr int LOWEST_PITCH = 24;
+constexpr int HIGHEST_PITCH = 119;
+
+constexpr bool valid_octave(int octave) noexcept {
+    return octave >= MIN_OCTAVE && octave <= MAX_OCTAVE;
+}
+
+// Notas por acorde: alcanza para las dos manos del piano
+constexpr std::size_t CHORD_CAPACITY = 8;
+
+// Repeticiones de un bloque. Las salidas que no tienen repetición propia
+// (MIDI, MusicXML, el ABC que no cae en barras) escriben el cuerpo expandido,
+// así que hay un tope para la cantidad y otro para lo que dura el bloque ya
+// expandido, con las repeticiones anidadas: 2^24 semicorcheas, un millón de
+// compases de 4/4
+constexpr int MAX_REPEAT_COUNT = 100000;
+constexpr long MAX_REPEAT_TICKS = 1L << 24;
+
+constexpr bool valid_repeat_count(int count) noexcept {
+    return count >= 1 && count <= MAX_REPEAT_COUNT;
+}
+
+// Bloques (Repetir y Motivo) anidados. Los parsers, el análisis y las
+// salidas recorren los bloques de forma recursiva, así que la profundidad
+// tiene un tope que no agota la pila de ningún hilo. El parser de Bison se
+// queda sin pila antes, a los 49 niveles
+constexpr int MAX_BLOCK_DEPTH = 64;
+
+// Semitonos desde Do de cada letra, y sus nombres latinos e ingleses
+constexpr int letter_semitones[7] = {0, 2, 4, 5, 7, 9, 11};
+constexpr std::string_view letter_names[7] = {"Do", "Re", "Mi", "Fa", "Sol", "La", "Si"};
+constexpr std::string_view english_letter_names[7] = {"C", "D", "E", "F", "G", "A", "B"};
+
+// Notas aceptadas, latinas o inglesas (no incluye Mi#, Fab, E# ni Fb)
+constexpr std::string_view valid_note_names[] = {"Do", "Re", "Mi", "Fa", "Sol", "La", "Si",
+                                                 "Do#", "Re#", "Fa#", "Sol#", "La#", "Si#",
+                                                 "Dob", "Reb", "Mib", "Solb", "Lab", "Sib",
+                                                 "C", "D", "E", "F", "G", "A", "B",
+                                                 "Cb", "Db", "Eb", "Gb", "Ab", "Bb",
+                                                 "C#", "D#", "F#", "G#", "A#", "B#"
+                                                 };
+
+constexpr bool valid_note_name(std::string_view note_name) noexcept {
+    for (const auto& note : valid_note_names) {
+        if (note_name == note) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Nombre de nota descompuesto en letra (0 = Do, ..., 6 = Si) y alteración
+// (-1 bemol, 0 natural, +1 sostenido)
+struct NoteSpelling {
+    int letter;
+    int accidental;
+
+    // Semitonos desde Do; Dob da -1 y Si# da 12
+    constexpr int semitones() const noexcept {
+        return letter_semitones[letter] + accidental;
+    }
+
+    // Nombre latino ("Sol#", "Sib")
+    std::string name() const noexcept;
+};
+
+// Descompone un nombre de nota latino o inglés ("Sol#", "Bb"); devuelve
+// false si el nombre no tiene esa forma
+constexpr bool spell_note_name(std::string_view note_name, NoteSpelling& spelling) noexcept {
+    for (int letter = 0; letter < 7; ++letter) {
+        for (std::string_view base : {letter_names[letter], english_letter_names[letter]}) {
+            if (note_name.substr(0, base.size()) != base || note_name.size() > base.size() + 1) {
+                continue;
+            }
+
+            char accidental = (note_name.size() > base.size()) ? note_name[base.size()] : '\0';
+            if (accidental == '\0' || accidental == '#' || accidental == 'b') {
+                spelling.letter = letter;
+                spelling.accidental = (accidental == '#') ? 1 : (accidental == 'b' ? -1 : 0);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Altura MIDI de una nota ya verificada (Do4 = 60)
+constexpr int pitch_number(const NoteSpelling& spelling, int octave) noexcept {
+    return 12 * (octave + 1) + spelling.semitones();
+}
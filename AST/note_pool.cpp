@@ -0,0 +1,55 @@
+#include "note_pool.hpp"
+#include "statement.hpp"
+#include <ostream>
+
+double NotePoolStats::dedupe_ratio() const noexcept {
+    std::size_t unique = unique_notes + unique_durations;
+    return (unique > 0) ? 2.0 * static_cast<double>(notes) / static_cast<double>(unique) : 0.0;
+}
+
+NotePool::NotePool() noexcept
+    : durations{{DurationExpression{DurationType::SEMICORCHEA}, DurationExpression{DurationType::CORCHEA},
+                 DurationExpression{DurationType::NEGRA}, DurationExpression{DurationType::BLANCA}}} {}
+
+NotePool::~NotePool() noexcept {
+    for (auto& entry : notes) {
+        entry.second->destroy();
+        delete entry.second;
+    }
+}
+
+NoteExpression* NotePool::note(const std::string& note_name, int octave) noexcept {
+    NoteExpression*& node = notes[note_name + std::to_string(octave)];
+    if (node == nullptr) {
+        node = new NoteExpression(note_name, octave);
+        node->freeze();
+    }
+    return node;
+}
+
+DurationExpression* NotePool::duration(DurationType type) noexcept {
+    std::size_t index = static_cast<std::size_t>(type);
+    used_durations[index] = true;
+    return &durations[index];
+}
+
+NoteStatement* NotePool::make_note(const std::string& note_name, int octave, DurationType type) noexcept {
+    ++created;
+    return new NoteStatement(note(note_name, octave), duration(type), this);
+}
+
+NotePoolStats NotePool::stats() const noexcept {
+    NotePoolStats result;
+    result.notes = created;
+    result.unique_notes = notes.size();
+    for (bool used : used_durations) {
+        result.unique_durations += used ? 1 : 0;
+    }
+    return result;
+}
+
+void writeNotePoolStats(std::ostream& out, const NotePoolStats& stats) noexcept {
+    out << "Notas compartidas: " << stats.notes << " notas con " << stats.unique_notes
+        << " alturas y " << stats.unique_durations << " duraciones distintas (x"
+        << stats.dedupe_ratio() << " menos nodos)\n";
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "expression.hpp"
+#include <array>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+
+class NoteStatement;
+
+// Estadísticas de un NotePool
+struct NotePoolStats {
+    std::size_t notes{0};              // Sentencias creadas con make_note
+    std::size_t unique_notes{0};       // Alturas distintas (nombre y octava)
+    std::size_t unique_durations{0};   // Duraciones distintas
+
+    // Nodos que se habrían creado sin compartir (una nota y una duración por
+    // sentencia) por cada nodo compartido
+    double dedupe_ratio() const noexcept;
+};
+
+// Fábrica de nodos de nota compartidos (hash-consing): una partitura generada
+// repite unas pocas combinaciones de altura y duración en millones de notas,
+// así que en lugar de un NoteExpression y un DurationExpression por sentencia
+// guarda uno por valor distinto, inmutable, con su texto ABC y su validez
+// calculados una vez (ver NoteExpression::freeze).
+//
+// Los nodos viven hasta que se destruye el pool, que debe vivir más que las
+// sentencias que los usan (MusicProgram lo comparte con un std::shared_ptr).
+// Agregar notas no es seguro entre hilos; leer los nodos entregados sí.
+class NotePool {
+public:
+    NotePool() noexcept;
+    ~NotePool() noexcept;
+
+    NotePool(const NotePool&) = delete;
+    NotePool& operator=(const NotePool&) = delete;
+
+    // Nodo compartido para la nota y para la duración. Las sentencias no los
+    // modifican: NoteStatement toma otro al transponerse
+    NoteExpression* note(const std::string& note_name, int octave) noexcept;
+    DurationExpression* duration(DurationType type) noexcept;
+
+    // Sentencia de nota con los nodos compartidos; el llamador la libera
+    NoteStatement* make_note(const std::string& note_name, int octave, DurationType type) noexcept;
+
+    NotePoolStats stats() const noexcept;
+
+private:
+    std::unordered_map<std::string, NoteExpression*> notes;   // Clave: nombre y octava ("Sol#4")
+    std::array<DurationExpression, 4> durations;
+    std::array<bool, 4> used_durations{};
+    std::size_t created{0};
+};
+
+// Escribe las estadísticas en una línea, para --tiempo
+void writeNotePoolStats(std::ostream& out, const NotePoolStats& stats) noexcept;
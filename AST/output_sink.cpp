@@ -0,0 +1,615 @@
+#include "output_sink.hpp"
+#include "declaration.hpp"
+#include "tempo_map.hpp"
+#include "voice.hpp"
+#include <charconv>
+#include <cstdint>
+#include <ostream>
+
+// Implementación de OutputSink: por defecto una salida ignora lo que no usa
+bool OutputSink::uses_notes() const noexcept {
+    return false;
+}
+
+void OutputSink::statement(std::size_t /*track*/, const Statement& /*statement*/) noexcept {}
+
+void OutputSink::note(std::size_t /*track*/, const TimedNote& /*note*/) noexcept {}
+
+void OutputSink::end_track(std::size_t /*track*/) noexcept {}
+
+static bool has_extension(const std::string& file_name, const std::string& extension) noexcept {
+    return file_name.size() > extension.size() &&
+           file_name.compare(file_name.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+// Identificador C a partir del nombre del archivo, sin directorio ni
+// extensión: "partituras/valid-test.h" da "valid_test"
+static std::string c_identifier(const std::string& file_name) noexcept {
+    std::size_t start = file_name.find_last_of("/\\");
+    start = (start == std::string::npos) ? 0 : start + 1;
+    std::size_t end = file_name.find_last_of('.');
+    end = (end == std::string::npos || end < start) ? file_name.size() : end;
+
+    std::string identifier;
+    for (std::size_t i = start; i < end; ++i) {
+        char c = file_name[i];
+        bool alphanumeric = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+        identifier += alphanumeric ? c : '_';
+    }
+    if (identifier.empty() || (identifier[0] >= '0' && identifier[0] <= '9')) {
+        identifier = "partitura_" + identifier;
+    }
+    return identifier;
+}
+
+OutputSink* make_output_sink(const std::string& file_name) noexcept {
+    if (has_extension(file_name, ".abc")) {
+        return new AbcSink();
+    }
+    if (has_extension(file_name, ".txt")) {
+        return new TextSink();
+    }
+    if (has_extension(file_name, ".mid") || has_extension(file_name, ".midi")) {
+        return new MidiSink();
+    }
+    if (has_extension(file_name, ".json")) {
+        return new JsonSink();
+    }
+    if (has_extension(file_name, ".h") || has_extension(file_name, ".hpp")) {
+        return new CppHeaderSink(c_identifier(file_name));
+    }
+    return nullptr;
+}
+
+// Implementación de EmissionPass
+
+// Sentencias por lote, como PASS_BLOCK en PassManager. Una repetición
+// puede sonar millones de notas, así que el lote también se entrega al
+// juntar EMISSION_NOTES notas, aunque sea en medio de una sentencia
+static constexpr std::size_t EMISSION_BATCH = 256;
+static constexpr std::size_t EMISSION_NOTES = 4096;
+
+void EmissionPass::add(OutputSink* sink) noexcept {
+    if (sink != nullptr) {
+        sinks.push_back(sink);
+    }
+}
+
+const char* EmissionPass::name() const noexcept {
+    return "emitir";
+}
+
+PassAccess EmissionPass::access() const noexcept {
+    return PassAccess{PASS_HEADER | PASS_SYMBOLS | PASS_PITCHES | PASS_TEMPO_MAP, 0, 0};
+}
+
+bool EmissionPass::begin(MusicProgram& program) noexcept {
+    tempo_map = program.get_tempo_map().empty() ? nullptr : &program.get_tempo_map();
+    voices = !program.get_voices().empty();
+    cursor = Cursor{};
+    batch.statements.clear();
+    batch.notes.clear();
+    note_sinks.clear();
+    for (const auto& sink : sinks) {
+        sink->begin(program);
+        if (sink->uses_notes()) {
+            note_sinks.push_back(sink);
+        }
+    }
+    return true;
+}
+
+bool EmissionPass::visit(Statement& statement) noexcept {
+    emit(0, statement, cursor, batch);
+    return true;
+}
+
+bool EmissionPass::finish(MusicProgram& program) noexcept {
+    flush(0, batch);
+    for (const auto& sink : sinks) {
+        sink->end_track(0);
+    }
+
+    const std::vector<MusicVoice*>& program_voices = program.get_voices();
+    parallel_for_each_index(program_voices.size(), [&](std::size_t i) {
+        Cursor voice_cursor;
+        Batch voice_batch;
+        for (const auto& stmt : program_voices[i]->get_statements()) {
+            emit(i + 1, *stmt, voice_cursor, voice_batch);
+        }
+        flush(i + 1, voice_batch);
+        for (const auto& sink : sinks) {
+            sink->end_track(i + 1);
+        }
+    });
+    return true;
+}
+
+void EmissionPass::emit(std::size_t track, const Statement& statement, Cursor& position,
+                        Batch& pending) const noexcept {
+    pending.statements.push_back(&statement);
+    if (!note_sinks.empty() && (track != 0 || !voices)) {
+        // Una sola referencia capturada: cabe en std::function sin reservar memoria
+        struct Timeline {
+            const EmissionPass& pass;
+            std::size_t track;
+            Cursor& position;
+            Batch& pending;
+        } timeline{*this, track, position, pending};
+        statement.for_each_played_note([&timeline](const SoundingStatement& note) {
+            Cursor& position = timeline.position;
+            const TempoMap* tempo_map = timeline.pass.tempo_map;
+            TimedNote timed{&note, position.tick, TempoMap::ticks_from_beats(note.played_beats()), 0.0, 0};
+            if (tempo_map != nullptr) {
+                position.segment = tempo_map->next_segment_index(position.tick, position.segment);
+                timed.seconds = tempo_map->tick_to_seconds(position.tick, position.segment);
+                timed.measure = tempo_map->tick_to_measure(position.tick, position.segment);
+            }
+            position.tick += timed.ticks;
+            timeline.pending.notes.push_back(timed);
+            if (timeline.pending.notes.size() == EMISSION_NOTES) {
+                timeline.pass.flush(timeline.track, timeline.pending);
+            }
+        });
+    }
+    if (pending.statements.size() >= EMISSION_BATCH) {
+        flush(track, pending);
+    }
+}
+
+void EmissionPass::flush(std::size_t track, Batch& pending) const noexcept {
+    for (const auto& sink : sinks) {
+        for (const Statement* stmt : pending.statements) {
+            sink->statement(track, *stmt);
+        }
+    }
+    for (const auto& sink : note_sinks) {
+        for (const TimedNote& note : pending.notes) {
+            sink->note(track, note);
+        }
+    }
+    pending.statements.clear();
+    pending.notes.clear();
+}
+
+// Implementación de AbcSink
+const char* AbcSink::description() const noexcept {
+    return "Notación ABC";
+}
+
+void AbcSink::begin(const MusicProgram& program) noexcept {
+    const std::vector<MusicVoice*>& program_voices = program.get_voices();
+    voices = !program_voices.empty();
+    header.str("");
+    tracks = std::vector<std::ostringstream>(program_voices.size() + 1);
+    states.assign(program_voices.size() + 1, AbcBarState{});
+    beats.assign(program_voices.size() + 1, 0.0);
+
+    double beat = 0.0;
+    program.write_abc_header(header, beat);
+    if (!voices) {
+        program.start_abc_statements(states[0]);
+        return;
+    }
+
+    // Como write_abc_voices: el tempo lo escribe la primera voz
+    const TempoMap* map = program.get_tempo_map().empty() ? nullptr : &program.get_tempo_map();
+    for (std::size_t i = 0; i < program_voices.size(); ++i) {
+        tracks[i + 1] << "V:" << program_voices[i]->get_name() << "\n";
+        states[i + 1] = AbcBarState{program.bar_length()};
+        start_abc_bars(states[i + 1], map, i == 0);
+    }
+}
+
+void AbcSink::statement(std::size_t track, const Statement& statement) noexcept {
+    if (track != 0 || !voices) {
+        statement.to_abc_on_grid(tracks[track], beats[track], states[track]);
+    }
+}
+
+void AbcSink::end_track(std::size_t track) noexcept {
+    if (track != 0 || !voices) {
+        finish_abc_bars(tracks[track], states[track]);
+    }
+}
+
+void AbcSink::write(std::ostream& out) const noexcept {
+    out << header.str();
+    for (const auto& track : tracks) {
+        out << track.str();
+    }
+}
+
+// Implementación de TextSink
+const char* TextSink::description() const noexcept {
+    return "Representación del programa";
+}
+
+void TextSink::begin(const MusicProgram& program) noexcept {
+    header = program.header_to_string();
+    tracks.assign(program.get_voices().size() + 1, std::string{});
+    names.clear();
+    for (const auto& voice : program.get_voices()) {
+        names.push_back(voice->get_name());
+    }
+}
+
+void TextSink::statement(std::size_t track, const Statement& statement) noexcept {
+    tracks[track] += (track == 0 ? "  " : "    ") + statement.to_string() + "\n";
+}
+
+void TextSink::write(std::ostream& out) const noexcept {
+    out << header << tracks[0];
+    if (names.empty()) {
+        return;
+    }
+
+    // Como voices_to_string
+    out << "Voces:\n";
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        out << "  Voz " << names[i] << ":\n" << tracks[i + 1];
+    }
+}
+
+// Implementación de MidiSink
+
+// Divisiones por negra del archivo: cada semicorchea son 120
+static constexpr long MIDI_DIVISION = 480;
+static constexpr long MIDI_TICKS_PER_TICK = MIDI_DIVISION / 4;
+static constexpr int MIDI_VELOCITY = 80;
+
+static void write_variable_length(std::string& out, unsigned long value) noexcept {
+    unsigned char bytes[5];
+    int count = 0;
+    do {
+        bytes[count++] = static_cast<unsigned char>(value & 0x7F);
+        value >>= 7;
+    } while (value != 0);
+    while (count > 1) {
+        out += static_cast<char>(bytes[--count] | 0x80);
+    }
+    out += static_cast<char>(bytes[0]);
+}
+
+static void write_big_endian(std::string& out, std::uint32_t value, int bytes) noexcept {
+    for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+        out += static_cast<char>((value >> shift) & 0xFF);
+    }
+}
+
+static void write_chunk(std::ostream& out, const char* type, const std::string& data) noexcept {
+    std::string length;
+    write_big_endian(length, static_cast<std::uint32_t>(data.size()), 4);
+    out.write(type, 4);
+    out << length << data;
+}
+
+static void write_meta_event(std::string& out, unsigned char type, const std::string& data) noexcept {
+    out += static_cast<char>(0xFF);
+    out += static_cast<char>(type);
+    write_variable_length(out, data.size());
+    out += data;
+}
+
+const char* MidiSink::description() const noexcept {
+    return "Secuencia MIDI";
+}
+
+bool MidiSink::uses_notes() const noexcept {
+    return true;
+}
+
+void MidiSink::begin(const MusicProgram& program) noexcept {
+    voices = !program.get_voices().empty();
+    tracks.assign(program.get_voices().size() + 1, Track{});
+
+    // Pista de tempo: un evento por tramo del mapa
+    tempo_track.clear();
+    long last_tick = 0;
+    for (const auto& segment : program.get_tempo_map().get_segments()) {
+        write_variable_length(tempo_track, (segment.tick - last_tick) * MIDI_TICKS_PER_TICK);
+        last_tick = segment.tick;
+
+        std::string tempo;
+        write_big_endian(tempo, static_cast<std::uint32_t>(60000000L / segment.tempo), 3);
+        write_meta_event(tempo_track, 0x51, tempo);
+
+        int exponent = 0;
+        while ((1 << exponent) < segment.denominator) {
+            ++exponent;
+        }
+        std::string meter{static_cast<char>(segment.numerator), static_cast<char>(exponent), 24, 8};
+        write_variable_length(tempo_track, 0);
+        write_meta_event(tempo_track, 0x58, meter);
+    }
+    write_variable_length(tempo_track, 0);
+    write_meta_event(tempo_track, 0x2F, "");
+
+    // Cada voz con su nombre y su canal, sin el 10 (percusión)
+    for (std::size_t i = 0; i < program.get_voices().size(); ++i) {
+        Track& track = tracks[i + 1];
+        track.channel = static_cast<int>((i < 9 ? i : i + 1) % 16);
+        write_variable_length(track.events, 0);
+        write_meta_event(track.events, 0x03, program.get_voices()[i]->get_name());
+    }
+}
+
+void MidiSink::event(Track& track, long tick) const noexcept {
+    write_variable_length(track.events, (tick - track.last_tick) * MIDI_TICKS_PER_TICK);
+    track.last_tick = tick;
+}
+
+void MidiSink::release(Track& track) const noexcept {
+    for (int pitch : track.sounding) {
+        event(track, track.sounding_end);
+        track.events += static_cast<char>(0x80 | track.channel);
+        track.events += static_cast<char>(pitch);
+        track.events += static_cast<char>(0);
+    }
+    track.sounding.clear();
+}
+
+void MidiSink::note(std::size_t index, const TimedNote& note) noexcept {
+    Track& track = tracks[index];
+    release(track);
+    for (std::size_t i = 0; i < note.note->pitch_count(); ++i) {
+        int pitch = note.note->pitch_midi_number(i);
+        event(track, note.tick);
+        track.events += static_cast<char>(0x90 | track.channel);
+        track.events += static_cast<char>(pitch);
+        track.events += static_cast<char>(MIDI_VELOCITY);
+        track.sounding.push_back(pitch);
+    }
+    track.sounding_end = note.tick + note.ticks;
+}
+
+void MidiSink::end_track(std::size_t index) noexcept {
+    Track& track = tracks[index];
+    release(track);
+    write_variable_length(track.events, 0);
+    write_meta_event(track.events, 0x2F, "");
+}
+
+void MidiSink::write(std::ostream& out) const noexcept {
+    // Con voces, la pista 0 (las sentencias de nivel superior) no suena
+    std::size_t first = voices ? 1 : 0;
+
+    std::string header;
+    write_big_endian(header, 1, 2);
+    write_big_endian(header, static_cast<std::uint32_t>(tracks.size() - first + 1), 2);
+    write_big_endian(header, MIDI_DIVISION, 2);
+    write_chunk(out, "MThd", header);
+    write_chunk(out, "MTrk", tempo_track);
+    for (std::size_t i = first; i < tracks.size(); ++i) {
+        write_chunk(out, "MTrk", tracks[i].events);
+    }
+}
+
+// Implementación de JsonSink
+
+// String entre comillas, para JSON y C: los nombres de las voces son
+// identificadores, pero por las dudas
+static std::string quote_string(const std::string& text) noexcept {
+    std::string result = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+        }
+        result += c;
+    }
+    return result + "\"";
+}
+
+// Números con to_chars: el double más corto que se vuelve a leer igual
+template <typename Number>
+static void append_number(std::string& out, Number value) noexcept {
+    char digits[32];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+const char* JsonSink::description() const noexcept {
+    return "Línea de tiempo JSON";
+}
+
+bool JsonSink::uses_notes() const noexcept {
+    return true;
+}
+
+void JsonSink::begin(const MusicProgram& program) noexcept {
+    voices = !program.get_voices().empty();
+    tracks.assign(program.get_voices().size() + 1, std::string{});
+    names.assign(1, "");
+    for (const auto& voice : program.get_voices()) {
+        names.push_back(voice->get_name());
+    }
+
+    tempo.clear();
+    const TempoMap& map = program.get_tempo_map();
+    for (const auto& segment : map.get_segments()) {
+        tempo += tempo.empty() ? "\n    {\"tick\": " : ",\n    {\"tick\": ";
+        append_number(tempo, segment.tick);
+        tempo += ", \"seconds\": ";
+        append_number(tempo, segment.seconds);
+        tempo += ", \"tempo\": ";
+        append_number(tempo, segment.tempo);
+        tempo += ", \"numerator\": ";
+        append_number(tempo, segment.numerator);
+        tempo += ", \"denominator\": ";
+        append_number(tempo, segment.denominator);
+        tempo += ", \"measure\": ";
+        append_number(tempo, map.tick_to_measure(segment.tick));
+        tempo += "}";
+    }
+}
+
+void JsonSink::note(std::size_t track, const TimedNote& note) noexcept {
+    std::string& out = tracks[track];
+    out += out.empty() ? "\n      {\"measure\": " : ",\n      {\"measure\": ";
+    append_number(out, note.measure);
+    out += ", \"tick\": ";
+    append_number(out, note.tick);
+    out += ", \"duration\": ";
+    append_number(out, note.ticks);
+    out += ", \"seconds\": ";
+    append_number(out, note.seconds);
+    out += ", \"pitches\": [";
+    for (std::size_t i = 0; i < note.note->pitch_count(); ++i) {
+        if (i > 0) {
+            out += ", ";
+        }
+        append_number(out, note.note->pitch_midi_number(i));
+    }
+    out += "]}";
+}
+
+void JsonSink::write(std::ostream& out) const noexcept {
+    out << "{\n  \"tempo\": [" << tempo << "\n  ],\n  \"voices\": [";
+    const char* separator = "";
+    for (std::size_t i = voices ? 1 : 0; i < tracks.size(); ++i) {
+        out << separator << "\n    {\"voice\": " << quote_string(names[i]) << ", \"notes\": ["
+            << tracks[i] << "\n    ]}";
+        separator = ",";
+    }
+    out << "\n  ]\n}\n";
+}
+
+// Implementación de CppHeaderSink
+
+// Tipos comunes a todas las cabeceras generadas: una sola definición aunque
+// se incluyan varias partituras
+static const char* CPP_HEADER_TYPES =
+    "#ifndef MUS_SCORE_TYPES\n"
+    "#define MUS_SCORE_TYPES\n"
+    "\n"
+    "#ifdef __cplusplus\n"
+    "#define MUS_CONST constexpr\n"
+    "#else\n"
+    "#define MUS_CONST static const\n"
+    "#endif\n"
+    "\n"
+    "/* Nota: comienzo y duración en semicorcheas (4 por negra), altura MIDI\n"
+    "   (Do4 = 60) y voz. Las notas de un acorde son eventos con el mismo tick */\n"
+    "typedef struct {\n"
+    "    uint32_t tick;\n"
+    "    uint16_t length;\n"
+    "    uint8_t pitch;\n"
+    "    uint8_t voice;\n"
+    "} mus_note;\n"
+    "\n"
+    "/* Tramo con un mismo tempo (negras por minuto) y un mismo compás */\n"
+    "typedef struct {\n"
+    "    uint32_t tick;\n"
+    "    uint16_t tempo;\n"
+    "    uint8_t numerator;\n"
+    "    uint8_t denominator;\n"
+    "} mus_tempo_change;\n"
+    "\n"
+    "#endif\n";
+
+CppHeaderSink::CppHeaderSink(const std::string& prefix) noexcept
+    : prefix{prefix} {}
+
+const char* CppHeaderSink::description() const noexcept {
+    return "Cabecera C/C++";
+}
+
+bool CppHeaderSink::uses_notes() const noexcept {
+    return true;
+}
+
+void CppHeaderSink::begin(const MusicProgram& program) noexcept {
+    voices = !program.get_voices().empty();
+    tracks.assign(program.get_voices().size() + 1, std::string{});
+    counts.assign(program.get_voices().size() + 1, 0);
+    names.assign(1, "");
+    for (const auto& voice : program.get_voices()) {
+        names.push_back(voice->get_name());
+    }
+
+    // El tempo y el compás de la cabecera, y los tramos del mapa
+    const std::vector<TempoSegment>& segments = program.get_tempo_map().get_segments();
+    constants.clear();
+    if (!segments.empty()) {
+        constants += "MUS_CONST uint16_t " + prefix + "_tempo = ";
+        append_number(constants, segments.front().tempo);
+        constants += ";\nMUS_CONST uint8_t " + prefix + "_numerator = ";
+        append_number(constants, segments.front().numerator);
+        constants += ";\nMUS_CONST uint8_t " + prefix + "_denominator = ";
+        append_number(constants, segments.front().denominator);
+        constants += ";\n\n";
+    }
+
+    constants += "MUS_CONST uint32_t " + prefix + "_tempo_change_count = ";
+    append_number(constants, segments.size());
+    constants += ";\nMUS_CONST mus_tempo_change " + prefix + "_tempo_changes[] = {\n";
+    for (const auto& segment : segments) {
+        constants += "    {";
+        append_number(constants, segment.tick);
+        constants += ", ";
+        append_number(constants, segment.tempo);
+        constants += ", ";
+        append_number(constants, segment.numerator);
+        constants += ", ";
+        append_number(constants, segment.denominator);
+        constants += "},\n";
+    }
+    if (segments.empty()) {
+        constants += "    {0, 0, 0, 0},\n";
+    }
+    constants += "};\n";
+}
+
+void CppHeaderSink::note(std::size_t track, const TimedNote& note) noexcept {
+    // Las voces se numeran desde 0; sin voces, todo es la voz 0
+    std::size_t voice = voices ? track - 1 : 0;
+    std::string& out = tracks[track];
+    for (std::size_t i = 0; i < note.note->pitch_count(); ++i) {
+        out += "    {";
+        append_number(out, note.tick);
+        out += ", ";
+        append_number(out, note.ticks);
+        out += ", ";
+        append_number(out, note.note->pitch_midi_number(i));
+        out += ", ";
+        append_number(out, voice);
+        out += "},\n";
+    }
+    counts[track] += note.note->pitch_count();
+}
+
+void CppHeaderSink::write(std::ostream& out) const noexcept {
+    std::string guard;
+    for (char c : prefix) {
+        guard += (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+    }
+    guard += "_MUS_H";
+
+    std::size_t first = voices ? 1 : 0;
+    std::size_t note_count = 0;
+    for (std::size_t i = first; i < counts.size(); ++i) {
+        note_count += counts[i];
+    }
+
+    out << "/* Generado por compilador_musical a partir de una partitura .mus: no editar */\n"
+        << "#ifndef " << guard << "\n#define " << guard << "\n\n#include <stdint.h>\n\n"
+        << CPP_HEADER_TYPES << "\n" << constants << "\n";
+
+    out << "MUS_CONST uint32_t " << prefix << "_voice_count = " << (voices ? names.size() - 1 : 1) << ";\n"
+        << "MUS_CONST char const* const " << prefix << "_voice_names[] = {";
+    for (std::size_t i = first; i < names.size(); ++i) {
+        out << (i == first ? "" : ", ") << quote_string(names[i]);
+    }
+    out << "};\n\n";
+
+    // C no admite arreglos vacíos: sin notas queda un evento nulo y la cuenta en 0
+    out << "MUS_CONST uint32_t " << prefix << "_note_count = " << note_count << ";\n"
+        << "MUS_CONST mus_note " << prefix << "_notes[] = {\n";
+    for (std::size_t i = first; i < tracks.size(); ++i) {
+        out << tracks[i];
+    }
+    if (note_count == 0) {
+        out << "    {0, 0, 0, 0},\n";
+    }
+    out << "};\n\n#endif\n";
+}
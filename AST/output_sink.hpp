@@ -0,0 +1,205 @@
+#pragma once
+
+#include "pass_manager.hpp"
+#include "statement.hpp"
+#include <cstddef>
+#include <iosfwd>
+#include <sstream>
+#include <string>
+#include <vector>
+
+class TempoMap;
+
+// Nota de la línea de tiempo que arma EmissionPass, una sola vez para todas
+// las salidas
+struct TimedNote {
+    const SoundingStatement* note;   // Alturas y duración, ya transpuestas
+    long tick;                       // Comienzo, en semicorcheas desde el inicio de la voz
+    long ticks;                      // Duración en semicorcheas
+    double seconds;                  // Comienzo en segundos, con los cambios de tempo
+    long measure;                    // Compás, desde 1
+};
+
+// Formato de salida de EmissionPass. Las pistas son las sentencias de nivel
+// superior (pista 0) y las voces (pista i + 1 para la voz i); en un programa
+// con voces, las de nivel superior no suenan y la pista 0 no recibe notas.
+// Las pistas se emiten en paralelo, así que cada salida lleva un buffer por
+// pista y solo los junta en write. Las sentencias y las notas de una pista
+// llegan en orden, por lotes: primero las sentencias de un lote y después
+// las notas que suenan en ellas.
+class OutputSink {
+public:
+    virtual ~OutputSink() noexcept = default;
+
+    // Lo que escribe, para el mensaje al terminar ("Notación ABC")
+    virtual const char* description() const noexcept = 0;
+
+    // Si usa las notas de la línea de tiempo; si ninguna salida las usa,
+    // EmissionPass no la arma
+    virtual bool uses_notes() const noexcept;
+
+    // Antes del recorrido, con el programa ya validado
+    virtual void begin(const MusicProgram& program) noexcept = 0;
+
+    // Cada sentencia de una pista y cada nota que suena en ella
+    virtual void statement(std::size_t track, const Statement& statement) noexcept;
+    virtual void note(std::size_t track, const TimedNote& note) noexcept;
+    virtual void end_track(std::size_t track) noexcept;
+
+    // Escribe la salida completa, después del recorrido
+    virtual void write(std::ostream& out) const noexcept = 0;
+};
+
+// Salida según la extensión del archivo: .abc, .txt (to_string), .mid,
+// .json o .h/.hpp. nullptr si la extensión no es ninguna de esas; el
+// llamador la libera
+OutputSink* make_output_sink(const std::string& file_name) noexcept;
+
+// Pase que recorre el programa una sola vez para todas las salidas: arma la
+// línea de tiempo de cada pista (posición, segundos y compás de cada nota
+// que suena) y entrega cada sentencia y cada nota a todas. Las voces se
+// emiten en finish, cada una en su propio hilo.
+//
+// Entregar cada nota a todas las salidas antes de pasar a la siguiente
+// alterna el código de cuatro codificadores por nota, y así el recorrido
+// único era más lento que un recorrido por formato (x0.91 en bench_passes
+// con -O2). Por eso las sentencias y las notas se juntan en lotes de
+// EMISSION_BATCH sentencias y cada salida procesa el lote entero antes que
+// la siguiente, como los bloques de PassManager; las notas van solo a las
+// salidas que las usan.
+class EmissionPass final : public ProgramPass {
+public:
+    // Agrega una salida; el pase no la libera
+    void add(OutputSink* sink) noexcept;
+
+    const char* name() const noexcept override;
+    PassAccess access() const noexcept override;
+    bool begin(MusicProgram& program) noexcept override;
+    bool visit(Statement& statement) noexcept override;
+    bool finish(MusicProgram& program) noexcept override;
+
+private:
+    // Posición de una pista en la línea de tiempo
+    struct Cursor {
+        long tick{0};
+        std::size_t segment{0};   // Tramo del mapa de tempo vigente en tick
+    };
+
+    // Sentencias de una pista y notas que suenan en ellas, aún sin entregar
+    struct Batch {
+        std::vector<const Statement*> statements;
+        std::vector<TimedNote> notes;
+    };
+
+    void emit(std::size_t track, const Statement& statement, Cursor& cursor, Batch& batch) const noexcept;
+    void flush(std::size_t track, Batch& batch) const noexcept;
+
+    std::vector<OutputSink*> sinks;
+    std::vector<OutputSink*> note_sinks;
+    const TempoMap* tempo_map{nullptr};
+    bool voices{false};
+    Cursor cursor;
+    Batch batch;
+};
+
+// to_abc: el mismo texto que MusicProgram::to_abc
+class AbcSink final : public OutputSink {
+public:
+    const char* description() const noexcept override;
+    void begin(const MusicProgram& program) noexcept override;
+    void statement(std::size_t track, const Statement& statement) noexcept override;
+    void end_track(std::size_t track) noexcept override;
+    void write(std::ostream& out) const noexcept override;
+
+private:
+    std::ostringstream header;
+    std::vector<std::ostringstream> tracks;
+    std::vector<AbcBarState> states;
+    std::vector<double> beats;
+    bool voices{false};
+};
+
+// to_string: el mismo texto que MusicProgram::to_string
+class TextSink final : public OutputSink {
+public:
+    const char* description() const noexcept override;
+    void begin(const MusicProgram& program) noexcept override;
+    void statement(std::size_t track, const Statement& statement) noexcept override;
+    void write(std::ostream& out) const noexcept override;
+
+private:
+    std::string header;
+    std::vector<std::string> tracks;
+    std::vector<std::string> names;
+};
+
+// Standard MIDI File de formato 1: una pista con los cambios de tempo y de
+// compás del mapa y una pista por voz, con su nombre y su propio canal
+class MidiSink final : public OutputSink {
+public:
+    const char* description() const noexcept override;
+    bool uses_notes() const noexcept override;
+    void begin(const MusicProgram& program) noexcept override;
+    void note(std::size_t track, const TimedNote& note) noexcept override;
+    void end_track(std::size_t track) noexcept override;
+    void write(std::ostream& out) const noexcept override;
+
+private:
+    // Eventos de una pista; las notas de una voz no se superponen, así que
+    // cada nota apaga la anterior antes de sonar
+    struct Track {
+        std::string events;
+        long last_tick{0};
+        int channel{0};
+        std::vector<int> sounding;   // Alturas de la nota anterior, todavía encendidas
+        long sounding_end{0};
+    };
+
+    void event(Track& track, long tick) const noexcept;
+    void release(Track& track) const noexcept;
+
+    std::string tempo_track;
+    std::vector<Track> tracks;
+    bool voices{false};
+};
+
+// Línea de tiempo en JSON: los tramos del mapa de tempo y las notas de cada
+// voz con su compás, posición, duración, segundos y alturas MIDI
+class JsonSink final : public OutputSink {
+public:
+    const char* description() const noexcept override;
+    bool uses_notes() const noexcept override;
+    void begin(const MusicProgram& program) noexcept override;
+    void note(std::size_t track, const TimedNote& note) noexcept override;
+    void write(std::ostream& out) const noexcept override;
+
+private:
+    std::string tempo;
+    std::vector<std::string> tracks;
+    std::vector<std::string> names;
+    bool voices{false};
+};
+
+// Cabecera C/C++ con la partitura como datos: un arreglo constexpr (static
+// const en C) de eventos de nota empaquetados y las constantes de tempo y de
+// compás, para enlazarla sin analizar nada ni usar el heap al ejecutar. Los
+// nombres llevan el prefijo dado (un identificador C). La salida depende solo
+// de la partitura, así que dos compilaciones escriben los mismos bytes
+class CppHeaderSink final : public OutputSink {
+public:
+    explicit CppHeaderSink(const std::string& prefix) noexcept;
+
+    const char* description() const noexcept override;
+    bool uses_notes() const noexcept override;
+    void begin(const MusicProgram& program) noexcept override;
+    void note(std::size_t track, const TimedNote& note) noexcept override;
+    void write(std::ostream& out) const noexcept override;
+
+private:
+    std::string prefix;
+    std::string constants;
+    std::vector<std::string> tracks;
+    std::vector<std::size_t> counts;
+    std::vector<std::string> names;
+    bool voices{false};
+};
@@ -0,0 +1,105 @@
+#include "pass_manager.hpp"
+#include "declaration.hpp"
+#include <algorithm>
+#include <chrono>
+#include <ostream>
+
+// Sentencias por bloque: los punteros y los nodos que visitan los pases de
+// un recorrido caben en la caché mientras todos pasan por el bloque
+static constexpr std::size_t PASS_BLOCK = 256;
+
+using PassClock = std::chrono::steady_clock;
+
+static double elapsed_ms(PassClock::time_point start) noexcept {
+    return std::chrono::duration<double, std::milli>(PassClock::now() - start).count();
+}
+
+bool ProgramPass::begin(MusicProgram& /*program*/) noexcept {
+    return true;
+}
+
+bool ProgramPass::finish(MusicProgram& /*program*/) noexcept {
+    return true;
+}
+
+void PassManager::add(ProgramPass* pass) noexcept {
+    if (pass != nullptr) {
+        passes.push_back(pass);
+    }
+}
+
+std::vector<std::vector<ProgramPass*>> PassManager::plan() const noexcept {
+    std::vector<std::vector<ProgramPass*>> groups;
+    unsigned reads = 0;
+    unsigned completes = 0;
+    for (const auto& pass : passes) {
+        PassAccess access = pass->access();
+        if (groups.empty() || (access.reads & completes) != 0 || (access.writes & reads) != 0) {
+            groups.emplace_back();
+            reads = 0;
+            completes = 0;
+        }
+        groups.back().push_back(pass);
+        reads |= access.reads;
+        completes |= access.completes;
+    }
+    return groups;
+}
+
+bool PassManager::run(MusicProgram& program) noexcept {
+    last_timings.clear();
+    traversals = 0;
+
+    const std::vector<Statement*>& statements = program.get_statements();
+    for (const auto& group : plan()) {
+        ++traversals;
+        std::size_t first = last_timings.size();
+        for (const auto& pass : group) {
+            last_timings.push_back(PassTiming{pass->name(), traversals, 0.0});
+        }
+
+        // Si un pase falla, sus tiempos quedan hasta el fallo
+        bool valid = true;
+        for (std::size_t i = 0; valid && i < group.size(); ++i) {
+            auto start = PassClock::now();
+            valid = group[i]->begin(program);
+            last_timings[first + i].ms += elapsed_ms(start);
+        }
+
+        for (std::size_t block = 0; valid && block < statements.size(); block += PASS_BLOCK) {
+            std::size_t end = std::min(block + PASS_BLOCK, statements.size());
+            for (std::size_t i = 0; valid && i < group.size(); ++i) {
+                auto start = PassClock::now();
+                for (std::size_t j = block; valid && j < end; ++j) {
+                    valid = group[i]->visit(*statements[j]);
+                }
+                last_timings[first + i].ms += elapsed_ms(start);
+            }
+        }
+
+        for (std::size_t i = 0; valid && i < group.size(); ++i) {
+            auto start = PassClock::now();
+            valid = group[i]->finish(program);
+            last_timings[first + i].ms += elapsed_ms(start);
+        }
+
+        if (!valid) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::size_t PassManager::traversal_count() const noexcept {
+    return traversals;
+}
+
+const std::vector<PassTiming>& PassManager::timings() const noexcept {
+    return last_timings;
+}
+
+void writePassTimings(std::ostream& out, const std::vector<PassTiming>& timings) noexcept {
+    for (const auto& timing : timings) {
+        out << "Pase " << timing.name << " (recorrido " << timing.traversal << "): " << timing.ms << " ms\n";
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+class MusicProgram;
+class Statement;
+
+// Datos del programa que un pase lee o escribe (máscaras de bits)
+enum PassData : unsigned {
+    PASS_HEADER = 1u << 0,      // Declaraciones de la cabecera
+    PASS_SYMBOLS = 1u << 1,     // Tabla de símbolos y enlaces de los motivos
+    PASS_PITCHES = 1u << 2,     // Alturas de las notas
+    PASS_TEMPO_MAP = 1u << 3,   // Mapa de tempo y compás
+};
+
+// Acceso de un pase a los datos del programa
+struct PassAccess {
+    unsigned reads{0};
+
+    // Lo que escribe al visitar cada sentencia: un pase posterior en el mismo
+    // recorrido lo ve ya escrito en esa sentencia y en las anteriores
+    unsigned writes{0};
+
+    // Lo que solo queda completo en finish (el mapa de tempo necesita todas
+    // las sentencias): un pase que lo lee va en un recorrido posterior
+    unsigned completes{0};
+};
+
+// Pase sobre las sentencias de nivel superior de un programa. El gestor
+// llama a begin, a visit con cada sentencia en orden y a finish; si alguna
+// llamada devuelve false, el pase falló y el gestor se detiene. Un pase solo
+// debe mirar la sentencia que visita y lo que acumuló de las anteriores.
+// Las voces no se recorren sentencia por sentencia: las procesa finish, como
+// los pases del AST (en paralelo).
+class ProgramPass {
+public:
+    virtual ~ProgramPass() noexcept = default;
+
+    virtual const char* name() const noexcept = 0;
+    virtual PassAccess access() const noexcept = 0;
+
+    virtual bool begin(MusicProgram& program) noexcept;
+    virtual bool visit(Statement& statement) noexcept = 0;
+    virtual bool finish(MusicProgram& program) noexcept;
+};
+
+// Tiempo de un pase en la última ejecución, con el recorrido en que se ejecutó (desde 1)
+struct PassTiming {
+    const char* name;
+    std::size_t traversal;
+    double ms;
+};
+
+// Gestor de pases: ejecuta los pases en el orden en que se agregaron,
+// fusionando en un solo recorrido de las sentencias los pases consecutivos
+// compatibles. Un pase comienza un recorrido nuevo si lee algo que un pase
+// del recorrido actual completa en finish, o si escribe algo que alguno de
+// ellos lee. Dentro de un recorrido, las sentencias se procesan en bloques:
+// cada pase visita el bloque entero antes que el siguiente, así que el
+// bloque se lee de memoria una sola vez y cada pase se mide por bloque.
+class PassManager {
+public:
+    // Agrega un pase al final; el gestor no lo libera
+    void add(ProgramPass* pass) noexcept;
+
+    // Ejecuta todos los pases. Devuelve false si alguno falla; los
+    // siguientes no se ejecutan
+    bool run(MusicProgram& program) noexcept;
+
+    // Recorridos de las sentencias y tiempo de cada pase en la última
+    // ejecución. Si un pase falla, los de su recorrido figuran hasta el fallo
+    // y los de los recorridos siguientes no figuran
+    std::size_t traversal_count() const noexcept;
+    const std::vector<PassTiming>& timings() const noexcept;
+
+private:
+    // Grupos de pases consecutivos que comparten un recorrido
+    std::vector<std::vector<ProgramPass*>> plan() const noexcept;
+
+    std::vector<ProgramPass*> passes;
+    std::vector<PassTiming> last_timings;
+    std::size_t traversals{0};
+};
+
+// Escribe el tiempo de cada pase, una línea por pase, para --tiempo
+void writePassTimings(std::ostream& out, const std::vector<PassTiming>& timings) noexcept;
@@ -0,0 +1,132 @@
+#include "program_passes.hpp"
+#include "declaration.hpp"
+#include "voice.hpp"
+#include <ostream>
+
+// Implementación de ValidationPass
+ValidationPass::ValidationPass(SymbolTable& table) noexcept
+    : table{table} {}
+
+const char* ValidationPass::name() const noexcept {
+    return "resolve_names";
+}
+
+PassAccess ValidationPass::access() const noexcept {
+    return PassAccess{PASS_HEADER | PASS_PITCHES, PASS_SYMBOLS, PASS_TEMPO_MAP};
+}
+
+bool ValidationPass::begin(MusicProgram& program) noexcept {
+    return program.resolve_declarations(table);
+}
+
+bool ValidationPass::visit(Statement& statement) noexcept {
+    SourceLocationScope location{statement.get_source_location()};
+    return statement.resolve_names(table);
+}
+
+bool ValidationPass::finish(MusicProgram& program) noexcept {
+    return program.resolve_voices(table);
+}
+
+// Implementación de TranspositionPass
+TranspositionPass::TranspositionPass(int semitones) noexcept
+    : semitones{semitones} {}
+
+const char* TranspositionPass::name() const noexcept {
+    return "transponer";
+}
+
+PassAccess TranspositionPass::access() const noexcept {
+    return PassAccess{PASS_HEADER | PASS_PITCHES, 0, PASS_HEADER | PASS_PITCHES};
+}
+
+bool TranspositionPass::begin(MusicProgram& program) noexcept {
+    total = program.get_transposition() + semitones;
+    transposition = ProgramTransposition{};
+    return true;
+}
+
+bool TranspositionPass::visit(Statement& statement) noexcept {
+    if (total != 0) {
+        transposition.gather(statement);
+    }
+    return true;
+}
+
+bool TranspositionPass::finish(MusicProgram& program) noexcept {
+    if (total == 0) {
+        return true;
+    }
+
+    for (const auto& voice : program.get_voices()) {
+        for (const auto& stmt : voice->get_statements()) {
+            transposition.gather(*stmt);
+        }
+    }
+    return transposition.apply(program, total);
+}
+
+// Implementación de AbcPass
+AbcPass::AbcPass(std::ostream& out) noexcept
+    : out{out} {}
+
+const char* AbcPass::name() const noexcept {
+    return "to_abc";
+}
+
+PassAccess AbcPass::access() const noexcept {
+    return PassAccess{PASS_HEADER | PASS_SYMBOLS | PASS_PITCHES | PASS_TEMPO_MAP, 0, 0};
+}
+
+bool AbcPass::begin(MusicProgram& program) noexcept {
+    beat = 0.0;
+    program.write_abc_header(out, beat);
+    voices = !program.get_voices().empty();
+    if (!voices) {
+        program.start_abc_statements(state);
+    }
+    return true;
+}
+
+bool AbcPass::visit(Statement& statement) noexcept {
+    if (!voices) {
+        statement.to_abc_on_grid(out, beat, state);
+    }
+    return true;
+}
+
+bool AbcPass::finish(MusicProgram& program) noexcept {
+    if (voices) {
+        program.write_abc_voices(out, beat);
+    } else {
+        finish_abc_bars(out, state);
+    }
+    return true;
+}
+
+// Implementación de TextPass
+TextPass::TextPass(std::string& out) noexcept
+    : out{out} {}
+
+const char* TextPass::name() const noexcept {
+    return "to_string";
+}
+
+PassAccess TextPass::access() const noexcept {
+    return PassAccess{PASS_HEADER | PASS_PITCHES, 0, 0};
+}
+
+bool TextPass::begin(MusicProgram& program) noexcept {
+    out += program.header_to_string();
+    return true;
+}
+
+bool TextPass::visit(Statement& statement) noexcept {
+    out += "  " + statement.to_string() + "\n";
+    return true;
+}
+
+bool TextPass::finish(MusicProgram& program) noexcept {
+    out += program.voices_to_string();
+    return true;
+}
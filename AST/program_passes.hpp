@@ -0,0 +1,78 @@
+#pragma once
+
+#include "pass_manager.hpp"
+#include "statement.hpp"
+#include "transpose.hpp"
+#include <iosfwd>
+#include <string>
+
+class SymbolTable;
+
+// Los pases del compilador sobre un MusicProgram, para el gestor de pases.
+// Cada uno hace lo mismo que el método del programa que lleva su nombre.
+
+// resolve_names, con la tabla del llamador. Completa el mapa de tempo
+class ValidationPass final : public ProgramPass {
+public:
+    explicit ValidationPass(SymbolTable& table) noexcept;
+
+    const char* name() const noexcept override;
+    PassAccess access() const noexcept override;
+    bool begin(MusicProgram& program) noexcept override;
+    bool visit(Statement& statement) noexcept override;
+    bool finish(MusicProgram& program) noexcept override;
+
+private:
+    SymbolTable& table;
+};
+
+// Transposición declarada en el archivo más semitones (transpose_program).
+// Reúne las alturas al visitar y las transpone en finish
+class TranspositionPass final : public ProgramPass {
+public:
+    explicit TranspositionPass(int semitones) noexcept;
+
+    const char* name() const noexcept override;
+    PassAccess access() const noexcept override;
+    bool begin(MusicProgram& program) noexcept override;
+    bool visit(Statement& statement) noexcept override;
+    bool finish(MusicProgram& program) noexcept override;
+
+private:
+    int semitones;
+    int total{0};
+    ProgramTransposition transposition;
+};
+
+// to_abc, sobre un programa ya validado
+class AbcPass final : public ProgramPass {
+public:
+    explicit AbcPass(std::ostream& out) noexcept;
+
+    const char* name() const noexcept override;
+    PassAccess access() const noexcept override;
+    bool begin(MusicProgram& program) noexcept override;
+    bool visit(Statement& statement) noexcept override;
+    bool finish(MusicProgram& program) noexcept override;
+
+private:
+    std::ostream& out;
+    double beat{0.0};
+    bool voices{false};   // Con voces, las sentencias de nivel superior no suenan
+    AbcBarState state;
+};
+
+// to_string, agregado al final de out
+class TextPass final : public ProgramPass {
+public:
+    explicit TextPass(std::string& out) noexcept;
+
+    const char* name() const noexcept override;
+    PassAccess access() const noexcept override;
+    bool begin(MusicProgram& program) noexcept override;
+    bool visit(Statement& statement) noexcept override;
+    bool finish(MusicProgram& program) noexcept override;
+
+private:
+    std::string& out;
+};
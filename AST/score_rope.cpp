@@ -0,0 +1,467 @@
+#include "score_rope.hpp"
+#include "declaration.hpp"
+#include "statement.hpp"
+#include "tempo_map.hpp"
+#include "voice.hpp"
+#include <algorithm>
+#include <sstream>
+
+// Sentencias por bloque y hijos por nodo interno: al pasarse, se dividen en dos
+static constexpr std::size_t BLOCK_CAPACITY = 64;
+static constexpr std::size_t FANOUT = 16;
+
+static long statement_ticks(const Statement* statement) noexcept {
+    return TempoMap::ticks_from_beats(statement->played_beats());
+}
+
+bool ScoreRope::GridState::operator==(const GridState& other) const noexcept {
+    return phase == other.phase && pending_bar == other.pending_bar && closed == other.closed;
+}
+
+// Implementación de ScoreRope
+ScoreRope::ScoreRope(std::vector<Statement*> statements, long bar_ticks) noexcept
+    : root{new Node{false}}, bar_ticks{bar_ticks} {
+    // Un bloque termina en cada barra (o al llenarse, si un compás tiene
+    // demasiadas sentencias); las que no suenan quedan en el bloque actual
+    std::vector<Node*> level;
+    Node* block = nullptr;
+    long position = 0;
+    for (const auto& stmt : statements) {
+        if (block == nullptr) {
+            block = new Node{true};
+        }
+        long ticks = statement_ticks(stmt);
+        block->statements.push_back(stmt);
+        block->ticks += ticks;
+        ++block->count;
+        position += ticks;
+
+        bool barline = ticks > 0 && bar_ticks > 0 && position % bar_ticks == 0;
+        if (barline || block->statements.size() == BLOCK_CAPACITY) {
+            level.push_back(block);
+            block = nullptr;
+        }
+    }
+    if (block != nullptr) {
+        level.push_back(block);
+    }
+
+    // Los niveles internos se arman de abajo hacia arriba, con nodos llenos
+    while (level.size() > FANOUT) {
+        std::vector<Node*> parents;
+        for (std::size_t i = 0; i < level.size(); i += FANOUT) {
+            Node* parent = new Node{false};
+            parent->children.assign(level.begin() + i, level.begin() + std::min(i + FANOUT, level.size()));
+            update(parent);
+            parents.push_back(parent);
+        }
+        level = std::move(parents);
+    }
+    root->children = std::move(level);
+    update(root);
+}
+
+ScoreRope::~ScoreRope() noexcept {
+    destroy_node(root, true);
+}
+
+void ScoreRope::destroy_node(Node* node, bool statements) noexcept {
+    for (auto& child : node->children) {
+        destroy_node(child, statements);
+    }
+    if (statements) {
+        for (auto& stmt : node->statements) {
+            stmt->destroy();
+            delete stmt;
+        }
+    }
+    delete node;
+}
+
+void ScoreRope::update(Node* node) noexcept {
+    node->ticks = 0;
+    node->count = 0;
+    if (node->leaf) {
+        for (const auto& stmt : node->statements) {
+            node->ticks += statement_ticks(stmt);
+        }
+        node->count = node->statements.size();
+    } else {
+        for (const auto& child : node->children) {
+            node->ticks += child->ticks;
+            node->count += child->count;
+        }
+    }
+    node->cached = false;
+}
+
+std::size_t ScoreRope::size() const noexcept {
+    return root->count;
+}
+
+long ScoreRope::total_ticks() const noexcept {
+    return root->ticks;
+}
+
+long ScoreRope::measure_count() const noexcept {
+    if (bar_ticks <= 0) {
+        return 0;
+    }
+    return (root->ticks + bar_ticks - 1) / bar_ticks;
+}
+
+ScoreRope::Node* ScoreRope::find_leaf(std::size_t& index, std::vector<PathStep>& path) const noexcept {
+    Node* node = root;
+    while (!node->leaf) {
+        if (node->children.empty()) {
+            return nullptr;
+        }
+        std::size_t child = 0;
+        while (child + 1 < node->children.size() && index >= node->children[child]->count) {
+            index -= node->children[child]->count;
+            ++child;
+        }
+        path.push_back(PathStep{node, child});
+        node = node->children[child];
+    }
+    return node;
+}
+
+Statement* ScoreRope::at(std::size_t index) const noexcept {
+    if (index >= size()) {
+        return nullptr;
+    }
+    std::vector<PathStep> path;
+    Node* leaf = find_leaf(index, path);
+    return leaf->statements[index];
+}
+
+long ScoreRope::tick_of(std::size_t index) const noexcept {
+    if (index >= size()) {
+        return total_ticks();
+    }
+    long tick = 0;
+    const Node* node = root;
+    while (!node->leaf) {
+        std::size_t child = 0;
+        while (index >= node->children[child]->count) {
+            index -= node->children[child]->count;
+            tick += node->children[child]->ticks;
+            ++child;
+        }
+        node = node->children[child];
+    }
+    for (std::size_t i = 0; i < index; ++i) {
+        tick += statement_ticks(node->statements[i]);
+    }
+    return tick;
+}
+
+std::size_t ScoreRope::index_at_tick(long tick) const noexcept {
+    if (tick >= total_ticks()) {
+        return size();
+    }
+    tick = std::max(tick, 0L);
+
+    // Se baja por el primer hijo que termina después de tick
+    std::size_t index = 0;
+    long start = 0;
+    const Node* node = root;
+    while (!node->leaf) {
+        std::size_t child = 0;
+        while (start + node->children[child]->ticks <= tick) {
+            start += node->children[child]->ticks;
+            index += node->children[child]->count;
+            ++child;
+        }
+        node = node->children[child];
+    }
+    for (const auto& stmt : node->statements) {
+        start += statement_ticks(stmt);
+        if (start > tick) {
+            break;
+        }
+        ++index;
+    }
+    return index;
+}
+
+std::size_t ScoreRope::measure_start(long measure) const noexcept {
+    return index_at_tick((measure - 1) * bar_ticks);
+}
+
+void ScoreRope::invalidate(Node* leaf, const std::vector<PathStep>& path, long delta_ticks,
+                           long delta_count) noexcept {
+    leaf->ticks += delta_ticks;
+    leaf->count += delta_count;
+    leaf->cached = false;
+    for (const auto& step : path) {
+        step.node->ticks += delta_ticks;
+        step.node->count += delta_count;
+        step.node->cached = false;
+    }
+}
+
+void ScoreRope::split_path(Node* leaf, std::vector<PathStep>& path) noexcept {
+    auto full = [](const Node* node) {
+        return node->leaf ? node->statements.size() > BLOCK_CAPACITY : node->children.size() > FANOUT;
+    };
+
+    // La mitad final de un nodo lleno pasa a un hermano nuevo, a su derecha
+    auto split = [](Node* node, Node* parent, std::size_t child) {
+        Node* sibling = new Node{node->leaf};
+        if (node->leaf) {
+            auto middle = node->statements.begin() + node->statements.size() / 2;
+            sibling->statements.assign(middle, node->statements.end());
+            node->statements.erase(middle, node->statements.end());
+        } else {
+            auto middle = node->children.begin() + node->children.size() / 2;
+            sibling->children.assign(middle, node->children.end());
+            node->children.erase(middle, node->children.end());
+        }
+        update(node);
+        update(sibling);
+        parent->children.insert(parent->children.begin() + child + 1, sibling);
+    };
+
+    Node* node = leaf;
+    for (std::size_t level = path.size(); level-- > 0 && full(node);) {
+        split(node, path[level].node, path[level].child);
+        node = path[level].node;
+    }
+
+    // Si la raíz se llenó, el árbol crece un nivel
+    if (full(root)) {
+        Node* old_root = root;
+        root = new Node{false};
+        root->children.push_back(old_root);
+        split(old_root, root, 0);
+        update(root);
+    }
+}
+
+void ScoreRope::insert(std::size_t index, Statement* statement) noexcept {
+    index = std::min(index, size());
+    if (root->children.empty()) {
+        root->children.push_back(new Node{true});
+    }
+
+    std::vector<PathStep> path;
+    Node* leaf = find_leaf(index, path);
+    leaf->statements.insert(leaf->statements.begin() + index, statement);
+    invalidate(leaf, path, statement_ticks(statement), 1);
+    split_path(leaf, path);
+}
+
+Statement* ScoreRope::erase(std::size_t index) noexcept {
+    if (index >= size()) {
+        return nullptr;
+    }
+
+    std::vector<PathStep> path;
+    Node* leaf = find_leaf(index, path);
+    Statement* statement = leaf->statements[index];
+    leaf->statements.erase(leaf->statements.begin() + index);
+    invalidate(leaf, path, -statement_ticks(statement), -1);
+
+    // Quitar los nodos que quedaron vacíos
+    Node* node = leaf;
+    for (std::size_t level = path.size(); level-- > 0 && node->count == 0;) {
+        Node* parent = path[level].node;
+        parent->children.erase(parent->children.begin() + path[level].child);
+        delete node;
+        node = parent;
+    }
+
+    // Una raíz con un solo hijo interno sobra: el árbol baja un nivel
+    while (root->children.size() == 1 && !root->children.front()->leaf) {
+        Node* child = root->children.front();
+        delete root;
+        root = child;
+    }
+    return statement;
+}
+
+Statement* ScoreRope::replace(std::size_t index, Statement* statement) noexcept {
+    if (index >= size()) {
+        return nullptr;
+    }
+
+    std::vector<PathStep> path;
+    Node* leaf = find_leaf(index, path);
+    Statement* previous = leaf->statements[index];
+    leaf->statements[index] = statement;
+    invalidate(leaf, path, statement_ticks(statement) - statement_ticks(previous), 0);
+    return previous;
+}
+
+void ScoreRope::write(Node* node, GridState& state) noexcept {
+    if (node->cached && node->start == state) {
+        state = node->end;
+        return;
+    }
+
+    GridState start = state;
+    if (node->leaf) {
+        // El bloque se escribe desde su posición dentro del compás, como el
+        // cuerpo de un motivo (ver MotifStatement::body_to_abc)
+        std::ostringstream text;
+        AbcBarState bar_state{static_cast<double>(bar_ticks) / TICKS_PER_BEAT, state.pending_bar, state.closed, false};
+        double beat = static_cast<double>(state.phase) / TICKS_PER_BEAT;
+        statements_to_abc(node->statements, text, beat, bar_state);
+        node->text = text.str();
+
+        long phase = (bar_ticks > 0) ? (state.phase + node->ticks) % bar_ticks : 0;
+        state = GridState{phase, bar_state.pending_bar, bar_state.closed};
+        ++regenerated;
+    } else {
+        node->text.clear();
+        for (const auto& child : node->children) {
+            write(child, state);
+            node->text += child->text;
+        }
+    }
+
+    node->cached = true;
+    node->start = start;
+    node->end = state;
+}
+
+void ScoreRope::to_abc(std::ostream& out) noexcept {
+    regenerated = 0;
+    GridState state{0, false, false};
+    write(root, state);
+    out << root->text;
+    out << (state.closed ? "\n" : "|\n");
+}
+
+std::size_t ScoreRope::regenerated_blocks() const noexcept {
+    return regenerated;
+}
+
+std::vector<Statement*> ScoreRope::release() noexcept {
+    std::vector<Statement*> statements;
+    statements.reserve(size());
+
+    std::vector<const Node*> pending{root};
+    while (!pending.empty()) {
+        const Node* node = pending.back();
+        pending.pop_back();
+        statements.insert(statements.end(), node->statements.begin(), node->statements.end());
+        pending.insert(pending.end(), node->children.rbegin(), node->children.rend());
+    }
+
+    destroy_node(root, false);
+    root = new Node{false};
+    return statements;
+}
+
+// Implementación de EditableScore
+EditableScore::~EditableScore() noexcept {
+    for (auto& decl : declarations) {
+        decl->destroy();
+        delete decl;
+    }
+    for (auto& stmt : definitions) {
+        stmt->destroy();
+        delete stmt;
+    }
+    for (auto& rope : ropes) {
+        delete rope;
+    }
+}
+
+EditableScore* EditableScore::from_program(MusicProgram& program) noexcept {
+    const TempoMap& tempo_map = program.get_tempo_map();
+    if (tempo_map.empty() || tempo_map.get_segments().size() > 1) {
+        return nullptr;
+    }
+    long bar_ticks = tempo_map.get_segments().front().bar_ticks;
+
+    EditableScore* score = new EditableScore();
+    score->note_pool = program.get_note_pool();
+    std::vector<Statement*> statements;
+    std::vector<MusicVoice*> voices;
+    program.release(score->declarations, statements, voices);
+
+    if (voices.empty()) {
+        score->names.push_back("");
+        score->ropes.push_back(new ScoreRope(std::move(statements), bar_ticks));
+        return score;
+    }
+
+    score->definitions = std::move(statements);
+    for (auto& voice : voices) {
+        score->names.push_back(voice->get_name());
+        score->ropes.push_back(new ScoreRope(voice->release_statements(), bar_ticks));
+        delete voice;
+    }
+    return score;
+}
+
+MusicProgram* EditableScore::to_program() noexcept {
+    MusicProgram* program = new MusicProgram();
+    program->set_note_pool(std::move(note_pool));
+    for (auto& decl : declarations) {
+        program->add_declaration(decl);
+    }
+    for (auto& stmt : definitions) {
+        program->add_statement(stmt);
+    }
+    declarations.clear();
+    definitions.clear();
+
+    for (std::size_t i = 0; i < ropes.size(); ++i) {
+        if (names[i].empty()) {
+            for (auto& stmt : ropes[i]->release()) {
+                program->add_statement(stmt);
+            }
+        } else {
+            MusicVoice* voice = new MusicVoice(names[i]);
+            for (auto& stmt : ropes[i]->release()) {
+                voice->add_statement(stmt);
+            }
+            program->add_voice(voice);
+        }
+        delete ropes[i];
+    }
+    ropes.clear();
+    names.clear();
+    return program;
+}
+
+std::size_t EditableScore::voice_count() const noexcept {
+    return ropes.size();
+}
+
+const std::string& EditableScore::voice_name(std::size_t voice) const noexcept {
+    return names[voice];
+}
+
+ScoreRope& EditableScore::voice(std::size_t voice) noexcept {
+    return *ropes[voice];
+}
+
+void EditableScore::to_abc(std::ostream& out) noexcept {
+    out << "X:1\n";
+    out << "T:Generated\n";
+    double beat = 0.0;
+    for (const auto& decl : declarations) {
+        decl->to_abc(out, beat);
+    }
+
+    if (ropes.size() == 1 && names.front().empty()) {
+        ropes.front()->to_abc(out);
+        return;
+    }
+
+    // Cada voz en su propio hilo y buffer, como MusicProgram::to_abc
+    std::vector<std::ostringstream> buffers(ropes.size());
+    parallel_for_each_index(ropes.size(), [&](std::size_t i) {
+        buffers[i] << "V:" << names[i] << "\n";
+        ropes[i]->to_abc(buffers[i]);
+    });
+    for (const auto& buffer : buffers) {
+        out << buffer.str();
+    }
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Declaration;
+class MusicProgram;
+class NotePool;
+class Statement;
+
+// Secuencia editable de sentencias de nivel superior (una voz, o las notas de
+// un programa sin voces), para un editor interactivo. Es un árbol B: las
+// hojas son bloques de sentencias (al armarlo, un compás por bloque) y cada
+// nodo guarda la duración y la cantidad de sentencias de su subárbol, así que
+// ubicar una sentencia o una barra, insertar, borrar y reemplazar recorren un
+// solo camino de la raíz a una hoja: O(log n), sin mover el resto.
+//
+// Cada nodo guarda además su texto ABC junto con el estado de la rejilla con
+// que comenzó (posición en el compás, barra pendiente, ":|" al final de lo
+// anterior). Una edición invalida solo su camino; al volver a escribir, un
+// subárbol intacto que comienza en el mismo estado copia su texto. Una
+// edición que cambia la duración en algo que no es un múltiplo del compás
+// mueve todas las barras posteriores, y esos bloques se vuelven a generar.
+//
+// La rejilla es fija: no admite cambios de tempo ni de compás.
+class ScoreRope {
+public:
+    // Toma las sentencias, ya validadas, y las reparte en bloques que
+    // terminan en las barras de un compás de bar_ticks semicorcheas
+    ScoreRope(std::vector<Statement*> statements, long bar_ticks) noexcept;
+    ~ScoreRope() noexcept;
+
+    ScoreRope(const ScoreRope&) = delete;
+    ScoreRope& operator=(const ScoreRope&) = delete;
+
+    std::size_t size() const noexcept;
+    long total_ticks() const noexcept;
+    long measure_count() const noexcept;
+
+    Statement* at(std::size_t index) const noexcept;
+
+    // Semicorchea en que comienza la sentencia index (total_ticks() si es size())
+    long tick_of(std::size_t index) const noexcept;
+
+    // Sentencia que suena en tick: la primera que termina después (size() si
+    // tick no es anterior al final)
+    std::size_t index_at_tick(long tick) const noexcept;
+
+    // Sentencia que suena al comenzar el compás measure (desde 1)
+    std::size_t measure_start(long measure) const noexcept;
+
+    // Ediciones. La sentencia insertada debe estar validada (resolve_names) y
+    // pasa a ser de la cuerda; erase y replace devuelven la que sale, que
+    // pasa a ser del llamador
+    void insert(std::size_t index, Statement* statement) noexcept;
+    Statement* erase(std::size_t index) noexcept;
+    Statement* replace(std::size_t index, Statement* statement) noexcept;
+
+    // Escribe las sentencias en ABC sobre la rejilla, con la barra final,
+    // igual que MusicVoice::to_abc sin la línea V:
+    void to_abc(std::ostream& out) noexcept;
+
+    // Bloques cuyo texto se generó en la última llamada a to_abc
+    std::size_t regenerated_blocks() const noexcept;
+
+    // Entrega las sentencias en orden y deja la cuerda vacía
+    std::vector<Statement*> release() noexcept;
+
+private:
+    // Estado de la rejilla al comenzar un subárbol
+    struct GridState {
+        long phase;      // Semicorcheas desde la última barra
+        bool pending_bar;
+        bool closed;
+
+        bool operator==(const GridState& other) const noexcept;
+    };
+
+    struct Node {
+        explicit Node(bool leaf) noexcept : leaf{leaf} {}
+
+        bool leaf;
+        std::vector<Statement*> statements;   // Solo en las hojas
+        std::vector<Node*> children;          // Solo en los nodos internos
+        std::size_t count{0};
+        long ticks{0};
+
+        // Texto ABC para el estado start y estado en que termina
+        bool cached{false};
+        GridState start{};
+        GridState end{};
+        std::string text;
+    };
+
+    // Camino desde la raíz: cada nodo interno y el hijo elegido en él
+    struct PathStep {
+        Node* node;
+        std::size_t child;
+    };
+
+    // Baja hasta la hoja que contiene la sentencia index (o la última hoja
+    // si index es size()); deja en index la posición dentro de la hoja
+    Node* find_leaf(std::size_t& index, std::vector<PathStep>& path) const noexcept;
+
+    // Recalcula duración y cantidad de un nodo a partir de su contenido
+    static void update(Node* node) noexcept;
+    static void destroy_node(Node* node, bool statements) noexcept;
+
+    // Divide los nodos del camino que quedaron con demasiados elementos
+    void split_path(Node* leaf, std::vector<PathStep>& path) noexcept;
+    void invalidate(Node* leaf, const std::vector<PathStep>& path, long delta_ticks,
+                    long delta_count) noexcept;
+
+    // Deja en node->text el texto del subárbol que comienza en state, y en
+    // state el estado en que termina
+    void write(Node* node, GridState& state) noexcept;
+
+    Node* root;
+    long bar_ticks;
+    std::size_t regenerated{0};
+};
+
+// Partitura editable: las declaraciones y los motivos definidos fuera de las
+// voces de un MusicProgram, y una ScoreRope por voz (una sola, de nombre
+// vacío, si el programa no tiene voces)
+class EditableScore {
+public:
+    ~EditableScore() noexcept;
+
+    EditableScore(const EditableScore&) = delete;
+    EditableScore& operator=(const EditableScore&) = delete;
+
+    // Toma el contenido de un programa ya validado (resolve_names) y lo deja
+    // vacío. Devuelve nullptr, sin tocar el programa, si no está validado o
+    // tiene cambios de tempo o de compás
+    static EditableScore* from_program(MusicProgram& program) noexcept;
+
+    // Devuelve el contenido como MusicProgram y queda vacía. El programa debe
+    // volver a validarse (resolve_names) antes de usar su mapa de tempo
+    MusicProgram* to_program() noexcept;
+
+    std::size_t voice_count() const noexcept;
+    const std::string& voice_name(std::size_t voice) const noexcept;
+    ScoreRope& voice(std::size_t voice) noexcept;
+
+    // Escribe la partitura en ABC, igual que MusicProgram::to_abc
+    void to_abc(std::ostream& out) noexcept;
+
+private:
+    EditableScore() noexcept = default;
+
+    std::vector<Declaration*> declarations;
+    std::vector<Statement*> definitions;
+    std::vector<std::string> names;
+    std::vector<ScoreRope*> ropes;
+    std::shared_ptr<NotePool> note_pool;   // El del programa, si las notas lo comparten
+};
@@ -1,16 +1,166 @@
 #include "statement.hpp"
+#include "declaration.hpp"
+#include "note_pool.hpp"
 #include "../Semantic_Analysis/symbol_table.hpp"
-#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <sstream>
+#include <vector>
+
+// Implementación de Statement
+void Statement::set_source_location(SourceLocation location) noexcept {
+    source_location = location;
+}
+
+SourceLocation Statement::get_source_location() const noexcept {
+    return source_location;
+}
+
+void Statement::to_abc_on_grid(std::ostream& out, double& beatCounter, AbcBarState& state) const noexcept {
+    if (state.pending_bar) {
+        out << "| ";
+        state.pending_bar = false;
+    }
+    if (beatCounter >= state.next_change) {
+        write_abc_changes(out, beatCounter, state);
+    }
+    state.closed = false;
+
+    this->to_abc(out, beatCounter);
+
+    // Barra de compás cuando se completa un compás
+    state.pending_bar = state.bar_length > 0.0 &&
+                        std::fmod(beatCounter - state.bar_origin, state.bar_length) == 0.0;
+}
+
+bool Statement::check_bar_grid(const TempoMap& tempo_map, long& position,
+                               const SoundingStatement*& crossing) const noexcept {
+    crossing = nullptr;
+    this->for_each_played_note([&](const SoundingStatement& note) {
+        if (crossing != nullptr) {
+            return;
+        }
+        long end = position + TempoMap::ticks_from_beats(note.get_duration()->beats());
+        if (end > tempo_map.next_barline(position)) {
+            crossing = &note;
+            return;
+        }
+        position = end;
+    });
+    return crossing == nullptr;
+}
+
+void Statement::reset_names() noexcept {}
+
+// Verifica las sentencias de un cuerpo en orden (ver Statement::check_bar_grid)
+static bool check_block_bar_grid(const ProgramBody& body, const TempoMap& tempo_map, long& position,
+                                 const SoundingStatement*& crossing) noexcept {
+    for (const auto& stmt : body) {
+        if (!stmt->check_bar_grid(tempo_map, position, crossing)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Duración en corcheas de una vuelta de un cuerpo
+static double block_beats(const ProgramBody& body) noexcept {
+    double beats = 0.0;
+    for (const auto& stmt : body) {
+        beats += stmt->played_beats();
+    }
+    return beats;
+}
+
+void finish_abc_bars(std::ostream& out, const AbcBarState& state) noexcept {
+    out << (state.closed ? "\n" : "|\n");
+}
+
+// Busca el próximo tramo que cambia algo que esta voz escribe: el compás
+// siempre, el tempo solo si la voz lo escribe
+static void schedule_abc_change(AbcBarState& state) noexcept {
+    state.next_change = std::numeric_limits<double>::infinity();
+    const auto& segments = state.tempo_map->get_segments();
+    for (std::size_t i = state.segment + 1; i < segments.size(); ++i) {
+        const TempoSegment& previous = segments[i - 1];
+        const TempoSegment& segment = segments[i];
+        bool meter = segment.numerator != previous.numerator || segment.denominator != previous.denominator;
+        if (meter || (state.write_tempo && segment.tempo != previous.tempo)) {
+            state.next_change = static_cast<double>(segment.tick) / TICKS_PER_BEAT;
+            return;
+        }
+    }
+}
+
+void start_abc_bars(AbcBarState& state, const TempoMap* tempo_map, bool write_tempo) noexcept {
+    state.tempo_map = (tempo_map != nullptr && tempo_map->get_segments().size() > 1) ? tempo_map : nullptr;
+    state.write_tempo = write_tempo;
+    state.segment = 0;
+    state.bar_origin = 0.0;
+    state.next_change = std::numeric_limits<double>::infinity();
+    if (state.tempo_map != nullptr) {
+        schedule_abc_change(state);
+    }
+}
+
+void extend_abc_bars(AbcBarState& state, const TempoMap& tempo_map) noexcept {
+    // Sin mapa, lo escrito sigue en el primer tramo, que es el de la cabecera
+    if (tempo_map.get_segments().size() > 1) {
+        state.tempo_map = &tempo_map;
+        schedule_abc_change(state);
+    }
+}
+
+void write_abc_changes(std::ostream& out, double beatCounter, AbcBarState& state) noexcept {
+    if (state.tempo_map == nullptr) {
+        return;
+    }
+
+    // Se compara con lo último escrito: los tramos intermedios no se ven
+    const auto& segments = state.tempo_map->get_segments();
+    const TempoSegment& written = segments[state.segment];
+    std::size_t index = state.tempo_map->segment_index(TempoMap::ticks_from_beats(beatCounter));
+    const TempoSegment& current = segments[index];
+    if (current.numerator != written.numerator || current.denominator != written.denominator) {
+        out << "[M:" << current.numerator << "/" << current.denominator << "] ";
+    }
+    if (state.write_tempo && current.tempo != written.tempo) {
+        out << "[Q:1/4=" << current.tempo << "] ";
+    }
+
+    state.segment = index;
+    state.bar_length = static_cast<double>(current.bar_ticks) / TICKS_PER_BEAT;
+    state.bar_origin = static_cast<double>(current.meter_tick) / TICKS_PER_BEAT;
+    schedule_abc_change(state);
+}
+
+// Implementación de SoundingStatement: suena una sola vez, donde está
+void SoundingStatement::for_each_played_note(const std::function<void(const SoundingStatement&)>& visit) const noexcept {
+    visit(*this);
+}
+
+double SoundingStatement::played_beats() const noexcept {
+    return get_duration()->beats();
+}
+
+void SoundingStatement::for_each_stored_note(const std::function<void(SoundingStatement&)>& visit) noexcept {
+    visit(*this);
+}
 
 // Implementacion de NoteStatement 
 NoteStatement::NoteStatement(NoteExpression* note, DurationExpression* duration) noexcept
     : note{note}, duration{duration} {}
 
-NoteExpression* NoteStatement::get_note() const noexcept {
+NoteStatement::NoteStatement(NoteExpression* note, DurationExpression* duration, NotePool* pool) noexcept
+    : note{note}, duration{duration}, pool{pool} {}
+
+const NoteExpression* NoteStatement::get_note() const noexcept {
     return note;
 }
 
-DurationExpression* NoteStatement::get_duration() const noexcept {
+const DurationExpression* NoteStatement::get_duration() const noexcept {
     return duration;
 }
 
@@ -19,6 +169,11 @@ std::string NoteStatement::to_string() const noexcept {
 }
 
 void NoteStatement::destroy() noexcept {
+    // Los nodos compartidos son del pool
+    if (pool != nullptr) {
+        return;
+    }
+
     if (note != nullptr) {
         note->destroy();
         delete note;
@@ -33,32 +188,41 @@ void NoteStatement::destroy() noexcept {
 // Implementación del método resolve_names (verificacion semantica) para NoteStatement
 bool NoteStatement::resolve_names(SymbolTable& table) noexcept{
     // Verificar que existan declaraciones necesarias antes de usar notas
-    if (!table.contains("__tempo__"))
+    if (!NoteStatement::check_declarations(table))
     {
-        std::cerr << "Error: Es necesario declarar el tempo antes de usar notas.\n";
         return false;
     }
     
-    if (!table.contains("__time_signature__"))
+    // Validar la nota y la duración 
+    if (!this->note->resolve_names(table))
     {
-        std::cerr << "Error: Es necesario declarar el compás antes de usar notas.\n";
         return false;
     }
     
-    if (!table.contains("__key__"))
+    if (!this->duration->resolve_names(table))
     {
-        std::cerr << "Error: Es necesario declarar la tonalidad antes de usar notas.\n";
         return false;
     }
     
-    // Validar la nota y la duración 
-    if (!this->note->resolve_names(table))
+    return true;
+}
+
+bool NoteStatement::check_declarations(SymbolTable& table) noexcept{
+    if (!table.contains("__tempo__"))
     {
+        SemanticErrorMessage{} << "Error: Es necesario declarar el tempo antes de usar notas.\n";
         return false;
     }
     
-    if (!this->duration->resolve_names(table))
+    if (!table.contains("__time_signature__"))
+    {
+        SemanticErrorMessage{} << "Error: Es necesario declarar el compás antes de usar notas.\n";
+        return false;
+    }
+    
+    if (!table.contains("__key__"))
     {
+        SemanticErrorMessage{} << "Error: Es necesario declarar la tonalidad antes de usar notas.\n";
         return false;
     }
     
@@ -72,4 +236,597 @@ void NoteStatement::to_abc(std::ostream& out, double& beatCounter) const noexcep
     
     // Actualizar el contador de beats
     beatCounter += duration->beats();
-} 
\ No newline at end of file
+}
+
+std::size_t NoteStatement::pitch_count() const noexcept {
+    return 1;
+}
+
+std::string NoteStatement::pitch_name(std::size_t /*index*/) const noexcept {
+    return note->get_note_name();
+}
+
+int NoteStatement::pitch_octave(std::size_t /*index*/) const noexcept {
+    return note->get_octave();
+}
+
+int NoteStatement::pitch_midi_number(std::size_t /*index*/) const noexcept {
+    return note->midi_number();
+}
+
+void NoteStatement::set_pitch_midi_number(std::size_t /*index*/, int midi, const NoteSpelling& spelling) noexcept {
+    if (pool != nullptr) {
+        note = pool->note(spelling.name(), (midi - spelling.semitones()) / 12 - 1);
+        return;
+    }
+
+    note->set_midi_number(midi, spelling);
+}
+
+SoundingStatement* NoteStatement::clone() const noexcept {
+    if (pool != nullptr) {
+        auto copy = new NoteStatement(note, duration, pool);
+        copy->set_source_location(get_source_location());
+        return copy;
+    }
+
+    auto copy = new NoteStatement(new NoteExpression(note->get_note_name(), note->get_octave()),
+                                  new DurationExpression(duration->get_duration_type()));
+    copy->set_source_location(get_source_location());
+    return copy;
+}
+
+// Valida el cuerpo de un bloque en su propio ámbito: los motivos definidos
+// dentro del bloque no son visibles fuera de él
+static bool resolve_block(ProgramBody& body, SymbolTable& table) noexcept {
+    table.enter_scope();
+    bool valid = true;
+    for (const auto& stmt : body)
+    {
+        if (!stmt->resolve_names(table))
+        {
+            valid = false;
+            break;
+        }
+    }
+    table.exit_scope();
+    return valid;
+}
+
+// Implementación de ChordStatement
+ChordStatement::ChordStatement(DurationType duration) noexcept
+    : duration{duration} {}
+
+bool ChordStatement::add_note(std::string_view note_name, int octave) noexcept {
+    ++written;
+    if (count == CAPACITY) {
+        return false;
+    }
+    ChordNote& note = notes[count++];
+    std::size_t length = std::min(note_name.size(), sizeof(note.name) - 1);
+    std::memcpy(note.name, note_name.data(), length);
+    note.name[length] = '\0';
+    note.octave = static_cast<signed char>(octave);
+    return true;
+}
+
+const DurationExpression* ChordStatement::get_duration() const noexcept {
+    return &duration;
+}
+
+std::string ChordStatement::to_string() const noexcept {
+    std::string result = "[";
+    for (std::size_t i = 0; i < count; ++i) {
+        result += (i == 0 ? "" : " ") + pitch_name(i) + std::to_string(notes[i].octave);
+    }
+    return result + "] " + duration.to_string();
+}
+
+void ChordStatement::destroy() noexcept {
+    // Las notas y la duración son parte de la sentencia
+}
+
+// Una sola pasada: declaraciones, cantidad de notas y cada nota
+bool ChordStatement::resolve_names(SymbolTable& table) noexcept {
+    if (!NoteStatement::check_declarations(table))
+    {
+        return false;
+    }
+
+    if (written > CAPACITY)
+    {
+        SemanticErrorMessage{} << "Error: Un acorde admite a lo sumo " << CAPACITY << " notas (tiene "
+                               << written << ").\n";
+        return false;
+    }
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (!check_note(notes[i].name, notes[i].octave))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Las notas entre corchetes y una sola duración: "[CEG]2"
+void ChordStatement::to_abc(std::ostream& out, double& beatCounter) const noexcept {
+    out << "[";
+    for (std::size_t i = 0; i < count; ++i) {
+        out << note_abc(notes[i].name, notes[i].octave);
+    }
+    out << "]" << duration.abc_suffix() << " ";
+
+    beatCounter += duration.beats();
+}
+
+std::size_t ChordStatement::pitch_count() const noexcept {
+    return count;
+}
+
+std::string ChordStatement::pitch_name(std::size_t index) const noexcept {
+    return notes[index].name;
+}
+
+int ChordStatement::pitch_octave(std::size_t index) const noexcept {
+    return notes[index].octave;
+}
+
+int ChordStatement::pitch_midi_number(std::size_t index) const noexcept {
+    return note_midi_number(notes[index].name, notes[index].octave);
+}
+
+void ChordStatement::set_pitch_midi_number(std::size_t index, int midi, const NoteSpelling& spelling) noexcept {
+    std::string name = spelling.name();
+    std::memcpy(notes[index].name, name.c_str(), name.size() + 1);
+    notes[index].octave = static_cast<signed char>((midi - spelling.semitones()) / 12 - 1);
+}
+
+// Las notas están dentro de la sentencia: la copia es la de sus miembros
+SoundingStatement* ChordStatement::clone() const noexcept {
+    return new ChordStatement(*this);
+}
+
+// Implementación de RepeatStatement
+RepeatStatement::RepeatStatement(int count, ProgramBody body) noexcept
+    : count{count}, body{std::move(body)} {}
+
+int RepeatStatement::get_count() const noexcept {
+    return count;
+}
+
+const ProgramBody& RepeatStatement::get_body() const noexcept {
+    return body;
+}
+
+std::string RepeatStatement::to_string() const noexcept {
+    std::string result = "Repetir " + std::to_string(count) + " {";
+    for (const auto& stmt : body) {
+        result += " " + stmt->to_string();
+    }
+    return result + " }";
+}
+
+void RepeatStatement::destroy() noexcept {
+    destroy_program_body(body);
+}
+
+// El cuerpo se valida una sola vez, sin importar cuántas veces suene. Los
+// topes de MAX_REPEAT_COUNT y MAX_REPEAT_TICKS acotan lo que escriben las
+// salidas expandidas
+bool RepeatStatement::resolve_names(SymbolTable& table) noexcept {
+    if (count < 1)
+    {
+        SemanticErrorMessage{} << "Error: La cantidad de repeticiones debe ser mayor a 0.\n";
+        return false;
+    }
+    if (!valid_repeat_count(count))
+    {
+        SemanticErrorMessage{} << "Error: La cantidad de repeticiones debe ser a lo sumo " << MAX_REPEAT_COUNT
+                               << ": " << count << ".\n";
+        return false;
+    }
+
+    if (!resolve_block(body, table))
+    {
+        return false;
+    }
+
+    if (played_beats() == 0.0)
+    {
+        SemanticErrorMessage{} << "Error: Repetición sin notas.\n";
+        return false;
+    }
+    if (count * block_beats(body) * TICKS_PER_BEAT > MAX_REPEAT_TICKS)
+    {
+        SemanticErrorMessage{} << "Error: La repetición, expandida, dura más de " << MAX_REPEAT_TICKS
+                               << " semicorcheas.\n";
+        return false;
+    }
+    return true;
+}
+
+void RepeatStatement::to_abc(std::ostream& out, double& beatCounter) const noexcept {
+    // Sin rejilla de compases el cuerpo se escribe expandido
+    AbcBarState state;
+    to_abc_on_grid(out, beatCounter, state);
+}
+
+void RepeatStatement::for_each_played_note(const std::function<void(const SoundingStatement&)>& visit) const noexcept {
+    for (int i = 0; i < count; ++i) {
+        for (const auto& stmt : body) {
+            stmt->for_each_played_note(visit);
+        }
+    }
+}
+
+double RepeatStatement::played_beats() const noexcept {
+    return count * block_beats(body);
+}
+
+void RepeatStatement::for_each_stored_note(const std::function<void(SoundingStatement&)>& visit) noexcept {
+    for (auto& stmt : body) {
+        stmt->for_each_stored_note(visit);
+    }
+}
+
+void RepeatStatement::to_abc_on_grid(std::ostream& out, double& beatCounter, AbcBarState& state) const noexcept {
+    double bar = state.bar_length;
+    double body_beats = (count > 0) ? played_beats() / count : 0.0;
+    // Un cambio de tempo o de compás dentro del bloque se escribe en su
+    // lugar, así que el bloque se expande
+    bool native = count >= 2 && !state.in_repeat && bar > 0.0 && body_beats > 0.0 &&
+                  std::fmod(beatCounter - state.bar_origin, bar) == 0.0 && std::fmod(body_beats, bar) == 0.0 &&
+                  beatCounter < state.next_change && beatCounter + count * body_beats <= state.next_change;
+
+    if (!native) {
+        for (int i = 0; i < count; ++i) {
+            statements_to_abc(body, out, beatCounter, state);
+        }
+        return;
+    }
+
+    // "|:" reemplaza la barra pendiente del compás anterior. ABC repite una
+    // sola vez; para más repeticiones se anota la cantidad sobre el bloque
+    out << "|: ";
+    if (count > 2) {
+        out << "\"^x" << count << "\" ";
+    }
+    state.pending_bar = false;
+    state.in_repeat = true;
+
+    double start = beatCounter;
+    statements_to_abc(body, out, beatCounter, state);
+    out << ":| ";
+
+    // El cuerpo dura compases completos, así que ":|" es la barra del último
+    state.pending_bar = false;
+    state.closed = true;
+    state.in_repeat = false;
+    beatCounter = start + count * body_beats;
+}
+
+bool RepeatStatement::check_bar_grid(const TempoMap& tempo_map, long& position,
+                                     const SoundingStatement*& crossing) const noexcept {
+    long body_ticks = TempoMap::ticks_from_beats(block_beats(body));
+    if (body_ticks == 0) {
+        return true;
+    }
+
+    const auto& segments = tempo_map.get_segments();
+    long remaining = count;
+    while (remaining > 0) {
+        // En un tramo las barras están cada bar_ticks, así que una vuelta que
+        // cabe entera en él comienza en el mismo lugar del compás que la de
+        // bar / mcd(cuerpo, bar) vueltas antes, y cruza una barra solo si
+        // aquella también la cruzó: basta verificar las primeras
+        std::size_t segment = tempo_map.segment_index(position);
+        long bar = segments[segment].bar_ticks;
+        long fitting = remaining;
+        if (segment + 1 < segments.size()) {
+            fitting = std::min(remaining, (segments[segment + 1].tick - position) / body_ticks);
+        }
+
+        // La vuelta que contiene el comienzo del tramo siguiente se verifica entera
+        long checked = (fitting == 0) ? 1 : std::min(fitting, bar / std::gcd(body_ticks, bar));
+        for (long i = 0; i < checked; ++i) {
+            if (!check_block_bar_grid(body, tempo_map, position, crossing)) {
+                return false;
+            }
+        }
+        long played = std::max(fitting, checked);
+        position += (played - checked) * body_ticks;
+        remaining -= played;
+    }
+    return true;
+}
+
+void RepeatStatement::reset_names() noexcept {
+    for (auto& stmt : body) {
+        stmt->reset_names();
+    }
+}
+
+// Implementación de MotifStatement
+MotifStatement::MotifStatement(const std::string& name, ProgramBody body) noexcept
+    : name{name}, body{std::move(body)} {}
+
+std::string MotifStatement::get_name() const noexcept {
+    return name;
+}
+
+const ProgramBody& MotifStatement::get_body() const noexcept {
+    return body;
+}
+
+double MotifStatement::body_beats() const noexcept {
+    return beats;
+}
+
+void MotifStatement::for_each_body_note(const std::function<void(const SoundingStatement&)>& visit) const noexcept {
+    for (const auto& stmt : body) {
+        stmt->for_each_played_note(visit);
+    }
+}
+
+void MotifStatement::body_to_abc(std::ostream& out, double& beatCounter, AbcBarState& state) const noexcept {
+    // Si un cambio de tempo o de compás cae dentro del cuerpo, el texto
+    // depende de la posición en la partitura: se escribe sin caché
+    if (beatCounter >= state.next_change || beatCounter + beats > state.next_change) {
+        statements_to_abc(body, out, beatCounter, state);
+        return;
+    }
+
+    double phase = (state.bar_length > 0.0) ? std::fmod(beatCounter - state.bar_origin, state.bar_length) : 0.0;
+    AbcCacheKey key{state.bar_length, phase, state.pending_bar, state.in_repeat};
+
+    const CachedAbc* cached = nullptr;
+    {
+        std::lock_guard<std::mutex> lock{abc_cache_mutex};
+        auto found = abc_cache.find(key);
+        if (found != abc_cache.end()) {
+            cached = &found->second;
+        }
+    }
+
+    if (cached == nullptr) {
+        // Generar el cuerpo desde la misma posición dentro del compás. Si dos
+        // hilos lo generan a la vez, el texto es el mismo y se guarda el primero
+        std::ostringstream text;
+        AbcBarState body_state{state.bar_length, state.pending_bar, false, state.in_repeat};
+        double body_beat = phase;
+        statements_to_abc(body, text, body_beat, body_state);
+
+        std::lock_guard<std::mutex> lock{abc_cache_mutex};
+        auto inserted = abc_cache.emplace(key, CachedAbc{text.str(), body_state.pending_bar, body_state.closed});
+        cached = &inserted.first->second;
+    }
+
+    // Los elementos de un map no se mueven al insertar otros
+    out << cached->text;
+    beatCounter += beats;
+    state.pending_bar = cached->pending_bar;
+    state.closed = cached->closed;
+}
+
+std::string MotifStatement::to_string() const noexcept {
+    std::string result = "Motivo " + name + " {";
+    for (const auto& stmt : body) {
+        result += " " + stmt->to_string();
+    }
+    return result + " }";
+}
+
+void MotifStatement::destroy() noexcept {
+    destroy_program_body(body);
+}
+
+// El cuerpo se valida una sola vez, en su propio ámbito. El motivo se agrega
+// a la tabla después, así que no puede referirse a sí mismo
+bool MotifStatement::resolve_names(SymbolTable& table) noexcept {
+    std::string symbol = MotifStatement::symbol_name(name);
+    if (table.current_scope_lookup(symbol) != nullptr)
+    {
+        SemanticErrorMessage{} << "Error: Motivo definido más de una vez en el mismo ámbito: " << name << ".\n";
+        return false;
+    }
+
+    if (!resolve_block(body, table))
+    {
+        return false;
+    }
+
+    beats = 0.0;
+    for (const auto& stmt : body)
+    {
+        beats += stmt->played_beats();
+    }
+
+    if (beats == 0.0)
+    {
+        SemanticErrorMessage{} << "Error: Motivo sin notas: " << name << ".\n";
+        return false;
+    }
+
+    return table.insert(symbol, this);
+}
+
+void MotifStatement::to_abc(std::ostream&, double&) const noexcept {
+    // La definición no suena: el cuerpo se escribe en cada referencia
+}
+
+void MotifStatement::for_each_played_note(const std::function<void(const SoundingStatement&)>&) const noexcept {}
+
+double MotifStatement::played_beats() const noexcept {
+    return 0.0;
+}
+
+void MotifStatement::for_each_stored_note(const std::function<void(SoundingStatement&)>& visit) noexcept {
+    // Las notas pueden cambiar: el texto ABC guardado deja de valer
+    {
+        std::lock_guard<std::mutex> lock{abc_cache_mutex};
+        abc_cache.clear();
+    }
+
+    for (auto& stmt : body) {
+        stmt->for_each_stored_note(visit);
+    }
+}
+
+void MotifStatement::to_abc_on_grid(std::ostream&, double&, AbcBarState&) const noexcept {}
+
+void MotifStatement::reset_names() noexcept {
+    // La duración y el texto ABC dependen de los motivos que se enlacen
+    beats = 0.0;
+    {
+        std::lock_guard<std::mutex> lock{abc_cache_mutex};
+        abc_cache.clear();
+    }
+
+    for (auto& stmt : body) {
+        stmt->reset_names();
+    }
+}
+
+std::string MotifStatement::symbol_name(const std::string& name) noexcept {
+    return "__motif_" + name + "__";
+}
+
+// Implementación de MotifReferenceStatement
+MotifReferenceStatement::MotifReferenceStatement(const std::string& name) noexcept
+    : name{name} {}
+
+std::string MotifReferenceStatement::get_name() const noexcept {
+    return name;
+}
+
+const MotifStatement* MotifReferenceStatement::get_motif() const noexcept {
+    return motif;
+}
+
+std::string MotifReferenceStatement::to_string() const noexcept {
+    return name;
+}
+
+void MotifReferenceStatement::destroy() noexcept {
+    // La definición pertenece a su MotifStatement
+    motif = nullptr;
+}
+
+bool MotifReferenceStatement::resolve_names(SymbolTable& table) noexcept {
+    auto symbol = table.lookup(MotifStatement::symbol_name(name));
+    motif = (symbol != nullptr) ? dynamic_cast<const MotifStatement*>(symbol->definition) : nullptr;
+    if (motif == nullptr)
+    {
+        SemanticErrorMessage{} << "Error: Motivo no definido: " << name << ".\n";
+        return false;
+    }
+    return true;
+}
+
+void MotifReferenceStatement::to_abc(std::ostream& out, double& beatCounter) const noexcept {
+    AbcBarState state;
+    to_abc_on_grid(out, beatCounter, state);
+}
+
+void MotifReferenceStatement::for_each_played_note(const std::function<void(const SoundingStatement&)>& visit) const noexcept {
+    if (motif != nullptr) {
+        motif->for_each_body_note(visit);
+    }
+}
+
+double MotifReferenceStatement::played_beats() const noexcept {
+    return (motif != nullptr) ? motif->body_beats() : 0.0;
+}
+
+bool MotifReferenceStatement::check_bar_grid(const TempoMap& tempo_map, long& position,
+                                             const SoundingStatement*& crossing) const noexcept {
+    return (motif == nullptr) || check_block_bar_grid(motif->get_body(), tempo_map, position, crossing);
+}
+
+void MotifReferenceStatement::reset_names() noexcept {
+    motif = nullptr;
+}
+
+void MotifReferenceStatement::for_each_stored_note(const std::function<void(SoundingStatement&)>&) noexcept {
+    // Las notas del motivo se recorren en su definición
+}
+
+void MotifReferenceStatement::to_abc_on_grid(std::ostream& out, double& beatCounter, AbcBarState& state) const noexcept {
+    if (motif != nullptr) {
+        motif->body_to_abc(out, beatCounter, state);
+    }
+}
+
+// Implementación de TempoChangeStatement
+TempoChangeStatement::TempoChangeStatement(int tempo_value) noexcept
+    : tempo_value{tempo_value} {}
+
+int TempoChangeStatement::get_tempo_value() const noexcept {
+    return tempo_value;
+}
+
+std::string TempoChangeStatement::to_string() const noexcept {
+    return "Tempo " + std::to_string(tempo_value);
+}
+
+void TempoChangeStatement::destroy() noexcept {
+    // No hay memoria que liberar
+}
+
+bool TempoChangeStatement::resolve_names(SymbolTable&) noexcept {
+    return TempoDeclaration::check_tempo(tempo_value);
+}
+
+void TempoChangeStatement::to_abc(std::ostream&, double&) const noexcept {
+    // El cambio se escribe desde el mapa de tempo (write_abc_changes)
+}
+
+void TempoChangeStatement::for_each_played_note(const std::function<void(const SoundingStatement&)>&) const noexcept {}
+
+double TempoChangeStatement::played_beats() const noexcept {
+    return 0.0;
+}
+
+void TempoChangeStatement::for_each_stored_note(const std::function<void(SoundingStatement&)>&) noexcept {}
+
+void TempoChangeStatement::to_abc_on_grid(std::ostream&, double&, AbcBarState&) const noexcept {}
+
+// Implementación de TimeSignatureChangeStatement
+TimeSignatureChangeStatement::TimeSignatureChangeStatement(int numerator, int denominator) noexcept
+    : numerator{numerator}, denominator{denominator} {}
+
+int TimeSignatureChangeStatement::get_numerator() const noexcept {
+    return numerator;
+}
+
+int TimeSignatureChangeStatement::get_denominator() const noexcept {
+    return denominator;
+}
+
+std::string TimeSignatureChangeStatement::to_string() const noexcept {
+    return "Compas " + std::to_string(numerator) + "/" + std::to_string(denominator);
+}
+
+void TimeSignatureChangeStatement::destroy() noexcept {
+    // No hay memoria que liberar
+}
+
+bool TimeSignatureChangeStatement::resolve_names(SymbolTable&) noexcept {
+    return TimeSignatureDeclaration::check_time_signature(numerator, denominator);
+}
+
+void TimeSignatureChangeStatement::to_abc(std::ostream&, double&) const noexcept {
+    // El cambio se escribe desde el mapa de tempo (write_abc_changes)
+}
+
+void TimeSignatureChangeStatement::for_each_played_note(const std::function<void(const SoundingStatement&)>&) const noexcept {}
+
+double TimeSignatureChangeStatement::played_beats() const noexcept {
+    return 0.0;
+}
+
+void TimeSignatureChangeStatement::for_each_stored_note(const std::function<void(SoundingStatement&)>&) noexcept {}
+
+void TimeSignatureChangeStatement::to_abc_on_grid(std::ostream&, double&, AbcBarState&) const noexcept {}
@@ -2,24 +2,363 @@
 
 #include "ast_node_interface.hpp"
 #include "expression.hpp"
+#include "tempo_map.hpp"
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <tuple>
+
+class NotePool;
+class SoundingStatement;
+
+// Estado de la escritura ABC sobre la rejilla de compases
+struct AbcBarState {
+    double bar_length{0.0};   // Duración de un compás en corcheas (0: sin barras)
+    bool pending_bar{false};  // Se completó un compás y su barra aún no se escribió
+    bool closed{false};       // Lo último escrito fue una barra de repetición (":|")
+    bool in_repeat{false};    // Dentro de una repetición nativa, que ABC no anida
+
+    // Cambios de tempo y compás a mitad de la partitura (ver start_abc_bars)
+    const TempoMap* tempo_map{nullptr};
+    bool write_tempo{false};  // Solo una voz escribe los cambios de tempo
+    std::size_t segment{0};   // Último tramo del mapa ya escrito
+    double bar_origin{0.0};   // Barra donde comenzó el compás vigente, en corcheas
+    double next_change{std::numeric_limits<double>::infinity()};   // Próximo cambio a escribir
+};
+
+// Prepara el estado para escribir una voz desde el comienzo del mapa. Sin
+// mapa (o con un solo tramo) la rejilla es la de bar_length, como antes
+void start_abc_bars(AbcBarState& state, const TempoMap* tempo_map, bool write_tempo) noexcept;
+
+// Retoma la escritura sobre un mapa que creció con cambios posteriores a lo
+// ya escrito (el de quien escribe cada sentencia al recibirla)
+void extend_abc_bars(AbcBarState& state, const TempoMap& tempo_map) noexcept;
+
+// Escribe los cambios del mapa que comenzaron hasta beatCounter ("[M:3/4]" y,
+// si la voz escribe el tempo, "[Q:1/4=90]") y mueve la rejilla al compás nuevo
+void write_abc_changes(std::ostream& out, double beatCounter, AbcBarState& state) noexcept;
 
 class Statement : public ASTNodeInterface{
     // Clase base para los statements
+public:
+    // Recorre las notas en el orden en que suenan. Las repeticiones se
+    // expanden sobre la marcha, sin copiar nodos
+    virtual void for_each_played_note(const std::function<void(const SoundingStatement&)>& visit) const noexcept = 0;
+
+    // Duración en corcheas de lo que suena
+    virtual double played_beats() const noexcept = 0;
+
+    // Recorre cada nota escrita una sola vez: los cuerpos de repeticiones y
+    // motivos no se expanden y las referencias no se siguen. Es el recorrido
+    // de los pases que modifican las notas
+    virtual void for_each_stored_note(const std::function<void(SoundingStatement&)>& visit) noexcept = 0;
+
+    // Escribe la sentencia en ABC sobre la rejilla de compases. Por defecto
+    // escribe la barra pendiente, delega en to_abc y deja pendiente la barra
+    // del compás que la sentencia haya completado
+    virtual void to_abc_on_grid(std::ostream& out, double& beatCounter, AbcBarState& state) const noexcept;
+
+    // Verifica que ninguna nota cruce una barra del mapa, desde position (en
+    // semicorcheas) hasta el final de la sentencia, donde deja position. Si
+    // una cruza, devuelve false con ella en crossing y su comienzo en
+    // position. Por omisión recorre las notas que suenan
+    virtual bool check_bar_grid(const TempoMap& tempo_map, long& position,
+                                const SoundingStatement*& crossing) const noexcept;
+
+    // Deshace lo que enlazó resolve_names (los motivos de las referencias),
+    // como si la sentencia acabara de traducirse, para volver a resolverla
+    // con otra tabla (ver ScoreDocument). Por omisión no hay nada que deshacer
+    virtual void reset_names() noexcept;
+
+    // Ubicación en el archivo fuente, si el front end la conoce
+    void set_source_location(SourceLocation location) noexcept;
+    SourceLocation get_source_location() const noexcept;
+
+private:
+    SourceLocation source_location;
+};
+
+// Escribe una secuencia de sentencias en ABC sobre la rejilla de compases.
+// La barra de cada compás completo se escribe al comenzar el siguiente, para
+// que una repetición pueda poner "|:" en su lugar
+template <typename Statements>
+void statements_to_abc(const Statements& statements, std::ostream& out,
+                       double& beatCounter, AbcBarState& state) noexcept {
+    for (const auto& stmt : statements) {
+        stmt->to_abc_on_grid(out, beatCounter, state);
+    }
+}
+
+// Escribe la barra final de una secuencia, salvo que ya termine en ":|"
+void finish_abc_bars(std::ostream& out, const AbcBarState& state) noexcept;
+
+// Sentencia que suena: una nota o un acorde. Sus alturas (una en la nota,
+// varias en el acorde) comienzan juntas y comparten la duración. Es lo que
+// visitan for_each_played_note y for_each_stored_note
+class SoundingStatement : public Statement{
+public:
+    virtual const DurationExpression* get_duration() const noexcept = 0;
+
+    // Alturas en el orden en que se escribieron
+    virtual std::size_t pitch_count() const noexcept = 0;
+    virtual std::string pitch_name(std::size_t index) const noexcept = 0;
+    virtual int pitch_octave(std::size_t index) const noexcept = 0;
+    virtual int pitch_midi_number(std::size_t index) const noexcept = 0;
+
+    // Reescribe una altura a partir de un número MIDI, como
+    // NoteExpression::set_midi_number
+    virtual void set_pitch_midi_number(std::size_t index, int midi, const NoteSpelling& spelling) noexcept = 0;
+
+    // Copia independiente, con su ubicación; el llamador la libera con destroy
+    virtual SoundingStatement* clone() const noexcept = 0;
+
+    void for_each_played_note(const std::function<void(const SoundingStatement&)>& visit) const noexcept override;
+    double played_beats() const noexcept override;
+    void for_each_stored_note(const std::function<void(SoundingStatement&)>& visit) noexcept override;
 };
 
-class NoteStatement : public Statement{
+class NoteStatement final : public SoundingStatement{
 public:
     NoteStatement(NoteExpression* note, DurationExpression* duration) noexcept;
 
-    NoteExpression* get_note() const noexcept;
-    DurationExpression* get_duration() const noexcept;
+    // Nota con los nodos compartidos de un NotePool (ver NotePool::make_note):
+    // no los libera, y al transponerla toma del pool los de la nueva altura
+    NoteStatement(NoteExpression* note, DurationExpression* duration, NotePool* pool) noexcept;
+
+    const NoteExpression* get_note() const noexcept;
+    const DurationExpression* get_duration() const noexcept override;
     std::string to_string() const noexcept override;
     void destroy() noexcept override;
     bool resolve_names(SymbolTable& table) noexcept override;
     void to_abc(std::ostream& out, double &beatCounter) const noexcept override;
 
+    std::size_t pitch_count() const noexcept override;
+    std::string pitch_name(std::size_t index) const noexcept override;
+    int pitch_octave(std::size_t index) const noexcept override;
+    int pitch_midi_number(std::size_t index) const noexcept override;
+    void set_pitch_midi_number(std::size_t index, int midi, const NoteSpelling& spelling) noexcept override;
+    SoundingStatement* clone() const noexcept override;
+
+    // Verifica que tempo, compás y tonalidad estén declarados antes de usar notas
+    static bool check_declarations(SymbolTable& table) noexcept;
+
 private:
     NoteExpression* note;
     DurationExpression* duration;
-}; 
\ No newline at end of file
+    NotePool* pool{nullptr};   // Si no es nullptr, note y duration son del pool
+};
+
+// Acorde ("[Do4 Mi4 Sol4] Negra"): notas simultáneas con una sola duración.
+// Las notas se guardan dentro de la sentencia, en un arreglo de capacidad
+// fija, y no como un NoteExpression por altura: un acorde es una sola
+// asignación, y se valida y se escribe en ABC ("[CEG]2") en una pasada.
+class ChordStatement final : public SoundingStatement{
+public:
+    // Notas por acorde (CHORD_CAPACITY)
+    static constexpr std::size_t CAPACITY = CHORD_CAPACITY;
+
+    ChordStatement(DurationType duration) noexcept;
+
+    // Agrega una nota (nombre de a lo sumo 4 letras, como "Sol#"). Si el
+    // acorde está lleno no la guarda, devuelve false y resolve_names lo reporta
+    bool add_note(std::string_view note_name, int octave) noexcept;
+
+    const DurationExpression* get_duration() const noexcept override;
+    std::string to_string() const noexcept override;
+    void destroy() noexcept override;
+    bool resolve_names(SymbolTable& table) noexcept override;
+    void to_abc(std::ostream& out, double &beatCounter) const noexcept override;
+
+    std::size_t pitch_count() const noexcept override;
+    std::string pitch_name(std::size_t index) const noexcept override;
+    int pitch_octave(std::size_t index) const noexcept override;
+    int pitch_midi_number(std::size_t index) const noexcept override;
+    void set_pitch_midi_number(std::size_t index, int midi, const NoteSpelling& spelling) noexcept override;
+    SoundingStatement* clone() const noexcept override;
+
+private:
+    // Seis bytes por nota: el nombre con su terminador y la octava
+    struct ChordNote {
+        char name[5];
+        signed char octave;
+    };
+
+    std::array<ChordNote, CAPACITY> notes{};
+    std::size_t count{0};
+    std::size_t written{0};   // Notas escritas en la fuente, aunque no entraran
+    DurationExpression duration;
+};
+
+// Bloque repetido ("Repetir N { ... }"). El cuerpo se guarda y se valida una
+// sola vez; la memoria crece con el material distinto y no con lo que suena.
+class RepeatStatement final : public Statement{
+public:
+    RepeatStatement(int count, ProgramBody body) noexcept;
+
+    int get_count() const noexcept;
+    const ProgramBody& get_body() const noexcept;
+    std::string to_string() const noexcept override;
+    void destroy() noexcept override;
+    bool resolve_names(SymbolTable& table) noexcept override;
+    void to_abc(std::ostream& out, double &beatCounter) const noexcept override;
+
+    void for_each_played_note(const std::function<void(const SoundingStatement&)>& visit) const noexcept override;
+    double played_beats() const noexcept override;
+    void for_each_stored_note(const std::function<void(SoundingStatement&)>& visit) noexcept override;
+
+    // Con repetición nativa ("|: ... :|") si el bloque comienza en una barra y
+    // dura compases completos; si no, el cuerpo se escribe count veces
+    void to_abc_on_grid(std::ostream& out, double& beatCounter, AbcBarState& state) const noexcept override;
+
+    // Sin expandir: una vuelta cruza o no una barra según dónde comienza en
+    // el compás, así que en cada tramo del mapa se verifican solo las vueltas
+    // que comienzan en posiciones distintas del compás
+    bool check_bar_grid(const TempoMap& tempo_map, long& position,
+                        const SoundingStatement*& crossing) const noexcept override;
+
+    void reset_names() noexcept override;
+
+private:
+    int count;
+    ProgramBody body;
+};
+
+// Definición de un motivo ("Motivo Tema { ... }"). No suena donde se define: la
+// tabla de símbolos guarda un puntero a la definición ya validada y cada
+// referencia recorre ese mismo cuerpo, que no se modifica después.
+class MotifStatement final : public Statement{
+public:
+    MotifStatement(const std::string& name, ProgramBody body) noexcept;
+
+    std::string get_name() const noexcept;
+    const ProgramBody& get_body() const noexcept;
+
+    // Duración del cuerpo, en corcheas (calculada al validar la definición)
+    double body_beats() const noexcept;
+
+    // Recorre las notas del cuerpo, en el orden en que suenan
+    void for_each_body_note(const std::function<void(const SoundingStatement&)>& visit) const noexcept;
+
+    // Escribe el cuerpo en ABC a partir del estado de la rejilla. El texto
+    // depende solo de la posición dentro del compás y del estado de barras,
+    // así que se genera la primera vez y se reutiliza en las demás
+    void body_to_abc(std::ostream& out, double& beatCounter, AbcBarState& state) const noexcept;
+
+    std::string to_string() const noexcept override;
+    void destroy() noexcept override;
+    bool resolve_names(SymbolTable& table) noexcept override;
+    void to_abc(std::ostream& out, double &beatCounter) const noexcept override;
+
+    void for_each_played_note(const std::function<void(const SoundingStatement&)>& visit) const noexcept override;
+    double played_beats() const noexcept override;
+    void for_each_stored_note(const std::function<void(SoundingStatement&)>& visit) noexcept override;
+    void to_abc_on_grid(std::ostream& out, double& beatCounter, AbcBarState& state) const noexcept override;
+    void reset_names() noexcept override;
+
+    // Nombre del símbolo de un motivo en la tabla de símbolos
+    static std::string symbol_name(const std::string& name) noexcept;
+
+private:
+    // Texto ABC del cuerpo y estado de barras en que termina
+    struct CachedAbc {
+        std::string text;
+        bool pending_bar;
+        bool closed;
+    };
+
+    // Clave: longitud del compás, posición en el compás, barra pendiente y
+    // si el motivo suena dentro de una repetición nativa
+    using AbcCacheKey = std::tuple<double, double, bool, bool>;
+
+    std::string name;
+    ProgramBody body;
+    double beats{0.0};
+
+    // Las voces se generan en paralelo y pueden usar el mismo motivo
+    mutable std::mutex abc_cache_mutex;
+    mutable std::map<AbcCacheKey, CachedAbc> abc_cache;
+};
+
+// Referencia a un motivo ("Tema"). resolve_names la enlaza con la definición
+// visible en la tabla de símbolos; el cuerpo no se copia.
+class MotifReferenceStatement final : public Statement{
+public:
+    MotifReferenceStatement(const std::string& name) noexcept;
+
+    std::string get_name() const noexcept;
+    const MotifStatement* get_motif() const noexcept;
+
+    std::string to_string() const noexcept override;
+    void destroy() noexcept override;
+    bool resolve_names(SymbolTable& table) noexcept override;
+    void to_abc(std::ostream& out, double &beatCounter) const noexcept override;
+
+    void for_each_played_note(const std::function<void(const SoundingStatement&)>& visit) const noexcept override;
+    double played_beats() const noexcept override;
+    void for_each_stored_note(const std::function<void(SoundingStatement&)>& visit) noexcept override;
+    void to_abc_on_grid(std::ostream& out, double& beatCounter, AbcBarState& state) const noexcept override;
+
+    // Verifica el cuerpo del motivo sentencia por sentencia, para que sus
+    // repeticiones tampoco se expandan
+    bool check_bar_grid(const TempoMap& tempo_map, long& position,
+                        const SoundingStatement*& crossing) const noexcept override;
+
+    void reset_names() noexcept override;
+
+private:
+    std::string name;
+    const MotifStatement* motif{nullptr};
+};
+
+// Cambio de tempo a mitad de la partitura: cualquier "Tempo" después del
+// primero. No suena; su posición en la voz lo ubica en el mapa de tempo
+class TempoChangeStatement final : public Statement{
+public:
+    TempoChangeStatement(int tempo_value) noexcept;
+
+    int get_tempo_value() const noexcept;
+    std::string to_string() const noexcept override;
+    void destroy() noexcept override;
+    bool resolve_names(SymbolTable& table) noexcept override;
+    void to_abc(std::ostream& out, double &beatCounter) const noexcept override;
+
+    void for_each_played_note(const std::function<void(const SoundingStatement&)>& visit) const noexcept override;
+    double played_beats() const noexcept override;
+    void for_each_stored_note(const std::function<void(SoundingStatement&)>& visit) noexcept override;
+
+    // El campo "[Q:...]" lo escribe la voz a partir del mapa de tempo
+    void to_abc_on_grid(std::ostream& out, double& beatCounter, AbcBarState& state) const noexcept override;
+
+private:
+    int tempo_value;
+};
+
+// Cambio de compás a mitad de la partitura: cualquier "Compas" después del
+// primero. Debe caer en una barra del compás anterior (ver TempoMap::build)
+class TimeSignatureChangeStatement final : public Statement{
+public:
+    TimeSignatureChangeStatement(int numerator, int denominator) noexcept;
+
+    int get_numerator() const noexcept;
+    int get_denominator() const noexcept;
+    std::string to_string() const noexcept override;
+    void destroy() noexcept override;
+    bool resolve_names(SymbolTable& table) noexcept override;
+    void to_abc(std::ostream& out, double &beatCounter) const noexcept override;
+
+    void for_each_played_note(const std::function<void(const SoundingStatement&)>& visit) const noexcept override;
+    double played_beats() const noexcept override;
+    void for_each_stored_note(const std::function<void(SoundingStatement&)>& visit) noexcept override;
+
+    // El campo "[M:...]" lo escriben todas las voces a partir del mapa de tempo
+    void to_abc_on_grid(std::ostream& out, double& beatCounter, AbcBarState& state) const noexcept override;
+
+private:
+    int numerator;
+    int denominator;
+};
@@ -0,0 +1,170 @@
+#include "tempo_map.hpp"
+#include "ast_node_interface.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Segundos por semicorchea a un tempo dado en negras por minuto
+static double tick_seconds(int tempo) noexcept {
+    return 15.0 / tempo;
+}
+
+static long bar_ticks_of(int numerator, int denominator) noexcept {
+    // Una semicorchea es 1/16 de redonda
+    return numerator * 16L / denominator;
+}
+
+void TempoMap::reset(int tempo, int numerator, int denominator) noexcept {
+    long bar_ticks = bar_ticks_of(numerator, denominator);
+    this->initial = TempoSegment{0, 0.0, tempo, numerator, denominator, bar_ticks, 0, 1};
+    this->changes.clear();
+    this->segments.clear();
+    this->built = 0;
+}
+
+void TempoMap::add_tempo_change(long tick, int tempo) noexcept {
+    this->changes.push_back(Change{tick, tempo, 0, 0});
+}
+
+void TempoMap::add_time_signature_change(long tick, int numerator, int denominator) noexcept {
+    this->changes.push_back(Change{tick, 0, numerator, denominator});
+}
+
+bool TempoMap::build() noexcept {
+    auto by_tick = [](const Change& a, const Change& b) { return a.tick < b.tick; };
+
+    // Los cambios nuevos que no preceden al último acumulado continúan los
+    // tramos armados; si no, se arman todos otra vez
+    std::size_t first = this->built;
+    bool extend = first > 0 && !this->segments.empty() &&
+                  std::none_of(this->changes.begin() + first, this->changes.end(),
+                               [&](const Change& change) { return change.tick < this->changes[first - 1].tick; });
+    if (extend) {
+        std::stable_sort(this->changes.begin() + first, this->changes.end(), by_tick);
+    } else {
+        std::stable_sort(this->changes.begin(), this->changes.end(), by_tick);
+        this->segments.clear();
+        this->segments.push_back(this->initial);
+        first = 0;
+    }
+    this->built = this->changes.size();
+
+    for (std::size_t i = first; i < this->changes.size(); ++i) {
+        const Change& change = this->changes[i];
+        TempoSegment current = this->segments.back();
+
+        if (change.numerator != 0) {
+            // El compás nuevo comienza en una barra del anterior
+            long offset = change.tick - current.meter_tick;
+            if (offset % current.bar_ticks != 0) {
+                SemanticErrorMessage{} << "Error: El cambio de compás a " << change.numerator << "/"
+                                       << change.denominator << " no cae en una barra (compás "
+                                       << current.meter_measure + offset / current.bar_ticks << ").\n";
+                this->segments.clear();
+                this->built = 0;
+                return false;
+            }
+            current.meter_measure += offset / current.bar_ticks;
+            current.meter_tick = change.tick;
+            current.numerator = change.numerator;
+            current.denominator = change.denominator;
+            current.bar_ticks = bar_ticks_of(change.numerator, change.denominator);
+        }
+        if (change.tempo != 0) {
+            current.tempo = change.tempo;
+        }
+
+        // Varios cambios en la misma posición forman un solo tramo. El
+        // primero nunca se reemplaza: guarda los valores de la cabecera
+        if (change.tick == this->segments.back().tick && this->segments.size() > 1) {
+            this->segments.back() = current;
+            continue;
+        }
+        const TempoSegment& previous = this->segments.back();
+        current.seconds = previous.seconds + (change.tick - previous.tick) * tick_seconds(previous.tempo);
+        current.tick = change.tick;
+        this->segments.push_back(current);
+    }
+    return true;
+}
+
+bool TempoMap::empty() const noexcept {
+    return this->segments.empty();
+}
+
+const std::vector<TempoSegment>& TempoMap::get_segments() const noexcept {
+    return this->segments;
+}
+
+std::size_t TempoMap::segment_index(long tick) const noexcept {
+    auto after = std::upper_bound(this->segments.begin() + 1, this->segments.end(), tick,
+                                  [](long value, const TempoSegment& segment) { return value < segment.tick; });
+    return static_cast<std::size_t>(after - this->segments.begin()) - 1;
+}
+
+const TempoSegment& TempoMap::segment_at(long tick) const noexcept {
+    return this->segments[this->segment_index(tick)];
+}
+
+double TempoMap::tick_to_seconds(long tick) const noexcept {
+    return this->tick_to_seconds(tick, this->segment_index(tick));
+}
+
+std::size_t TempoMap::next_segment_index(long tick, std::size_t segment) const noexcept {
+    while (segment + 1 < this->segments.size() && this->segments[segment + 1].tick <= tick) {
+        ++segment;
+    }
+    return segment;
+}
+
+double TempoMap::tick_to_seconds(long tick, std::size_t index) const noexcept {
+    const TempoSegment& segment = this->segments[index];
+    return segment.seconds + (tick - segment.tick) * tick_seconds(segment.tempo);
+}
+
+long TempoMap::seconds_to_tick(double seconds) const noexcept {
+    auto after = std::upper_bound(this->segments.begin() + 1, this->segments.end(), seconds,
+                                  [](double value, const TempoSegment& segment) { return value < segment.seconds; });
+    const TempoSegment& segment = *(after - 1);
+    // El margen evita que el redondeo de los segundos acumulados deje una
+    // posición exacta en la semicorchea anterior
+    double ticks = (seconds - segment.seconds) / tick_seconds(segment.tempo);
+    return segment.tick + static_cast<long>(std::floor(ticks + 1e-9));
+}
+
+long TempoMap::tick_to_measure(long tick) const noexcept {
+    return this->tick_to_measure(tick, this->segment_index(tick));
+}
+
+long TempoMap::tick_to_measure(long tick, std::size_t index) const noexcept {
+    const TempoSegment& segment = this->segments[index];
+    return segment.meter_measure + (tick - segment.meter_tick) / segment.bar_ticks;
+}
+
+long TempoMap::measure_to_tick(long measure) const noexcept {
+    // El número de compás al comenzar cada tramo no decrece
+    auto after = std::upper_bound(this->segments.begin() + 1, this->segments.end(), measure,
+                                  [](long value, const TempoSegment& segment) { return value < segment.meter_measure; });
+    const TempoSegment& segment = *(after - 1);
+    return segment.meter_tick + (measure - segment.meter_measure) * segment.bar_ticks;
+}
+
+double TempoMap::measures_at(long tick) const noexcept {
+    const TempoSegment& segment = this->segment_at(tick);
+    return (segment.meter_measure - 1) + static_cast<double>(tick - segment.meter_tick) / segment.bar_ticks;
+}
+
+long TempoMap::next_barline(long tick) const noexcept {
+    // Un cambio de compás cae en una barra del anterior, así que la barra
+    // siguiente según el tramo vigente no salta ningún cambio
+    const TempoSegment& segment = this->segment_at(tick);
+    return segment.meter_tick + ((tick - segment.meter_tick) / segment.bar_ticks + 1) * segment.bar_ticks;
+}
+
+bool TempoMap::is_barline(long tick) const noexcept {
+    const TempoSegment& segment = this->segment_at(tick);
+    return (tick - segment.meter_tick) % segment.bar_ticks == 0;
+}
+
+long TempoMap::ticks_from_beats(double beats) noexcept {
+    return std::lround(beats * TICKS_PER_BEAT);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Semicorcheas por corchea (la unidad de DurationExpression::beats()). El mapa
+// trabaja en semicorcheas, la duración más corta, para que todo sea entero
+constexpr long TICKS_PER_BEAT = 2;
+
+// Tramo de la partitura con un mismo tempo y un mismo compás
+struct TempoSegment {
+    long tick;            // Comienzo, en semicorcheas desde el inicio
+    double seconds;       // Segundos transcurridos al comenzar
+    int tempo;            // Negras por minuto
+    int numerator;
+    int denominator;
+    long bar_ticks;       // Semicorcheas por compás
+    long meter_tick;      // Barra donde comenzó el compás vigente
+    long meter_measure;   // Número de compás (desde 1) que comienza en meter_tick
+};
+
+// Mapa de tempo y compás: los cambios ordenados por posición, cada uno con
+// las semicorcheas, los segundos y los compases acumulados hasta él. Con eso
+// cualquier conversión entre semicorcheas, segundos y compases es una
+// búsqueda binaria sobre los cambios, sin recorrer la partitura.
+//
+// Se arma en dos pasos: reset con los valores de la cabecera, los cambios en
+// cualquier orden y build. Los cambios en una misma posición se aplican en el
+// orden en que se agregaron (vale el último). Se pueden agregar más cambios
+// y volver a llamar a build: si ninguno precede a los ya acumulados, solo
+// acumula los nuevos (así crece el mapa de quien recibe la partitura en
+// orden, ver pipeline.hpp).
+class TempoMap {
+public:
+    void reset(int tempo, int numerator, int denominator) noexcept;
+    void add_tempo_change(long tick, int tempo) noexcept;
+    void add_time_signature_change(long tick, int numerator, int denominator) noexcept;
+
+    // Ordena y acumula los cambios. Si un cambio de compás no cae en una
+    // barra del compás anterior, falla con el mensaje de error y queda vacío
+    bool build() noexcept;
+
+    // Sin tramos hasta el primer build (por ejemplo, si falta el compás)
+    bool empty() const noexcept;
+    const std::vector<TempoSegment>& get_segments() const noexcept;
+
+    // Índice del tramo vigente en tick: el último que comienza en tick o antes
+    std::size_t segment_index(long tick) const noexcept;
+    const TempoSegment& segment_at(long tick) const noexcept;
+
+    double tick_to_seconds(long tick) const noexcept;
+    long seconds_to_tick(double seconds) const noexcept;
+
+    // Para recorrer posiciones crecientes sin búsqueda binaria: el tramo
+    // vigente en tick buscado hacia adelante desde segment (el de la
+    // posición anterior), y las conversiones con ese tramo
+    std::size_t next_segment_index(long tick, std::size_t segment) const noexcept;
+    double tick_to_seconds(long tick, std::size_t segment) const noexcept;
+    long tick_to_measure(long tick, std::size_t segment) const noexcept;
+
+    // Compás (desde 1) que contiene tick, y semicorchea en que comienza un compás
+    long tick_to_measure(long tick) const noexcept;
+    long measure_to_tick(long measure) const noexcept;
+
+    // Compases transcurridos hasta tick, con fracción (para los mensajes)
+    double measures_at(long tick) const noexcept;
+
+    // Primera barra posterior a tick
+    long next_barline(long tick) const noexcept;
+    bool is_barline(long tick) const noexcept;
+
+    static long ticks_from_beats(double beats) noexcept;
+
+private:
+    // Un cambio deja en 0 lo que no cambia
+    struct Change {
+        long tick;
+        int tempo;
+        int numerator;
+        int denominator;
+    };
+
+    TempoSegment initial{};
+    std::vector<Change> changes;
+    std::size_t built{0};   // Cambios ya acumulados en segments
+    std::vector<TempoSegment> segments;
+};
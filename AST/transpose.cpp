@@ -0,0 +1,186 @@
+#include "transpose.hpp"
+#include "expression.hpp"
+#include "statement.hpp"
+#include "voice.hpp"
+#include <algorithm>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Alturas MIDI de Do1 y Si8: el rango de octavas que acepta NoteExpression
+static const int lowest_pitch = LOWEST_PITCH;
+static const int highest_pitch = HIGHEST_PITCH;
+
+void transpose_pitches(std::int16_t* pitches, std::size_t count, int semitones,
+                       int& low, int& high) noexcept {
+    std::size_t i = 0;
+    std::int16_t min_pitch = INT16_MAX;
+    std::int16_t max_pitch = INT16_MIN;
+
+#ifdef __SSE2__
+    if (count >= 8) {
+        const __m128i offset = _mm_set1_epi16(static_cast<std::int16_t>(semitones));
+        __m128i minimum = _mm_set1_epi16(INT16_MAX);
+        __m128i maximum = _mm_set1_epi16(INT16_MIN);
+        for (; i + 8 <= count; i += 8) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pitches + i));
+            block = _mm_add_epi16(block, offset);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pitches + i), block);
+            minimum = _mm_min_epi16(minimum, block);
+            maximum = _mm_max_epi16(maximum, block);
+        }
+
+        alignas(16) std::int16_t lanes[8];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), minimum);
+        min_pitch = *std::min_element(lanes, lanes + 8);
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), maximum);
+        max_pitch = *std::max_element(lanes, lanes + 8);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        pitches[i] = static_cast<std::int16_t>(pitches[i] + semitones);
+        min_pitch = std::min(min_pitch, pitches[i]);
+        max_pitch = std::max(max_pitch, pitches[i]);
+    }
+
+    low = min_pitch;
+    high = max_pitch;
+}
+
+bool transpose_program(MusicProgram& program, int semitones) noexcept {
+    ProgramTransposition transposition;
+    for (const auto& stmt : program.get_statements()) {
+        transposition.gather(*stmt);
+    }
+    for (const auto& voice : program.get_voices()) {
+        for (const auto& stmt : voice->get_statements()) {
+            transposition.gather(*stmt);
+        }
+    }
+    return transposition.apply(program, semitones);
+}
+
+void ProgramTransposition::gather(Statement& statement) noexcept {
+    // Reunir las alturas escritas (las de cada acorde, una por nota) en
+    // arreglos contiguos, con la sentencia y la posición de cada una
+    statement.for_each_stored_note([this](SoundingStatement& note) {
+        for (std::size_t i = 0; i < note.pitch_count(); ++i) {
+            notes.emplace_back(&note, i);
+            pitches.push_back(static_cast<std::int16_t>(note.pitch_midi_number(i)));
+        }
+    });
+}
+
+bool ProgramTransposition::apply(MusicProgram& program, int semitones) noexcept {
+    // La transposición debe caber en 16 bits para el kernel
+    semitones = std::max(-highest_pitch, std::min(semitones, highest_pitch));
+
+    int low = lowest_pitch;
+    int high = highest_pitch;
+    if (!pitches.empty()) {
+        transpose_pitches(pitches.data(), pitches.size(), semitones, low, high);
+    }
+
+    // Verificar el rango de octavas antes de modificar el programa
+    if (low < lowest_pitch || high > highest_pitch) {
+        for (std::size_t i = 0; i < pitches.size(); ++i) {
+            if (pitches[i] < lowest_pitch || pitches[i] > highest_pitch) {
+                SemanticErrorMessage{} << "Error: Al transponer " << semitones << " semitonos, la nota "
+                          << notes[i].first->pitch_name(notes[i].second)
+                          << notes[i].first->pitch_octave(notes[i].second) << " queda fuera del rango de octavas (1-8).\n";
+                break;
+            }
+        }
+        return false;
+    }
+
+    // La tonalidad se transpone primero: su armadura decide la grafía de
+    // cada altura (Mi# en Fa# mayor, Dob en Mib menor)
+    std::array<NoteSpelling, 12> spellings = KeyDeclaration("Do", KeyMode::MAYOR).pitch_spellings();
+    for (const auto& decl : program.get_declarations()) {
+        if (auto key = dynamic_cast<KeyDeclaration*>(decl)) {
+            key->transpose(semitones);
+            spellings = key->pitch_spellings();
+        }
+    }
+
+    for (std::size_t i = 0; i < notes.size(); ++i) {
+        notes[i].first->set_pitch_midi_number(notes[i].second, pitches[i], spellings[pitches[i] % 12]);
+    }
+    return true;
+}
+
+void IncrementalTransposition::start(MusicProgram& program, int semitones) noexcept {
+    // Igual que ProgramTransposition::apply, salvo que la tonalidad se
+    // transpone antes de ver las notas
+    this->semitones = std::max(-highest_pitch, std::min(semitones, highest_pitch));
+    this->failed = false;
+    this->error.clear();
+    this->spellings = KeyDeclaration("Do", KeyMode::MAYOR).pitch_spellings();
+    if (this->semitones == 0) {
+        return;
+    }
+    for (const auto& decl : program.get_declarations()) {
+        if (auto key = dynamic_cast<KeyDeclaration*>(decl)) {
+            key->transpose(this->semitones);
+            this->spellings = key->pitch_spellings();
+        }
+    }
+}
+
+void IncrementalTransposition::add(Statement& statement, std::size_t track) noexcept {
+    if (semitones == 0 || (failed && track >= failed_track)) {
+        return;
+    }
+
+    notes.clear();
+    pitches.clear();
+    statement.for_each_stored_note([this](SoundingStatement& note) {
+        for (std::size_t i = 0; i < note.pitch_count(); ++i) {
+            notes.emplace_back(&note, i);
+            pitches.push_back(static_cast<std::int16_t>(note.pitch_midi_number(i)));
+        }
+    });
+    if (pitches.empty()) {
+        return;
+    }
+
+    int low = lowest_pitch;
+    int high = highest_pitch;
+    transpose_pitches(pitches.data(), pitches.size(), semitones, low, high);
+    if (low < lowest_pitch || high > highest_pitch) {
+        for (std::size_t i = 0; i < pitches.size(); ++i) {
+            if (pitches[i] < lowest_pitch || pitches[i] > highest_pitch) {
+                std::ostringstream message;
+                message << "Error: Al transponer " << semitones << " semitonos, la nota "
+                        << notes[i].first->pitch_name(notes[i].second)
+                        << notes[i].first->pitch_octave(notes[i].second) << " queda fuera del rango de octavas (1-8).\n";
+                error = message.str();
+                break;
+            }
+        }
+        failed = true;
+        failed_track = track;
+        return;
+    }
+
+    // Tras un error el programa ya no sirve: no hace falta escribir las alturas
+    if (failed) {
+        return;
+    }
+    for (std::size_t i = 0; i < notes.size(); ++i) {
+        notes[i].first->set_pitch_midi_number(notes[i].second, pitches[i], spellings[pitches[i] % 12]);
+    }
+}
+
+bool IncrementalTransposition::finish() noexcept {
+    if (failed) {
+        SemanticErrorMessage{} << error;
+    }
+    return !failed;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "declaration.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+class SoundingStatement;
+class Statement;
+
+// Suma semitones a cada altura (número MIDI) y devuelve en low y high la
+// menor y la mayor altura resultante, en la misma pasada. Con SSE2 procesa
+// ocho alturas de 16 bits por instrucción.
+void transpose_pitches(std::int16_t* pitches, std::size_t count, int semitones,
+                       int& low, int& high) noexcept;
+
+// Transpone el programa: la tonalidad y cada nota escrita (los cuerpos de
+// repeticiones y motivos se transponen una sola vez). Las notas se reúnen en
+// un arreglo de alturas MIDI, se transponen con transpose_pitches y se
+// vuelven a escribir con las alteraciones de la nueva tonalidad. Si alguna
+// nota queda fuera de las octavas 1-8, reporta el error y no modifica nada.
+bool transpose_program(MusicProgram& program, int semitones) noexcept;
+
+// transpose_program en dos pasos, para quien recorre las sentencias por su
+// cuenta (ver TranspositionPass): gather reúne las alturas escritas de una
+// sentencia y apply transpone todas las reunidas y la tonalidad
+class ProgramTransposition {
+public:
+    void gather(Statement& statement) noexcept;
+    bool apply(MusicProgram& program, int semitones) noexcept;
+
+private:
+    // Cada altura con su sentencia y su posición en ella
+    std::vector<std::pair<SoundingStatement*, std::size_t>> notes;
+    std::vector<std::int16_t> pitches;
+};
+
+// transpose_program para quien usa cada sentencia en cuanto la recibe (ver
+// pipeline.hpp): start transpone la tonalidad y add transpone cada sentencia
+// al llegar. Las sentencias vienen de varias partes (track 0 es el nivel
+// superior y track i + 1 la voz i) y finish reporta la primera nota fuera de
+// rango en el orden de transpose_program. Si finish falla, el programa queda
+// transpuesto a medias
+class IncrementalTransposition {
+public:
+    void start(MusicProgram& program, int semitones) noexcept;
+    void add(Statement& statement, std::size_t track) noexcept;
+    bool finish() noexcept;
+
+private:
+    int semitones{0};
+    std::array<NoteSpelling, 12> spellings;
+
+    // La primera nota fuera de rango de la primera parte que tuvo una
+    bool failed{false};
+    std::size_t failed_track{0};
+    std::string error;
+
+    std::vector<std::pair<SoundingStatement*, std::size_t>> notes;
+    std::vector<std::int16_t> pitches;
+};
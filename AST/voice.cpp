@@ -0,0 +1,209 @@
+#include "voice.hpp"
+#include "statement.hpp"
+#include "../Semantic_Analysis/symbol_table.hpp"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+// Implementación de MusicVoice
+MusicVoice::MusicVoice(const std::string& name) noexcept
+    : name{name} {}
+
+void MusicVoice::add_statement(Statement* statement) noexcept{
+    if (statement != nullptr)
+    {
+        this->statements.push_back(statement);
+    }
+}
+
+std::string MusicVoice::get_name() const noexcept{
+    return this->name;
+}
+
+const std::vector<Statement*>& MusicVoice::get_statements() const noexcept{
+    return this->statements;
+}
+
+std::vector<Statement*> MusicVoice::release_statements() noexcept{
+    std::vector<Statement*> released = std::move(this->statements);
+    this->statements.clear();
+    return released;
+}
+
+double MusicVoice::total_beats() const noexcept{
+    double total = 0.0;
+    for (const auto& stmt : this->statements)
+    {
+        total += stmt->played_beats();
+    }
+    return total;
+}
+
+bool MusicVoice::check_bar_grid(const TempoMap& tempo_map) const noexcept{
+    if (tempo_map.empty())
+    {
+        return true;
+    }
+
+    // Las posiciones se cuentan en semicorcheas, así que la aritmética es
+    // exacta. Las repeticiones no se expanden (ver RepeatStatement::check_bar_grid)
+    long position = 0;
+    for (const auto& stmt : this->statements)
+    {
+        if (!this->check_bar_grid(*stmt, tempo_map, position))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MusicVoice::check_bar_grid(const Statement& statement, const TempoMap& tempo_map, long& position) const noexcept{
+    SourceLocationScope location{statement.get_source_location()};
+    const SoundingStatement* crossing = nullptr;
+    if (!statement.check_bar_grid(tempo_map, position, crossing))
+    {
+        SemanticErrorMessage{} << "Error: En la voz " << this->name << ", la nota " << crossing->to_string()
+                  << " cruza la barra del compás " << tempo_map.tick_to_measure(position) << ".\n";
+        return false;
+    }
+    return true;
+}
+
+void MusicVoice::trim(long from, long to) noexcept{
+    trim_statements(this->statements, from, to);
+}
+
+std::string MusicVoice::to_string() const noexcept{
+    std::string result = "Voz " + this->name + ":\n";
+    for (const auto& stmt : this->statements)
+    {
+        result += "    " + stmt->to_string() + "\n";
+    }
+    return result;
+}
+
+void MusicVoice::destroy() noexcept{
+    for (auto& stmt : this->statements)
+    {
+        if (stmt != nullptr)
+        {
+            stmt->destroy();
+            delete stmt;
+        }
+    }
+    this->statements.clear();
+}
+
+bool MusicVoice::resolve_names(SymbolTable& table) noexcept{
+    // Los motivos definidos dentro de la voz son locales a ella
+    table.enter_scope();
+    bool valid = true;
+    for (const auto& stmt : this->statements)
+    {
+        SourceLocationScope location{stmt->get_source_location()};
+        if (!stmt->resolve_names(table))
+        {
+            valid = false;
+            break;
+        }
+    }
+    table.exit_scope();
+    return valid;
+}
+
+void MusicVoice::to_abc(std::ostream& out, double& beatCounter) const noexcept{
+    this->to_abc(out, beatCounter, 0.0);
+}
+
+void MusicVoice::to_abc(std::ostream& out, double& beatCounter, double bar_length,
+                        const TempoMap* tempo_map, bool write_tempo) const noexcept{
+    out << "V:" << this->name << "\n";
+    AbcBarState state{bar_length};
+    start_abc_bars(state, tempo_map, write_tempo);
+    statements_to_abc(this->statements, out, beatCounter, state);
+    finish_abc_bars(out, state);
+}
+
+void trim_statements(std::vector<Statement*>& statements, long from, long to) noexcept{
+    std::vector<Statement*> kept;
+    long position = 0;
+    for (auto& stmt : statements)
+    {
+        long end = position + TempoMap::ticks_from_beats(stmt->played_beats());
+        bool keep;
+        if (end == position)
+        {
+            bool change = dynamic_cast<const TempoChangeStatement*>(stmt) != nullptr ||
+                          dynamic_cast<const TimeSignatureChangeStatement*>(stmt) != nullptr;
+            keep = !change || (position > from && position < to);
+        }
+        else if (position >= from && end <= to)
+        {
+            keep = true;
+        }
+        else
+        {
+            // Las notas no cruzan barras, así que cada una queda dentro o fuera
+            long tick = position;
+            stmt->for_each_played_note([&](const SoundingStatement& note) {
+                long next = tick + TempoMap::ticks_from_beats(note.played_beats());
+                if (tick >= from && next <= to)
+                {
+                    kept.push_back(note.clone());
+                }
+                tick = next;
+            });
+            keep = false;
+        }
+
+        if (keep)
+        {
+            kept.push_back(stmt);
+        }
+        else
+        {
+            stmt->destroy();
+            delete stmt;
+        }
+        position = end;
+    }
+    statements = std::move(kept);
+}
+
+void parallel_for_each_index(std::size_t count,
+                             const std::function<void(std::size_t)>& function) noexcept{
+    std::size_t thread_count = std::min<std::size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+    std::atomic<std::size_t> next_index{0};
+
+    // Cada hilo toma el siguiente índice libre, así que las voces largas no
+    // dejan a los demás hilos esperando. Los errores de cada índice se
+    // guardan aparte y, después de esperar a los hilos, se entregan al
+    // destino del hilo que llama en el orden de los índices: el informe es
+    // el mismo sin importar qué hilo terminó primero.
+    std::vector<BufferedErrorSink> errors(count);
+    auto worker = [&]() {
+        for (std::size_t i = next_index++; i < count; i = next_index++)
+        {
+            SemanticErrorRedirect redirect{errors[i]};
+            function(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < thread_count; ++i)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    SemanticErrorSink& sink = semantic_error_sink();
+    for (auto& buffer : errors)
+    {
+        buffer.replay(sink);
+    }
+}
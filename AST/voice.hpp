@@ -0,0 +1,67 @@
+#pragma once
+
+#include "ast_node_interface.hpp"
+#include "tempo_map.hpp"
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Voz (parte) de una partitura: una secuencia de notas propia, que se
+// traduce a un campo V: de ABC. Las voces son independientes entre sí, así
+// que el análisis semántico y la generación de cada una pueden correr en paralelo.
+class MusicVoice final : public ASTNodeInterface{
+public:
+    MusicVoice(const std::string& name) noexcept;
+
+    void add_statement(Statement* statement) noexcept;
+
+    std::string get_name() const noexcept;
+    const std::vector<Statement*>& get_statements() const noexcept;
+
+    // Entrega las sentencias al llamador y deja la voz vacía
+    std::vector<Statement*> release_statements() noexcept;
+
+    // Duración total de la voz, en corcheas
+    double total_beats() const noexcept;
+
+    // Verifica que ninguna nota cruce una barra de la rejilla de compases,
+    // con los cambios de compás del mapa (vacío: sin rejilla)
+    bool check_bar_grid(const TempoMap& tempo_map) const noexcept;
+
+    // Lo mismo para una sentencia de la voz que comienza en position, que
+    // queda al final de ella; para quien recorre la voz por partes (ver
+    // ScoreDocument). El mapa no puede estar vacío
+    bool check_bar_grid(const Statement& statement, const TempoMap& tempo_map, long& position) const noexcept;
+
+    // Deja en la voz solo lo que suena en [from, to) (ver trim_statements)
+    void trim(long from, long to) noexcept;
+
+    std::string to_string() const noexcept override;
+    void destroy() noexcept override;
+    bool resolve_names(SymbolTable& table) noexcept override;
+
+    // Sin rejilla de compases no se insertan barras intermedias
+    void to_abc(std::ostream& out, double &beatCounter) const noexcept override;
+    void to_abc(std::ostream& out, double &beatCounter, double bar_length,
+                const TempoMap* tempo_map = nullptr, bool write_tempo = false) const noexcept;
+
+private:
+    std::string name;
+    std::vector<Statement*> statements;
+};
+
+// Deja en statements solo lo que suena en [from, to), en semicorcheas desde
+// la primera sentencia, para compilar un rango de compases por separado. Una
+// sentencia que cruza un extremo (una repetición o un motivo que abarca la
+// barra) se reemplaza por copias de sus notas dentro del rango. Las
+// definiciones de motivos se conservan; los cambios de tempo y de compás,
+// solo si caen después de from: los de from van en la cabecera del
+// fragmento. Las referencias a motivos deben estar resueltas.
+void trim_statements(std::vector<Statement*>& statements, long from, long to) noexcept;
+
+// Ejecuta function(i) para cada i en [0, count), repartiendo los índices
+// entre tantos hilos como núcleos haya (o count, si es menor). Los errores
+// semánticos se informan agrupados por índice y en orden de índice.
+void parallel_for_each_index(std::size_t count,
+                             const std::function<void(std::size_t)>& function) noexcept;
@@ -0,0 +1,78 @@
+#include "compilador_musical.h"
+#include "compile.hpp"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace {
+
+// Resultado de una compilación que no llegó a producir ABC ni diagnósticos
+cm_status_t compileFailed(cm_status_t status, size_t* output_length,
+                          size_t* diagnostic_count) noexcept {
+    if (output_length != nullptr) {
+        *output_length = 0;
+    }
+    if (diagnostic_count != nullptr) {
+        *diagnostic_count = 0;
+    }
+    return status;
+}
+
+}
+
+cm_status_t cm_compile(const char* source, size_t source_length, int semitones,
+                       char* output, size_t output_capacity, size_t* output_length,
+                       cm_diagnostic_t* diagnostics, size_t diagnostic_capacity,
+                       size_t* diagnostic_count) {
+    // compileBuffer y los std::string pueden lanzar std::bad_alloc, que no
+    // debe propagarse a un llamador en C
+    try {
+        std::string abc;
+        std::vector<CompileDiagnostic> found;
+        bool compiled = compileBuffer(source, source_length, semitones, abc, found);
+
+        if (diagnostic_count != nullptr) {
+            *diagnostic_count = found.size();
+        }
+        std::size_t copied = std::min(found.size(), diagnostic_capacity);
+        for (std::size_t i = 0; i < copied; ++i) {
+            cm_diagnostic_t& target = diagnostics[i];
+            target.phase = (found[i].phase == CompileDiagnostic::Phase::SYNTAX) ? CM_PHASE_SYNTAX
+                                                                                : CM_PHASE_SEMANTIC;
+            target.line = found[i].line;
+            target.column = found[i].column;
+            // Al truncar, no cortar un carácter UTF-8 por la mitad
+            const std::string& message = found[i].message;
+            std::size_t length = std::min(message.size(), std::size_t{CM_MESSAGE_MAX - 1});
+            while (length < message.size() && length > 0 &&
+                   (static_cast<unsigned char>(message[length]) & 0xC0) == 0x80) {
+                --length;
+            }
+            std::memcpy(target.message, message.data(), length);
+            target.message[length] = '\0';
+        }
+
+        if (!compiled) {
+            if (output_length != nullptr) {
+                *output_length = 0;
+            }
+            return CM_ERROR;
+        }
+
+        if (output_length != nullptr) {
+            *output_length = abc.size();
+        }
+        if (abc.size() > output_capacity) {
+            return CM_OUTPUT_TOO_SMALL;
+        }
+        std::memcpy(output, abc.data(), abc.size());
+        if (abc.size() < output_capacity) {
+            output[abc.size()] = '\0';
+        }
+        return CM_OK;
+    } catch (const std::bad_alloc&) {
+        return compileFailed(CM_OUT_OF_MEMORY, output_length, diagnostic_count);
+    } catch (...) {
+        return compileFailed(CM_ERROR, output_length, diagnostic_count);
+    }
+}
@@ -0,0 +1,190 @@
+#include "protocol.hpp"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Cliente del servidor de compilación (compilador_musical --servidor). Envía
+// una partitura y escribe el ABC recibido, o mide la latencia de muchas
+// peticiones pequeñas sobre varias conexiones a la vez.
+
+void mostrar_uso(const char* programa) {
+    std::cerr << "Uso: " << programa << " <socket> [--transponer N] [-o archivo.abc] <archivo.mus>" << std::endl;
+    std::cerr << "     " << programa << " <socket> --bench N [--conexiones C] <archivo.mus>" << std::endl;
+}
+
+// Conecta al socket del servidor; -1 si no se pudo
+int conectar(const std::string& ruta) {
+    sockaddr_un direccion{};
+    direccion.sun_family = AF_UNIX;
+    if (ruta.size() >= sizeof direccion.sun_path) {
+        return -1;
+    }
+    std::strcpy(direccion.sun_path, ruta.c_str());
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&direccion), sizeof direccion) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Percentil p (entre 0 y 1) de una muestra ordenada
+double percentil(const std::vector<double>& ordenadas, double p) {
+    std::size_t indice = static_cast<std::size_t>(p * (ordenadas.size() - 1) + 0.5);
+    return ordenadas[indice];
+}
+
+// Envía peticiones repetidas desde conexiones concurrentes y reporta la
+// latencia de cada petición (desde que se envía hasta que llega la respuesta)
+int medir(const std::string& ruta, const std::string& partitura, int peticiones, int conexiones) {
+    conexiones = std::max(1, std::min(conexiones, peticiones));
+    std::vector<std::vector<double>> latencias(conexiones);
+    std::vector<char> fallo(conexiones, 0);
+
+    auto conexion = [&](int indice) {
+        int fd = conectar(ruta);
+        if (fd < 0) {
+            fallo[indice] = 1;
+            return;
+        }
+
+        FrameReader lector{fd};
+        std::string respuesta;
+        int codigo;
+        int cantidad = peticiones / conexiones + (indice < peticiones % conexiones ? 1 : 0);
+        latencias[indice].reserve(cantidad);
+        for (int i = 0; i < cantidad; ++i) {
+            auto inicio = std::chrono::steady_clock::now();
+            if (!writeFrame(fd, 0, partitura) || !lector.read(codigo, respuesta) || codigo != 0) {
+                fallo[indice] = 1;
+                break;
+            }
+            auto fin = std::chrono::steady_clock::now();
+            latencias[indice].push_back(std::chrono::duration<double, std::micro>(fin - inicio).count());
+        }
+        ::close(fd);
+    };
+
+    auto inicio = std::chrono::steady_clock::now();
+    std::vector<std::thread> hilos;
+    for (int i = 0; i < conexiones; ++i) {
+        hilos.emplace_back(conexion, i);
+    }
+    for (auto& hilo : hilos) {
+        hilo.join();
+    }
+    auto fin = std::chrono::steady_clock::now();
+
+    if (std::find(fallo.begin(), fallo.end(), 1) != fallo.end()) {
+        std::cerr << "Error: Una conexión falló o la partitura no compila" << std::endl;
+        return 1;
+    }
+
+    std::vector<double> todas;
+    for (const auto& lista : latencias) {
+        todas.insert(todas.end(), lista.begin(), lista.end());
+    }
+    std::sort(todas.begin(), todas.end());
+
+    double total_ms = std::chrono::duration<double, std::milli>(fin - inicio).count();
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Peticiones: " << todas.size() << " en " << conexiones << " conexiones, "
+              << total_ms << " ms (" << todas.size() * 1000.0 / total_ms << " por segundo)" << std::endl;
+    std::cout << "Latencia por petición: p50 " << percentil(todas, 0.50) << " us, p99 "
+              << percentil(todas, 0.99) << " us, máx " << todas.back() << " us" << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    std::string ruta;
+    std::string nombre_archivo;
+    std::string archivo_abc;
+    int transponer = 0;
+    int peticiones = 0;
+    int conexiones = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string argumento = argv[i];
+        if (argumento == "--transponer" && i + 1 < argc) {
+            transponer = std::atoi(argv[++i]);
+        } else if (argumento == "--bench" && i + 1 < argc) {
+            peticiones = std::atoi(argv[++i]);
+        } else if (argumento == "--conexiones" && i + 1 < argc) {
+            conexiones = std::atoi(argv[++i]);
+        } else if (argumento == "-o" && i + 1 < argc) {
+            archivo_abc = argv[++i];
+        } else if (ruta.empty() && argumento.rfind("--", 0) != 0) {
+            ruta = argumento;
+        } else if (nombre_archivo.empty() && argumento.rfind("--", 0) != 0) {
+            nombre_archivo = argumento;
+        } else {
+            mostrar_uso(argv[0]);
+            return 1;
+        }
+    }
+
+    if (ruta.empty() || nombre_archivo.empty()) {
+        mostrar_uso(argv[0]);
+        return 1;
+    }
+
+    std::ifstream archivo(nombre_archivo, std::ios::binary);
+    if (!archivo) {
+        std::cerr << "Error: No se pudo abrir el archivo " << nombre_archivo << std::endl;
+        return 1;
+    }
+    std::stringstream contenido;
+    contenido << archivo.rdbuf();
+    std::string partitura = contenido.str();
+
+    std::signal(SIGPIPE, SIG_IGN);
+    if (peticiones > 0) {
+        return medir(ruta, partitura, peticiones, conexiones);
+    }
+
+    int fd = conectar(ruta);
+    if (fd < 0) {
+        std::cerr << "Error: No se pudo conectar a " << ruta << std::endl;
+        return 1;
+    }
+
+    FrameReader lector{fd};
+    std::string respuesta;
+    int codigo;
+    bool recibido = writeFrame(fd, transponer, partitura) && lector.read(codigo, respuesta);
+    ::close(fd);
+    if (!recibido) {
+        std::cerr << "Error: El servidor cerró la conexión" << std::endl;
+        return 1;
+    }
+
+    // Los errores se escriben tal como los reportaría el compilador
+    if (codigo != 0) {
+        std::cerr << respuesta;
+        return 1;
+    }
+    if (archivo_abc.empty()) {
+        std::cout << respuesta;
+    } else {
+        std::ofstream salida(archivo_abc, std::ios::binary);
+        if (!salida.is_open()) {
+            std::cerr << "Error: No se pudo abrir el archivo " << archivo_abc << std::endl;
+            return 1;
+        }
+        salida << respuesta;
+    }
+    return 0;
+}
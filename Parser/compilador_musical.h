@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Interfaz en C de libcompilador_musical. Compila una partitura en memoria a
+// notación ABC en un buffer del llamador, sin archivos temporales ni estado
+// global: varios hilos pueden compilar a la vez. La interfaz en C++
+// equivalente es compileBuffer (compile.hpp).
+
+// Resultado de cm_compile
+typedef enum {
+    CM_OK = 0,                  // el ABC quedó en el buffer de salida
+    CM_ERROR = 1,               // la partitura no es válida; ver los diagnósticos
+    CM_OUTPUT_TOO_SMALL = 2,    // el ABC no cabe; output_length indica cuánto ocupa
+    CM_OUT_OF_MEMORY = 3        // no hubo memoria para compilar; no se escribió nada
+} cm_status_t;
+
+// Etapa que reportó un diagnóstico
+typedef enum {
+    CM_PHASE_SYNTAX = 0,        // error léxico o sintáctico, con ubicación
+    CM_PHASE_SEMANTIC = 1       // error semántico, con la ubicación de la instrucción de
+                                // nivel superior que lo produjo
+} cm_phase_t;
+
+// Longitud máxima de un mensaje, incluido el '\0' (los más largos se truncan)
+#define CM_MESSAGE_MAX 256
+
+typedef struct {
+    cm_phase_t phase;
+    int line;
+    int column;
+    char message[CM_MESSAGE_MAX];
+} cm_diagnostic_t;
+
+// Compila source[0, source_length) transponiendo semitones (además de lo que
+// declare la partitura con "Transponer").
+//
+// El ABC se escribe en output, terminado en '\0' si cabe, y output_length
+// recibe su longitud sin el '\0'. Si no cabe en output_capacity bytes no se
+// escribe nada y se devuelve CM_OUTPUT_TOO_SMALL: basta repetir la llamada
+// con un buffer de output_length + 1 bytes.
+//
+// Los diagnósticos se copian a diagnostics (hasta diagnostic_capacity) y
+// diagnostic_count recibe la cantidad total, que puede ser mayor. diagnostics
+// puede ser NULL si diagnostic_capacity es 0; output_length y
+// diagnostic_count pueden ser NULL si no interesan.
+//
+// Ninguna excepción de C++ cruza esta interfaz: si falta memoria para el ABC
+// o los diagnósticos se devuelve CM_OUT_OF_MEMORY con output_length y
+// diagnostic_count en 0. El análisis es noexcept, como el resto del
+// compilador: si la memoria falta ahí, el proceso termina (std::terminate).
+cm_status_t cm_compile(const char* source, size_t source_length, int semitones,
+                       char* output, size_t output_capacity, size_t* output_length,
+                       cm_diagnostic_t* diagnostics, size_t diagnostic_capacity,
+                       size_t* diagnostic_count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,140 @@
+#include "compile.hpp"
+#include "lowering.hpp"
+#include "parallel_front_end.hpp"
+#include "syntax_error.hpp"
+#include "../AST/declaration.hpp"
+#include "../AST/program_passes.hpp"
+#include "../Semantic_Analysis/symbol_table.hpp"
+#include <memory>
+#include <new>
+#include <ostream>
+#include <streambuf>
+
+// Buffer de salida que agrega al final de un string existente, para que la
+// capacidad reservada por peticiones anteriores se reutilice
+class StringAppendBuffer : public std::streambuf {
+public:
+    explicit StringAppendBuffer(std::string& target) noexcept : target{target} {}
+
+protected:
+    int_type overflow(int_type c) override {
+        if (c != traits_type::eof()) {
+            target.push_back(static_cast<char>(c));
+        }
+        return c;
+    }
+
+    std::streamsize xsputn(const char* text, std::streamsize count) override {
+        target.append(text, static_cast<std::size_t>(count));
+        return count;
+    }
+
+private:
+    std::string& target;
+};
+
+MusicProgram* analyzeProgram(const Program& program, int semitones) noexcept {
+    MusicProgram* music = lowerProgram(program);
+    if (!analyzeMusicProgram(*music, semitones)) {
+        delete music;
+        return nullptr;
+    }
+    return music;
+}
+
+bool analyzeMusicProgram(MusicProgram& music, int semitones) noexcept {
+    // La transposición (la declarada en el archivo más la pedida por el
+    // llamador) reúne las alturas en el mismo recorrido que la validación
+    SymbolTable table;
+    ValidationPass validation{table};
+    TranspositionPass transposition{semitones};
+    PassManager passes;
+    passes.add(&validation);
+    passes.add(&transposition);
+    return passes.run(music);
+}
+
+// Implementación de DiagnosticErrorSink
+DiagnosticErrorSink::DiagnosticErrorSink(std::vector<CompileDiagnostic>& diagnostics) noexcept
+    : diagnostics{diagnostics} {}
+
+void DiagnosticErrorSink::report(SourceLocation location, const std::string& message) noexcept {
+    static const std::string prefix = "Error: ";
+    std::size_t begin = (message.compare(0, prefix.size(), prefix) == 0) ? prefix.size() : 0;
+    std::size_t end = message.size();
+    while (end > begin && message[end - 1] == '\n') {
+        --end;
+    }
+    diagnostics.push_back({CompileDiagnostic::Phase::SEMANTIC, location.line, location.column,
+                           message.substr(begin, end - begin)});
+}
+
+std::string diagnosticToString(const CompileDiagnostic& diagnostic) noexcept {
+    if (diagnostic.phase == CompileDiagnostic::Phase::SYNTAX) {
+        return syntaxErrorToString(SyntaxError{diagnostic.line, diagnostic.column, diagnostic.message});
+    }
+    return "Error: " + diagnostic.message;
+}
+
+bool analyzeMusicProgram(MusicProgram& music, int semitones,
+                         std::vector<CompileDiagnostic>& diagnostics) noexcept {
+    diagnostics.clear();
+    DiagnosticErrorSink sink{diagnostics};
+    SemanticErrorRedirect redirect{sink};
+    return analyzeMusicProgram(music, semitones);
+}
+
+bool compileBuffer(const char* buffer, std::size_t length, int semitones,
+                   std::string& abc, std::vector<CompileDiagnostic>& diagnostics) {
+    abc.clear();
+    diagnostics.clear();
+
+    // Un solo fragmento: el front end paralelo no crea hilos. Las ubicaciones
+    // de las instrucciones pasan al AST para los diagnósticos semánticos
+    std::vector<SyntaxError> syntax_errors;
+    std::vector<InstructionLocation> locations;
+    Program* program = parseParallel(buffer, length, 1, syntax_errors, &locations);
+    if (!syntax_errors.empty()) {
+        program->destroy();
+        for (auto& error : syntax_errors) {
+            diagnostics.push_back({CompileDiagnostic::Phase::SYNTAX, error.line, error.column,
+                                   std::move(error.message)});
+        }
+        return false;
+    }
+
+    std::unique_ptr<MusicProgram> music{lowerProgram(*program, &locations)};
+    program->destroy();
+    if (!analyzeMusicProgram(*music, semitones, diagnostics)) {
+        return false;
+    }
+
+    // El flujo atrapa la excepción si el ABC no cabe en memoria y queda en
+    // mal estado: el ABC quedó truncado
+    StringAppendBuffer abc_buffer{abc};
+    std::ostream abc_stream{&abc_buffer};
+    double beat = 0.0;
+    music->to_abc(abc_stream, beat);
+    if (abc_stream.bad()) {
+        abc.clear();
+        throw std::bad_alloc{};
+    }
+    return true;
+}
+
+bool compileBuffer(const char* buffer, std::size_t length, int semitones,
+                   std::string& abc, std::string& errors) noexcept {
+    std::vector<CompileDiagnostic> diagnostics;
+    errors.clear();
+    if (compileBuffer(buffer, length, semitones, abc, diagnostics)) {
+        return true;
+    }
+
+    for (const auto& diagnostic : diagnostics) {
+        errors += diagnosticToString(diagnostic);
+        errors += '\n';
+    }
+    bool syntax = !diagnostics.empty() && diagnostics.front().phase == CompileDiagnostic::Phase::SYNTAX;
+    errors += syntax ? "Error: El análisis falló\n" : "Error: El programa no es válido semánticamente\n";
+    return false;
+}
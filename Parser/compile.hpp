@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../AST/ast_node_interface.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class MusicProgram;
+class Program;
+
+// Traduce el árbol del parser al AST, lo verifica y aplica la transposición
+// (la declarada con "Transponer" más semitones). Devuelve nullptr si el
+// programa no es válido; los errores van al destino de errores semánticos
+// del hilo actual (ver SemanticErrorRedirect).
+MusicProgram* analyzeProgram(const Program& program, int semitones) noexcept;
+
+// Igual que la anterior, sobre un programa ya traducido al AST (por ejemplo,
+// instrucción por instrucción con ProgramLowering). Devuelve false si no es válido.
+bool analyzeMusicProgram(MusicProgram& music, int semitones) noexcept;
+
+// Diagnóstico de una compilación. Los errores semánticos llevan la
+// ubicación de la instrucción de nivel superior que los produjo (line y
+// column son 0 si no se conoce).
+struct CompileDiagnostic {
+    enum class Phase { SYNTAX, SEMANTIC };
+
+    Phase phase;
+    int line;
+    int column;
+    std::string message;
+};
+
+// Destino que guarda los errores semánticos como diagnósticos, con su
+// ubicación y sin el prefijo "Error: " ni el salto de línea final
+class DiagnosticErrorSink final : public SemanticErrorSink {
+public:
+    explicit DiagnosticErrorSink(std::vector<CompileDiagnostic>& diagnostics) noexcept;
+    void report(SourceLocation location, const std::string& message) noexcept override;
+
+private:
+    std::vector<CompileDiagnostic>& diagnostics;
+};
+
+// Igual que analyzeMusicProgram, pero deja los errores semánticos en
+// diagnostics (que se limpia primero) en lugar de escribirlos
+bool analyzeMusicProgram(MusicProgram& music, int semitones,
+                         std::vector<CompileDiagnostic>& diagnostics) noexcept;
+
+// Formatea un diagnóstico igual que el programa principal lo escribe en stderr
+std::string diagnosticToString(const CompileDiagnostic& diagnostic) noexcept;
+
+// Compila una partitura en memoria a notación ABC, sin estado global: usa el
+// escáner reentrante y el parser descendente, así que varios hilos pueden
+// compilar a la vez. Si tiene éxito deja el ABC en abc; si no, deja los
+// errores en diagnostics. abc y diagnostics se limpian primero y conservan
+// su capacidad entre llamadas. Si falta memoria para el ABC o los
+// diagnósticos lanza std::bad_alloc (cm_compile la atrapa).
+bool compileBuffer(const char* buffer, std::size_t length, int semitones,
+                   std::string& abc, std::vector<CompileDiagnostic>& diagnostics);
+
+// Igual que la anterior, pero con los errores como texto: los mismos
+// mensajes que el programa principal escribe en stderr, uno por línea
+bool compileBuffer(const char* buffer, std::size_t length, int semitones,
+                   std::string& abc, std::string& errors) noexcept;
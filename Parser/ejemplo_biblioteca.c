@@ -0,0 +1,71 @@
+// Ejemplo de uso de libcompilador_musical desde C: lee una partitura a
+// memoria, la compila con cm_compile y escribe el ABC en la salida estándar
+// o los diagnósticos en la salida de errores.
+#include "compilador_musical.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static char* leer_archivo(const char* nombre, size_t* longitud) {
+    FILE* archivo = fopen(nombre, "rb");
+    if (archivo == NULL) {
+        return NULL;
+    }
+    fseek(archivo, 0, SEEK_END);
+    long tamano = ftell(archivo);
+    fseek(archivo, 0, SEEK_SET);
+
+    char* contenido = malloc(tamano > 0 ? (size_t)tamano : 1);
+    *longitud = fread(contenido, 1, (size_t)tamano, archivo);
+    fclose(archivo);
+    return contenido;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Uso: %s <archivo.mus> [semitonos]\n", argv[0]);
+        return 1;
+    }
+
+    size_t longitud;
+    char* partitura = leer_archivo(argv[1], &longitud);
+    if (partitura == NULL) {
+        fprintf(stderr, "Error: No se pudo abrir el archivo %s\n", argv[1]);
+        return 1;
+    }
+    int semitonos = (argc > 2) ? atoi(argv[2]) : 0;
+
+    // Primer intento con un buffer pequeño; si no alcanza, se repite con el
+    // tamaño que informa cm_compile
+    size_t capacidad = 256;
+    char* salida = malloc(capacidad);
+    size_t longitud_abc;
+    cm_diagnostic_t diagnosticos[16];
+    size_t cantidad;
+    cm_status_t estado = cm_compile(partitura, longitud, semitonos, salida, capacidad, &longitud_abc,
+                                    diagnosticos, 16, &cantidad);
+    if (estado == CM_OUTPUT_TOO_SMALL) {
+        capacidad = longitud_abc + 1;
+        salida = realloc(salida, capacidad);
+        estado = cm_compile(partitura, longitud, semitonos, salida, capacidad, &longitud_abc,
+                            diagnosticos, 16, &cantidad);
+    }
+
+    if (estado == CM_OK) {
+        fwrite(salida, 1, longitud_abc, stdout);
+    } else if (estado == CM_OUT_OF_MEMORY) {
+        fprintf(stderr, "Error: No hubo memoria para compilar %s\n", argv[1]);
+    } else {
+        for (size_t i = 0; i < cantidad && i < 16; ++i) {
+            if (diagnosticos[i].phase == CM_PHASE_SYNTAX) {
+                fprintf(stderr, "sintaxis, línea %d, columna %d: %s\n", diagnosticos[i].line,
+                        diagnosticos[i].column, diagnosticos[i].message);
+            } else {
+                fprintf(stderr, "semántica: %s\n", diagnosticos[i].message);
+            }
+        }
+    }
+
+    free(salida);
+    free(partitura);
+    return estado == CM_OK ? 0 : 1;
+}
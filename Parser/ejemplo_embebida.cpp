@@ -0,0 +1,63 @@
+/*
+    Compilador Musical: Partitura embebida
+
+    La partitura de partitura.inc (un literal de cadena) se analiza, se
+    valida y se baja a un arreglo de notas durante la compilación, con
+    embedded_score.hpp; el programa solo imprime las notas. Si la partitura
+    tiene un error, no compila.
+
+    Con -DCABECERA="programa.h" (la cabecera que genera compilador_musical
+    -o programa.h para la misma partitura) compara además, también al
+    compilar, las notas y el mapa de tempo con los del compilador.
+*/
+
+#include "embedded_score.hpp"
+#include <cstdio>
+
+constexpr std::string_view fuente =
+#include "partitura.inc"
+    ;
+
+EMBED_SCORE(partitura, fuente);
+
+#ifdef CABECERA
+#include CABECERA
+
+constexpr bool mismas_notas() {
+    if (partitura.notes.size() != programa_note_count || partitura.voice_count != programa_voice_count ||
+        partitura.tempo_change_count != programa_tempo_change_count || partitura.tempo != programa_tempo ||
+        partitura.numerator != programa_numerator || partitura.denominator != programa_denominator) {
+        return false;
+    }
+    for (std::size_t i = 0; i < partitura.notes.size(); ++i) {
+        const EmbeddedNote& nota = partitura.notes[i];
+        const mus_note& esperada = programa_notes[i];
+        if (nota.tick != esperada.tick || nota.length != esperada.length || nota.pitch != esperada.pitch ||
+            nota.voice != esperada.voice) {
+            return false;
+        }
+    }
+    for (std::size_t i = 0; i < partitura.tempo_change_count; ++i) {
+        const EmbeddedTempoChange& cambio = partitura.tempo_changes[i];
+        const mus_tempo_change& esperado = programa_tempo_changes[i];
+        if (cambio.tick != esperado.tick || cambio.tempo != esperado.tempo ||
+            cambio.numerator != esperado.numerator || cambio.denominator != esperado.denominator) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(mismas_notas(), "La partitura embebida no coincide con la cabecera del compilador");
+#endif
+
+int main() {
+    std::printf("Tempo %d, compás %d/%d, %zu voz(ces), %zu notas\n", partitura.tempo, partitura.numerator,
+                partitura.denominator, partitura.voice_count, partitura.notes.size());
+    for (const auto& nota : partitura.notes) {
+        std::printf("  voz %u: semicorchea %u, altura %u, duración %u\n", static_cast<unsigned>(nota.voice),
+                    static_cast<unsigned>(nota.tick), static_cast<unsigned>(nota.pitch),
+                    static_cast<unsigned>(nota.length));
+    }
+    return 0;
+}
@@ -0,0 +1,1032 @@
+#pragma once
+
+#include "../AST/music_rules.hpp"
+#include "../Scanner/token.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Partituras embebidas: el escáner, el parser y las verificaciones
+// semánticas del lenguaje como funciones constexpr, para que una partitura
+// escrita como literal se analice, se valide y se baje a un arreglo de notas
+// durante la compilación de C++. Un error de la partitura es un error de
+// compilación y el programa no analiza nada al ejecutar:
+//
+//     EMBED_SCORE(tema, "Tempo 90\nCompas 3/4\nTonalidad Sol M\nSol4 Blanca Re4 Negra");
+//     static_assert(tema.notes[1].pitch == 62, "");
+//
+// Aplica las mismas reglas que compileBuffer, con los rangos y la lista de
+// notas de music_rules.hpp: cabeceras obligatorias, tonalidad y transposición
+// sin repetir, tempo y compás válidos (también en los cambios), notas y
+// octavas válidas, acordes de a lo sumo CHORD_CAPACITY notas, repeticiones y
+// motivos con notas, motivos definidos antes de usarse y sin repetir en su
+// ámbito, nada que suene fuera de las voces, cambios de compás en una barra,
+// ninguna nota que cruce una barra en una voz, voces alineadas y rango de la
+// transposición. Las notas son las de la cabecera .h de CppHeaderSink
+// (output_sink.hpp): una por altura, con las repeticiones y los motivos
+// expandidos, ordenadas por voz y ya transpuestas.
+//
+// Sin memoria dinámica (C++17 no la admite en constexpr), así que las voces,
+// los motivos, los cambios de tempo y de compás y el anidamiento de bloques
+// tienen capacidad fija; el número de notas se calcula con una primera
+// pasada sobre el mismo texto. Las partituras grandes pueden superar los
+// límites de evaluación del compilador (-fconstexpr-loop-limit y
+// -fconstexpr-ops-limit en GCC, -fconstexpr-steps en Clang).
+
+// Capacidades fijas
+constexpr std::size_t EMBEDDED_MAX_VOICES = 16;
+constexpr std::size_t EMBEDDED_MAX_MOTIFS = 64;
+constexpr std::size_t EMBEDDED_MAX_TEMPO_CHANGES = 64;
+constexpr std::size_t EMBEDDED_MAX_DEPTH = 16;
+
+// Primer error de la partitura; con EMBED_SCORE aparece en el mensaje del
+// compilador como argumento de EmbeddedScoreCheck
+enum class EmbeddedError {
+    NONE,
+    SYNTAX,                  // Token inesperado o carácter no reconocido
+    TEMPO_RANGE,
+    NUMERATOR_RANGE,
+    DENOMINATOR,
+    NOTE_NAME,
+    OCTAVE_RANGE,
+    KEY_ROOT,
+    DUPLICATE_KEY,
+    DUPLICATE_TRANSPOSE,
+    CHORD_CAPACITY,
+    REPEAT_COUNT,
+    REPEAT_LENGTH,           // La repetición expandida dura más de MAX_REPEAT_TICKS
+    EMPTY_BLOCK,             // Repetición o motivo sin notas
+    DUPLICATE_MOTIF,
+    UNDEFINED_MOTIF,
+    NOTES_OUTSIDE_VOICES,
+    METER_OFF_BARLINE,
+    BAR_CROSSING,
+    VOICES_NOT_ALIGNED,
+    MISSING_TEMPO,
+    MISSING_TIME_SIGNATURE,
+    MISSING_KEY,
+    TRANSPOSITION_RANGE,
+    TOO_MANY_VOICES,
+    TOO_MANY_MOTIFS,
+    TOO_MANY_TEMPO_CHANGES,
+    TOO_DEEP
+};
+
+constexpr const char* embedded_error_message(EmbeddedError error) noexcept {
+    switch (error) {
+        case EmbeddedError::NONE: return "Sin errores";
+        case EmbeddedError::SYNTAX: return "Error de sintaxis";
+        case EmbeddedError::TEMPO_RANGE: return "El tempo debe estar en el rango de Larghissimo a Prestissimo";
+        case EmbeddedError::NUMERATOR_RANGE: return "El numerador del compás debe ser mayor a 1 y menor a 12";
+        case EmbeddedError::DENOMINATOR: return "El denominador del compás debe ser 2, 4, 8 o 16";
+        case EmbeddedError::NOTE_NAME: return "Nota inválida";
+        case EmbeddedError::OCTAVE_RANGE: return "Octava fuera de rango (1-8)";
+        case EmbeddedError::KEY_ROOT: return "Tónica inválida";
+        case EmbeddedError::DUPLICATE_KEY: return "Tonalidad declarada más de una vez";
+        case EmbeddedError::DUPLICATE_TRANSPOSE: return "Transposición declarada más de una vez";
+        case EmbeddedError::CHORD_CAPACITY: return "Un acorde admite a lo sumo 8 notas";
+        case EmbeddedError::REPEAT_COUNT: return "La cantidad de repeticiones debe estar entre 1 y 100000";
+        case EmbeddedError::REPEAT_LENGTH: return "La repetición, expandida, dura más de 2^24 semicorcheas";
+        case EmbeddedError::EMPTY_BLOCK: return "Repetición o motivo sin notas";
+        case EmbeddedError::DUPLICATE_MOTIF: return "Motivo definido más de una vez";
+        case EmbeddedError::UNDEFINED_MOTIF: return "Motivo no definido";
+        case EmbeddedError::NOTES_OUTSIDE_VOICES: return "Hay notas fuera de una voz en un programa con voces";
+        case EmbeddedError::METER_OFF_BARLINE: return "El cambio de compás no cae en una barra";
+        case EmbeddedError::BAR_CROSSING: return "Una nota cruza la barra del compás";
+        case EmbeddedError::VOICES_NOT_ALIGNED: return "Las voces no están alineadas";
+        case EmbeddedError::MISSING_TEMPO: return "Falta declaración de tempo";
+        case EmbeddedError::MISSING_TIME_SIGNATURE: return "Falta declaración de compás";
+        case EmbeddedError::MISSING_KEY: return "Falta declaración de tonalidad";
+        case EmbeddedError::TRANSPOSITION_RANGE: return "La transposición deja notas fuera del rango Do1-Si8";
+        case EmbeddedError::TOO_MANY_VOICES: return "Demasiadas voces para una partitura embebida";
+        case EmbeddedError::TOO_MANY_MOTIFS: return "Demasiados motivos para una partitura embebida";
+        case EmbeddedError::TOO_MANY_TEMPO_CHANGES: return "Demasiados cambios de tempo o de compás para una partitura embebida";
+        case EmbeddedError::TOO_DEEP: return "Bloques anidados demasiado profundos para una partitura embebida";
+    }
+    return "Error desconocido";
+}
+
+// Evento de nota, como mus_note en la cabecera de CppHeaderSink
+struct EmbeddedNote {
+    std::uint32_t tick;     // Comienzo, en semicorcheas desde el inicio de la voz
+    std::uint16_t length;   // Duración en semicorcheas
+    std::uint8_t pitch;     // Altura MIDI, ya transpuesta
+    std::uint8_t voice;     // Voz, desde 0
+};
+
+// Tramo del mapa de tempo, como mus_tempo_change: el primero es la cabecera
+struct EmbeddedTempoChange {
+    std::uint32_t tick;
+    std::uint16_t tempo;
+    std::uint8_t numerator;
+    std::uint8_t denominator;
+};
+
+// Partitura embebida con Notes notas. Si error no es NONE, line es la línea
+// donde se detectó (0 para las reglas de todo el programa) y el resto no se usa
+template <std::size_t Notes>
+struct EmbeddedScore {
+    EmbeddedError error{EmbeddedError::NONE};
+    int line{0};
+
+    int tempo{0};
+    int numerator{0};
+    int denominator{0};
+    std::size_t tempo_change_count{0};
+    std::array<EmbeddedTempoChange, EMBEDDED_MAX_TEMPO_CHANGES + 1> tempo_changes{};
+
+    // Sin voces, una sola voz sin nombre
+    std::size_t voice_count{0};
+    std::array<std::string_view, EMBEDDED_MAX_VOICES> voice_names{};
+
+    std::array<EmbeddedNote, Notes> notes{};
+
+    constexpr bool valid() const noexcept {
+        return error == EmbeddedError::NONE;
+    }
+};
+
+// Token del escáner embebido: los mismos de token.h, o -1 ante un carácter
+// no reconocido (como FAST_SCANNER_ERROR)
+struct EmbeddedToken {
+    int kind{TOKEN_EOF};
+    std::string_view text{};
+    int line{1};
+};
+
+// Mismos tokens y reglas de desempate que fast_scanner.c: gana el lexema más
+// largo y, en empate, palabra reservada, nota con octava e identificador
+class EmbeddedScanner {
+public:
+    constexpr explicit EmbeddedScanner(std::string_view source) noexcept
+        : source{source} {}
+
+    constexpr EmbeddedToken next() noexcept {
+        for (;;) {
+            while (pos < source.size() && (source[pos] == ' ' || source[pos] == '\t' || source[pos] == '\n')) {
+                line += (source[pos] == '\n') ? 1 : 0;
+                ++pos;
+            }
+            if (pos >= source.size()) {
+                return EmbeddedToken{TOKEN_EOF, source.substr(pos, 0), line};
+            }
+
+            // Comentario hasta el fin de la línea
+            if (source[pos] == '/' && pos + 1 < source.size() && source[pos + 1] == '/') {
+                while (pos < source.size() && source[pos] != '\n') {
+                    ++pos;
+                }
+                continue;
+            }
+            break;
+        }
+
+        std::size_t start = pos;
+        char c = source[pos];
+        int kind = -1;
+        if (is_letter(c) || c == '_') {
+            std::size_t word_end = pos + 1;
+            while (word_end < source.size() && (is_letter(source[word_end]) || is_digit(source[word_end]) ||
+                                                source[word_end] == '_')) {
+                ++word_end;
+            }
+            std::size_t word_length = word_end - pos;
+            std::size_t note_length = complete_note_length();
+            int keyword = keyword_token(source.substr(pos, word_length));
+
+            if (note_length > word_length) {
+                kind = TOKEN_NOTA_COMPLETA;
+                pos += note_length;
+            } else if (keyword != TOKEN_EOF) {
+                kind = keyword;
+                pos = word_end;
+            } else if (note_length == word_length) {
+                kind = TOKEN_NOTA_COMPLETA;
+                pos = word_end;
+            } else {
+                kind = TOKEN_IDENTIFIER;
+                pos = word_end;
+            }
+        } else if (is_digit(c) || ((c == '-' || c == '+') && pos + 1 < source.size() && is_digit(source[pos + 1]))) {
+            ++pos;
+            while (pos < source.size() && is_digit(source[pos])) {
+                ++pos;
+            }
+            kind = TOKEN_NUMERO;
+        } else {
+            switch (c) {
+                case '/': kind = TOKEN_BARRA; break;
+                case '#': kind = TOKEN_SOSTENIDO; break;
+                case '{': kind = TOKEN_LLAVE_ABRE; break;
+                case '}': kind = TOKEN_LLAVE_CIERRA; break;
+                case '[': kind = TOKEN_CORCHETE_ABRE; break;
+                case ']': kind = TOKEN_CORCHETE_CIERRA; break;
+                default: break;
+            }
+            ++pos;
+        }
+        return EmbeddedToken{kind, source.substr(start, pos - start), line};
+    }
+
+private:
+    struct Keyword {
+        std::string_view text;
+        int token;
+    };
+
+    static constexpr bool is_letter(char c) noexcept {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+
+    static constexpr bool is_digit(char c) noexcept {
+        return c >= '0' && c <= '9';
+    }
+
+    static constexpr int keyword_token(std::string_view word) noexcept {
+        constexpr Keyword keywords[] = {
+            {"Tonalidad", TOKEN_TONALIDAD}, {"Tempo", TOKEN_TEMPO}, {"Compas", TOKEN_COMPAS},
+            {"Blanca", TOKEN_BLANCA}, {"Negra", TOKEN_NEGRA}, {"Corchea", TOKEN_CORCHEA},
+            {"Semicorchea", TOKEN_SEMICORCHEA}, {"M", TOKEN_MAYOR}, {"m", TOKEN_MENOR},
+            {"Do", TOKEN_NOTA_DO}, {"Re", TOKEN_NOTA_RE}, {"Mi", TOKEN_NOTA_MI}, {"Fa", TOKEN_NOTA_FA},
+            {"Sol", TOKEN_NOTA_SOL}, {"La", TOKEN_NOTA_LA}, {"Si", TOKEN_NOTA_SI},
+            {"C", TOKEN_NOTA_DO}, {"D", TOKEN_NOTA_RE}, {"E", TOKEN_NOTA_MI}, {"F", TOKEN_NOTA_FA},
+            {"G", TOKEN_NOTA_SOL}, {"A", TOKEN_NOTA_LA}, {"B", TOKEN_NOTA_SI}, {"b", TOKEN_BEMOL},
+            {"Voz", TOKEN_VOZ}, {"Repetir", TOKEN_REPETIR}, {"Motivo", TOKEN_MOTIVO},
+            {"Transponer", TOKEN_TRANSPONER},
+        };
+        for (const auto& keyword : keywords) {
+            if (keyword.text == word) {
+                return keyword.token;
+            }
+        }
+        return TOKEN_EOF;
+    }
+
+    // Longitud de una nota con octava ("Do#4", "Sib3", "C5") en pos, o 0
+    constexpr std::size_t complete_note_length() const noexcept {
+        std::size_t available = source.size() - pos;
+        auto at = [&](std::size_t offset) { return (offset < available) ? source[pos + offset] : '\0'; };
+
+        std::size_t name_length = 0;
+        switch (at(0)) {
+            case 'D': name_length = (at(1) == 'o') ? 2 : 1; break;
+            case 'F': name_length = (at(1) == 'a') ? 2 : 1; break;
+            case 'R': name_length = (at(1) == 'e') ? 2 : 0; break;
+            case 'M': name_length = (at(1) == 'i') ? 2 : 0; break;
+            case 'L': name_length = (at(1) == 'a') ? 2 : 0; break;
+            case 'S': name_length = (at(1) == 'o' && at(2) == 'l') ? 3 : (at(1) == 'i' ? 2 : 0); break;
+            case 'A': case 'B': case 'C': case 'E': case 'G': name_length = 1; break;
+            default: break;
+        }
+        if (name_length == 0) {
+            return 0;
+        }
+
+        std::size_t length = name_length;
+        if (at(length) == '#' || at(length) == 'b') {
+            ++length;
+        }
+        return is_digit(at(length)) ? length + 1 : 0;
+    }
+
+    std::string_view source;
+    std::size_t pos{0};
+    int line{1};
+};
+
+// Nota guardada durante el análisis: las de las voces y el nivel superior
+// (track = pista, como en EmissionPass) y las de los cuerpos de los motivos
+// (track negativo, uno por motivo; posición desde el inicio del cuerpo)
+struct EmbeddedStoredNote {
+    long tick{0};
+    int length{0};
+    int pitch{0};
+    int track{-1};
+    int line{0};
+};
+
+// Parser constexpr: la misma gramática que ValidatingParser (validator.cpp),
+// pero guarda las notas. Una repetición copia las notas de su cuerpo y una
+// referencia copia las del motivo, así que el texto se lee una sola vez. Con
+// Storage = 0 solo cuenta, para dimensionar la pasada que guarda
+template <std::size_t Storage>
+class EmbeddedScoreParser {
+public:
+    constexpr explicit EmbeddedScoreParser(std::string_view source) noexcept
+        : scanner{source} {
+        for (std::size_t i = 0; i < tracks.size(); ++i) {
+            tracks[i].track = static_cast<int>(i);
+        }
+    }
+
+    constexpr bool run() noexcept {
+        advance();
+        // Una entrada vacía es un error, como en la gramática
+        if (token.kind == TOKEN_EOF) {
+            return fail(EmbeddedError::SYNTAX);
+        }
+        while (token.kind != TOKEN_EOF) {
+            if (!parseInstruction()) {
+                return false;
+            }
+        }
+        // Las reglas de todo el programa necesitan las notas guardadas
+        return Storage == 0 || finish();
+    }
+
+    // Notas que suenan y notas guardadas (con los cuerpos de los motivos)
+    constexpr std::size_t sounding_count() const noexcept {
+        return sounding;
+    }
+
+    constexpr std::size_t stored_count() const noexcept {
+        return stored;
+    }
+
+    template <std::size_t Notes>
+    constexpr void write(EmbeddedScore<Notes>& score) const noexcept {
+        score.error = error;
+        score.line = error_line;
+        if (error != EmbeddedError::NONE) {
+            return;
+        }
+
+        score.tempo = tempo;
+        score.numerator = numerator;
+        score.denominator = denominator;
+        score.tempo_change_count = segment_count;
+        for (std::size_t i = 0; i < segment_count; ++i) {
+            const Segment& segment = segments[i];
+            score.tempo_changes[i] = EmbeddedTempoChange{static_cast<std::uint32_t>(segment.tick),
+                                                         static_cast<std::uint16_t>(segment.tempo),
+                                                         static_cast<std::uint8_t>(segment.numerator),
+                                                         static_cast<std::uint8_t>(segment.denominator)};
+        }
+
+        score.voice_count = (voice_count > 0) ? voice_count : 1;
+        for (std::size_t i = 0; i < voice_count; ++i) {
+            score.voice_names[i] = voice_names[i];
+        }
+
+        // Las notas de cada voz, en orden; sin voces, las del nivel superior
+        std::size_t count = 0;
+        int first = (voice_count > 0) ? 1 : 0;
+        int last = static_cast<int>(voice_count);
+        for (int track = first; track <= last; ++track) {
+            for (std::size_t i = 0; i < stored && i < Storage; ++i) {
+                const EmbeddedStoredNote& note = notes[i];
+                if (note.track != track || count == Notes) {
+                    continue;
+                }
+                score.notes[count++] = EmbeddedNote{static_cast<std::uint32_t>(note.tick),
+                                                    static_cast<std::uint16_t>(note.length),
+                                                    static_cast<std::uint8_t>(note.pitch + transposition),
+                                                    static_cast<std::uint8_t>(track - first)};
+            }
+        }
+    }
+
+private:
+    // Posición de una secuencia (una pista o el cuerpo de un motivo) y
+    // cuántas notas suyas hay guardadas. Las notas guardadas entre dos
+    // posiciones pueden ser también de motivos definidos en el medio, así que
+    // una copia toma solo las de la secuencia
+    struct Sequence {
+        long tick{0};
+        int track{-1};
+        std::size_t count{0};
+    };
+
+    // Motivo visible: scope es la pista donde se definió, o -1 en un bloque;
+    // su cuerpo son las notas de la secuencia body en [begin, end)
+    struct Motif {
+        std::string_view name{};
+        int scope{0};
+        Sequence body{};
+        std::size_t begin{0};
+        std::size_t end{0};
+    };
+
+    // Cambio de tempo (numerator = 0) o de compás (tempo = 0)
+    struct Change {
+        long tick{0};
+        int tempo{0};
+        int numerator{0};
+        int denominator{0};
+        int line{0};
+    };
+
+    // Tramo del mapa de tempo, como TempoSegment
+    struct Segment {
+        long tick{0};
+        int tempo{0};
+        int numerator{0};
+        int denominator{0};
+        long bar_ticks{0};
+        long meter_tick{0};
+    };
+
+    constexpr void advance() noexcept {
+        token = scanner.next();
+    }
+
+    // Registra el primer error; devuelve false para cortar el análisis
+    constexpr bool fail(EmbeddedError kind, int line = -1) noexcept {
+        if (error == EmbeddedError::NONE) {
+            error = kind;
+            error_line = (line < 0) ? token.line : line;
+        }
+        return false;
+    }
+
+    // Valor del número actual, saturado como numberValue en el parser (aquí
+    // en 10^9, que tampoco acepta ninguna regla)
+    constexpr int number() const noexcept {
+        std::string_view text = token.text;
+        bool negative = text[0] == '-';
+        std::size_t i = (text[0] == '-' || text[0] == '+') ? 1 : 0;
+        int value = 0;
+        for (; i < text.size(); ++i) {
+            value = (value > 100000000) ? 1000000000 : value * 10 + (text[i] - '0');
+        }
+        return negative ? -value : value;
+    }
+
+    constexpr bool parseInstruction() noexcept {
+        Sequence& sequence = tracks[current];
+        switch (token.kind) {
+            case TOKEN_TEMPO: return parseTempo();
+            case TOKEN_COMPAS: return parseTimeSignature();
+            case TOKEN_TONALIDAD: return parseKey();
+            case TOKEN_TRANSPONER: return parseTranspose();
+            case TOKEN_VOZ: return parseVoice();
+            case TOKEN_NOTA_COMPLETA: return parseNote(sequence);
+            case TOKEN_CORCHETE_ABRE: return parseChord(sequence);
+            case TOKEN_REPETIR: return parseRepeat(sequence);
+            case TOKEN_MOTIVO: return parseMotif();
+            case TOKEN_IDENTIFIER: return parseReference(sequence);
+            default: return fail(EmbeddedError::SYNTAX);
+        }
+    }
+
+    // Los Tempo y Compas después del primero son cambios en la posición
+    // actual de la voz (o del nivel superior)
+    constexpr bool addChange(const Change& change) noexcept {
+        if (change_count == EMBEDDED_MAX_TEMPO_CHANGES) {
+            return fail(EmbeddedError::TOO_MANY_TEMPO_CHANGES, change.line);
+        }
+        changes[change_count++] = change;
+        return true;
+    }
+
+    constexpr bool parseTempo() noexcept {
+        int line = token.line;
+        advance();
+        if (token.kind != TOKEN_NUMERO) {
+            return fail(EmbeddedError::SYNTAX);
+        }
+        int value = number();
+        advance();
+        if (!valid_tempo(value)) {
+            return fail(EmbeddedError::TEMPO_RANGE, line);
+        }
+
+        if (has_tempo) {
+            return addChange(Change{tracks[current].tick, value, 0, 0, line});
+        }
+        tempo = value;
+        has_tempo = true;
+        return true;
+    }
+
+    constexpr bool parseTimeSignature() noexcept {
+        int line = token.line;
+        advance();
+        if (token.kind != TOKEN_NUMERO) {
+            return fail(EmbeddedError::SYNTAX);
+        }
+        int upper = number();
+        advance();
+        if (token.kind != TOKEN_BARRA) {
+            return fail(EmbeddedError::SYNTAX);
+        }
+        advance();
+        if (token.kind != TOKEN_NUMERO) {
+            return fail(EmbeddedError::SYNTAX);
+        }
+        int lower = number();
+        advance();
+
+        if (!valid_numerator(upper)) {
+            return fail(EmbeddedError::NUMERATOR_RANGE, line);
+        }
+        if (!valid_denominator(lower)) {
+            return fail(EmbeddedError::DENOMINATOR, line);
+        }
+
+        if (has_time_signature) {
+            return addChange(Change{tracks[current].tick, 0, upper, lower, line});
+        }
+        numerator = upper;
+        denominator = lower;
+        has_time_signature = true;
+        return true;
+    }
+
+    constexpr bool parseKey() noexcept {
+        int line = token.line;
+        advance();
+        if (token.kind < TOKEN_NOTA_DO || token.kind > TOKEN_NOTA_SI) {
+            return fail(EmbeddedError::SYNTAX);
+        }
+
+        // Tónica latina ("Sol", "Sib"), como la escribe el parser
+        char root[5]{};
+        std::size_t length = 0;
+        for (char c : letter_names[token.kind - TOKEN_NOTA_DO]) {
+            root[length++] = c;
+        }
+        advance();
+        if (token.kind == TOKEN_SOSTENIDO || token.kind == TOKEN_BEMOL) {
+            root[length++] = (token.kind == TOKEN_SOSTENIDO) ? '#' : 'b';
+            advance();
+        }
+        if (token.kind != TOKEN_MAYOR && token.kind != TOKEN_MENOR) {
+            return fail(EmbeddedError::SYNTAX);
+        }
+        advance();
+
+        if (has_key) {
+            return fail(EmbeddedError::DUPLICATE_KEY, line);
+        }
+        if (!valid_note_name(std::string_view{root, length})) {
+            return fail(EmbeddedError::KEY_ROOT, line);
+        }
+        has_key = true;
+        return true;
+    }
+
+    constexpr bool parseTranspose() noexcept {
+        int line = token.line;
+        advance();
+        if (token.kind != TOKEN_NUMERO) {
+            return fail(EmbeddedError::SYNTAX);
+        }
+        if (has_transposition) {
+            return fail(EmbeddedError::DUPLICATE_TRANSPOSE, line);
+        }
+        transposition = number();
+        has_transposition = true;
+        advance();
+        return true;
+    }
+
+    // Volver a declarar una voz continúa la misma parte
+    constexpr bool parseVoice() noexcept {
+        advance();
+        if (token.kind != TOKEN_IDENTIFIER) {
+            return fail(EmbeddedError::SYNTAX);
+        }
+
+        std::size_t voice = 0;
+        while (voice < voice_count && voice_names[voice] != token.text) {
+            ++voice;
+        }
+        if (voice == voice_count) {
+            if (voice_count == EMBEDDED_MAX_VOICES) {
+                return fail(EmbeddedError::TOO_MANY_VOICES);
+            }
+            voice_names[voice_count++] = token.text;
+        }
+        current = voice + 1;
+        advance();
+        return true;
+    }
+
+    // Duración en semicorcheas del token actual, o 0 si no es una duración
+    constexpr int durationTicks() const noexcept {
+        switch (token.kind) {
+            case TOKEN_BLANCA: return duration_ticks(DurationType::BLANCA);
+            case TOKEN_NEGRA: return duration_ticks(DurationType::NEGRA);
+            case TOKEN_CORCHEA: return duration_ticks(DurationType::CORCHEA);
+            case TOKEN_SEMICORCHEA: return duration_ticks(DurationType::SEMICORCHEA);
+            default: return 0;
+        }
+    }
+
+    // Altura de una nota escrita ("Do#4"), o -1 si el nombre o la octava no
+    // son válidos. Registra el rango, para verificar la transposición al final
+    constexpr int checkPitch(std::string_view full_note, int line) noexcept {
+        std::string_view name = full_note.substr(0, full_note.size() - 1);
+        int octave = full_note.back() - '0';
+        if (!valid_note_name(name)) {
+            fail(EmbeddedError::NOTE_NAME, line);
+            return -1;
+        }
+        if (!valid_octave(octave)) {
+            fail(EmbeddedError::OCTAVE_RANGE, line);
+            return -1;
+        }
+
+        NoteSpelling spelling{0, 0};
+        spell_note_name(name, spelling);
+        int pitch = pitch_number(spelling, octave);
+        lowest_pitch = (pitch < lowest_pitch) ? pitch : lowest_pitch;
+        highest_pitch = (pitch > highest_pitch) ? pitch : highest_pitch;
+        return pitch;
+    }
+
+    constexpr void store(Sequence& sequence, int pitch, int length, int line) noexcept {
+        if constexpr (Storage > 0) {
+            if (stored < Storage) {
+                notes[stored] = EmbeddedStoredNote{sequence.tick, length, pitch, sequence.track, line};
+            }
+        }
+        ++stored;
+        ++sequence.count;
+        sounding += (sequence.track >= 0) ? 1 : 0;
+    }
+
+    // Agrega a sequence times copias de las items notas de source guardadas
+    // en [begin, end), la k-ésima desplazada offset + k * length semicorcheas
+    constexpr void copy(const Sequence& source, std::size_t items, std::size_t begin, std::size_t end,
+                        long offset, long length, long times, Sequence& sequence) noexcept {
+        if constexpr (Storage > 0) {
+            for (long k = 0; k < times; ++k) {
+                std::size_t next = stored;
+                for (std::size_t i = begin; i < end && i < Storage; ++i) {
+                    if (notes[i].track == source.track && next < Storage) {
+                        EmbeddedStoredNote note = notes[i];
+                        note.tick += offset + k * length;
+                        note.track = sequence.track;
+                        notes[next++] = note;
+                    }
+                }
+                stored += items;
+            }
+        } else {
+            stored += items * static_cast<std::size_t>(times);
+        }
+        sequence.count += items * static_cast<std::size_t>(times);
+        sounding += (sequence.track >= 0) ? items * static_cast<std::size_t>(times) : 0;
+    }
+
+    constexpr bool parseNote(Sequence& sequence) noexcept {
+        std::string_view full_note = token.text;
+        int line = token.line;
+        advance();
+
+        int duration = durationTicks();
+        if (duration == 0) {
+            return fail(EmbeddedError::SYNTAX);
+        }
+        advance();
+
+        int pitch = checkPitch(full_note, line);
+        if (pitch < 0) {
+            return false;
+        }
+        store(sequence, pitch, duration, line);
+        sequence.tick += duration;
+        return true;
+    }
+
+    // Las notas del acorde se verifican al leerlas y se guardan una por altura
+    constexpr bool parseChord(Sequence& sequence) noexcept {
+        int line = token.line;
+        advance();
+        int pitches[CHORD_CAPACITY]{};
+        std::size_t count = 0;
+        while (token.kind == TOKEN_NOTA_COMPLETA) {
+            if (count == CHORD_CAPACITY) {
+                return fail(EmbeddedError::CHORD_CAPACITY, line);
+            }
+            pitches[count] = checkPitch(token.text, token.line);
+            if (pitches[count++] < 0) {
+                return false;
+            }
+            advance();
+        }
+        if (count == 0 || token.kind != TOKEN_CORCHETE_CIERRA) {
+            return fail(EmbeddedError::SYNTAX);
+        }
+        advance();
+
+        int duration = durationTicks();
+        if (duration == 0) {
+            return fail(EmbeddedError::SYNTAX);
+        }
+        advance();
+
+        for (std::size_t i = 0; i < count; ++i) {
+            store(sequence, pitches[i], duration, line);
+        }
+        sequence.tick += duration;
+        return true;
+    }
+
+    // cuerpo : (nota | acorde | repeticion | motivo | referencia)*, a partir
+    // de TOKEN_LLAVE_ABRE. Los motivos definidos en el cuerpo son locales a él
+    constexpr bool parseBlock(Sequence& sequence) noexcept {
+        if (depth == EMBEDDED_MAX_DEPTH) {
+            return fail(EmbeddedError::TOO_DEEP);
+        }
+        advance();
+        block_starts[depth++] = motif_count;
+        while (token.kind != TOKEN_LLAVE_CIERRA) {
+            bool valid = false;
+            switch (token.kind) {
+                case TOKEN_NOTA_COMPLETA: valid = parseNote(sequence); break;
+                case TOKEN_CORCHETE_ABRE: valid = parseChord(sequence); break;
+                case TOKEN_REPETIR: valid = parseRepeat(sequence); break;
+                case TOKEN_MOTIVO: valid = parseMotif(); break;
+                case TOKEN_IDENTIFIER: valid = parseReference(sequence); break;
+                default: valid = fail(EmbeddedError::SYNTAX); break;
+            }
+            if (!valid) {
+                return false;
+            }
+        }
+        motif_count = block_starts[--depth];
+        advance();
+        return true;
+    }
+
+    // El cuerpo se analiza una vez, en su lugar, y las demás vueltas son copias
+    constexpr bool parseRepeat(Sequence& sequence) noexcept {
+        int line = token.line;
+        advance();
+        if (token.kind != TOKEN_NUMERO) {
+            return fail(EmbeddedError::SYNTAX);
+        }
+        int count = number();
+        advance();
+        if (token.kind != TOKEN_LLAVE_ABRE) {
+            return fail(EmbeddedError::SYNTAX);
+        }
+
+        std::size_t begin = stored;
+        std::size_t items = sequence.count;
+        long start = sequence.tick;
+        if (!parseBlock(sequence)) {
+            return false;
+        }
+        if (!valid_repeat_count(count)) {
+            return fail(EmbeddedError::REPEAT_COUNT, line);
+        }
+        long length = sequence.tick - start;
+        if (length == 0) {
+            return fail(EmbeddedError::EMPTY_BLOCK, line);
+        }
+        if (count * length > MAX_REPEAT_TICKS) {
+            return fail(EmbeddedError::REPEAT_LENGTH, line);
+        }
+
+        copy(sequence, sequence.count - items, begin, stored, length, length, count - 1, sequence);
+        sequence.tick = start + count * length;
+        return true;
+    }
+
+    // La definición no suena: el cuerpo se guarda aparte, en su propia secuencia
+    constexpr bool parseMotif() noexcept {
+        int line = token.line;
+        advance();
+        if (token.kind != TOKEN_IDENTIFIER) {
+            return fail(EmbeddedError::SYNTAX);
+        }
+        std::string_view name = token.text;
+        advance();
+        if (token.kind != TOKEN_LLAVE_ABRE) {
+            return fail(EmbeddedError::SYNTAX);
+        }
+
+        Sequence body{0, -1 - static_cast<int>(body_count++), 0};
+        std::size_t begin = stored;
+        if (!parseBlock(body)) {
+            return false;
+        }
+        if (body.tick == 0) {
+            return fail(EmbeddedError::EMPTY_BLOCK, line);
+        }
+
+        // Sin repetir el nombre en el mismo ámbito: en un bloque, desde su
+        // inicio; si no, entre los de la voz o los del programa
+        int scope = (depth > 0) ? -1 : static_cast<int>(current);
+        std::size_t scope_begin = (depth > 0) ? block_starts[depth - 1] : 0;
+        for (std::size_t i = scope_begin; i < motif_count; ++i) {
+            if (motifs[i].scope == scope && motifs[i].name == name) {
+                return fail(EmbeddedError::DUPLICATE_MOTIF, line);
+            }
+        }
+        if (motif_count == EMBEDDED_MAX_MOTIFS) {
+            return fail(EmbeddedError::TOO_MANY_MOTIFS, line);
+        }
+        motifs[motif_count++] = Motif{name, scope, body, begin, stored};
+        return true;
+    }
+
+    // Definición visible más interna: bloques abiertos, voz y programa
+    constexpr const Motif* lookup(std::string_view name) const noexcept {
+        for (int scope : {-1, static_cast<int>(current), 0}) {
+            for (std::size_t i = motif_count; i > 0; --i) {
+                if (motifs[i - 1].scope == scope && motifs[i - 1].name == name) {
+                    return &motifs[i - 1];
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    constexpr bool parseReference(Sequence& sequence) noexcept {
+        std::string_view name = token.text;
+        int line = token.line;
+        advance();
+
+        const Motif* motif = lookup(name);
+        if (motif == nullptr) {
+            return fail(EmbeddedError::UNDEFINED_MOTIF, line);
+        }
+        copy(motif->body, motif->body.count, motif->begin, motif->end, sequence.tick, 0, 1, sequence);
+        sequence.tick += motif->body.tick;
+        return true;
+    }
+
+    // Ordena los cambios por posición (los de una misma posición, en el orden
+    // en que aparecen) y arma los tramos, como TempoMap::build
+    constexpr bool buildTempoMap() noexcept {
+        for (std::size_t i = 1; i < change_count; ++i) {
+            Change change = changes[i];
+            std::size_t j = i;
+            for (; j > 0 && changes[j - 1].tick > change.tick; --j) {
+                changes[j] = changes[j - 1];
+            }
+            changes[j] = change;
+        }
+
+        long bar_ticks = numerator * 16L / denominator;
+        segments[0] = Segment{0, tempo, numerator, denominator, bar_ticks, 0};
+        segment_count = 1;
+        for (std::size_t i = 0; i < change_count; ++i) {
+            const Change& change = changes[i];
+            Segment segment = segments[segment_count - 1];
+            if (change.numerator != 0) {
+                // El compás nuevo comienza en una barra del anterior
+                if ((change.tick - segment.meter_tick) % segment.bar_ticks != 0) {
+                    return fail(EmbeddedError::METER_OFF_BARLINE, change.line);
+                }
+                segment.meter_tick = change.tick;
+                segment.numerator = change.numerator;
+                segment.denominator = change.denominator;
+                segment.bar_ticks = change.numerator * 16L / change.denominator;
+            }
+            if (change.tempo != 0) {
+                segment.tempo = change.tempo;
+            }
+
+            // Varios cambios en la misma posición forman un solo tramo
+            segment.tick = change.tick;
+            if (change.tick == segments[segment_count - 1].tick && segment_count > 1) {
+                segments[segment_count - 1] = segment;
+            } else {
+                segments[segment_count++] = segment;
+            }
+        }
+        return true;
+    }
+
+    constexpr long nextBarline(long tick) const noexcept {
+        std::size_t index = 0;
+        while (index + 1 < segment_count && segments[index + 1].tick <= tick) {
+            ++index;
+        }
+        const Segment& segment = segments[index];
+        return segment.meter_tick + ((tick - segment.meter_tick) / segment.bar_ticks + 1) * segment.bar_ticks;
+    }
+
+    // Reglas que dependen del programa completo, en el orden de resolve_voices
+    constexpr bool finish() noexcept {
+        if (voice_count > 0 && tracks[0].tick > 0) {
+            return fail(EmbeddedError::NOTES_OUTSIDE_VOICES, 0);
+        }
+
+        if (has_tempo && has_time_signature) {
+            if (!buildTempoMap()) {
+                return false;
+            }
+
+            // Ninguna nota de una voz cruza una barra
+            for (std::size_t i = 0; i < stored && i < Storage && voice_count > 0; ++i) {
+                const EmbeddedStoredNote& note = notes[i];
+                if (note.track > 0 && note.tick + note.length > nextBarline(note.tick)) {
+                    return fail(EmbeddedError::BAR_CROSSING, note.line);
+                }
+            }
+
+            // Todas las voces comienzan en la primera barra, así que quedan
+            // alineadas si terminan en el mismo punto
+            for (std::size_t voice = 1; voice < voice_count; ++voice) {
+                if (tracks[voice + 1].tick != tracks[1].tick) {
+                    return fail(EmbeddedError::VOICES_NOT_ALIGNED, 0);
+                }
+            }
+        }
+
+        if (!has_tempo) {
+            return fail(EmbeddedError::MISSING_TEMPO, 0);
+        }
+        if (!has_time_signature) {
+            return fail(EmbeddedError::MISSING_TIME_SIGNATURE, 0);
+        }
+        if (!has_key) {
+            return fail(EmbeddedError::MISSING_KEY, 0);
+        }
+
+        // Transposición: las alturas deben quedar en Do1-Si8
+        if (transposition != 0 && lowest_pitch <= highest_pitch) {
+            int total = (transposition < -HIGHEST_PITCH) ? -HIGHEST_PITCH
+                                                         : (transposition > HIGHEST_PITCH ? HIGHEST_PITCH : transposition);
+            if (lowest_pitch + total < LOWEST_PITCH || highest_pitch + total > HIGHEST_PITCH) {
+                return fail(EmbeddedError::TRANSPOSITION_RANGE, 0);
+            }
+        }
+        return true;
+    }
+
+    EmbeddedScanner scanner;
+    EmbeddedToken token{};
+    EmbeddedError error{EmbeddedError::NONE};
+    int error_line{0};
+
+    bool has_tempo{false};
+    bool has_time_signature{false};
+    bool has_key{false};
+    bool has_transposition{false};
+    int tempo{0};
+    int numerator{0};
+    int denominator{0};
+    int transposition{0};
+    int lowest_pitch{1000};
+    int highest_pitch{-1000};
+
+    // Pista 0: nivel superior; pista i + 1: voz i
+    std::array<Sequence, EMBEDDED_MAX_VOICES + 1> tracks{};
+    std::array<std::string_view, EMBEDDED_MAX_VOICES> voice_names{};
+    std::size_t voice_count{0};
+    std::size_t current{0};
+
+    std::array<Motif, EMBEDDED_MAX_MOTIFS> motifs{};
+    std::size_t motif_count{0};
+    std::size_t body_count{0};   // Cuerpos de motivo analizados, para numerar sus secuencias
+    std::array<std::size_t, EMBEDDED_MAX_DEPTH> block_starts{};   // motif_count al abrir cada bloque
+    std::size_t depth{0};
+
+    std::array<Change, EMBEDDED_MAX_TEMPO_CHANGES> changes{};
+    std::size_t change_count{0};
+    std::array<Segment, EMBEDDED_MAX_TEMPO_CHANGES + 1> segments{};
+    std::size_t segment_count{0};
+
+    std::array<EmbeddedStoredNote, Storage> notes{};
+    std::size_t stored{0};
+    std::size_t sounding{0};
+};
+
+// Notas que suenan en la partitura (una por altura), para dimensionar EmbeddedScore
+constexpr std::size_t count_embedded_notes(std::string_view source) noexcept {
+    EmbeddedScoreParser<0> parser{source};
+    parser.run();
+    return parser.sounding_count();
+}
+
+// Notas que guarda el análisis: las que suenan y los cuerpos de los motivos
+constexpr std::size_t count_embedded_storage(std::string_view source) noexcept {
+    EmbeddedScoreParser<0> parser{source};
+    parser.run();
+    return parser.stored_count();
+}
+
+template <std::size_t Notes, std::size_t Storage>
+constexpr EmbeddedScore<Notes> parse_embedded_score(std::string_view source) noexcept {
+    EmbeddedScoreParser<Storage> parser{source};
+    parser.run();
+    EmbeddedScore<Notes> score{};
+    parser.write(score);
+    return score;
+}
+
+// Falla la compilación si la partitura tiene un error. El mensaje del
+// compilador muestra el error y la línea como argumentos de la plantilla
+// ("EmbeddedScoreCheck<EmbeddedError::BAR_CROSSING, 12>")
+template <EmbeddedError Error, int Line>
+struct EmbeddedScoreCheck {
+    static_assert(Error == EmbeddedError::NONE, "La partitura embebida no es válida: ver el error y la línea "
+                                                "en los argumentos de EmbeddedScoreCheck");
+    static constexpr bool valid = true;
+};
+
+// Define name como la partitura constexpr de source (un literal o un
+// std::string_view constexpr), y verifica que no tenga errores
+#define EMBED_SCORE(name, source)                                                                           \
+    constexpr auto name =                                                                                   \
+        parse_embedded_score<count_embedded_notes(source), count_embedded_storage(source)>(source);        \
+    static_assert(EmbeddedScoreCheck<name.error, name.line>::valid, "Partitura embebida inválida")
@@ -1,10 +1,30 @@
 #include "expression.hpp"
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
 #include <sstream>
 
 using namespace std::literals;
 
 Expression::~Expression() {}
 
+int numberValue(const char* text) noexcept {
+    errno = 0;
+    long value = std::strtol(text, nullptr, 10);
+    if (errno == ERANGE) {
+        return value < 0 ? INT_MIN : INT_MAX;
+    }
+    if (value > INT_MAX) {
+        return INT_MAX;
+    }
+    if (value < INT_MIN) {
+        return INT_MIN;
+    }
+    return static_cast<int>(value);
+}
+
 // Implementación de Number
 Number::Number(int val) noexcept
     : value{val} {}
@@ -37,6 +57,27 @@ int Tempo::getTempo() const noexcept {
     return tempo_value->getIntValue();
 }
 
+// Implementación de Transpose
+Transpose::Transpose(Number* semitones) noexcept
+    : semitones{semitones} {}
+
+void Transpose::destroy() noexcept {
+    if (semitones != nullptr) {
+        semitones->destroy();
+        semitones = nullptr;
+    }
+    delete this;
+}
+
+std::string Transpose::to_string() const noexcept {
+    int value = getSemitones();
+    return "Transponer "s + (value > 0 ? "+" : "") + std::to_string(value);
+}
+
+int Transpose::getSemitones() const noexcept {
+    return semitones->getIntValue();
+}
+
 // Implementación de TimeSignature
 TimeSignature::TimeSignature(Number* num, Number* denom) noexcept
     : numerator{num}, denominator{denom} {}
@@ -110,12 +151,164 @@ Duration Note::getDuration() const noexcept {
     return duration;
 }
 
+// Implementación de Chord
+Chord::Chord() noexcept {}
+
+void Chord::destroy() noexcept {
+    delete this;
+}
+
+std::string Chord::to_string() const noexcept {
+    std::string result = "[";
+    for (std::size_t i = 0; i < notes.size(); ++i) {
+        result += (i == 0 ? ""s : " "s) + notes[i].note_name + std::to_string(notes[i].octave);
+    }
+    return result + "] "s + durationToString(duration);
+}
+
+void Chord::addNote(std::string note_name, int octave) noexcept {
+    notes.push_back(Pitch{std::move(note_name), octave});
+}
+
+void Chord::setDuration(Duration dur) noexcept {
+    duration = dur;
+}
+
+const std::vector<Chord::Pitch>& Chord::getNotes() const noexcept {
+    return notes;
+}
+
+Duration Chord::getDuration() const noexcept {
+    return duration;
+}
+
+// Implementación de Voice
+Voice::Voice(std::string name) noexcept
+    : name{name} {}
+
+void Voice::destroy() noexcept {
+    delete this;
+}
+
+std::string Voice::to_string() const noexcept {
+    return "Voz "s + name;
+}
+
+std::string Voice::getName() const noexcept {
+    return name;
+}
+
+// Implementación de Block
+Block::Block() noexcept {}
+
+void Block::destroy() noexcept {
+    for (auto instruction : instructions) {
+        if (instruction != nullptr) {
+            instruction->destroy();
+        }
+    }
+    instructions.clear();
+    delete this;
+}
+
+std::string Block::to_string() const noexcept {
+    // El cuerpo se imprime indentado, una instrucción por línea
+    std::stringstream ss;
+    ss << "{\n";
+    for (const auto& instruction : instructions) {
+        std::stringstream lines{instruction->to_string()};
+        std::string line;
+        while (std::getline(lines, line)) {
+            ss << "  " << line << "\n";
+        }
+    }
+    ss << "}";
+    return ss.str();
+}
+
+void Block::addInstruction(Expression* instruction) noexcept {
+    if (instruction != nullptr) {
+        instructions.push_back(instruction);
+    }
+}
+
+const std::vector<Expression*>& Block::getInstructions() const noexcept {
+    return instructions;
+}
+
+// Implementación de Repeat
+Repeat::Repeat(Number* count, Block* body) noexcept
+    : count{count}, body{body} {}
+
+void Repeat::destroy() noexcept {
+    if (count != nullptr) {
+        count->destroy();
+        count = nullptr;
+    }
+    if (body != nullptr) {
+        body->destroy();
+        body = nullptr;
+    }
+    delete this;
+}
+
+std::string Repeat::to_string() const noexcept {
+    return "Repetir "s + std::to_string(getCount()) + " " + body->to_string();
+}
+
+int Repeat::getCount() const noexcept {
+    return (count != nullptr) ? count->getIntValue() : 0;
+}
+
+const std::vector<Expression*>& Repeat::getInstructions() const noexcept {
+    return body->getInstructions();
+}
+
+// Implementación de Motif
+Motif::Motif(std::string name, Block* body) noexcept
+    : name{name}, body{body} {}
+
+void Motif::destroy() noexcept {
+    if (body != nullptr) {
+        body->destroy();
+        body = nullptr;
+    }
+    delete this;
+}
+
+std::string Motif::to_string() const noexcept {
+    return "Motivo "s + name + " " + body->to_string();
+}
+
+std::string Motif::getName() const noexcept {
+    return name;
+}
+
+const std::vector<Expression*>& Motif::getInstructions() const noexcept {
+    return body->getInstructions();
+}
+
+// Implementación de MotifReference
+MotifReference::MotifReference(std::string name) noexcept
+    : name{name} {}
+
+void MotifReference::destroy() noexcept {
+    delete this;
+}
+
+std::string MotifReference::to_string() const noexcept {
+    return name;
+}
+
+std::string MotifReference::getName() const noexcept {
+    return name;
+}
+
 // Implementación de Program
 Program::Program() noexcept {}
 
-Program::~Program() {
-    destroy();
-}
+// Las instrucciones se liberan en destroy(), que termina con delete this
+Program::~Program() {}
 
 void Program::destroy() noexcept {
     for (auto instruction : instructions) {
@@ -161,4 +354,32 @@ std::string durationToString(Duration duration) noexcept {
         default:
             return "Desconocido";
     }
-} 
\ No newline at end of file
+} 
+
+// Función auxiliar para extraer la octava de una nota completa
+int extraer_octava(const char* nota_completa) noexcept {
+    int len = strlen(nota_completa);
+    // La octava siempre es el último carácter
+    if (len > 0) {
+        char ultimo = nota_completa[len-1];
+        if (isdigit(ultimo)) {
+            return ultimo - '0';
+        }
+    }
+    // Si no se encuentra una octava válida, devolver un valor por defecto
+    return 4; // Octava 4 por defecto
+}
+
+// Función auxiliar para extraer solo el nombre de la nota sin la octava
+std::string extraer_nombre_nota(const char* nota_completa) noexcept {
+    int len = strlen(nota_completa);
+    
+    // Buscar dónde termina el nombre de la nota y comienza la octava
+    // La octava siempre es el último carácter, si es un dígito
+    if (len > 0 && isdigit(nota_completa[len-1])) {
+        return std::string(nota_completa, len-1);
+    }
+    
+    // Si no hay octava, devolver todo el string
+    return std::string(nota_completa);
+}
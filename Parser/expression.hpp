@@ -24,6 +24,11 @@ public:
     }
 };
 
+// Valor de un TOKEN_NUMERO. Un número que no cabe en un int queda en
+// INT_MAX (o INT_MIN) en lugar de dar la vuelta, así que el análisis
+// semántico lo rechaza como fuera de rango
+int numberValue(const char* text) noexcept;
+
 // Clase para representar un valor numérico
 class Number : public Expression {
 public:
@@ -70,6 +75,18 @@ private:
     Number* tempo_value;
 };
 
+// Clase para la transposición de toda la partitura, en semitonos ("Transponer +2")
+class Transpose : public Expression {
+public:
+    Transpose(Number* semitones) noexcept;
+    void destroy() noexcept override;
+    std::string to_string() const noexcept override;
+    int getSemitones() const noexcept;
+
+private:
+    Number* semitones;
+};
+
 // Clase para el compás
 class TimeSignature : public Expression {
 public:
@@ -124,6 +141,97 @@ private:
     Duration duration;
 };
 
+// Clase para un acorde: "[Do4 Mi4 Sol4] Negra". Las notas suenan juntas y
+// comparten la duración, que se fija al leer el corchete de cierre
+class Chord : public Expression {
+public:
+    struct Pitch {
+        std::string note_name;
+        int octave;
+    };
+
+    Chord() noexcept;
+    void destroy() noexcept override;
+    std::string to_string() const noexcept override;
+    void addNote(std::string note_name, int octave) noexcept;
+    void setDuration(Duration duration) noexcept;
+    const std::vector<Pitch>& getNotes() const noexcept;
+    Duration getDuration() const noexcept;
+
+private:
+    std::vector<Pitch> notes;
+    Duration duration{Duration::NEGRA};
+};
+
+// Clase para el inicio de una voz (parte): las instrucciones siguientes
+// pertenecen a ella hasta la próxima voz
+class Voice : public Expression {
+public:
+    Voice(std::string name) noexcept;
+    void destroy() noexcept override;
+    std::string to_string() const noexcept override;
+    std::string getName() const noexcept;
+
+private:
+    std::string name;
+};
+
+// Cuerpo entre llaves de una repetición o de un motivo: notas, repeticiones,
+// motivos locales y referencias a motivos
+class Block : public Expression {
+public:
+    Block() noexcept;
+    void destroy() noexcept override;
+    std::string to_string() const noexcept override;
+    void addInstruction(Expression* instruction) noexcept override;
+    const std::vector<Expression*>& getInstructions() const noexcept;
+
+private:
+    std::vector<Expression*> instructions;
+};
+
+// Clase para un bloque repetido: "Repetir N { ... }". El cuerpo se guarda una
+// sola vez junto con la cantidad de repeticiones
+class Repeat : public Expression {
+public:
+    Repeat(Number* count, Block* body) noexcept;
+    void destroy() noexcept override;
+    std::string to_string() const noexcept override;
+    int getCount() const noexcept;
+    const std::vector<Expression*>& getInstructions() const noexcept;
+
+private:
+    Number* count;
+    Block* body;
+};
+
+// Clase para la definición de un motivo: "Motivo Tema { ... }". El cuerpo no
+// suena donde se define, sino en cada referencia al motivo
+class Motif : public Expression {
+public:
+    Motif(std::string name, Block* body) noexcept;
+    void destroy() noexcept override;
+    std::string to_string() const noexcept override;
+    std::string getName() const noexcept;
+    const std::vector<Expression*>& getInstructions() const noexcept;
+
+private:
+    std::string name;
+    Block* body;
+};
+
+// Clase para una referencia a un motivo definido antes: "Tema"
+class MotifReference : public Expression {
+public:
+    MotifReference(std::string name) noexcept;
+    void destroy() noexcept override;
+    std::string to_string() const noexcept override;
+    std::string getName() const noexcept;
+
+private:
+    std::string name;
+};
+
 // Clase para almacenar y manejar una secuencia de instrucciones musicales
 class Program : public Expression {
 public:
@@ -139,4 +247,9 @@ private:
 };
 
 // Función para convertir una duración a string
-std::string durationToString(Duration duration) noexcept; 
\ No newline at end of file
+std::string durationToString(Duration duration) noexcept;
+
+// Funciones auxiliares para extraer la octava y el nombre de la nota de un
+// token TOKEN_NOTA_COMPLETA (las usan ambos parsers)
+int extraer_octava(const char* nota_completa) noexcept;
+std::string extraer_nombre_nota(const char* nota_completa) noexcept;
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+// Requiere C++20 (corrutinas): solo lo incluyen note_stream.hpp y sus usuarios,
+// que se compilan aparte (ver "make notas")
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <utility>
+
+// Generador perezoso: la corrutina avanza solo cuando se pide el siguiente
+// valor, y destruir el generador (por ejemplo, al salir de un for con break)
+// la termina sin ejecutar el resto. El valor entregado con co_yield vive en
+// la corrutina y no se copia; es válido hasta el siguiente incremento.
+template <typename T>
+class Generator {
+public:
+    struct promise_type {
+        const T* current{nullptr};
+
+        Generator get_return_object() noexcept {
+            return Generator{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        std::suspend_always final_suspend() const noexcept { return {}; }
+        std::suspend_always yield_value(const T& value) noexcept {
+            this->current = &value;
+            return {};
+        }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        iterator() noexcept = default;
+        explicit iterator(std::coroutine_handle<promise_type> handle) noexcept : handle{handle} {}
+
+        reference operator*() const noexcept { return *this->handle.promise().current; }
+        pointer operator->() const noexcept { return this->handle.promise().current; }
+
+        iterator& operator++() noexcept {
+            this->handle.resume();
+            return *this;
+        }
+        void operator++(int) noexcept { ++*this; }
+
+        bool operator==(std::default_sentinel_t) const noexcept {
+            return !this->handle || this->handle.done();
+        }
+
+    private:
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    Generator(Generator&& other) noexcept : handle{std::exchange(other.handle, {})} {}
+    Generator& operator=(Generator&& other) noexcept {
+        if (this != &other) {
+            if (this->handle) {
+                this->handle.destroy();
+            }
+            this->handle = std::exchange(other.handle, {});
+        }
+        return *this;
+    }
+    Generator(const Generator&) = delete;
+    Generator& operator=(const Generator&) = delete;
+
+    ~Generator() noexcept {
+        if (this->handle) {
+            this->handle.destroy();
+        }
+    }
+
+    // Comienza a ejecutar la corrutina hasta el primer valor
+    iterator begin() noexcept {
+        if (this->handle) {
+            this->handle.resume();
+        }
+        return iterator{this->handle};
+    }
+    std::default_sentinel_t end() const noexcept { return {}; }
+
+private:
+    explicit Generator(std::coroutine_handle<promise_type> handle) noexcept : handle{handle} {}
+
+    std::coroutine_handle<promise_type> handle;
+};
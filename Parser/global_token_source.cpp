@@ -0,0 +1,31 @@
+#include "recursive_descent.hpp"
+
+// Requerido para usar el mismo YYSTYPE que el parser
+#define YYSTYPE Expression*
+#include "token.h"
+
+// La fuente sobre el escáner global queda fuera de recursive_descent.cpp para
+// que la biblioteca (que solo usa fuentes reentrantes) no dependa de yylex
+extern int yylex();
+extern char* yytext;
+
+// Implementación de GlobalTokenSource
+int GlobalTokenSource::next() noexcept {
+    return yylex();
+}
+
+const char* GlobalTokenSource::getText() const noexcept {
+    return yytext;
+}
+
+int GlobalTokenSource::getLine() const noexcept {
+    return yylloc.first_line;
+}
+
+int GlobalTokenSource::getColumn() const noexcept {
+    return yylloc.first_column;
+}
+
+int GlobalTokenSource::getLastColumn() const noexcept {
+    return yylloc.last_column;
+}
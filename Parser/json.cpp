@@ -0,0 +1,327 @@
+#include "json.hpp"
+#include <cstdio>
+#include <cstdlib>
+
+// Parser descendente recursivo de JSON
+class JsonValue::Parser {
+public:
+    explicit Parser(const std::string& text) noexcept : text{text} {}
+
+    bool parseDocument(JsonValue& value) noexcept {
+        if (!parseValue(value, 0)) {
+            return false;
+        }
+        skipSpace();
+        return position == text.size();
+    }
+
+private:
+    // Profundidad máxima de anidamiento, para no agotar la pila con entradas hostiles
+    static constexpr int max_depth = 128;
+
+    void skipSpace() noexcept {
+        while (position < text.size() &&
+               (text[position] == ' ' || text[position] == '\t' ||
+                text[position] == '\n' || text[position] == '\r')) {
+            ++position;
+        }
+    }
+
+    bool consume(char expected) noexcept {
+        skipSpace();
+        if (position < text.size() && text[position] == expected) {
+            ++position;
+            return true;
+        }
+        return false;
+    }
+
+    bool consumeWord(const char* word) noexcept {
+        std::size_t start = position;
+        for (; *word != '\0'; ++word, ++position) {
+            if (position >= text.size() || text[position] != *word) {
+                position = start;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool parseValue(JsonValue& value, int depth) noexcept {
+        skipSpace();
+        if (position >= text.size() || depth > max_depth) {
+            return false;
+        }
+
+        char c = text[position];
+        if (c == '{') {
+            return parseObject(value, depth);
+        }
+        if (c == '[') {
+            return parseArray(value, depth);
+        }
+        if (c == '"') {
+            value.type = Type::STRING;
+            return parseString(value.text);
+        }
+        if (consumeWord("true")) {
+            value.type = Type::BOOLEAN;
+            value.boolean = true;
+            return true;
+        }
+        if (consumeWord("false")) {
+            value.type = Type::BOOLEAN;
+            value.boolean = false;
+            return true;
+        }
+        if (consumeWord("null")) {
+            value.type = Type::NUL;
+            return true;
+        }
+        return parseNumber(value);
+    }
+
+    bool parseNumber(JsonValue& value) noexcept {
+        const char* begin = text.c_str() + position;
+        char* end;
+        double number = std::strtod(begin, &end);
+        if (end == begin) {
+            return false;
+        }
+        position += static_cast<std::size_t>(end - begin);
+        value.type = Type::NUMBER;
+        value.number = number;
+        return true;
+    }
+
+    // Cuatro dígitos hexadecimales de un escape \uXXXX
+    bool parseHex(unsigned& code) noexcept {
+        if (position + 4 > text.size()) {
+            return false;
+        }
+        code = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = text[position++];
+            code <<= 4;
+            if (c >= '0' && c <= '9') {
+                code |= static_cast<unsigned>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                code |= static_cast<unsigned>(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                code |= static_cast<unsigned>(c - 'A' + 10);
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, unsigned code) noexcept {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool parseString(std::string& out) noexcept {
+        ++position;  // comilla inicial
+        out.clear();
+        while (position < text.size()) {
+            char c = text[position++];
+            if (c == '"') {
+                return true;
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (position >= text.size()) {
+                return false;
+            }
+            char escaped = text[position++];
+            switch (escaped) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    unsigned code;
+                    if (!parseHex(code)) {
+                        return false;
+                    }
+                    // Par sustituto de UTF-16 para los caracteres fuera del plano básico
+                    if (code >= 0xD800 && code < 0xDC00 && position + 6 <= text.size() &&
+                        text[position] == '\\' && text[position + 1] == 'u') {
+                        position += 2;
+                        unsigned low;
+                        if (!parseHex(low)) {
+                            return false;
+                        }
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, code);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        return false;
+    }
+
+    bool parseArray(JsonValue& value, int depth) noexcept {
+        ++position;
+        value.type = Type::ARRAY;
+        if (consume(']')) {
+            return true;
+        }
+        do {
+            value.items.emplace_back();
+            if (!parseValue(value.items.back(), depth + 1)) {
+                return false;
+            }
+        } while (consume(','));
+        return consume(']');
+    }
+
+    bool parseObject(JsonValue& value, int depth) noexcept {
+        ++position;
+        value.type = Type::OBJECT;
+        if (consume('}')) {
+            return true;
+        }
+        do {
+            skipSpace();
+            if (position >= text.size() || text[position] != '"') {
+                return false;
+            }
+            value.members.emplace_back();
+            if (!parseString(value.members.back().first) || !consume(':') ||
+                !parseValue(value.members.back().second, depth + 1)) {
+                return false;
+            }
+        } while (consume(','));
+        return consume('}');
+    }
+
+    const std::string& text;
+    std::size_t position{0};
+};
+
+// Implementación de JsonValue
+JsonValue::Type JsonValue::getType() const noexcept {
+    return type;
+}
+
+bool JsonValue::isNull() const noexcept {
+    return type == Type::NUL;
+}
+
+bool JsonValue::getBool() const noexcept {
+    return boolean;
+}
+
+double JsonValue::getNumber() const noexcept {
+    return number;
+}
+
+int JsonValue::getInt() const noexcept {
+    return static_cast<int>(number);
+}
+
+const std::string& JsonValue::getString() const noexcept {
+    return text;
+}
+
+const std::vector<JsonValue>& JsonValue::getItems() const noexcept {
+    return items;
+}
+
+const JsonValue& JsonValue::operator[](const std::string& key) const noexcept {
+    static const JsonValue null_value;
+    for (const auto& member : members) {
+        if (member.first == key) {
+            return member.second;
+        }
+    }
+    return null_value;
+}
+
+bool JsonValue::has(const std::string& key) const noexcept {
+    for (const auto& member : members) {
+        if (member.first == key) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string JsonValue::toJson() const noexcept {
+    switch (type) {
+        case Type::NUL: return "null";
+        case Type::BOOLEAN: return boolean ? "true" : "false";
+        case Type::NUMBER: {
+            char buffer[32];
+            std::snprintf(buffer, sizeof buffer, "%.17g", number);
+            return buffer;
+        }
+        case Type::STRING: return jsonQuote(text);
+        case Type::ARRAY: {
+            std::string result = "[";
+            for (std::size_t i = 0; i < items.size(); ++i) {
+                result += (i > 0 ? "," : "") + items[i].toJson();
+            }
+            return result + "]";
+        }
+        case Type::OBJECT: {
+            std::string result = "{";
+            for (std::size_t i = 0; i < members.size(); ++i) {
+                result += (i > 0 ? "," : "") + jsonQuote(members[i].first) + ":" + members[i].second.toJson();
+            }
+            return result + "}";
+        }
+    }
+    return "null";
+}
+
+bool JsonValue::parse(const std::string& text, JsonValue& value) noexcept {
+    value = JsonValue();
+    return Parser{text}.parseDocument(value);
+}
+
+std::string jsonQuote(const std::string& text) noexcept {
+    std::string result = "\"";
+    for (char c : text) {
+        switch (c) {
+            case '"': result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n"; break;
+            case '\r': result += "\\r"; break;
+            case '\t': result += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof escaped, "\\u%04x", c);
+                    result += escaped;
+                } else {
+                    result += c;
+                }
+        }
+    }
+    return result + "\"";
+}
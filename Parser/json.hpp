@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Valor JSON mínimo para el servidor de lenguaje (JSON-RPC): lo justo para
+// leer los mensajes del editor. Las respuestas se escriben directamente como
+// texto, con jsonQuote para los strings.
+class JsonValue {
+public:
+    enum class Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+    JsonValue() noexcept = default;
+
+    Type getType() const noexcept;
+    bool isNull() const noexcept;
+
+    bool getBool() const noexcept;
+    double getNumber() const noexcept;
+    int getInt() const noexcept;
+    const std::string& getString() const noexcept;
+    const std::vector<JsonValue>& getItems() const noexcept;
+
+    // Miembro de un objeto, o un valor nulo si no existe (o si no es objeto)
+    const JsonValue& operator[](const std::string& key) const noexcept;
+    bool has(const std::string& key) const noexcept;
+
+    // Texto JSON del valor, tal como se leyó (para reenviar ids)
+    std::string toJson() const noexcept;
+
+    // Lee un valor JSON completo; false si el texto no es JSON válido
+    static bool parse(const std::string& text, JsonValue& value) noexcept;
+
+private:
+    class Parser;
+
+    Type type{Type::NUL};
+    bool boolean{false};
+    double number{0.0};
+    std::string text;
+    std::vector<JsonValue> items;
+    std::vector<std::pair<std::string, JsonValue>> members;
+};
+
+// String entre comillas, con los caracteres de control y comillas escapados
+std::string jsonQuote(const std::string& text) noexcept;
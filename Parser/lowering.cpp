@@ -0,0 +1,173 @@
+#include "lowering.hpp"
+#include "../AST/expression.hpp"
+#include "../AST/note_pool.hpp"
+#include "../AST/statement.hpp"
+#include "../AST/voice.hpp"
+#include <memory>
+
+// Duración del AST equivalente a la del parser
+static DurationType lowerDuration(Duration duration) noexcept {
+    switch (duration) {
+        case Duration::BLANCA: return DurationType::BLANCA;
+        case Duration::NEGRA: return DurationType::NEGRA;
+        case Duration::CORCHEA: return DurationType::CORCHEA;
+        case Duration::SEMICORCHEA: return DurationType::SEMICORCHEA;
+        default: return DurationType::NEGRA;
+    }
+}
+
+static Statement* lowerStatement(const Expression* instruction, NotePool& pool) noexcept;
+
+// Cuerpo de un bloque. forward_list solo inserta al frente: se recorre al revés
+static ProgramBody lowerBody(const std::vector<Expression*>& instructions, NotePool& pool) noexcept {
+    ProgramBody body;
+    for (auto it = instructions.rbegin(); it != instructions.rend(); ++it) {
+        if (Statement* statement = lowerStatement(*it, pool)) {
+            body.push_front(statement);
+        }
+    }
+    return body;
+}
+
+// Sentencia del AST equivalente a una nota, un acorde, una repetición o un motivo (con
+// su cuerpo) o una referencia, o nullptr si la instrucción no es una sentencia.
+// Las notas comparten los nodos de altura y duración del pool del programa
+static Statement* lowerStatement(const Expression* instruction, NotePool& pool) noexcept {
+    if (auto note = dynamic_cast<const Note*>(instruction)) {
+        return pool.make_note(note->getNoteName(), note->getOctave(), lowerDuration(note->getDuration()));
+    }
+
+    if (auto chord = dynamic_cast<const Chord*>(instruction)) {
+        // Las notas que no entran quedan contadas: resolve_names reporta el error
+        auto statement = new ChordStatement(lowerDuration(chord->getDuration()));
+        for (const auto& pitch : chord->getNotes()) {
+            statement->add_note(pitch.note_name, pitch.octave);
+        }
+        return statement;
+    }
+
+    if (auto repeat = dynamic_cast<const Repeat*>(instruction)) {
+        return new RepeatStatement(repeat->getCount(), lowerBody(repeat->getInstructions(), pool));
+    }
+
+    if (auto motif = dynamic_cast<const Motif*>(instruction)) {
+        return new MotifStatement(motif->getName(), lowerBody(motif->getInstructions(), pool));
+    }
+
+    if (auto reference = dynamic_cast<const MotifReference*>(instruction)) {
+        return new MotifReferenceStatement(reference->getName());
+    }
+
+    return nullptr;
+}
+
+// Implementación de LoweringState
+bool LoweringState::operator==(const LoweringState& other) const noexcept {
+    return has_tempo == other.has_tempo && has_time_signature == other.has_time_signature && voice == other.voice;
+}
+
+bool LoweringState::operator!=(const LoweringState& other) const noexcept {
+    return !(*this == other);
+}
+
+LoweredInstruction lowerInstruction(const Expression* instruction, LoweringState& state, NotePool& pool,
+                                    SourceLocation location) noexcept {
+    LoweredInstruction lowered;
+    if (auto tempo = dynamic_cast<const Tempo*>(instruction)) {
+        if (state.has_tempo) {
+            lowered.statement = new TempoChangeStatement(tempo->getTempo());
+        } else {
+            lowered.declaration = new TempoDeclaration(tempo->getTempo());
+            state.has_tempo = true;
+        }
+    } else if (auto time_signature = dynamic_cast<const TimeSignature*>(instruction)) {
+        if (state.has_time_signature) {
+            lowered.statement = new TimeSignatureChangeStatement(time_signature->getNumerator(),
+                                                                 time_signature->getDenominator());
+        } else {
+            lowered.declaration = new TimeSignatureDeclaration(time_signature->getNumerator(),
+                                                               time_signature->getDenominator());
+            state.has_time_signature = true;
+        }
+    } else if (auto transpose = dynamic_cast<const Transpose*>(instruction)) {
+        lowered.declaration = new TransposeDeclaration(transpose->getSemitones());
+    } else if (auto key = dynamic_cast<const Key*>(instruction)) {
+        KeyMode mode = (key->getType() == Key::KeyType::MAJOR) ? KeyMode::MAYOR : KeyMode::MENOR;
+        lowered.declaration = new KeyDeclaration(key->getNote(), mode);
+    } else if (auto voice_start = dynamic_cast<const Voice*>(instruction)) {
+        state.voice = voice_start->getName();
+    } else {
+        lowered.statement = lowerStatement(instruction, pool);
+    }
+
+    if (lowered.statement != nullptr) {
+        lowered.statement->set_source_location(location);
+    }
+    if (lowered.declaration != nullptr) {
+        lowered.declaration->set_source_location(location);
+    }
+    return lowered;
+}
+
+ProgramLowering::ProgramLowering() noexcept
+    : result{new MusicProgram()} {
+    this->result->set_note_pool(std::make_shared<NotePool>());
+}
+
+ProgramLowering::~ProgramLowering() noexcept {
+    delete this->result;
+}
+
+void ProgramLowering::add(const Expression* instruction, SourceLocation location) noexcept {
+    LoweredInstruction lowered = lowerInstruction(instruction, this->state, *this->result->get_note_pool(), location);
+
+    // Tras "Voz X": buscar la voz por nombre, o crearla si es la primera vez que aparece
+    if (dynamic_cast<const Voice*>(instruction) != nullptr) {
+        this->voice = nullptr;
+        for (const auto existing : this->result->get_voices()) {
+            if (existing->get_name() == this->state.voice) {
+                this->voice = existing;
+                break;
+            }
+        }
+        if (this->voice == nullptr) {
+            this->voice = new MusicVoice(this->state.voice);
+            this->result->add_voice(this->voice);
+        }
+    }
+
+    if (lowered.statement != nullptr) {
+        if (this->voice != nullptr) {
+            this->voice->add_statement(lowered.statement);
+        } else {
+            this->result->add_statement(lowered.statement);
+        }
+    }
+    this->result->add_declaration(lowered.declaration);
+}
+
+MusicProgram& ProgramLowering::current() noexcept {
+    return *this->result;
+}
+
+MusicProgram* ProgramLowering::release() noexcept {
+    MusicProgram* program = this->result;
+    this->result = nullptr;
+    this->voice = nullptr;
+    this->state = LoweringState{};
+    return program;
+}
+
+MusicProgram* lowerProgram(const Program& program,
+                           const std::vector<InstructionLocation>* locations) noexcept {
+    ProgramLowering lowering;
+    const auto& instructions = program.getInstructions();
+    for (std::size_t i = 0; i < instructions.size(); ++i) {
+        SourceLocation location;
+        if (locations != nullptr && i < locations->size()) {
+            location = SourceLocation{(*locations)[i].line, (*locations)[i].column};
+        }
+        lowering.add(instructions[i], location);
+    }
+    return lowering.release();
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "expression.hpp"
+#include "recursive_descent.hpp"
+#include "../AST/declaration.hpp"
+#include <string>
+#include <vector>
+
+class NotePool;
+
+// Traduce el árbol del parser (Program, una lista plana de instrucciones) al
+// AST del compilador (MusicProgram). Las notas que siguen a "Voz X" pertenecen
+// a la voz X; volver a declarar una voz continúa la misma parte. Cada
+// "Repetir N { ... }" se traduce a una RepeatStatement sin expandir su cuerpo;
+// los motivos y sus referencias se enlazan después, en resolve_names.
+// El primer "Tempo" y el primer "Compas" son declaraciones de la cabecera;
+// los siguientes son cambios, sentencias que quedan en la posición en que
+// aparecen (ver TempoMap).
+// Las notas comparten los nodos de altura y duración de un NotePool, que
+// queda en el programa (MusicProgram::get_note_pool).
+// Si recibe locations (una por instrucción), cada declaración y sentencia de
+// nivel superior guarda la suya, para ubicar los errores semánticos.
+MusicProgram* lowerProgram(const Program& program,
+                           const std::vector<InstructionLocation>* locations = nullptr) noexcept;
+
+// Estado de la traducción entre una instrucción y la siguiente: si ya hubo
+// un "Tempo" y un "Compas" (los siguientes son cambios) y la voz de las
+// sentencias (vacía antes del primer "Voz")
+struct LoweringState {
+    bool has_tempo{false};
+    bool has_time_signature{false};
+    std::string voice;
+
+    bool operator==(const LoweringState& other) const noexcept;
+    bool operator!=(const LoweringState& other) const noexcept;
+};
+
+// Instrucción de nivel superior traducida: una declaración, una sentencia de
+// state.voice o, para "Voz X", ninguna de las dos (state.voice pasa a ser X)
+struct LoweredInstruction {
+    Declaration* declaration{nullptr};
+    Statement* statement{nullptr};
+};
+
+// Traduce una instrucción a partir del estado, que deja listo para la
+// siguiente. Lo traducido es del llamador; las notas comparten los nodos de
+// pool. Para quien guarda las partes del programa por su cuenta (ver
+// ScoreDocument)
+LoweredInstruction lowerInstruction(const Expression* instruction, LoweringState& state, NotePool& pool,
+                                    SourceLocation location = SourceLocation{}) noexcept;
+
+// Traducción incremental, para quien recibe las instrucciones de nivel
+// superior de a una (ver pipeline.hpp). lowerProgram la usa sobre el árbol
+// completo, así que ambas producen el mismo AST.
+class ProgramLowering {
+public:
+    ProgramLowering() noexcept;
+    ~ProgramLowering() noexcept;
+
+    ProgramLowering(const ProgramLowering&) = delete;
+    ProgramLowering& operator=(const ProgramLowering&) = delete;
+
+    // Traduce la siguiente instrucción y la agrega al programa o a la voz actual
+    void add(const Expression* instruction, SourceLocation location = SourceLocation{}) noexcept;
+
+    // Programa traducido hasta ahora, que sigue siendo de la traducción
+    MusicProgram& current() noexcept;
+
+    // Entrega el programa traducido hasta ahora; el llamador lo libera
+    MusicProgram* release() noexcept;
+
+private:
+    MusicProgram* result;
+    MusicVoice* voice{nullptr};
+    LoweringState state;
+};
@@ -0,0 +1,496 @@
+#include "json.hpp"
+#include "score_document.hpp"
+#include "../AST/declaration.hpp"
+#include "../Semantic_Analysis/symbol_table.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Servidor de lenguaje (Language Server Protocol) para archivos .mus: lee
+// mensajes JSON-RPC de stdin y responde por stdout. Publica los errores de
+// cada documento al abrirlo y tras cada cambio, describe la duración y la
+// posición en el compás de la instrucción bajo el cursor y lista los
+// compases de cada voz como símbolos del documento.
+
+// Los editores cuentan las columnas en unidades UTF-16; el documento, en bytes
+static std::size_t utf16ToByteColumn(std::string_view line, std::size_t units) noexcept {
+    std::size_t byte = 0;
+    while (byte < line.size() && units > 0) {
+        unsigned char c = static_cast<unsigned char>(line[byte]);
+        std::size_t length = (c < 0x80) ? 1 : (c < 0xE0) ? 2 : (c < 0xF0) ? 3 : 4;
+        std::size_t width = (length == 4) ? 2 : 1;
+        if (width > units) {
+            break;
+        }
+        units -= width;
+        byte = std::min(byte + length, line.size());
+    }
+    return byte;
+}
+
+static std::size_t byteToUtf16Column(std::string_view line, std::size_t bytes) noexcept {
+    std::size_t units = 0;
+    std::size_t byte = 0;
+    bytes = std::min(bytes, line.size());
+    while (byte < bytes) {
+        unsigned char c = static_cast<unsigned char>(line[byte]);
+        std::size_t length = (c < 0x80) ? 1 : (c < 0xE0) ? 2 : (c < 0xF0) ? 3 : 4;
+        units += (length == 4) ? 2 : 1;
+        byte += length;
+    }
+    return units;
+}
+
+// Lee un mensaje ("Content-Length: N", una línea vacía y N bytes de JSON)
+static bool readMessage(std::string& body) noexcept {
+    std::size_t length = 0;
+    bool has_length = false;
+    std::string header;
+    for (;;) {
+        int c = std::getchar();
+        if (c == EOF) {
+            return false;
+        }
+        if (c != '\n') {
+            header.push_back(static_cast<char>(c));
+            continue;
+        }
+        if (!header.empty() && header.back() == '\r') {
+            header.pop_back();
+        }
+        if (header.empty()) {
+            if (has_length) {
+                break;
+            }
+            continue;
+        }
+        static const char prefix[] = "Content-Length:";
+        if (header.compare(0, sizeof(prefix) - 1, prefix) == 0) {
+            length = static_cast<std::size_t>(std::strtoul(header.c_str() + sizeof(prefix) - 1, nullptr, 10));
+            has_length = true;
+        }
+        header.clear();
+    }
+
+    body.resize(length);
+    return std::fread(&body[0], 1, length, stdin) == length;
+}
+
+static void writeMessage(const std::string& body) noexcept {
+    std::printf("Content-Length: %zu\r\n\r\n", body.size());
+    std::fwrite(body.data(), 1, body.size(), stdout);
+    std::fflush(stdout);
+}
+
+static void respond(const JsonValue& id, const std::string& result) noexcept {
+    writeMessage("{\"jsonrpc\":\"2.0\",\"id\":" + id.toJson() + ",\"result\":" + result + "}");
+}
+
+static void respondError(const JsonValue& id, int code, const std::string& message) noexcept {
+    writeMessage("{\"jsonrpc\":\"2.0\",\"id\":" + id.toJson() + ",\"error\":{\"code\":" +
+                 std::to_string(code) + ",\"message\":" + jsonQuote(message) + "}}");
+}
+
+static void notify(const std::string& method, const std::string& params) noexcept {
+    writeMessage("{\"jsonrpc\":\"2.0\",\"method\":" + jsonQuote(method) + ",\"params\":" + params + "}");
+}
+
+static std::string position(std::size_t line, std::size_t character) noexcept {
+    return "{\"line\":" + std::to_string(line) + ",\"character\":" + std::to_string(character) + "}";
+}
+
+// Rango de una línea (desde 0) entre dos columnas en bytes
+static std::string range(const ScoreDocument& document, std::size_t line,
+                         std::size_t begin, std::size_t end) noexcept {
+    std::string_view text = document.getLine(line);
+    return "{\"start\":" + position(line, byteToUtf16Column(text, begin)) +
+           ",\"end\":" + position(line, byteToUtf16Column(text, end)) + "}";
+}
+
+// Diagnósticos de un documento. Un error sintáctico marca el texto desde su
+// columna hasta el siguiente blanco; uno semántico, el resto de la línea de
+// su instrucción (o el comienzo del documento, si no tiene ubicación)
+static std::string diagnosticsToJson(const ScoreDocument& document) noexcept {
+    std::string result = "[";
+    for (const auto& diagnostic : document.getDiagnostics()) {
+        std::size_t line = (diagnostic.line > 0) ? static_cast<std::size_t>(diagnostic.line) - 1 : 0;
+        std::string_view text = document.getLine(line);
+        std::size_t begin = (diagnostic.column > 0) ? static_cast<std::size_t>(diagnostic.column) - 1 : 0;
+        begin = std::min(begin, text.size());
+        std::size_t end = begin;
+        if (diagnostic.phase == CompileDiagnostic::Phase::SYNTAX) {
+            auto blank = [&text](std::size_t i) { return text[i] == ' ' || text[i] == '\t' || text[i] == '\r'; };
+            while (end < text.size() && !blank(end)) {
+                ++end;
+            }
+            // Un error al final de la línea (falta algo) marca el token anterior
+            if (end == begin) {
+                while (begin > 0 && blank(begin - 1)) {
+                    --begin;
+                }
+                end = begin;
+                while (begin > 0 && !blank(begin - 1)) {
+                    --begin;
+                }
+            }
+        } else if (diagnostic.line > 0) {
+            end = text.size();
+        }
+
+        if (result.size() > 1) {
+            result += ",";
+        }
+        result += "{\"range\":" + range(document, line, begin, end) + ",\"severity\":1,\"source\":" +
+                  jsonQuote(diagnostic.phase == CompileDiagnostic::Phase::SYNTAX ? "sintaxis" : "semántica") +
+                  ",\"message\":" + jsonQuote(diagnostic.message) + "}";
+    }
+    return result + "]";
+}
+
+// Símbolo de un compás (SymbolKind 8: campo)
+static std::string measureToJson(const ScoreDocument& document, const MeasureSymbol& measure) noexcept {
+    std::size_t first = static_cast<std::size_t>(measure.first_line) - 1;
+    std::size_t last = std::min(static_cast<std::size_t>(measure.last_line), document.getLineCount()) - 1;
+    last = std::max(last, first);
+    std::string whole = "{\"start\":" + position(first, 0) + ",\"end\":" +
+                        position(last, byteToUtf16Column(document.getLine(last), document.getLine(last).size())) + "}";
+    return "{\"name\":" + jsonQuote("Compás " + std::to_string(measure.number)) +
+           ",\"kind\":8,\"range\":" + whole + ",\"selectionRange\":" +
+           range(document, first, 0, document.getLine(first).size()) + "}";
+}
+
+// Símbolos del documento: los compases fuera de las voces y, dentro de cada
+// voz (SymbolKind 2: módulo), los suyos
+static std::string symbolsToJson(const ScoreDocument& document) noexcept {
+    std::string result = "[";
+    const auto& measures = document.getMeasures();
+    for (std::size_t i = 0; i < measures.size();) {
+        if (result.size() > 1) {
+            result += ",";
+        }
+        if (measures[i].voice.empty()) {
+            result += measureToJson(document, measures[i++]);
+            continue;
+        }
+
+        std::size_t end = i;
+        std::string children;
+        while (end < measures.size() && measures[end].voice == measures[i].voice) {
+            children += (children.empty() ? "" : ",") + measureToJson(document, measures[end++]);
+        }
+        std::size_t first = static_cast<std::size_t>(measures[i].first_line) - 1;
+        std::size_t last = std::min(static_cast<std::size_t>(measures[end - 1].last_line), document.getLineCount()) - 1;
+        last = std::max(last, first);
+        result += "{\"name\":" + jsonQuote("Voz " + measures[i].voice) + ",\"kind\":2,\"range\":{\"start\":" +
+                  position(first, 0) + ",\"end\":" +
+                  position(last, byteToUtf16Column(document.getLine(last), document.getLine(last).size())) +
+                  "},\"selectionRange\":" + range(document, first, 0, 0) +
+                  ",\"children\":[" + children + "]}";
+        i = end;
+    }
+    return result + "]";
+}
+
+class LanguageServer {
+public:
+    // Atiende mensajes hasta "exit"; devuelve el código de salida
+    int run() noexcept {
+        std::string body;
+        while (readMessage(body)) {
+            JsonValue message;
+            if (!JsonValue::parse(body, message)) {
+                respondError(JsonValue{}, -32700, "JSON inválido");
+                continue;
+            }
+
+            const std::string& method = message["method"].getString();
+            if (method == "exit") {
+                return shutdown_requested ? 0 : 1;
+            }
+            handle(method, message);
+        }
+        return 1;
+    }
+
+private:
+    void handle(const std::string& method, const JsonValue& message) noexcept {
+        const JsonValue& id = message["id"];
+        const JsonValue& params = message["params"];
+        bool is_request = message.has("id");
+
+        if (method == "initialize") {
+            respond(id, "{\"capabilities\":{\"textDocumentSync\":{\"openClose\":true,\"change\":2},"
+                        "\"hoverProvider\":true,\"documentSymbolProvider\":true},"
+                        "\"serverInfo\":{\"name\":\"servidor_lsp\"}}");
+        } else if (method == "shutdown") {
+            shutdown_requested = true;
+            respond(id, "null");
+        } else if (method == "textDocument/didOpen") {
+            const JsonValue& document = params["textDocument"];
+            const std::string& uri = document["uri"].getString();
+            documents[uri] = std::make_unique<ScoreDocument>(document["text"].getString());
+            publish(uri);
+        } else if (method == "textDocument/didChange") {
+            change(params);
+        } else if (method == "textDocument/didClose") {
+            const std::string& uri = params["textDocument"]["uri"].getString();
+            documents.erase(uri);
+            notify("textDocument/publishDiagnostics", "{\"uri\":" + jsonQuote(uri) + ",\"diagnostics\":[]}");
+        } else if (method == "textDocument/hover") {
+            respond(id, hover(params));
+        } else if (method == "textDocument/documentSymbol") {
+            ScoreDocument* document = find(params["textDocument"]["uri"].getString());
+            respond(id, (document != nullptr) ? symbolsToJson(*document) : "[]");
+        } else if (is_request) {
+            respondError(id, -32601, "Método no soportado: " + method);
+        }
+        // Las demás notificaciones (initialized, $/..., etc.) se ignoran
+    }
+
+    ScoreDocument* find(const std::string& uri) noexcept {
+        auto it = documents.find(uri);
+        return (it != documents.end()) ? it->second.get() : nullptr;
+    }
+
+    void publish(const std::string& uri) noexcept {
+        ScoreDocument* document = find(uri);
+        if (document != nullptr) {
+            notify("textDocument/publishDiagnostics",
+                   "{\"uri\":" + jsonQuote(uri) + ",\"diagnostics\":" + diagnosticsToJson(*document) + "}");
+        }
+    }
+
+    // Aplica los cambios en orden: los que traen un rango son incrementales;
+    // los demás reemplazan el documento completo
+    void change(const JsonValue& params) noexcept {
+        const std::string& uri = params["textDocument"]["uri"].getString();
+        ScoreDocument* document = find(uri);
+        if (document == nullptr) {
+            return;
+        }
+
+        for (const auto& change : params["contentChanges"].getItems()) {
+            const std::string& text = change["text"].getString();
+            if (!change.has("range")) {
+                document->replaceText(text);
+                continue;
+            }
+
+            const JsonValue& start = change["range"]["start"];
+            const JsonValue& end = change["range"]["end"];
+            std::size_t start_line = static_cast<std::size_t>(start["line"].getInt());
+            std::size_t end_line = static_cast<std::size_t>(end["line"].getInt());
+            document->applyEdit(
+                start_line, utf16ToByteColumn(document->getLine(start_line), start["character"].getInt()),
+                end_line, utf16ToByteColumn(document->getLine(end_line), end["character"].getInt()),
+                text);
+        }
+        publish(uri);
+    }
+
+    std::string hover(const JsonValue& params) noexcept {
+        ScoreDocument* document = find(params["textDocument"]["uri"].getString());
+        if (document == nullptr) {
+            return "null";
+        }
+
+        std::size_t line = static_cast<std::size_t>(params["position"]["line"].getInt());
+        std::size_t column = utf16ToByteColumn(document->getLine(line), params["position"]["character"].getInt());
+        std::string description = document->describeAt(static_cast<int>(line) + 1, static_cast<int>(column) + 1);
+        if (description.empty()) {
+            return "null";
+        }
+        return "{\"contents\":{\"kind\":\"plaintext\",\"value\":" + jsonQuote(description) + "}}";
+    }
+
+    std::map<std::string, std::unique_ptr<ScoreDocument>> documents;
+    bool shutdown_requested{false};
+};
+
+// Diferencias entre dos análisis del mismo texto (vacío si coinciden)
+static std::string compareDocuments(const ScoreDocument& incremental, const ScoreDocument& full) noexcept {
+    if (incremental.getText() != full.getText()) {
+        return "el texto no coincide";
+    }
+    const auto& a = incremental.getDiagnostics();
+    const auto& b = full.getDiagnostics();
+    if (a.size() != b.size()) {
+        return "cantidad de errores: " + std::to_string(a.size()) + " y " + std::to_string(b.size());
+    }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (a[i].phase != b[i].phase || a[i].line != b[i].line || a[i].column != b[i].column ||
+            a[i].message != b[i].message) {
+            return "error distinto: " + diagnosticToString(a[i]) + " y " + diagnosticToString(b[i]);
+        }
+    }
+    if (incremental.programToString() != full.programToString()) {
+        return "las instrucciones no coinciden";
+    }
+    const auto& measures_a = incremental.getMeasures();
+    const auto& measures_b = full.getMeasures();
+    if (measures_a.size() != measures_b.size()) {
+        return "cantidad de compases distinta";
+    }
+    for (std::size_t i = 0; i < measures_a.size(); ++i) {
+        if (measures_a[i].voice != measures_b[i].voice || measures_a[i].number != measures_b[i].number ||
+            measures_a[i].first_line != measures_b[i].first_line ||
+            measures_a[i].last_line != measures_b[i].last_line) {
+            return "compás distinto: " + std::to_string(measures_a[i].number);
+        }
+    }
+    return "";
+}
+
+// Diferencias entre los errores semánticos de un análisis y los del
+// programa completo, traducido y verificado de una vez con resolve_names
+// (vacío si coinciden). Solo sin errores sintácticos: con ellos no se publican
+static std::string compareWithProgram(const ScoreDocument& document) noexcept {
+    const auto& diagnostics = document.getDiagnostics();
+    bool syntax = std::any_of(diagnostics.begin(), diagnostics.end(), [](const CompileDiagnostic& diagnostic) {
+        return diagnostic.phase == CompileDiagnostic::Phase::SYNTAX;
+    });
+    if (syntax) {
+        return "";
+    }
+
+    const std::string& text = document.getText();
+    std::vector<SyntaxError> syntax_errors;
+    std::vector<InstructionLocation> locations;
+    Program* program = parseParallel(text.data(), text.size(), 1, syntax_errors, &locations);
+    std::vector<CompileDiagnostic> expected;
+    if (syntax_errors.empty()) {
+        std::unique_ptr<MusicProgram> music{lowerProgram(*program, &locations)};
+        DiagnosticErrorSink sink{expected};
+        SemanticErrorRedirect redirect{sink};
+        SymbolTable table;
+        music->resolve_names(table);
+    }
+    program->destroy();
+    std::stable_sort(expected.begin(), expected.end(), [](const CompileDiagnostic& a, const CompileDiagnostic& b) {
+        return std::tie(a.line, a.column, a.message) < std::tie(b.line, b.column, b.message);
+    });
+
+    if (diagnostics.size() != expected.size()) {
+        return "cantidad de errores frente al programa completo: " + std::to_string(diagnostics.size()) + " y " +
+               std::to_string(expected.size());
+    }
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        if (diagnostics[i].line != expected[i].line || diagnostics[i].column != expected[i].column ||
+            diagnostics[i].message != expected[i].message) {
+            return "error distinto frente al programa completo: " + diagnosticToString(diagnostics[i]) + " y " +
+                   diagnosticToString(expected[i]);
+        }
+    }
+    return "";
+}
+
+// Verifica el análisis incremental contra uno completo: arma el documento
+// línea por línea (si es corto), borra y vuelve a insertar hasta 200 líneas
+// comparando tras cada edición (con el documento analizado de nuevo y con
+// los errores del programa completo), y mide el tiempo de una edición de una línea
+// frente al de analizar el documento completo
+static int verify(const std::string& path) noexcept {
+    std::ifstream file{path, std::ios::binary};
+    if (!file) {
+        std::cerr << "Error: No se pudo abrir el archivo: " << path << std::endl;
+        return 1;
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::string text = contents.str();
+
+    std::vector<std::string> lines;
+    std::size_t begin = 0;
+    while (begin < text.size()) {
+        std::size_t end = text.find('\n', begin);
+        end = (end == std::string::npos) ? text.size() : end + 1;
+        lines.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
+
+    auto check = [&](const ScoreDocument& document, const std::string& step) {
+        ScoreDocument full{document.getText()};
+        std::string difference = compareDocuments(document, full);
+        if (difference.empty()) {
+            difference = compareWithProgram(document);
+        }
+        if (!difference.empty()) {
+            std::cerr << "Diferencia en " << path << " (" << step << "): " << difference << std::endl;
+            return false;
+        }
+        return true;
+    };
+
+    static const std::size_t max_appended_lines = 2000;
+    ScoreDocument document{lines.size() <= max_appended_lines ? std::string{} : text};
+    if (lines.size() <= max_appended_lines) {
+        for (std::size_t i = 0; i < lines.size(); ++i) {
+            std::size_t last = document.getLineCount() - 1;
+            document.applyEdit(last, document.getLine(last).size(), last, document.getLine(last).size(), lines[i]);
+        }
+    }
+    if (!check(document, "texto completo")) {
+        return 1;
+    }
+
+    // Borrar y volver a insertar líneas repartidas por todo el documento
+    std::size_t edit_count = std::min<std::size_t>(200, lines.size());
+    for (std::size_t i = 0; i < edit_count; ++i) {
+        std::size_t line = i * lines.size() / edit_count;
+        document.applyEdit(line, 0, line + 1, 0, "");
+        if (!check(document, "línea " + std::to_string(line + 1) + " borrada")) {
+            return 1;
+        }
+        document.applyEdit(line, 0, line, 0, lines[line]);
+        if (!check(document, "línea " + std::to_string(line + 1) + " insertada")) {
+            return 1;
+        }
+    }
+
+    // Tiempos: las mismas ediciones, sin comparar
+    using Clock = std::chrono::steady_clock;
+    std::size_t reused = 0;
+    std::size_t total = 0;
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < edit_count; ++i) {
+        std::size_t line = i * lines.size() / edit_count;
+        document.applyEdit(line, 0, line + 1, 0, "");
+        reused += document.getReusedSegments();
+        total += document.getReusedSegments() + document.getReparsedSegments();
+        document.applyEdit(line, 0, line, 0, lines[line]);
+    }
+    double edit_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count() /
+                     static_cast<double>(std::max<std::size_t>(1, 2 * edit_count));
+
+    start = Clock::now();
+    ScoreDocument full{text};
+    double full_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    std::cout << "OK: " << path << " (" << lines.size() << " líneas, " << 2 * edit_count
+              << " ediciones; edición: " << edit_ms << " ms, análisis completo: " << full_ms
+              << " ms; segmentos reutilizados: " << reused << " de " << total << ")" << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 3 && std::strcmp(argv[1], "--verificar") == 0) {
+        return verify(argv[2]);
+    }
+    if (argc != 1) {
+        std::cerr << "Uso: " << argv[0] << " [--verificar archivo.mus]" << std::endl;
+        return 1;
+    }
+
+    LanguageServer server;
+    return server.run();
+}
@@ -1,26 +1,281 @@
 #include <iostream>
+#include <chrono>
 #include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <vector>
 #include "expression.hpp"
+#include "compile.hpp"
+#include "measure_index.hpp"
+#include "../AST/declaration.hpp"
+#include "../AST/note_pool.hpp"
+#include "../AST/output_sink.hpp"
+#include "../AST/program_passes.hpp"
+#include "../Semantic_Analysis/symbol_table.hpp"
+#include "lowering.hpp"
+#include "parallel_front_end.hpp"
+#include "pipeline.hpp"
+#include "recursive_descent.hpp"
+#include "server.hpp"
+#include "syntax_error.hpp"
+#include "validator.hpp"
 
 extern FILE* yyin;
 extern int yyparse();
 extern Expression* parser_result;
 
 // verificar la extensión del archivo
+bool tiene_extension(const std::string& nombre_archivo, const std::string& extension) {
+    if (nombre_archivo.size() < extension.size()) return false;
+    return nombre_archivo.substr(nombre_archivo.size() - extension.size()) == extension;
+}
+
 bool tiene_extension_mus(const std::string& nombre_archivo) {
-    if (nombre_archivo.size() < 4) return false;
-    return nombre_archivo.substr(nombre_archivo.size() - 4) == ".mus";
+    return tiene_extension(nombre_archivo, ".mus");
+}
+
+void mostrar_uso(const char* programa) {
+    std::cerr << "Uso: " << programa << " [--parser=bison|descendente] [--hilos N | --pipeline] [--tiempo] [--transponer N] [-o archivo.abc|.txt|.mid|.json|.h]... <archivo.mus>" << std::endl;
+    std::cerr << "     " << programa << " --servidor <socket|-> [--trabajadores N]" << std::endl;
+    std::cerr << "     " << programa << " --check [--tiempo] [--transponer N] <archivo.mus>..." << std::endl;
+    std::cerr << "     " << programa << " --compases A-B [--indice archivo.idx] [--tiempo] [--transponer N] [-o archivo.abc] <archivo.mus>" << std::endl;
+}
+
+// Lee el archivo completo; devuelve false si no se puede abrir
+bool leer_archivo(const std::string& nombre_archivo, std::string& entrada) {
+    FILE* fuente = fopen(nombre_archivo.c_str(), "rb");
+    if (fuente == nullptr) {
+        return false;
+    }
+    fseek(fuente, 0, SEEK_END);
+    entrada.resize(static_cast<std::size_t>(ftell(fuente)));
+    fseek(fuente, 0, SEEK_SET);
+    entrada.resize(fread(&entrada[0], 1, entrada.size(), fuente));
+    fclose(fuente);
+    return true;
+}
+
+// Escribe los errores de una compilación igual que la compilación completa
+void reportar_diagnosticos(const std::vector<CompileDiagnostic>& diagnosticos) {
+    for (const auto& diagnostico : diagnosticos) {
+        std::cerr << diagnosticToString(diagnostico) << std::endl;
+    }
+    bool sintaxis = !diagnosticos.empty() && diagnosticos.front().phase == CompileDiagnostic::Phase::SYNTAX;
+    std::cerr << (sintaxis ? "Error: El análisis falló" : "Error: El programa no es válido semánticamente") << std::endl;
+}
+
+// Modo --check: solo verifica cada archivo, sin construir el árbol ni el AST
+// (ver validator.hpp). Si la verificación rápida encuentra un error o no
+// alcanza, se compila el archivo para reportar los mismos errores que el
+// compilador. No escribe nada para los archivos válidos.
+int verificar_archivos(const std::vector<std::string>& archivos, int transponer, bool medir_tiempo) {
+    std::string entrada;
+    std::string abc;
+    std::vector<CompileDiagnostic> diagnosticos;
+    std::size_t bytes = 0;
+    int invalidos = 0;
+
+    auto inicio = std::chrono::steady_clock::now();
+    for (const auto& archivo : archivos) {
+        if (!tiene_extension_mus(archivo) || !leer_archivo(archivo, entrada)) {
+            std::cerr << archivo << ": Error: No se pudo abrir el archivo .mus" << std::endl;
+            ++invalidos;
+            continue;
+        }
+        bytes += entrada.size();
+
+        if (checkBuffer(entrada.data(), entrada.size(), transponer) == CheckResult::VALID) {
+            continue;
+        }
+        if (compileBuffer(entrada.data(), entrada.size(), transponer, abc, diagnosticos)) {
+            continue;
+        }
+        for (const auto& diagnostico : diagnosticos) {
+            std::cerr << archivo << ": " << diagnosticToString(diagnostico) << std::endl;
+        }
+        ++invalidos;
+    }
+    auto fin = std::chrono::steady_clock::now();
+
+    if (medir_tiempo) {
+        double ms = std::chrono::duration<double, std::milli>(fin - inicio).count();
+        std::cerr << "Tiempo de verificación: " << ms << " ms ("
+                  << (ms > 0.0 ? bytes / 1e3 / ms : 0.0) << " MB/s)" << std::endl;
+    }
+    if (archivos.size() > 1) {
+        std::cout << archivos.size() << " archivos verificados, " << invalidos << " con errores" << std::endl;
+    }
+    return (invalidos == 0) ? 0 : 1;
+}
+
+// Modo --compases A-B: compila solo ese rango de compases a un fragmento ABC
+// independiente (ver measure_index.hpp). El índice de compases se lee de
+// archivo_indice si corresponde al archivo; si no, se arma con una
+// compilación completa y, si se indicó archivo_indice, se guarda para las
+// siguientes. Sin -o el fragmento va a la salida estándar.
+int compilar_compases(const std::string& nombre_archivo, const std::string& rango,
+                      const std::string& archivo_indice, const std::string& archivo_abc,
+                      int transponer, bool medir_tiempo) {
+    long primero = 0;
+    long ultimo = 0;
+    char guion = 0;
+    char resto = 0;
+    int campos = std::sscanf(rango.c_str(), "%ld%c%ld%c", &primero, &guion, &ultimo, &resto);
+    if (campos == 1) {
+        ultimo = primero;
+    } else if (campos != 3 || guion != '-') {
+        std::cerr << "Error: Rango de compases no válido: " << rango << " (se espera A-B)" << std::endl;
+        return 1;
+    }
+
+    std::string entrada;
+    if (!tiene_extension_mus(nombre_archivo) || !leer_archivo(nombre_archivo, entrada)) {
+        std::cerr << "Error: No se pudo abrir el archivo .mus " << nombre_archivo << std::endl;
+        return 1;
+    }
+
+    auto inicio = std::chrono::steady_clock::now();
+    MeasureIndex indice;
+    std::vector<CompileDiagnostic> diagnosticos;
+    std::ifstream indice_guardado(archivo_indice);
+    bool reutilizado = !archivo_indice.empty() && indice_guardado.is_open() &&
+                       readMeasureIndex(indice_guardado, indice) &&
+                       indice.matches(entrada.data(), entrada.size());
+    if (!reutilizado) {
+        if (!indexBuffer(entrada.data(), entrada.size(), indice, diagnosticos)) {
+            reportar_diagnosticos(diagnosticos);
+            return 1;
+        }
+        if (!archivo_indice.empty()) {
+            std::ofstream salida_indice(archivo_indice);
+            writeMeasureIndex(salida_indice, indice);
+        }
+    }
+    auto fin_indice = std::chrono::steady_clock::now();
+
+    std::string abc;
+    if (!compileMeasures(entrada.data(), entrada.size(), indice, primero, ultimo, transponer, abc, diagnosticos)) {
+        reportar_diagnosticos(diagnosticos);
+        return 1;
+    }
+    auto fin = std::chrono::steady_clock::now();
+
+    if (medir_tiempo) {
+        std::cerr << "Tiempo del índice (" << (reutilizado ? "leído" : "armado") << ", "
+                  << indice.measures.size() << " compases): "
+                  << std::chrono::duration<double, std::milli>(fin_indice - inicio).count() << " ms" << std::endl;
+        std::cerr << "Tiempo de los compases " << primero << "-" << ultimo << ": "
+                  << std::chrono::duration<double, std::milli>(fin - fin_indice).count() << " ms" << std::endl;
+    }
+
+    if (archivo_abc.empty()) {
+        std::cout << abc;
+        return 0;
+    }
+    std::ofstream salida(archivo_abc);
+    if (!salida.is_open()) {
+        std::cerr << "Error: No se pudo abrir el archivo " << archivo_abc << std::endl;
+        return 1;
+    }
+    salida << abc;
+    std::cout << "Compases " << primero << "-" << ultimo << " escritos en " << archivo_abc << std::endl;
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
-    // Verificar que se pasó un archivo como argumento
-    if (argc != 2) {
-        std::cerr << "Uso: " << argv[0] << " <archivo.mus>" << std::endl;
+    std::string nombre_archivo;
+    bool usar_descendente = false;
+    bool medir_tiempo = false;
+    int hilos = 0;
+    std::vector<std::string> archivos_salida;
+    int transponer = 0;
+    std::string socket_servidor;
+    unsigned trabajadores = 0;
+    bool solo_verificar = false;
+    bool segmentado = false;
+    std::string rango_compases;
+    std::string archivo_indice;
+    std::vector<std::string> archivos;
+
+    // Procesar las opciones y el archivo de entrada
+    for (int i = 1; i < argc; ++i) {
+        std::string argumento = argv[i];
+        if (argumento == "--parser=bison") {
+            usar_descendente = false;
+        } else if (argumento == "--parser=descendente") {
+            usar_descendente = true;
+        } else if (argumento == "--hilos" && i + 1 < argc) {
+            hilos = std::atoi(argv[++i]);
+        } else if (argumento == "--transponer" && i + 1 < argc) {
+            transponer = std::atoi(argv[++i]);
+        } else if (argumento == "--servidor" && i + 1 < argc) {
+            socket_servidor = argv[++i];
+        } else if (argumento == "--trabajadores" && i + 1 < argc) {
+            trabajadores = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (argumento == "-o" && i + 1 < argc) {
+            archivos_salida.push_back(argv[++i]);
+        } else if (argumento == "--compases" && i + 1 < argc) {
+            rango_compases = argv[++i];
+        } else if (argumento == "--indice" && i + 1 < argc) {
+            archivo_indice = argv[++i];
+        } else if (argumento == "--tiempo") {
+            medir_tiempo = true;
+        } else if (argumento == "--pipeline") {
+            segmentado = true;
+        } else if (argumento == "--check") {
+            solo_verificar = true;
+        } else if (argumento.rfind("--", 0) != 0) {
+            archivos.push_back(argumento);
+        } else {
+            mostrar_uso(argv[0]);
+            return 1;
+        }
+    }
+
+    // Modo servidor: compila las partituras que reciba hasta que lo detengan
+    if (!socket_servidor.empty()) {
+        return runServer(socket_servidor, trabajadores);
+    }
+
+    // Modo de verificación: uno o más archivos, sin salida para los válidos
+    if (solo_verificar && !archivos.empty()) {
+        return verificar_archivos(archivos, transponer, medir_tiempo);
+    }
+
+    // Verificar que se pasó un solo archivo como argumento
+    if (archivos.size() != 1 || solo_verificar) {
+        mostrar_uso(argv[0]);
         return 1;
     }
+    nombre_archivo = archivos.front();
+
+    // Con --compases y --pipeline, una sola salida ABC
+    std::string archivo_abc = archivos_salida.empty() ? "" : archivos_salida.front();
+    if ((!rango_compases.empty() || segmentado) &&
+        (archivos_salida.size() > 1 || (!archivo_abc.empty() && !tiene_extension(archivo_abc, ".abc")))) {
+        std::cerr << "Error: --compases y --pipeline escriben solo un archivo .abc" << std::endl;
+        return 1;
+    }
+
+    // Una salida por cada -o, según la extensión del archivo
+    std::vector<std::unique_ptr<OutputSink>> salidas;
+    for (const auto& archivo_salida : archivos_salida) {
+        salidas.emplace_back(make_output_sink(archivo_salida));
+        if (salidas.back() == nullptr) {
+            std::cerr << "Error: Formato de salida desconocido: " << archivo_salida
+                      << " (se espera .abc, .txt, .mid, .json o .h)" << std::endl;
+            return 1;
+        }
+    }
 
-    std::string nombre_archivo = argv[1];
+    // Rango de compases: solo esa parte del archivo, con el índice de compases
+    if (!rango_compases.empty()) {
+        return compilar_compases(nombre_archivo, rango_compases, archivo_indice, archivo_abc,
+                                 transponer, medir_tiempo);
+    }
 
     // Verificar que el archivo tiene la extensión correcta
     if (!tiene_extension_mus(nombre_archivo)) {
@@ -37,14 +292,59 @@ int main(int argc, char* argv[]) {
 
     std::cout << "Analizando archivo: " << nombre_archivo << std::endl;
 
-    // Llamar al parser
-    int resultado = yyparse();
+    // Llamar al parser seleccionado: todos consumen los mismos tokens y construyen el mismo árbol
+    const char* front_end = usar_descendente ? "descendente" : "bison";
+    auto inicio = std::chrono::steady_clock::now();
+    int resultado = 0;
+    PipelineResult segmentos;
+    if (segmentado) {
+        // Compilación segmentada: escáner, parser y emisor en hilos distintos
+        std::ifstream archivo(nombre_archivo, std::ios::binary);
+        std::stringstream contenido;
+        contenido << archivo.rdbuf();
+        std::string entrada = contenido.str();
+
+        front_end = "pipeline";
+        compilePipelined(entrada.data(), entrada.size(), transponer, !archivo_abc.empty(), segmentos);
+        parser_result = segmentos.program;
+        parser_errors = std::move(segmentos.syntax_errors);
+    } else if (hilos > 0) {
+        // Front end paralelo: la entrada completa en memoria, un fragmento por hilo
+        std::ifstream archivo(nombre_archivo, std::ios::binary);
+        std::stringstream contenido;
+        contenido << archivo.rdbuf();
+        std::string entrada = contenido.str();
+
+        front_end = "paralelo";
+        parser_result = parseParallel(entrada.data(), entrada.size(), hilos, parser_errors);
+    } else if (usar_descendente) {
+        GlobalTokenSource fuente;
+        RecursiveDescentParser parser{fuente, parser_errors};
+        parser_result = parser.parse();
+    } else {
+        resultado = yyparse();
+    }
+    auto fin = std::chrono::steady_clock::now();
+
+    if (medir_tiempo) {
+        std::cerr << "Tiempo de análisis (" << front_end << "): "
+                  << std::chrono::duration<double, std::milli>(fin - inicio).count()
+                  << " ms" << std::endl;
+        if (segmentado) {
+            writePipelineStats(std::cerr, segmentos.stats);
+        }
+    }
 
     // Cerrar el archivo
     fclose(yyin);
 
+    // Reportar todos los errores recolectados durante el análisis
+    for (const auto& error : parser_errors) {
+        std::cerr << syntaxErrorToString(error) << std::endl;
+    }
+
     // Verificar el resultado del análisis
-    if (resultado != 0 || parser_result == nullptr) {
+    if (resultado != 0 || !parser_errors.empty() || parser_result == nullptr) {
         std::cerr << "Error: El análisis falló" << std::endl;
         return 1;
     }
@@ -55,6 +355,63 @@ int main(int argc, char* argv[]) {
     
     std::cout << "Análisis completado con éxito" << std::endl;
 
+    // Análisis semántico y traducción a ABC sobre el AST (cada voz en paralelo)
+    if (!archivo_abc.empty() && segmentado) {
+        // El emisor ya verificó el programa y escribió el ABC
+        if (!segmentos.valid) {
+            std::cerr << segmentos.semantic_errors;
+            std::cerr << "Error: El programa no es válido semánticamente" << std::endl;
+            return 1;
+        }
+
+        std::ofstream salida(archivo_abc);
+        if (!salida.is_open()) {
+            std::cerr << "Error: No se pudo abrir el archivo " << archivo_abc << std::endl;
+            return 1;
+        }
+        salida << segmentos.abc;
+
+        std::cout << "Notación ABC escrita en " << archivo_abc << std::endl;
+    } else if (!salidas.empty()) {
+        // Verificación y transposición en un recorrido de las sentencias; la
+        // escritura, que necesita el mapa de tempo completo, en otro, uno
+        // solo para todas las salidas
+        MusicProgram* programa = lowerProgram(*static_cast<Program*>(parser_result));
+        SymbolTable tabla;
+        ValidationPass validacion{tabla};
+        TranspositionPass transposicion{transponer};
+        EmissionPass escritura;
+        for (const auto& salida : salidas) {
+            escritura.add(salida.get());
+        }
+        PassManager pases;
+        pases.add(&validacion);
+        pases.add(&transposicion);
+        pases.add(&escritura);
+        bool valido = pases.run(*programa);
+
+        if (medir_tiempo) {
+            writePassTimings(std::cerr, pases.timings());
+            writeNotePoolStats(std::cerr, programa->get_note_pool()->stats());
+        }
+        delete programa;
+        if (!valido) {
+            std::cerr << "Error: El programa no es válido semánticamente" << std::endl;
+            return 1;
+        }
+
+        for (std::size_t i = 0; i < salidas.size(); ++i) {
+            std::ofstream archivo(archivos_salida[i], std::ios::binary);
+            if (!archivo.is_open()) {
+                std::cerr << "Error: No se pudo abrir el archivo " << archivos_salida[i] << std::endl;
+                return 1;
+            }
+            salidas[i]->write(archivo);
+
+            std::cout << salidas[i]->description() << " escrita en " << archivos_salida[i] << std::endl;
+        }
+    }
+
     parser_result = nullptr;
 
     return 0;
@@ -0,0 +1,495 @@
+#include "measure_index.hpp"
+#include "lowering.hpp"
+#include "parallel_front_end.hpp"
+#include "recursive_descent.hpp"
+#include "syntax_error.hpp"
+#include "../AST/declaration.hpp"
+#include "../AST/statement.hpp"
+#include "../AST/voice.hpp"
+#include "../Semantic_Analysis/symbol_table.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <sstream>
+
+std::size_t MeasureIndex::source_offset(std::size_t voice, std::size_t measure) const noexcept {
+    const IndexedVoice& indexed = voices[voice];
+    std::size_t first = indexed.measures[measure - 1].first;
+    return (first < indexed.statements.size()) ? indexed.statements[first].begin : source_length;
+}
+
+bool MeasureIndex::matches(const char* buffer, std::size_t length) const noexcept {
+    return length == source_length && sourceHash(buffer, length) == source_hash;
+}
+
+std::uint64_t sourceHash(const char* buffer, std::size_t length) noexcept {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (std::size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(buffer[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static void addSyntaxErrors(std::vector<SyntaxError>& errors,
+                            std::vector<CompileDiagnostic>& diagnostics) noexcept {
+    for (auto& error : errors) {
+        diagnostics.push_back({CompileDiagnostic::Phase::SYNTAX, error.line, error.column,
+                               std::move(error.message)});
+    }
+}
+
+// Ubica las instrucciones en el archivo: las ubicaciones de los nodos (línea
+// y columna, en bytes) se pasan a posiciones, y cada instrucción se extiende
+// hasta el comienzo de la siguiente
+class SourceOffsets {
+public:
+    SourceOffsets(const char* buffer, std::size_t length,
+                  const std::vector<InstructionLocation>& locations) noexcept
+        : length{length} {
+        line_starts.push_back(0);
+        for (std::size_t i = 0; i < length; ++i) {
+            if (buffer[i] == '\n') {
+                line_starts.push_back(i + 1);
+            }
+        }
+        for (const auto& location : locations) {
+            instruction_starts.push_back(offset(location.line, location.column));
+        }
+    }
+
+    IndexedStatement entry(SourceLocation location, long tick, bool motif) const noexcept {
+        std::size_t begin = offset(location.line, location.column);
+        auto next = std::upper_bound(instruction_starts.begin(), instruction_starts.end(), begin);
+        std::size_t end = (next != instruction_starts.end()) ? *next : length;
+        return IndexedStatement{begin, end, location.line, location.column, tick, motif};
+    }
+
+private:
+    std::size_t offset(int line, int column) const noexcept {
+        return line_starts[line - 1] + column - 1;
+    }
+
+    std::size_t length;
+    std::vector<std::size_t> line_starts;
+    std::vector<std::size_t> instruction_starts;
+};
+
+// Indexa las sentencias de una voz y, para cada compás, las que suenan en él
+static IndexedVoice indexVoice(const std::string& name, const std::vector<Statement*>& statements,
+                               const std::vector<IndexedMeasure>& measures, long total_ticks,
+                               const SourceOffsets& offsets) noexcept {
+    IndexedVoice voice{name, {}, {}};
+    std::vector<long> ends;
+    long position = 0;
+    for (const auto& stmt : statements) {
+        bool motif = dynamic_cast<const MotifStatement*>(stmt) != nullptr;
+        voice.statements.push_back(offsets.entry(stmt->get_source_location(), position, motif));
+        position += TempoMap::ticks_from_beats(stmt->played_beats());
+        ends.push_back(position);
+    }
+
+    // La primera sentencia de un compás es la primera que termina después
+    // de su barra (o, si no suena, la que está en la barra o después); la
+    // última, la anterior a la primera que comienza en la barra siguiente
+    std::size_t count = voice.statements.size();
+    std::size_t first = 0;
+    std::size_t last = 0;
+    for (std::size_t m = 0; m < measures.size(); ++m) {
+        long start = measures[m].tick;
+        long end = (m + 1 < measures.size()) ? measures[m + 1].tick : total_ticks;
+        while (first < count && ends[first] <= start &&
+               (ends[first] > voice.statements[first].tick || voice.statements[first].tick < start)) {
+            ++first;
+        }
+        last = std::max(last, first);
+        while (last < count && voice.statements[last].tick < end) {
+            ++last;
+        }
+        voice.measures.push_back(MeasureSpan{first, last});
+    }
+    return voice;
+}
+
+bool indexBuffer(const char* buffer, std::size_t length, MeasureIndex& index,
+                 std::vector<CompileDiagnostic>& diagnostics) noexcept {
+    index = MeasureIndex{};
+    diagnostics.clear();
+
+    // Se necesita la ubicación de cada instrucción, así que se analiza la
+    // entrada completa como un solo fragmento
+    std::vector<SyntaxError> errors;
+    std::vector<InstructionLocation> locations;
+    Program* program = new Program();
+    {
+        std::vector<Expression*> instructions;
+        ChunkTokenSource source{buffer, length, 0, length, errors};
+        RecursiveDescentParser parser{source, errors};
+        parser.start();
+        parser.parseInto(instructions, &locations);
+        for (auto instruction : instructions) {
+            program->addInstruction(instruction);
+        }
+    }
+    if (!errors.empty()) {
+        addSyntaxErrors(errors, diagnostics);
+        program->destroy();
+        return false;
+    }
+
+    MusicProgram* music = lowerProgram(*program, &locations);
+    program->destroy();
+    if (!analyzeMusicProgram(*music, 0, diagnostics)) {
+        delete music;
+        return false;
+    }
+
+    SourceOffsets offsets{buffer, length, locations};
+    index.source_length = length;
+    index.source_hash = sourceHash(buffer, length);
+    for (const auto& decl : music->get_declarations()) {
+        index.declarations.push_back(offsets.entry(decl->get_source_location(), 0, false));
+    }
+
+    // Las voces están alineadas: todas duran lo mismo
+    const auto& voices = music->get_voices();
+    for (const auto& voice : voices) {
+        index.total_ticks = std::max(index.total_ticks, TempoMap::ticks_from_beats(voice->total_beats()));
+    }
+    if (voices.empty()) {
+        for (const auto& stmt : music->get_statements()) {
+            index.total_ticks += TempoMap::ticks_from_beats(stmt->played_beats());
+        }
+    }
+
+    const TempoMap& tempo_map = music->get_tempo_map();
+    long measure_count = (index.total_ticks > 0) ? tempo_map.tick_to_measure(index.total_ticks - 1) : 0;
+    for (long measure = 1; measure <= measure_count; ++measure) {
+        long tick = tempo_map.measure_to_tick(measure);
+        const TempoSegment& segment = tempo_map.segment_at(tick);
+        index.measures.push_back(IndexedMeasure{tick, segment.tempo, segment.numerator, segment.denominator});
+    }
+
+    if (voices.empty()) {
+        index.voices.push_back(indexVoice("", music->get_statements(), index.measures,
+                                          index.total_ticks, offsets));
+    } else {
+        for (const auto& stmt : music->get_statements()) {
+            if (dynamic_cast<const MotifStatement*>(stmt) != nullptr) {
+                index.motifs.push_back(offsets.entry(stmt->get_source_location(), 0, true));
+            }
+        }
+        for (const auto& voice : voices) {
+            index.voices.push_back(indexVoice(voice->get_name(), voice->get_statements(), index.measures,
+                                              index.total_ticks, offsets));
+        }
+    }
+    delete music;
+    return true;
+}
+
+// Analiza los bytes [begin, end) del archivo, que comienzan en line y
+// column, y entrega cada instrucción con su ubicación en el archivo
+static void parseSlice(const char* buffer, std::size_t length, std::size_t begin, std::size_t end,
+                       int line, int column, std::vector<SyntaxError>& errors,
+                       const std::function<void(Expression*, SourceLocation)>& consume) noexcept {
+    auto absolute = [&](int slice_line, int slice_column) {
+        return SourceLocation{line + slice_line - 1, (slice_line == 1) ? column + slice_column - 1 : slice_column};
+    };
+
+    std::vector<SyntaxError> slice_errors;
+    ChunkTokenSource source{buffer, length, begin, end, slice_errors};
+    RecursiveDescentParser parser{source, slice_errors};
+    parser.start(false);
+    parser.parseInto([&](Expression* instruction, const InstructionLocation& location) {
+        consume(instruction, absolute(location.line, location.column));
+    });
+
+    for (const auto& error : slice_errors) {
+        SourceLocation location = absolute(error.line, error.column);
+        recordSyntaxError(errors, location.line, location.column, error.message);
+    }
+}
+
+// Enlaza las referencias a motivos, para poder recorrer lo que suena en las
+// sentencias que cruzan los extremos del rango. Los errores se descartan: el
+// análisis del fragmento encuentra los mismos y los reporta
+static bool linkMotifs(MusicProgram& music) noexcept {
+    std::ostringstream discarded;
+    SemanticErrorRedirect redirect{discarded};
+    SymbolTable table;
+    for (const auto& decl : music.get_declarations()) {
+        if (!decl->resolve_names(table)) {
+            return false;
+        }
+    }
+    for (const auto& stmt : music.get_statements()) {
+        if (!stmt->resolve_names(table)) {
+            return false;
+        }
+    }
+    for (const auto& voice : music.get_voices()) {
+        SymbolTable voice_table{table};
+        if (!voice->resolve_names(voice_table)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool compileMeasures(const char* buffer, std::size_t length, const MeasureIndex& index,
+                     long first, long last, int semitones, std::string& abc,
+                     std::vector<CompileDiagnostic>& diagnostics) noexcept {
+    abc.clear();
+    diagnostics.clear();
+
+    long measure_count = static_cast<long>(index.measures.size());
+    if (first < 1 || last < first || last > measure_count) {
+        diagnostics.push_back({CompileDiagnostic::Phase::SEMANTIC, 0, 0,
+                               "El rango de compases " + std::to_string(first) + "-" + std::to_string(last) +
+                               " no existe: la partitura tiene " + std::to_string(measure_count) + " compases."});
+        return false;
+    }
+    const IndexedMeasure& start = index.measures[first - 1];
+    long end_tick = (last < measure_count) ? index.measures[last].tick : index.total_ticks;
+
+    std::vector<SyntaxError> errors;
+    ProgramLowering lowering;
+    auto lower = [&](Expression* instruction, SourceLocation location) {
+        lowering.add(instruction, location);
+        instruction->destroy();
+    };
+    auto parse = [&](const IndexedStatement& from, const IndexedStatement& to,
+                     const std::function<void(Expression*, SourceLocation)>& consume) {
+        parseSlice(buffer, length, from.begin, to.end, from.line, from.column, errors, consume);
+    };
+
+    // La cabecera lleva el tempo y el compás vigentes al comenzar el rango
+    for (const auto& decl : index.declarations) {
+        parse(decl, decl, [&](Expression* instruction, SourceLocation location) {
+            if (dynamic_cast<const Tempo*>(instruction) != nullptr) {
+                instruction->destroy();
+                instruction = new Tempo(new Number(start.tempo));
+            } else if (dynamic_cast<const TimeSignature*>(instruction) != nullptr) {
+                instruction->destroy();
+                instruction = new TimeSignature(new Number(start.numerator), new Number(start.denominator));
+            }
+            lower(instruction, location);
+        });
+    }
+    for (const auto& motif : index.motifs) {
+        parse(motif, motif, lower);
+    }
+
+    // Cada voz: los motivos que define antes del rango y las sentencias del
+    // rango, en tramos de instrucciones contiguas en el archivo
+    std::vector<long> trim_start;
+    for (const auto& voice : index.voices) {
+        if (!voice.name.empty()) {
+            lower(new Voice(voice.name), SourceLocation{});
+        }
+
+        std::size_t span_first = voice.measures[first - 1].first;
+        std::size_t span_last = voice.measures[last - 1].last;
+        for (std::size_t i = 0; i < span_first; ++i) {
+            if (voice.statements[i].motif) {
+                parse(voice.statements[i], voice.statements[i], lower);
+            }
+        }
+        for (std::size_t i = span_first; i < span_last;) {
+            std::size_t j = i;
+            while (j + 1 < span_last && voice.statements[j].end == voice.statements[j + 1].begin) {
+                ++j;
+            }
+            parse(voice.statements[i], voice.statements[j], lower);
+            i = j + 1;
+        }
+        trim_start.push_back(span_first < voice.statements.size() ? voice.statements[span_first].tick : start.tick);
+    }
+
+    if (!errors.empty()) {
+        addSyntaxErrors(errors, diagnostics);
+        return false;
+    }
+
+    // Recortar lo que cruza los extremos, en semicorcheas desde la primera
+    // sentencia del rango en cada voz
+    MusicProgram* music = lowering.release();
+    if (linkMotifs(*music)) {
+        const auto& voices = music->get_voices();
+        for (std::size_t i = 0; i < index.voices.size(); ++i) {
+            long from = start.tick - trim_start[i];
+            long to = end_tick - trim_start[i];
+            if (index.voices[i].name.empty()) {
+                music->trim(from, to);
+            } else {
+                voices[i]->trim(from, to);
+            }
+        }
+    }
+
+    if (!analyzeMusicProgram(*music, semitones, diagnostics)) {
+        delete music;
+        return false;
+    }
+
+    std::ostringstream out;
+    double beat = 0.0;
+    music->to_abc(out, beat);
+    abc = out.str();
+    delete music;
+    return true;
+}
+
+static void writeEntry(std::ostream& out, const char* kind, const IndexedStatement& entry) noexcept {
+    out << kind << ' ' << entry.begin << ' ' << entry.end << ' ' << entry.line << ' ' << entry.column;
+}
+
+void writeMeasureIndex(std::ostream& out, const MeasureIndex& index) noexcept {
+    out << "indice_compases 1\n";
+    out << "fuente " << index.source_length << ' ' << (index.source_hash >> 32) << ' '
+        << (index.source_hash & 0xffffffffu) << '\n';
+    out << "total " << index.total_ticks << '\n';
+    for (const auto& decl : index.declarations) {
+        writeEntry(out, "declaracion", decl);
+        out << '\n';
+    }
+    for (const auto& motif : index.motifs) {
+        writeEntry(out, "motivo", motif);
+        out << '\n';
+    }
+    for (const auto& measure : index.measures) {
+        out << "compas " << measure.tick << ' ' << measure.tempo << ' ' << measure.numerator << ' '
+            << measure.denominator << '\n';
+    }
+    for (const auto& voice : index.voices) {
+        // "-": el programa sin voces (un nombre de voz es un identificador)
+        out << "voz " << (voice.name.empty() ? "-" : voice.name) << '\n';
+        for (const auto& stmt : voice.statements) {
+            writeEntry(out, "sentencia", stmt);
+            out << ' ' << stmt.tick << ' ' << stmt.motif << '\n';
+        }
+        for (const auto& span : voice.measures) {
+            out << "tramo " << span.first << ' ' << span.last << '\n';
+        }
+    }
+    out << "fin\n";
+}
+
+// Lector del texto del índice: palabras y números separados por blancos.
+// Un índice grande tiene una línea por sentencia y por compás, así que se
+// lee de una vez y se convierte con strtoll en lugar de operator>>
+class IndexReader {
+public:
+    explicit IndexReader(const std::string& text) noexcept
+        : position{text.c_str()}, end{text.c_str() + text.size()} {}
+
+    bool word(std::string& value) noexcept {
+        skipSpace();
+        const char* start = position;
+        while (position < end && !std::isspace(static_cast<unsigned char>(*position))) {
+            ++position;
+        }
+        value.assign(start, position);
+        return position > start;
+    }
+
+    template <typename Number>
+    bool number(Number& value) noexcept {
+        skipSpace();
+        char* number_end = nullptr;
+        long long parsed = std::strtoll(position, &number_end, 10);
+        if (number_end == position || number_end > end) {
+            return false;
+        }
+        position = number_end;
+        value = static_cast<Number>(parsed);
+        return true;
+    }
+
+    template <typename Number, typename... Rest>
+    bool number(Number& value, Rest&... rest) noexcept {
+        return number(value) && number(rest...);
+    }
+
+private:
+    void skipSpace() noexcept {
+        while (position < end && std::isspace(static_cast<unsigned char>(*position))) {
+            ++position;
+        }
+    }
+
+    const char* position;
+    const char* end;
+};
+
+static bool readEntry(IndexReader& reader, IndexedStatement& entry) noexcept {
+    entry = IndexedStatement{};
+    return reader.number(entry.begin, entry.end, entry.line, entry.column);
+}
+
+bool readMeasureIndex(std::istream& in, MeasureIndex& index) noexcept {
+    index = MeasureIndex{};
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    std::string text = contents.str();
+    IndexReader reader{text};
+
+    std::string kind;
+    int version = 0;
+    if (!reader.word(kind) || kind != "indice_compases" || !reader.number(version) || version != 1) {
+        return false;
+    }
+
+    while (reader.word(kind)) {
+        bool valid = true;
+        if (kind == "fuente") {
+            // El hash ocupa los 64 bits: se lee como dos mitades
+            std::uint64_t high = 0;
+            std::uint64_t low = 0;
+            valid = reader.number(index.source_length, high, low);
+            index.source_hash = (high << 32) | low;
+        } else if (kind == "total") {
+            valid = reader.number(index.total_ticks);
+        } else if (kind == "declaracion" || kind == "motivo") {
+            IndexedStatement entry;
+            valid = readEntry(reader, entry);
+            (kind == "motivo" ? index.motifs : index.declarations).push_back(entry);
+        } else if (kind == "compas") {
+            IndexedMeasure measure{};
+            valid = reader.number(measure.tick, measure.tempo, measure.numerator, measure.denominator);
+            index.measures.push_back(measure);
+        } else if (kind == "voz") {
+            std::string name;
+            valid = reader.word(name);
+            index.voices.push_back(IndexedVoice{(name == "-") ? "" : name, {}, {}});
+        } else if ((kind == "sentencia" || kind == "tramo") && !index.voices.empty()) {
+            IndexedVoice& voice = index.voices.back();
+            if (kind == "sentencia") {
+                IndexedStatement entry;
+                valid = readEntry(reader, entry) && reader.number(entry.tick, entry.motif);
+                voice.statements.push_back(entry);
+            } else {
+                MeasureSpan span{};
+                valid = reader.number(span.first, span.last) && span.first <= span.last &&
+                        span.last <= voice.statements.size();
+                voice.measures.push_back(span);
+            }
+        } else if (kind == "fin") {
+            // Completo: cada voz con un tramo por compás
+            return std::all_of(index.voices.begin(), index.voices.end(), [&](const IndexedVoice& voice) {
+                return voice.measures.size() == index.measures.size();
+            });
+        } else {
+            valid = false;
+        }
+
+        if (!valid) {
+            return false;
+        }
+    }
+    return false;
+}
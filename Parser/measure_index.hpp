@@ -0,0 +1,88 @@
+#pragma once
+
+#include "compile.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Instrucción de nivel superior en el archivo fuente: los bytes [begin, end)
+// (hasta la instrucción siguiente, con los blancos y comentarios que la
+// siguen), su ubicación y la semicorchea en que comienza dentro de su voz
+struct IndexedStatement {
+    std::size_t begin;
+    std::size_t end;
+    int line;
+    int column;
+    long tick;
+    bool motif;   // Definición de un motivo: no suena, pero la usan las referencias
+};
+
+// Sentencias de una voz que suenan en un compás: [first, last). Las de los
+// extremos pueden comenzar antes o terminar después del compás (una
+// repetición o un motivo que cruza la barra)
+struct MeasureSpan {
+    std::size_t first;
+    std::size_t last;
+};
+
+// Voz del índice. El nombre vacío es el programa sin voces
+struct IndexedVoice {
+    std::string name;
+    std::vector<IndexedStatement> statements;
+    std::vector<MeasureSpan> measures;   // Uno por compás de la partitura
+};
+
+// Compás de la partitura: semicorchea en que comienza y tempo y compás vigentes
+struct IndexedMeasure {
+    long tick;
+    int tempo;
+    int numerator;
+    int denominator;
+};
+
+// Índice de compases de un programa válido: para cada compás, la semicorchea
+// en que comienza y, en cada voz, las sentencias que suenan en él y el byte
+// del archivo donde comienza la primera. Con él, un rango de compases se
+// compila analizando solo esa parte del archivo (ver compileMeasures).
+struct MeasureIndex {
+    // Archivo del que se armó, para descartar un índice guardado que ya no corresponde
+    std::size_t source_length{0};
+    std::uint64_t source_hash{0};
+
+    long total_ticks{0};
+    std::vector<IndexedStatement> declarations;   // Cabecera: tempo, compás, tonalidad, transposición
+    std::vector<IndexedStatement> motifs;         // Motivos definidos fuera de las voces
+    std::vector<IndexedMeasure> measures;
+    std::vector<IndexedVoice> voices;
+
+    // Byte del archivo donde comienza el compás (desde 1) en la voz
+    std::size_t source_offset(std::size_t voice, std::size_t measure) const noexcept;
+
+    // Indica si el índice se armó a partir de este contenido
+    bool matches(const char* buffer, std::size_t length) const noexcept;
+};
+
+// Hash FNV-1a de 64 bits del contenido del archivo
+std::uint64_t sourceHash(const char* buffer, std::size_t length) noexcept;
+
+// Compila la partitura completa con el parser descendente y arma su índice.
+// Devuelve false si no es válida, con los errores en diagnostics.
+bool indexBuffer(const char* buffer, std::size_t length, MeasureIndex& index,
+                 std::vector<CompileDiagnostic>& diagnostics) noexcept;
+
+// Compila los compases [first, last] (desde 1) a un fragmento ABC
+// independiente, con la cabecera del tempo y el compás vigentes en first.
+// Solo se escanean, analizan y verifican las sentencias del rango en cada voz,
+// las declaraciones de la cabecera y los motivos definidos antes; lo que
+// cruza un extremo del rango se recorta a las notas que caen dentro. El
+// índice debe corresponder al contenido del buffer (ver MeasureIndex::matches).
+bool compileMeasures(const char* buffer, std::size_t length, const MeasureIndex& index,
+                     long first, long last, int semitones, std::string& abc,
+                     std::vector<CompileDiagnostic>& diagnostics) noexcept;
+
+// Guarda el índice como texto, una entrada por línea, y lo vuelve a leer.
+// readMeasureIndex devuelve false si el texto no es un índice completo
+void writeMeasureIndex(std::ostream& out, const MeasureIndex& index) noexcept;
+bool readMeasureIndex(std::istream& in, MeasureIndex& index) noexcept;
@@ -0,0 +1,377 @@
+#include "musicxml.hpp"
+#include "xml_writer.hpp"
+#include "../AST/declaration.hpp"
+#include "../AST/tempo_map.hpp"
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Divisiones por negra: una por semicorchea, la duración más corta
+static constexpr long DIVISIONS = duration_ticks(DurationType::NEGRA);
+
+// Figura de MusicXML y puntillos de cada duración que se escribe sin
+// ligaduras, de la más larga a la más corta (en semicorcheas: una nota que
+// cruza una barra se parte en duraciones que no son de una figura)
+struct XmlFigure {
+    int ticks;
+    const char* type;
+    int dots;
+};
+
+static constexpr XmlFigure FIGURES[] = {
+    {duration_ticks(DurationType::BLANCA), "half", 0},
+    {duration_ticks(DurationType::NEGRA) * 7 / 4, "quarter", 2},
+    {duration_ticks(DurationType::NEGRA) * 3 / 2, "quarter", 1},
+    {duration_ticks(DurationType::NEGRA), "quarter", 0},
+    {duration_ticks(DurationType::CORCHEA) * 3 / 2, "eighth", 1},
+    {duration_ticks(DurationType::CORCHEA), "eighth", 0},
+    {duration_ticks(DurationType::SEMICORCHEA), "16th", 0},
+};
+
+// La figura más larga que cabe en ticks
+static const XmlFigure& figureFor(long ticks) noexcept {
+    for (const auto& figure : FIGURES) {
+        if (figure.ticks <= ticks) {
+            return figure;
+        }
+    }
+    return FIGURES[std::size(FIGURES) - 1];
+}
+
+// Parte de la salida: una voz (o las notas fuera de voces) con la suma de
+// sus alturas, para elegir la clave
+struct XmlPart {
+    std::string_view voice;
+    long pitch_sum{0};
+    long notes{0};
+};
+
+// Lo que comparten todas las partes: el mapa de tempo, la tonalidad y la
+// grafía de cada altura
+struct XmlScore {
+    TempoMap tempo_map;
+    int fifths;
+    bool minor;
+    int transposition;
+    std::array<NoteSpelling, 12> spellings;
+};
+
+// Posición de una parte al escribirla: el compás abierto y lo último que
+// se anunció de tempo y de compás
+struct XmlCursor {
+    long number{0};                // Compás abierto (0: ninguno)
+    long start{0};
+    long end{0};
+    std::size_t segment{0};        // Tramo del mapa de tempo en la última posición
+    int tempo{0};
+    int numerator{0};
+    int denominator{0};
+};
+
+static bool fail(NoteStreamError* error, const std::string& message) noexcept {
+    error->message = message;
+    return false;
+}
+
+// Indicaciones de metrónomo de los cambios de tempo desde tick hasta antes
+// de until; los que caen dentro de la nota que comienza en tick (porque los
+// declara otra voz) llevan su distancia en <offset>. Solo la primera parte
+// las escribe: el tempo vale para todas
+static void announceTempo(XmlWriter& xml, const XmlScore& score, XmlCursor& cursor, long tick, long until,
+                          bool first_part) noexcept {
+    const std::vector<TempoSegment>& segments = score.tempo_map.get_segments();
+    cursor.segment = score.tempo_map.next_segment_index(tick, cursor.segment);
+    for (;; ++cursor.segment) {
+        const TempoSegment& segment = segments[cursor.segment];
+        if (segment.tempo != cursor.tempo && first_part) {
+            xml.open("direction");
+            xml.attribute("placement", "above");
+            xml.open("direction-type");
+            xml.open("metronome");
+            xml.element("beat-unit", "quarter");
+            xml.element("per-minute", segment.tempo);
+            xml.close();
+            xml.close();
+            if (segment.tick > tick) {
+                xml.element("offset", segment.tick - tick);
+            }
+            xml.open("sound");
+            xml.attribute("tempo", segment.tempo);
+            xml.close();
+            xml.close();
+        }
+        cursor.tempo = segment.tempo;
+        if (cursor.segment + 1 == segments.size() || segments[cursor.segment + 1].tick >= until) {
+            break;
+        }
+    }
+}
+
+// Abre el compás siguiente. El primero lleva los atributos completos; los
+// demás, el compás nuevo si cambió en su barra
+static void openMeasure(XmlWriter& xml, const XmlScore& score, const XmlPart& part, XmlCursor& cursor) noexcept {
+    cursor.start = cursor.end;
+    cursor.end = score.tempo_map.next_barline(cursor.start);
+    ++cursor.number;
+
+    xml.open("measure");
+    xml.attribute("number", cursor.number);
+
+    cursor.segment = score.tempo_map.next_segment_index(cursor.start, cursor.segment);
+    const TempoSegment& segment = score.tempo_map.get_segments()[cursor.segment];
+    bool meter = segment.numerator != cursor.numerator || segment.denominator != cursor.denominator;
+    if (cursor.number == 1 || meter) {
+        xml.open("attributes");
+        if (cursor.number == 1) {
+            xml.element("divisions", DIVISIONS);
+            xml.open("key");
+            xml.element("fifths", score.fifths);
+            xml.element("mode", score.minor ? "minor" : "major");
+            xml.close();
+        }
+        xml.open("time");
+        xml.element("beats", segment.numerator);
+        xml.element("beat-type", segment.denominator);
+        xml.close();
+        if (cursor.number == 1) {
+            // Clave de Fa para las partes que suenan, en promedio, debajo de Do4
+            bool low = part.notes > 0 && part.pitch_sum < 60 * part.notes;
+            xml.open("clef");
+            xml.element("sign", low ? "F" : "G");
+            xml.element("line", low ? 4L : 2L);
+            xml.close();
+        }
+        xml.close();
+        cursor.numerator = segment.numerator;
+        cursor.denominator = segment.denominator;
+    }
+}
+
+static void closeMeasure(XmlWriter& xml, bool last) noexcept {
+    if (last) {
+        xml.open("barline");
+        xml.attribute("location", "right");
+        xml.element("bar-style", "light-heavy");
+        xml.close();
+    }
+    xml.close();
+}
+
+// Ligaduras de una nota partida: <tie> para el sonido, <tied> para la notación
+static void writeTies(XmlWriter& xml, const char* name, bool stop, bool start) noexcept {
+    if (stop) {
+        xml.open(name);
+        xml.attribute("type", "stop");
+        xml.close();
+    }
+    if (start) {
+        xml.open(name);
+        xml.attribute("type", "start");
+        xml.close();
+    }
+}
+
+// Una nota (o una parte de ella, ligada a la anterior o a la siguiente)
+static void writeNote(XmlWriter& xml, const XmlScore& score, const DecodedNote& note, const XmlFigure& figure,
+                      bool chord, bool tie_stop, bool tie_start) noexcept {
+    // Sin transposición se conserva la grafía escrita; con ella, la de la
+    // tonalidad transpuesta, como en transpose_program
+    NoteSpelling spelling{0, 0};
+    int octave = note.octave;
+    if (score.transposition == 0) {
+        spell_note_name(note.name, spelling);
+    } else {
+        int pitch = note.pitch + score.transposition;
+        spelling = score.spellings[pitch % 12];
+        octave = (pitch - spelling.semitones()) / 12 - 1;
+    }
+
+    xml.open("note");
+    if (chord) {
+        xml.element("chord");
+    }
+    xml.open("pitch");
+    xml.element("step", english_letter_names[spelling.letter]);
+    if (spelling.accidental != 0) {
+        xml.element("alter", spelling.accidental);
+    }
+    xml.element("octave", octave);
+    xml.close();
+    xml.element("duration", figure.ticks);
+    writeTies(xml, "tie", tie_stop, tie_start);
+    xml.element("type", figure.type);
+    for (int i = 0; i < figure.dots; ++i) {
+        xml.element("dot");
+    }
+    if (tie_stop || tie_start) {
+        xml.open("notations");
+        writeTies(xml, "tied", tie_stop, tie_start);
+        xml.close();
+    }
+    xml.close();
+}
+
+// Escribe las notas que comienzan juntas (una nota o un acorde). Fuera de
+// voces una nota puede cruzar barras: se parte en figuras ligadas, compás
+// por compás
+static void writeGroup(XmlWriter& xml, const XmlScore& score, const XmlPart& part, XmlCursor& cursor,
+                       const std::vector<DecodedNote>& group, bool first_part) noexcept {
+    long tick = group.front().tick;
+    long remaining = group.front().duration;
+    bool tied = false;
+    while (remaining > 0) {
+        while (cursor.number == 0 || tick >= cursor.end) {
+            if (cursor.number != 0) {
+                closeMeasure(xml, false);
+            }
+            openMeasure(xml, score, part, cursor);
+        }
+        const XmlFigure& figure = figureFor(std::min(remaining, cursor.end - tick));
+        announceTempo(xml, score, cursor, tick, tick + figure.ticks, first_part);
+        tick += figure.ticks;
+        remaining -= figure.ticks;
+        for (std::size_t i = 0; i < group.size(); ++i) {
+            writeNote(xml, score, group[i], figure, i > 0, tied, remaining > 0);
+        }
+        tied = true;
+    }
+}
+
+// Escribe una parte con una pasada de decodeNotes que se queda con sus notas
+static bool writePart(XmlWriter& xml, const char* buffer, std::size_t length, const XmlScore& score,
+                      const XmlPart& part, std::size_t index, long end, NoteStreamError* error) noexcept {
+    xml.open("part");
+    xml.attribute("id", "P" + std::to_string(index + 1));
+
+    // Las notas de un acorde llegan de a una con la misma posición: se
+    // juntan hasta la siguiente, porque al partirlas van compás por compás
+    XmlCursor cursor;
+    bool first_part = index == 0;
+    std::vector<DecodedNote> group;
+    group.reserve(CHORD_CAPACITY);
+    for (const auto& note : decodeNotes(buffer, length, error)) {
+        if (note.voice != part.voice) {
+            continue;
+        }
+        if (!group.empty() && note.tick != group.front().tick) {
+            writeGroup(xml, score, part, cursor, group, first_part);
+            group.clear();
+        }
+        group.push_back(note);
+    }
+    if (error->line != 0) {
+        return false;
+    }
+    if (!group.empty()) {
+        writeGroup(xml, score, part, cursor, group, first_part);
+    }
+
+    // Las voces terminan juntas; una parte sin notas tiene al menos un compás
+    while (cursor.number == 0 || cursor.end < end) {
+        if (cursor.number != 0) {
+            closeMeasure(xml, false);
+        }
+        openMeasure(xml, score, part, cursor);
+    }
+    closeMeasure(xml, true);
+    xml.close();
+    return true;
+}
+
+bool writeMusicXml(const char* buffer, std::size_t length, int semitones, std::ostream& out,
+                   NoteStreamError* error) noexcept {
+    NoteStreamError failure;
+    if (error == nullptr) {
+        error = &failure;
+    }
+
+    // Primera pasada: la cabecera, los cambios, las voces y el final
+    DecodedDeclarations declarations;
+    std::vector<XmlPart> parts;
+    long end = 0;
+    for (const auto& note : decodeNotes(buffer, length, error, &declarations)) {
+        end = std::max(end, note.tick + note.duration);
+        auto part = std::find_if(parts.begin(), parts.end(),
+                                 [&](const XmlPart& found) { return found.voice == note.voice; });
+        if (part == parts.end()) {
+            parts.push_back(XmlPart{note.voice});
+            part = parts.end() - 1;
+        }
+        part->pitch_sum += note.pitch;
+        ++part->notes;
+    }
+    if (error->line != 0) {
+        return false;
+    }
+    if (declarations.tempo == 0 || declarations.numerator == 0 || declarations.key_root.empty()) {
+        return fail(error, "Faltan las declaraciones de Tempo, Compas o Tonalidad");
+    }
+
+    // Con voces, cada voz es una parte (en el orden en que se declaran) y las
+    // notas fuera de ellas no suenan
+    std::vector<XmlPart> ordered;
+    for (const auto& voice : declarations.voices) {
+        auto part = std::find_if(parts.begin(), parts.end(),
+                                 [&](const XmlPart& found) { return found.voice == voice; });
+        ordered.push_back(part != parts.end() ? *part : XmlPart{voice});
+    }
+    if (ordered.empty()) {
+        ordered.push_back(parts.empty() ? XmlPart{""} : parts.front());
+    }
+
+    // Los cambios en una misma posición se aplican en el orden del AST: las
+    // sentencias fuera de voces y después cada voz
+    XmlScore score;
+    std::stable_sort(declarations.changes.begin(), declarations.changes.end(),
+                     [](const DecodedChange& a, const DecodedChange& b) { return a.voice < b.voice; });
+    score.tempo_map.reset(declarations.tempo, declarations.numerator, declarations.denominator);
+    for (const auto& change : declarations.changes) {
+        if (change.tempo != 0) {
+            score.tempo_map.add_tempo_change(change.tick, change.tempo);
+        } else {
+            score.tempo_map.add_time_signature_change(change.tick, change.numerator, change.denominator);
+        }
+    }
+    if (!score.tempo_map.build()) {
+        return fail(error, "Un cambio de compás no cae en una barra");
+    }
+
+    KeyDeclaration key{declarations.key_root, declarations.minor ? KeyMode::MENOR : KeyMode::MAYOR};
+    score.transposition = std::clamp(declarations.transposition + semitones, -HIGHEST_PITCH, HIGHEST_PITCH);
+    if (score.transposition != 0) {
+        key.transpose(score.transposition);
+    }
+    score.fifths = key.fifths();
+    score.minor = declarations.minor;
+    score.spellings = key.pitch_spellings();
+
+    XmlWriter xml{out};
+    xml.declaration("score-partwise PUBLIC \"-//Recordare//DTD MusicXML 4.0 Partwise//EN\" "
+                    "\"http://www.musicxml.org/dtds/partwise.dtd\"");
+    xml.open("score-partwise");
+    xml.attribute("version", "4.0");
+    xml.open("identification");
+    xml.open("encoding");
+    xml.element("software", "Compilador Musical");
+    xml.close();
+    xml.close();
+
+    xml.open("part-list");
+    for (std::size_t i = 0; i < ordered.size(); ++i) {
+        xml.open("score-part");
+        xml.attribute("id", "P" + std::to_string(i + 1));
+        xml.element("part-name", ordered[i].voice.empty() ? std::string_view{"Música"} : ordered[i].voice);
+        xml.close();
+    }
+    xml.close();
+
+    for (std::size_t i = 0; i < ordered.size(); ++i) {
+        if (!writePart(xml, buffer, length, score, ordered[i], i, end, error)) {
+            return false;
+        }
+    }
+    xml.close();
+    return true;
+}
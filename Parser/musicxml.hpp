@@ -0,0 +1,28 @@
+#pragma once
+
+// Requiere C++20 (usa decodeNotes, ver note_stream.hpp)
+#include "note_stream.hpp"
+#include <cstddef>
+#include <iosfwd>
+
+// Escribe una partitura en MusicXML 4.0 (score-partwise) a medida que
+// decodeNotes entrega las notas, con un XmlWriter: sin el AST ni un árbol
+// del documento, así que la memoria no crece con el largo de la partitura
+// (solo con la cantidad de cambios de tempo y de compás).
+//
+// Una primera pasada lee la cabecera, los cambios y las voces; después cada
+// voz es una parte (las notas fuera de voces, si no hay voces) y se escribe
+// con otra pasada que se queda con sus notas. Cada compás del mapa de tempo
+// es un <measure>; el primero lleva los <attributes> de Tempo, Compas y
+// Tonalidad, y los cambios de compás y de tempo van en el compás y la
+// posición donde ocurren. Las divisiones son las semicorcheas de una negra,
+// así que la duración de una nota en divisiones es la de la línea de tiempo.
+// Las repeticiones y los motivos se escriben expandidos.
+//
+// Las alturas se transponen como en el compilador (la transposición
+// declarada más semitones, escrita en la tonalidad transpuesta). La
+// partitura debe ser válida (checkBuffer o compileBuffer): si no lo es, la
+// salida puede quedar a medias; devuelve false y, si error no es nullptr,
+// deja allí el motivo.
+bool writeMusicXml(const char* buffer, std::size_t length, int semitones, std::ostream& out,
+                   NoteStreamError* error = nullptr) noexcept;
@@ -0,0 +1,257 @@
+// notas_musicales: lista las notas de una partitura con decodeNotes, sin
+// construir el AST, verifica que coincidan con las del compilador y exporta
+// la partitura a MusicXML
+#include "note_stream.hpp"
+#include "compile.hpp"
+#include "lowering.hpp"
+#include "musicxml.hpp"
+#include "parallel_front_end.hpp"
+#include "validator.hpp"
+#include "../AST/declaration.hpp"
+#include "../AST/statement.hpp"
+#include "../AST/voice.hpp"
+#include "../Semantic_Analysis/symbol_table.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+static void mostrar_uso(const char* programa) {
+    std::cerr << "Uso: " << programa << " [--compases N] [--tiempo] <archivo.mus>" << std::endl;
+    std::cerr << "     " << programa << " --verificar <archivo.mus>..." << std::endl;
+    std::cerr << "     " << programa << " --musicxml <salida.musicxml> [--transponer N] [--tiempo] <archivo.mus>" << std::endl;
+}
+
+static bool leer_archivo(const std::string& nombre, std::string& contenido) {
+    std::ifstream archivo(nombre, std::ios::binary);
+    if (!archivo.is_open()) {
+        std::cerr << "Error: No se pudo abrir el archivo " << nombre << std::endl;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << archivo.rdbuf();
+    contenido = buffer.str();
+    return true;
+}
+
+// Nota con los mismos campos en ambos recorridos, para compararlos
+struct NotaComparable {
+    std::string nombre;
+    int octava;
+    int duracion;
+    long compas;
+    long tick;
+
+    bool operator==(const NotaComparable& otra) const noexcept = default;
+};
+
+// Notas de cada voz, en el orden en que aparece la voz
+struct VozComparable {
+    std::string nombre;
+    std::vector<NotaComparable> notas;
+};
+
+// Recorre las notas del AST (el mismo que usa el compilador), voz por voz
+// (el compás sale del mapa de tempo; sin él, 4/4 como en decodeNotes)
+static void notas_del_ast(const std::vector<Statement*>& sentencias, const std::string& voz,
+                          const TempoMap& mapa, std::vector<VozComparable>& voces) {
+    VozComparable resultado{voz, {}};
+    long posicion = 0;
+    for (const auto sentencia : sentencias) {
+        // Las notas de un acorde comienzan juntas, en el orden escrito
+        sentencia->for_each_played_note([&](const SoundingStatement& sonido) {
+            long compas = mapa.empty() ? posicion / 16 + 1 : mapa.tick_to_measure(posicion);
+            long duracion = TempoMap::ticks_from_beats(sonido.get_duration()->beats());
+            for (std::size_t i = 0; i < sonido.pitch_count(); ++i) {
+                resultado.notas.push_back(NotaComparable{sonido.pitch_name(i), sonido.pitch_octave(i),
+                                                         static_cast<int>(duracion), compas, posicion});
+            }
+            posicion += duracion;
+        });
+    }
+    if (!resultado.notas.empty()) {
+        voces.push_back(std::move(resultado));
+    }
+}
+
+// Compara decodeNotes con el AST sobre una partitura válida
+static bool verificar(const std::string& nombre) {
+    std::string entrada;
+    if (!leer_archivo(nombre, entrada)) {
+        return false;
+    }
+
+    std::string abc;
+    std::vector<CompileDiagnostic> diagnosticos;
+    if (!compileBuffer(entrada.data(), entrada.size(), 0, abc, diagnosticos)) {
+        std::cout << "Omitido (no es válido): " << nombre << std::endl;
+        return true;
+    }
+
+    std::vector<SyntaxError> errores;
+    Program* programa = parseParallel(entrada.data(), entrada.size(), 1, errores);
+    std::unique_ptr<MusicProgram> musica{lowerProgram(*programa)};
+    programa->destroy();
+    SymbolTable tabla;
+    musica->resolve_names(tabla);
+
+    const TempoMap& mapa = musica->get_tempo_map();
+    std::vector<VozComparable> esperadas;
+    notas_del_ast(musica->get_statements(), "", mapa, esperadas);
+    for (const auto voz : musica->get_voices()) {
+        notas_del_ast(voz->get_statements(), voz->get_name(), mapa, esperadas);
+    }
+
+    std::vector<VozComparable> decodificadas;
+    NoteStreamError error;
+    for (const auto& nota : decodeNotes(entrada.data(), entrada.size(), &error)) {
+        auto voz = decodificadas.begin();
+        while (voz != decodificadas.end() && voz->nombre != nota.voice) {
+            ++voz;
+        }
+        if (voz == decodificadas.end()) {
+            decodificadas.push_back(VozComparable{std::string{nota.voice}, {}});
+            voz = decodificadas.end() - 1;
+        }
+        voz->notas.push_back(NotaComparable{std::string{nota.name}, nota.octave, nota.duration,
+                                            nota.measure, nota.tick});
+    }
+
+    bool iguales = error.line == 0 && decodificadas.size() == esperadas.size();
+    for (std::size_t i = 0; iguales && i < esperadas.size(); ++i) {
+        iguales = decodificadas[i].nombre == esperadas[i].nombre && decodificadas[i].notas == esperadas[i].notas;
+    }
+    if (!iguales) {
+        std::cout << "Diferencia en " << nombre;
+        if (error.line != 0) {
+            std::cout << " (línea " << error.line << ", columna " << error.column << ": " << error.message << ")";
+        }
+        std::cout << std::endl;
+        return false;
+    }
+    std::cout << "OK: " << nombre << std::endl;
+    return true;
+}
+
+// Exporta la partitura a MusicXML. La verificación rápida no arma el AST;
+// solo si no alcanza para decidir (o si la partitura tiene errores) se
+// compila, para dar los mismos diagnósticos que el compilador
+static bool exportar_musicxml(const std::string& entrada, int semitonos, const std::string& nombre,
+                              bool medir_tiempo) {
+    auto inicio = std::chrono::steady_clock::now();
+    if (checkBuffer(entrada.data(), entrada.size(), semitonos) != CheckResult::VALID) {
+        std::string abc;
+        std::string errores;
+        if (!compileBuffer(entrada.data(), entrada.size(), semitonos, abc, errores)) {
+            std::cerr << errores;
+            return false;
+        }
+    }
+
+    std::ofstream salida(nombre, std::ios::binary);
+    if (!salida.is_open()) {
+        std::cerr << "Error: No se pudo crear el archivo " << nombre << std::endl;
+        return false;
+    }
+    NoteStreamError error;
+    if (!writeMusicXml(entrada.data(), entrada.size(), semitonos, salida, &error)) {
+        std::cerr << "Error al escribir MusicXML: " << error.message << std::endl;
+        salida.close();
+        std::remove(nombre.c_str());
+        return false;
+    }
+    salida.close();
+    auto fin = std::chrono::steady_clock::now();
+
+    std::cout << "MusicXML escrito en " << nombre << std::endl;
+    if (medir_tiempo) {
+        // La memoria máxima del proceso, para ver que no crece con la partitura
+        rusage uso{};
+        getrusage(RUSAGE_SELF, &uso);
+        std::cerr << "MusicXML en " << std::chrono::duration<double, std::milli>(fin - inicio).count()
+                  << " ms, memoria máxima " << uso.ru_maxrss << " KiB" << std::endl;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    long compases = 0;
+    bool medir_tiempo = false;
+    bool modo_verificar = false;
+    std::string archivo_musicxml;
+    int semitonos = 0;
+    std::vector<std::string> archivos;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string argumento = argv[i];
+        if (argumento == "--compases" && i + 1 < argc) {
+            compases = std::atol(argv[++i]);
+        } else if (argumento == "--tiempo") {
+            medir_tiempo = true;
+        } else if (argumento == "--verificar") {
+            modo_verificar = true;
+        } else if (argumento == "--musicxml" && i + 1 < argc) {
+            archivo_musicxml = argv[++i];
+        } else if (argumento == "--transponer" && i + 1 < argc) {
+            semitonos = std::atoi(argv[++i]);
+        } else if (argumento.rfind("--", 0) != 0) {
+            archivos.push_back(argumento);
+        } else {
+            mostrar_uso(argv[0]);
+            return 1;
+        }
+    }
+
+    if (modo_verificar && !archivos.empty()) {
+        bool todos = true;
+        for (const auto& archivo : archivos) {
+            todos = verificar(archivo) && todos;
+        }
+        return todos ? 0 : 1;
+    }
+    if (archivos.size() != 1) {
+        mostrar_uso(argv[0]);
+        return 1;
+    }
+
+    std::string entrada;
+    if (!leer_archivo(archivos.front(), entrada)) {
+        return 1;
+    }
+    if (!archivo_musicxml.empty()) {
+        return exportar_musicxml(entrada, semitonos, archivo_musicxml, medir_tiempo) ? 0 : 1;
+    }
+
+    // Con --compases N se deja de escanear en la primera nota posterior al
+    // compás N (en una partitura con voces, la de la primera voz)
+    auto inicio = std::chrono::steady_clock::now();
+    long cantidad = 0;
+    NoteStreamError error;
+    std::ostringstream salida;
+    for (const auto& nota : decodeNotes(entrada.data(), entrada.size(), &error)) {
+        if (compases > 0 && nota.measure > compases) {
+            break;
+        }
+        salida << nota.measure << '\t' << nota.tick << '\t' << nota.voice << '\t' << nota.name << nota.octave
+               << '\t' << nota.pitch << '\t' << nota.duration << '\n';
+        ++cantidad;
+    }
+    auto fin = std::chrono::steady_clock::now();
+
+    std::cout << salida.str();
+    if (error.line != 0) {
+        std::cerr << "Error (línea " << error.line << ", columna " << error.column << "): " << error.message << std::endl;
+        return 1;
+    }
+    if (medir_tiempo) {
+        std::cerr << "Notas decodificadas: " << cantidad << " en "
+                  << std::chrono::duration<double, std::milli>(fin - inicio).count() << " ms" << std::endl;
+    }
+    return 0;
+}
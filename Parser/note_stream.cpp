@@ -0,0 +1,407 @@
+#include "note_stream.hpp"
+#include "expression.hpp"
+#include "syntax_error.hpp"
+#include "../AST/expression.hpp"
+#include "../Scanner/fast_scanner.h"
+#include "../Scanner/token.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+// Motivo definido: el estado del escáner al comenzar su cuerpo y el motivo
+// visible antes de él. Los motivos forman una lista enlazada por ámbito, así
+// que el ámbito de una definición es un puntero a su último motivo
+struct StreamMotif {
+    std::string_view name;
+    fast_scanner_t body;
+    const StreamMotif* previous;
+};
+
+// Bloque que se está recorriendo: una repetición (con las vueltas que
+// faltan) o el cuerpo de un motivo referenciado (con el punto de regreso)
+struct StreamFrame {
+    enum class Kind { REPEAT, CALL };
+
+    Kind kind;
+    fast_scanner_t resume;          // Inicio del cuerpo (REPEAT) o regreso (CALL)
+    int remaining;
+    const StreamMotif* scope;       // Ámbito al entrar al bloque
+    std::size_t motif_count;        // Motivos definidos antes de entrar
+};
+
+// Posición de una voz y el último motivo definido en ella
+struct StreamVoice {
+    std::string_view name;
+    long tick;
+    const StreamMotif* scope;
+};
+
+// Compás vigente desde una posición: el de la cabecera (tick 0) o un cambio
+// de compás, con el número del compás que comienza allí
+struct StreamMeter {
+    long tick;
+    long measure;
+    long bar_ticks;
+    std::size_t voice;   // Voz del cambio: en una misma posición vale la última
+};
+
+// Nota de un acorde leída antes de conocer la duración ("Do#4" y su línea)
+struct ChordPitch {
+    std::string_view full_note;
+    int line;
+};
+
+// Lectura de los tokens con un solo token de lookahead, como los parsers
+struct NoteTokens {
+    fast_scanner_t scanner;
+    int token{TOKEN_EOF};
+
+    void advance() noexcept {
+        this->token = fast_scanner_next(&this->scanner);
+    }
+
+    std::string_view text() const noexcept {
+        return std::string_view{this->scanner.text, this->scanner.length};
+    }
+
+    // Valor del número actual, como numberValue en el parser
+    int number() const noexcept {
+        char digits[32];
+        std::size_t length = std::min(this->scanner.length, sizeof(digits) - 1);
+        std::memcpy(digits, this->scanner.text, length);
+        digits[length] = '\0';
+        return numberValue(digits);
+    }
+};
+
+// Duración en semicorcheas de un token de duración, o 0 si no lo es
+static int tokenTicks(int token) noexcept {
+    switch (token) {
+        case TOKEN_BLANCA: return 8;
+        case TOKEN_NEGRA: return 4;
+        case TOKEN_CORCHEA: return 2;
+        case TOKEN_SEMICORCHEA: return 1;
+        default: return 0;
+    }
+}
+
+// Compás vigente en tick: el último cambio en esa posición o antes
+static std::vector<StreamMeter>::const_iterator meterAt(const std::vector<StreamMeter>& meters, long tick) noexcept {
+    return std::upper_bound(meters.begin() + 1, meters.end(), tick,
+                            [](long value, const StreamMeter& meter) { return value < meter.tick; }) - 1;
+}
+
+// Agrega un cambio de compás en el orden del mapa de tempo del AST (por
+// posición y, en una misma posición, por voz) y renumera los siguientes
+static void addMeter(std::vector<StreamMeter>& meters, StreamMeter meter) noexcept {
+    auto position = std::upper_bound(meters.begin() + 1, meters.end(), meter,
+                                     [](const StreamMeter& value, const StreamMeter& other) {
+                                         return value.tick < other.tick ||
+                                                (value.tick == other.tick && value.voice < other.voice);
+                                     });
+    position = meters.insert(position, meter);
+    for (auto it = position; it != meters.end(); ++it) {
+        const StreamMeter& previous = *(it - 1);
+        it->measure = previous.measure + (it->tick - previous.tick) / previous.bar_ticks;
+    }
+}
+
+// Motivo visible con ese nombre desde scope, o nullptr
+static const StreamMotif* findMotif(const StreamMotif* scope, std::string_view name) noexcept {
+    for (; scope != nullptr; scope = scope->previous) {
+        if (scope->name == name) {
+            return scope;
+        }
+    }
+    return nullptr;
+}
+
+static void fail(NoteStreamError* error, const NoteTokens& tokens, const char* message) noexcept {
+    if (error != nullptr) {
+        error->line = tokens.scanner.token_line;
+        error->column = tokens.scanner.token_column;
+        error->message = message;
+        error->message += tokens.text().empty() ? std::string{} : ": " + std::string{tokens.text()};
+    }
+}
+
+Generator<DecodedNote> decodeNotes(const char* buffer, std::size_t length,
+                                   NoteStreamError* error, DecodedDeclarations* declarations) noexcept {
+    NoteTokens tokens;
+    fast_scanner_init(&tokens.scanner, buffer, length, 1);
+    tokens.advance();
+
+    // Los motivos van en un deque para que las direcciones no cambien; al
+    // salir de un bloque se descartan los definidos dentro de él
+    std::deque<StreamMotif> motifs;
+    std::vector<StreamFrame> frames;
+    std::vector<StreamVoice> voices{StreamVoice{"", 0, nullptr}};
+    std::size_t voice = 0;
+    const StreamMotif* scope = nullptr;
+    std::vector<StreamMeter> meters{StreamMeter{0, 1, 16, 0}};
+    bool has_time_signature = false;
+    bool has_tempo = false;
+    std::vector<ChordPitch> chord;
+    DecodedNote note{};
+
+    for (;;) {
+        switch (tokens.token) {
+            case TOKEN_EOF:
+                if (!frames.empty()) {
+                    fail(error, tokens, "Bloque sin cerrar al final del archivo");
+                }
+                co_return;
+
+            case TOKEN_NOTA_COMPLETA: {
+                // Nombre, alteración opcional y un dígito de octava ("Do#4")
+                std::string_view full_note = tokens.text();
+                note.name = full_note.substr(0, full_note.size() - 1);
+                note.octave = full_note.back() - '0';
+                note.line = tokens.scanner.token_line;
+                tokens.advance();
+                note.duration = tokenTicks(tokens.token);
+                if (note.duration == 0) {
+                    fail(error, tokens, "Se esperaba una duración");
+                    co_return;
+                }
+                tokens.advance();
+
+                NoteSpelling spelling{0, 0};
+                parse_note_name(note.name, spelling);
+                note.pitch = 12 * (note.octave + 1) + spelling.semitones();
+                note.voice = voices[voice].name;
+                note.tick = voices[voice].tick;
+                auto meter = meterAt(meters, note.tick);
+                note.measure = meter->measure + (note.tick - meter->tick) / meter->bar_ticks;
+                voices[voice].tick += note.duration;
+                co_yield note;
+                break;
+            }
+
+            case TOKEN_CORCHETE_ABRE: {
+                // Las notas del acorde se guardan hasta leer la duración
+                chord.clear();
+                tokens.advance();
+                while (tokens.token == TOKEN_NOTA_COMPLETA) {
+                    chord.push_back(ChordPitch{tokens.text(), tokens.scanner.token_line});
+                    tokens.advance();
+                }
+                if (chord.empty() || tokens.token != TOKEN_CORCHETE_CIERRA) {
+                    fail(error, tokens, "Acorde inválido");
+                    co_return;
+                }
+                tokens.advance();
+                note.duration = tokenTicks(tokens.token);
+                if (note.duration == 0) {
+                    fail(error, tokens, "Se esperaba una duración");
+                    co_return;
+                }
+                tokens.advance();
+
+                // Todas comienzan en la misma posición; la voz avanza una vez
+                note.voice = voices[voice].name;
+                note.tick = voices[voice].tick;
+                auto meter = meterAt(meters, note.tick);
+                note.measure = meter->measure + (note.tick - meter->tick) / meter->bar_ticks;
+                for (const auto& pitch : chord) {
+                    note.name = pitch.full_note.substr(0, pitch.full_note.size() - 1);
+                    note.octave = pitch.full_note.back() - '0';
+                    note.line = pitch.line;
+                    NoteSpelling spelling{0, 0};
+                    parse_note_name(note.name, spelling);
+                    note.pitch = 12 * (note.octave + 1) + spelling.semitones();
+                    co_yield note;
+                }
+                voices[voice].tick += note.duration;
+                break;
+            }
+
+            case TOKEN_REPETIR: {
+                tokens.advance();
+                int count = (tokens.token == TOKEN_NUMERO) ? tokens.number() : 0;
+                if (tokens.token == TOKEN_NUMERO) {
+                    tokens.advance();
+                }
+                if (count < 1 || tokens.token != TOKEN_LLAVE_ABRE) {
+                    fail(error, tokens, "Repetición inválida");
+                    co_return;
+                }
+                // El escáner queda justo después de "{": el inicio del cuerpo
+                frames.push_back(StreamFrame{StreamFrame::Kind::REPEAT, tokens.scanner, count - 1,
+                                             scope, motifs.size()});
+                tokens.advance();
+                break;
+            }
+
+            case TOKEN_MOTIVO: {
+                tokens.advance();
+                std::string_view name = tokens.text();
+                if (tokens.token != TOKEN_IDENTIFIER) {
+                    fail(error, tokens, "Se esperaba el nombre del motivo");
+                    co_return;
+                }
+                tokens.advance();
+                if (tokens.token != TOKEN_LLAVE_ABRE) {
+                    fail(error, tokens, "Se esperaba el cuerpo del motivo");
+                    co_return;
+                }
+                motifs.push_back(StreamMotif{name, tokens.scanner, scope});
+
+                // La definición no suena: se salta el cuerpo contando llaves
+                int depth = 1;
+                while (depth > 0) {
+                    tokens.advance();
+                    if (tokens.token == TOKEN_EOF) {
+                        fail(error, tokens, "Motivo sin cerrar al final del archivo");
+                        co_return;
+                    }
+                    depth += (tokens.token == TOKEN_LLAVE_ABRE) - (tokens.token == TOKEN_LLAVE_CIERRA);
+                }
+                tokens.advance();
+
+                // Visible desde aquí, no en su propio cuerpo
+                scope = &motifs.back();
+                break;
+            }
+
+            case TOKEN_IDENTIFIER: {
+                const StreamMotif* motif = findMotif(scope, tokens.text());
+                if (motif == nullptr) {
+                    fail(error, tokens, "Motivo no definido");
+                    co_return;
+                }
+                // El cuerpo se resuelve en el ámbito de su definición
+                frames.push_back(StreamFrame{StreamFrame::Kind::CALL, tokens.scanner, 0, scope, motifs.size()});
+                scope = motif->previous;
+                tokens.scanner = motif->body;
+                tokens.advance();
+                break;
+            }
+
+            case TOKEN_LLAVE_CIERRA: {
+                if (frames.empty()) {
+                    fail(error, tokens, "Llave de cierre sin bloque abierto");
+                    co_return;
+                }
+                StreamFrame& frame = frames.back();
+                motifs.resize(frame.motif_count);
+                scope = frame.scope;
+                if (frame.kind == StreamFrame::Kind::REPEAT && frame.remaining > 0) {
+                    --frame.remaining;
+                    tokens.scanner = frame.resume;
+                } else if (frame.kind == StreamFrame::Kind::CALL) {
+                    tokens.scanner = frame.resume;
+                    frames.pop_back();
+                } else {
+                    frames.pop_back();
+                }
+                tokens.advance();
+                break;
+            }
+
+            case TOKEN_VOZ: {
+                tokens.advance();
+                if (tokens.token != TOKEN_IDENTIFIER || !frames.empty()) {
+                    fail(error, tokens, "Voz inválida");
+                    co_return;
+                }
+
+                // Volver a declarar una voz continúa la misma parte, con sus motivos
+                voices[voice].scope = scope;
+                std::size_t next = 1;
+                while (next < voices.size() && voices[next].name != tokens.text()) {
+                    ++next;
+                }
+                if (next == voices.size()) {
+                    voices.push_back(StreamVoice{tokens.text(), 0, voices[0].scope});
+                    if (declarations != nullptr) {
+                        declarations->voices.push_back(tokens.text());
+                    }
+                }
+                voice = next;
+                scope = voices[voice].scope;
+                tokens.advance();
+                break;
+            }
+
+            case TOKEN_COMPAS: {
+                tokens.advance();
+                int numerator = (tokens.token == TOKEN_NUMERO) ? tokens.number() : 0;
+                tokens.advance();
+                if (tokens.token == TOKEN_BARRA) {
+                    tokens.advance();
+                }
+                int denominator = (tokens.token == TOKEN_NUMERO) ? tokens.number() : 0;
+                if (numerator < 1 || denominator < 1 || numerator * 16 % denominator != 0) {
+                    fail(error, tokens, "Compás inválido");
+                    co_return;
+                }
+                // El primero es la cabecera; los siguientes, cambios en la
+                // posición de la voz actual
+                if (has_time_signature) {
+                    addMeter(meters, StreamMeter{voices[voice].tick, 0, numerator * 16L / denominator, voice});
+                    if (declarations != nullptr) {
+                        declarations->changes.push_back(
+                            DecodedChange{voices[voice].tick, voice, 0, numerator, denominator});
+                    }
+                } else {
+                    meters.front().bar_ticks = numerator * 16L / denominator;
+                    has_time_signature = true;
+                    if (declarations != nullptr) {
+                        declarations->numerator = numerator;
+                        declarations->denominator = denominator;
+                    }
+                }
+                tokens.advance();
+                break;
+            }
+
+            case TOKEN_TEMPO:
+            case TOKEN_TONALIDAD:
+            case TOKEN_TRANSPONER: {
+                // No cambian las notas escritas: sus argumentos solo se
+                // anotan en declarations
+                int instruction = tokens.token;
+                int number = 0;
+                std::string root;
+                bool minor = false;
+                do {
+                    tokens.advance();
+                    if (tokens.token == TOKEN_NUMERO) {
+                        number = tokens.number();
+                    } else if (tokens.token >= TOKEN_NOTA_DO && tokens.token <= TOKEN_NOTA_SI) {
+                        root = letter_names[tokens.token - TOKEN_NOTA_DO];
+                    } else if (tokens.token == TOKEN_SOSTENIDO || tokens.token == TOKEN_BEMOL) {
+                        root += (tokens.token == TOKEN_SOSTENIDO) ? '#' : 'b';
+                    } else if (tokens.token == TOKEN_MENOR) {
+                        minor = true;
+                    }
+                } while (tokens.token != TOKEN_EOF && !isInstructionStart(tokens.token) &&
+                         tokens.token != TOKEN_LLAVE_CIERRA);
+
+                // Como con el compás, el primer tempo es la cabecera
+                bool tempo_change = instruction == TOKEN_TEMPO && has_tempo;
+                has_tempo = has_tempo || instruction == TOKEN_TEMPO;
+                if (declarations == nullptr) {
+                    break;
+                }
+                if (instruction == TOKEN_TONALIDAD) {
+                    declarations->key_root = root;
+                    declarations->minor = minor;
+                } else if (instruction == TOKEN_TRANSPONER) {
+                    declarations->transposition = number;
+                } else if (tempo_change) {
+                    declarations->changes.push_back(DecodedChange{voices[voice].tick, voice, number, 0, 0});
+                } else {
+                    declarations->tempo = number;
+                }
+                break;
+            }
+
+            default:
+                fail(error, tokens, "Token inesperado");
+                co_return;
+        }
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+// Requiere C++20 (ver generator.hpp)
+#include "generator.hpp"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Nota tal como suena, en el orden del archivo. Las repeticiones se
+// expanden y las referencias a motivos entregan las notas del motivo. Las
+// notas de un acorde se entregan una por una, con la misma posición
+struct DecodedNote {
+    std::string_view name;    // Nombre como se escribió ("Do#", "Bb"); apunta al buffer
+    int octave;
+    int pitch;                // Altura MIDI escrita (Do4 = 60), sin transposición
+    int duration;             // En semicorcheas: 8 blanca, 4 negra, 2 corchea, 1 semicorchea
+    long measure;             // Compás, desde 1
+    long tick;                // Posición en semicorcheas desde el inicio de la voz
+    std::string_view voice;   // Voz ("" fuera de toda voz); apunta al buffer
+    int line;                 // Línea de la nota en el archivo (dentro del motivo, si viene de uno)
+};
+
+// Motivo por el que la decodificación se detuvo antes del final (line 0: ninguno)
+struct NoteStreamError {
+    int line{0};
+    int column{0};
+    std::string message;
+};
+
+// Cambio de tempo o de compás, en la posición de la voz donde aparece
+struct DecodedChange {
+    long tick;
+    std::size_t voice;   // 0 fuera de toda voz; i + 1 para la voz i
+    int tempo;           // 0 si no cambia el tempo
+    int numerator;       // 0 si no cambia el compás
+    int denominator;
+};
+
+// Declaraciones y cambios leídos por decodeNotes, para quien necesita más
+// que las notas (ver musicxml.hpp). Se completan a medida que avanza el
+// generador; al terminar están todos. Un valor en 0 (o una raíz vacía) es
+// una declaración que todavía no apareció
+struct DecodedDeclarations {
+    int tempo{0};
+    int numerator{0};
+    int denominator{0};
+    std::string key_root;                   // "Sol", "Fa#"
+    bool minor{false};
+    int transposition{0};
+    std::vector<std::string_view> voices;   // En el orden en que se declaran
+    std::vector<DecodedChange> changes;     // En el orden del archivo
+};
+
+// Decodifica las notas de una partitura en memoria a medida que se piden,
+// tomando los tokens del escáner reentrante de a uno: no construye el árbol
+// del parser ni el MusicProgram. Terminar antes (un break en el for) deja de
+// escanear en ese punto, así que leer los primeros compases cuesta lo mismo
+// en un archivo grande que en uno pequeño.
+//
+// Cada repetición y cada motivo guardan una copia del estado del escáner al
+// comenzar su cuerpo y lo vuelven a escanear en cada vuelta o referencia.
+// Los motivos se buscan como en el análisis semántico: en el ámbito donde se
+// definió la referencia, sin ver los definidos después.
+//
+// Las voces se entregan en el orden en que aparecen en el archivo, cada una
+// con su propia posición. El compás se calcula con la declaración "Compas"
+// vista hasta ese momento (4/4 antes de ella) y los cambios de compás ya
+// leídos; los de una voz que aparece más adelante en el archivo todavía no
+// se conocen, así que sus compases solo valen para las voces siguientes. La
+// partitura no se verifica
+// (para eso, checkBuffer o compileBuffer): ante una entrada que no puede
+// decodificar, el generador termina y, si error no es nullptr, deja allí la
+// ubicación y el motivo. Si declarations no es nullptr, deja allí la
+// cabecera y los cambios que va leyendo. buffer, error y declarations deben
+// vivir mientras se use el generador.
+Generator<DecodedNote> decodeNotes(const char* buffer, std::size_t length,
+                                   NoteStreamError* error = nullptr,
+                                   DecodedDeclarations* declarations = nullptr) noexcept;
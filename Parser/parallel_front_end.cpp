@@ -0,0 +1,328 @@
+#include "parallel_front_end.hpp"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+// Requerido para usar el mismo YYSTYPE que el parser
+#define YYSTYPE Expression*
+#include "token.h"
+
+// Implementación de ChunkTokenSource
+ChunkTokenSource::ChunkTokenSource(const char* buffer, std::size_t length, std::size_t begin,
+                                   std::size_t end, std::vector<SyntaxError>& errors) noexcept
+    : chunk_end{buffer + end}, errors{errors} {
+    fast_scanner_init(&scanner, buffer + begin, length - begin, 1);
+}
+
+int ChunkTokenSource::next() noexcept {
+    for (;;) {
+        int token = fast_scanner_next(&scanner);
+        text.assign(scanner.text, scanner.length);
+
+        if (token != FAST_SCANNER_ERROR) {
+            return token;
+        }
+        recordSyntaxError(errors, scanner.token_line, scanner.token_column,
+                          "Carácter no reconocido: " + text);
+    }
+}
+
+const char* ChunkTokenSource::getText() const noexcept {
+    return text.c_str();
+}
+
+int ChunkTokenSource::getLine() const noexcept {
+    return scanner.token_line;
+}
+
+int ChunkTokenSource::getColumn() const noexcept {
+    return scanner.token_column;
+}
+
+int ChunkTokenSource::getLastColumn() const noexcept {
+    return scanner.token_column + static_cast<int>(scanner.length) - 1;
+}
+
+bool ChunkTokenSource::atBoundary() const noexcept {
+    return scanner.text >= chunk_end;
+}
+
+// Resultado del análisis de un fragmento
+struct ChunkResult {
+    std::vector<Expression*> instructions;
+    std::vector<InstructionLocation> locations;
+    std::vector<SyntaxError> errors;
+    int line_count{0};
+};
+
+// Primer token a partir de offset (saltando blancos y comentarios) y su posición
+static int firstToken(const char* buffer, std::size_t length, std::size_t offset,
+                      std::size_t& token_offset) {
+    fast_scanner_t scanner;
+    fast_scanner_init(&scanner, buffer + offset, length - offset, 1);
+    int token = fast_scanner_next(&scanner);
+    token_offset = static_cast<std::size_t>(scanner.text - buffer);
+    return token;
+}
+
+// Inicio de la línea que contiene offset
+static std::size_t lineStart(const char* buffer, std::size_t offset) {
+    while (offset > 0 && buffer[offset - 1] != '\n') {
+        --offset;
+    }
+    return offset;
+}
+
+// Inicio de la siguiente línea a partir de offset
+static std::size_t nextLine(const char* buffer, std::size_t length, std::size_t offset) {
+    const void* newline = std::memchr(buffer + offset, '\n', length - offset);
+    return (newline == nullptr) ? length : static_cast<const char*>(newline) - buffer + 1;
+}
+
+// Inicio de la primera línea, a partir de offset, cuyo primer token cumple la condición
+template <typename Condition>
+static std::size_t findLine(const char* buffer, std::size_t length, std::size_t offset,
+                            Condition condition) {
+    while (offset < length) {
+        std::size_t token_offset;
+        int token = firstToken(buffer, length, offset, token_offset);
+        if (token == YYEOF) {
+            return length;
+        }
+
+        std::size_t start = lineStart(buffer, token_offset);
+        if (condition(token)) {
+            return start;
+        }
+        offset = nextLine(buffer, length, token_offset);
+    }
+    return length;
+}
+
+bool LineNesting::outside() const noexcept {
+    return depth == 0 && !chord;
+}
+
+bool LineNesting::operator==(const LineNesting& other) const noexcept {
+    return depth == other.depth && chord == other.chord;
+}
+
+bool LineNesting::operator!=(const LineNesting& other) const noexcept {
+    return !(*this == other);
+}
+
+LineNesting lineNesting(const char* buffer, std::size_t line, std::size_t end, LineNesting nesting) noexcept {
+    for (std::size_t i = line; i < end; ++i) {
+        char c = buffer[i];
+        if (c == '/' && i + 1 < end && buffer[i + 1] == '/') {
+            break;
+        }
+        if (c == '{') {
+            ++nesting.depth;
+            nesting.chord = false;
+        } else if (c == '}') {
+            nesting.depth -= (nesting.depth > 0);
+            nesting.chord = false;
+        } else if (c == '[') {
+            nesting.chord = true;
+        } else if (c == ']') {
+            nesting.chord = false;
+        }
+    }
+    return nesting;
+}
+
+bool isChunkStart(int token) noexcept {
+    return token != TOKEN_IDENTIFIER && isInstructionStart(token);
+}
+
+// Efecto de un tramo de líneas sobre el anidamiento, sin conocer el de su
+// inicio: total es la suma de llaves abiertas menos cerradas y lowest el
+// mínimo de esa suma (las llaves de cierre de más no bajan de cero). chord
+// es el estado del acorde tras la última llave o corchete (-1 si no hay)
+struct NestingSummary {
+    int total{0};
+    int lowest{0};
+    int chord{-1};
+
+    LineNesting apply(LineNesting nesting) const noexcept {
+        nesting.depth = std::max(nesting.depth, -lowest) + total;
+        if (chord >= 0) {
+            nesting.chord = (chord == 1);
+        }
+        return nesting;
+    }
+};
+
+// Resume [begin, end), que comienza al inicio de una línea, con las mismas
+// reglas que lineNesting
+static NestingSummary summarizeNesting(const char* buffer, std::size_t begin, std::size_t end) {
+    NestingSummary summary;
+    for (std::size_t i = begin; i < end; ++i) {
+        char c = buffer[i];
+        if (c == '/' && i + 1 < end && buffer[i + 1] == '/') {
+            const void* newline = std::memchr(buffer + i, '\n', end - i);
+            if (newline == nullptr) {
+                break;
+            }
+            i = static_cast<const char*>(newline) - buffer;
+        } else if (c == '{') {
+            ++summary.total;
+            summary.chord = 0;
+        } else if (c == '}') {
+            summary.lowest = std::min(summary.lowest, --summary.total);
+            summary.chord = 0;
+        } else if (c == '[') {
+            summary.chord = 1;
+        } else if (c == ']') {
+            summary.chord = 0;
+        }
+    }
+    return summary;
+}
+
+// Ejecuta function(i) para cada i en [0, count), cada uno en su propio hilo
+// (el 0 en el hilo que llama)
+template <typename Function>
+static void forEachChunk(std::size_t count, const Function& function) {
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < count; ++i) {
+        threads.emplace_back(function, i);
+    }
+    if (count > 0) {
+        function(0);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+std::vector<std::size_t> splitChunks(const char* buffer, std::size_t length,
+                                     unsigned chunk_count) noexcept {
+    std::vector<std::size_t> starts{0};
+    if (chunk_count <= 1) {
+        return starts;
+    }
+
+    // Con bloques (Repetir N { ... }, Motivo A { ... }) o acordes ([Do4 Mi4] Negra) solo se
+    // puede dividir fuera de ellos. La entrada se reparte en tramos de igual
+    // tamaño que comienzan al inicio de una línea; cada hilo resume el
+    // anidamiento de su tramo, con eso se obtiene el del inicio de cada uno y
+    // cada hilo busca en su tramo la primera línea donde se puede dividir. Un
+    // tramo sin ninguna (todo dentro de un bloque) queda con el anterior
+    if (std::memchr(buffer, '{', length) != nullptr || std::memchr(buffer, '[', length) != nullptr) {
+        std::vector<std::size_t> ranges{0};
+        for (unsigned i = 1; i < chunk_count; ++i) {
+            std::size_t offset = nextLine(buffer, length, length * i / chunk_count - 1);
+            if (offset > ranges.back() && offset < length) {
+                ranges.push_back(offset);
+            }
+        }
+        ranges.push_back(length);
+        std::size_t range_count = ranges.size() - 1;
+
+        std::vector<NestingSummary> summaries(range_count);
+        forEachChunk(range_count, [&](std::size_t i) {
+            summaries[i] = summarizeNesting(buffer, ranges[i], ranges[i + 1]);
+        });
+
+        std::vector<LineNesting> entry(range_count);
+        for (std::size_t i = 1; i < range_count; ++i) {
+            entry[i] = summaries[i - 1].apply(entry[i - 1]);
+        }
+
+        std::vector<std::size_t> found(range_count, length);
+        forEachChunk(range_count, [&](std::size_t i) {
+            if (i == 0) {
+                return;
+            }
+            LineNesting nesting = entry[i];
+            std::size_t offset = ranges[i];
+            while (offset < ranges[i + 1]) {
+                std::size_t token_offset;
+                int token = firstToken(buffer, length, offset, token_offset);
+                std::size_t start = lineStart(buffer, token_offset);
+                if (token == YYEOF || start >= ranges[i + 1]) {
+                    return;
+                }
+                if (nesting.outside() && isChunkStart(token)) {
+                    found[i] = start;
+                    return;
+                }
+                offset = nextLine(buffer, length, token_offset);
+                nesting = lineNesting(buffer, start, offset, nesting);
+            }
+        });
+
+        for (std::size_t i = 1; i < range_count; ++i) {
+            if (found[i] < length) {
+                starts.push_back(found[i]);
+            }
+        }
+        return starts;
+    }
+
+    // Las declaraciones de cabecera (Tempo, Compas, Tonalidad) quedan en el
+    // primer fragmento: la división comienza en la primera línea con una nota o un acorde
+    std::size_t header_end = findLine(buffer, length, 0, [](int token) {
+        return token == TOKEN_NOTA_COMPLETA || token == TOKEN_CORCHETE_ABRE;
+    });
+
+    std::size_t body_length = length - header_end;
+    for (unsigned i = 1; i < chunk_count; ++i) {
+        std::size_t offset = std::max(header_end + body_length * i / chunk_count, starts.back() + 1);
+        if (offset >= length) {
+            break;
+        }
+
+        // Avanzar hasta un inicio de línea cuyo primer token abra una instrucción
+        offset = findLine(buffer, length, nextLine(buffer, length, offset - 1), isChunkStart);
+        if (offset >= length) {
+            break;
+        }
+        starts.push_back(offset);
+    }
+    return starts;
+}
+
+Program* parseParallel(const char* buffer, std::size_t length, unsigned thread_count,
+                       std::vector<SyntaxError>& errors,
+                       std::vector<InstructionLocation>* locations) noexcept {
+    std::vector<std::size_t> starts = splitChunks(buffer, length, std::max(thread_count, 1u));
+    std::vector<ChunkResult> results(starts.size());
+
+    // Escanear y analizar cada fragmento en su propio hilo
+    auto parse_chunk = [&](std::size_t index) {
+        std::size_t begin = starts[index];
+        std::size_t end = (index + 1 < starts.size()) ? starts[index + 1] : length;
+        ChunkResult& result = results[index];
+
+        ChunkTokenSource source{buffer, length, begin, end, result.errors};
+        RecursiveDescentParser parser{source, result.errors};
+        parser.start(index == 0);
+        parser.parseInto(result.instructions, (locations != nullptr) ? &result.locations : nullptr);
+
+        result.line_count = static_cast<int>(std::count(buffer + begin, buffer + end, '\n'));
+    };
+
+    forEachChunk(starts.size(), parse_chunk);
+
+    // Unir las instrucciones en orden y corregir la línea de cada error
+    Program* program = new Program();
+    int line_offset = 0;
+    for (auto& result : results) {
+        for (auto instruction : result.instructions) {
+            program->addInstruction(instruction);
+        }
+        if (locations != nullptr) {
+            for (const auto& location : result.locations) {
+                locations->push_back({location.line + line_offset, location.column});
+            }
+        }
+        for (const auto& error : result.errors) {
+            recordSyntaxError(errors, error.line + line_offset, error.column, error.message);
+        }
+        line_offset += result.line_count;
+    }
+    return program;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "expression.hpp"
+#include "recursive_descent.hpp"
+#include "syntax_error.hpp"
+#include "../Scanner/fast_scanner.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Fuente de tokens sobre un fragmento [begin, end) de un buffer en memoria,
+// con su propio escáner reentrante. Al llegar al final del fragmento sigue
+// leyendo el buffer, de modo que el lookahead de la última instrucción es el
+// mismo que en un análisis secuencial; atBoundary() indica que el token
+// actual ya pertenece al siguiente fragmento.
+class ChunkTokenSource : public TokenSource {
+public:
+    ChunkTokenSource(const char* buffer, std::size_t length, std::size_t begin,
+                     std::size_t end, std::vector<SyntaxError>& errors) noexcept;
+
+    int next() noexcept override;
+    const char* getText() const noexcept override;
+    int getLine() const noexcept override;
+    int getColumn() const noexcept override;
+    int getLastColumn() const noexcept override;
+    bool atBoundary() const noexcept override;
+
+private:
+    fast_scanner_t scanner;
+    const char* chunk_end;
+    std::vector<SyntaxError>& errors;
+    std::string text;
+};
+
+// Front end paralelo. El lenguaje es orientado a líneas, así que tras ubicar
+// las declaraciones de cabecera el resto de la entrada se divide en
+// fragmentos que comienzan al inicio de una línea cuyo primer token abre una
+// instrucción (salvo una referencia a un motivo), fuera de todo bloque entre
+// llaves. Cada fragmento se escanea y analiza en su propio hilo
+// con el parser descendente y los resultados se unen en orden. Los números
+// de línea de los errores se corrigen con la cantidad de líneas de los
+// fragmentos anteriores, así que la salida es la misma que la secuencial.
+// Si recibe locations, deja allí la ubicación de cada instrucción, con la
+// misma corrección.
+Program* parseParallel(const char* buffer, std::size_t length, unsigned thread_count,
+                       std::vector<SyntaxError>& errors,
+                       std::vector<InstructionLocation>* locations = nullptr) noexcept;
+
+// Anidamiento al final de una línea: llaves abiertas y si quedó abierto un
+// acorde escrito en varias líneas. Solo se divide fuera de ambos
+struct LineNesting {
+    int depth{0};
+    bool chord{false};
+
+    bool outside() const noexcept;
+    bool operator==(const LineNesting& other) const noexcept;
+    bool operator!=(const LineNesting& other) const noexcept;
+};
+
+// Anidamiento al final de la línea [line, end), a partir de nesting. El
+// resto de la línea tras "//" es comentario. Una llave de cierre sin bloque
+// abierto no baja de cero, igual que en el parser (se descarta). Un acorde
+// queda abierto desde "[" hasta "]" o una llave; si el parser lo cerró antes
+// por un error, solo se pierden puntos de división
+LineNesting lineNesting(const char* buffer, std::size_t line, std::size_t end, LineNesting nesting) noexcept;
+
+// Token con el que puede comenzar un fragmento. Un identificador al inicio de
+// una línea puede ser una referencia a un motivo, pero también el nombre de
+// "Voz" o "Motivo" escrito en la línea siguiente: nunca se divide ahí
+bool isChunkStart(int token) noexcept;
+
+// Posiciones de inicio de cada fragmento (la primera siempre es 0)
+std::vector<std::size_t> splitChunks(const char* buffer, std::size_t length,
+                                     unsigned chunk_count) noexcept;
@@ -0,0 +1,500 @@
+#include "pipeline.hpp"
+#include "compile.hpp"
+#include "lowering.hpp"
+#include "recursive_descent.hpp"
+#include "../AST/declaration.hpp"
+#include "../AST/statement.hpp"
+#include "../AST/transpose.hpp"
+#include "../AST/voice.hpp"
+#include "../Scanner/fast_scanner.h"
+#include "../Semantic_Analysis/symbol_table.hpp"
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+// Requerido para usar el mismo YYSTYPE que el parser
+#define YYSTYPE Expression*
+#include "token.h"
+
+using PipelineClock = std::chrono::steady_clock;
+
+// Token tal como lo deja el escáner; el lexema apunta al buffer de entrada
+struct ScannedToken {
+    int token;
+    int line;
+    int column;
+    const char* text;
+    std::size_t length;
+};
+
+// Los tokens viajan en lotes para que el costo de la cola (dos escrituras
+// atómicas) se reparta entre muchos tokens
+constexpr std::size_t TOKEN_BATCH_SIZE = 256;
+
+struct TokenBatch {
+    std::size_t count;
+    ScannedToken tokens[TOKEN_BATCH_SIZE];
+};
+
+// Instrucción de nivel superior; instruction es nullptr al final de la entrada
+struct ParsedInstruction {
+    Expression* instruction;
+    InstructionLocation location;
+};
+
+// Colas entre las etapas. Son grandes (los lotes ocupan unos 400 KB), así
+// que van en el heap
+struct PipelineQueues {
+    SpscQueue<TokenBatch, 64> tokens;
+    SpscQueue<ParsedInstruction, 1024> instructions;
+};
+
+// Fuente de tokens del parser: lee los lotes de la cola del escáner. Los
+// caracteres no reconocidos se reportan al leerlos, igual que en
+// ChunkTokenSource, así que los errores quedan en el mismo orden
+class BatchTokenSource : public TokenSource {
+public:
+    BatchTokenSource(SpscQueue<TokenBatch, 64>& queue, std::vector<SyntaxError>& errors,
+                     double& wait_ms) noexcept
+        : queue{queue}, errors{errors}, wait_ms{wait_ms} {}
+
+    int next() noexcept override {
+        for (;;) {
+            // Tras el fin de la entrada no hay más lotes: se repite el último token
+            if (this->current.token == YYEOF && this->started) {
+                return YYEOF;
+            }
+            if (this->batch == nullptr) {
+                this->batch = &this->queue.front(this->wait_ms);
+                this->index = 0;
+            }
+            this->current = this->batch->tokens[this->index++];
+            this->started = true;
+            if (this->index == this->batch->count) {
+                this->queue.release();
+                this->batch = nullptr;
+            }
+
+            this->text.assign(this->current.text, this->current.length);
+            if (this->current.token != FAST_SCANNER_ERROR) {
+                return this->current.token;
+            }
+            recordSyntaxError(this->errors, this->current.line, this->current.column,
+                              "Carácter no reconocido: " + this->text);
+        }
+    }
+
+    const char* getText() const noexcept override {
+        return this->text.c_str();
+    }
+
+    int getLine() const noexcept override {
+        return this->current.line;
+    }
+
+    int getColumn() const noexcept override {
+        return this->current.column;
+    }
+
+    int getLastColumn() const noexcept override {
+        return this->current.column + static_cast<int>(this->current.length) - 1;
+    }
+
+private:
+    SpscQueue<TokenBatch, 64>& queue;
+    std::vector<SyntaxError>& errors;
+    double& wait_ms;
+    TokenBatch* batch{nullptr};
+    std::size_t index{0};
+    ScannedToken current{YYEOF, 0, 0, "", 0};
+    bool started{false};
+    std::string text;
+};
+
+// Etapa 1: escanea la entrada completa en lotes; el último termina en YYEOF
+static void scanStage(const char* buffer, std::size_t length, SpscQueue<TokenBatch, 64>& queue,
+                      PipelineStageStats& stats) noexcept {
+    auto start = PipelineClock::now();
+    fast_scanner_t scanner;
+    fast_scanner_init(&scanner, buffer, length, 1);
+
+    bool at_end = false;
+    while (!at_end) {
+        TokenBatch& batch = queue.acquire(stats.wait_ms);
+        batch.count = 0;
+        while (batch.count < TOKEN_BATCH_SIZE && !at_end) {
+            int token = fast_scanner_next(&scanner);
+            batch.tokens[batch.count++] = ScannedToken{token, scanner.token_line, scanner.token_column,
+                                                       scanner.text, scanner.length};
+            at_end = (token == YYEOF);
+        }
+        queue.commit();
+    }
+    stats.busy_ms = std::chrono::duration<double, std::milli>(PipelineClock::now() - start).count() - stats.wait_ms;
+}
+
+// Etapa 2: analiza los tokens y entrega cada instrucción en cuanto se reduce
+static void parseStage(PipelineQueues& queues, std::vector<SyntaxError>& errors,
+                       PipelineStageStats& stats) noexcept {
+    auto start = PipelineClock::now();
+    BatchTokenSource source{queues.tokens, errors, stats.wait_ms};
+    RecursiveDescentParser parser{source, errors};
+    parser.start();
+    parser.parseInto([&](Expression* instruction, const InstructionLocation& location) {
+        queues.instructions.acquire(stats.wait_ms) = ParsedInstruction{instruction, location};
+        queues.instructions.commit();
+    });
+    queues.instructions.acquire(stats.wait_ms) = ParsedInstruction{nullptr, InstructionLocation{0, 0}};
+    queues.instructions.commit();
+    stats.busy_ms = std::chrono::duration<double, std::milli>(PipelineClock::now() - start).count() - stats.wait_ms;
+}
+
+// Análisis del emisor: verifica y escribe en ABC cada sentencia del programa
+// que arma ProgramLowering en cuanto llega, en el orden de analyzeMusicProgram
+// (ValidationPass y TranspositionPass) y to_abc. La cabecera se cierra con la
+// primera sentencia o voz: se resuelven las declaraciones, se transpone la
+// tonalidad y se escribe la cabecera ABC. Cada sentencia de nivel superior se
+// resuelve en la tabla, se transpone, avanza el mapa de tempo y se escribe;
+// las de cada voz se resuelven en la copia de la tabla de su voz y se
+// transponen. Los errores quedan guardados y finish los entrega en el orden
+// del análisis secuencial.
+// finish hace lo que necesita el programa completo: las declaraciones
+// obligatorias, el mapa armado con resolve_voices (que reporta sus errores
+// en su lugar), la rejilla y la alineación de las voces, el error de rango de
+// la transposición y, con voces, el ABC de las voces, que depende de los
+// cambios de compás de todas ellas.
+// Una declaración después de cerrada la cabecera cambia lo ya analizado (una
+// tonalidad o una transposición tardía): el análisis se abandona y el emisor
+// analiza el programa completo al final, como antes (deferred)
+class StreamingAnalysis {
+public:
+    StreamingAnalysis(MusicProgram& program, int semitones) noexcept
+        : program{program}, semitones{semitones} {}
+
+    // Analiza lo que la última instrucción agregó al programa
+    void update() noexcept {
+        if (this->deferred) {
+            return;
+        }
+
+        std::size_t declarations = this->program.get_declarations().size();
+        if (declarations != this->declarations_seen) {
+            this->declarations_seen = declarations;
+            this->deferred = this->header_closed;
+            return;
+        }
+
+        const auto& statements = this->program.get_statements();
+        while (this->statements_seen < statements.size()) {
+            this->closeHeader();
+            this->addStatement(*statements[this->statements_seen++]);
+        }
+
+        const auto& voices = this->program.get_voices();
+        if (this->voices.size() < voices.size()) {
+            this->closeHeader();
+            this->addVoices();
+        }
+        for (std::size_t i = 0; i < this->voices.size(); ++i) {
+            const auto& voice_statements = voices[i]->get_statements();
+            VoiceAnalysis& voice = *this->voices[i];
+            while (voice.statements_seen < voice_statements.size()) {
+                this->addVoiceStatement(*voice_statements[voice.statements_seen++], i);
+            }
+        }
+    }
+
+    bool isDeferred() const noexcept {
+        return this->deferred;
+    }
+
+    // Completa el análisis y entrega los errores al destino del hilo. Si el
+    // programa es válido, deja el ABC en abc
+    bool finish(std::string& abc) noexcept {
+        this->closeHeader();
+        SemanticErrorSink& sink = semantic_error_sink();
+        this->errors.replay(sink);
+        if (this->failed) {
+            return false;
+        }
+
+        bool valid = true;
+        if (this->voices.empty()) {
+            valid = this->program.resolve_voices(this->table);
+        } else {
+            for (const auto& voice : this->voices) {
+                voice->errors.replay(sink);
+                valid = valid && !voice->failed;
+            }
+            valid = valid && this->program.check_voices() &&
+                    MusicProgram::check_required_declarations(this->table);
+        }
+        if (!valid || !this->transposition.finish()) {
+            return false;
+        }
+
+        if (!this->voices.empty()) {
+            this->program.write_abc_voices(this->abc, this->beat);
+        } else if (this->rewrite) {
+            // Un cambio llegó a un tramo ya escrito: se escribe todo otra vez
+            // con el mapa que armó resolve_voices
+            this->abc.str("");
+            this->beat = 0.0;
+            this->program.to_abc(this->abc, this->beat);
+        } else {
+            finish_abc_bars(this->abc, this->state);
+        }
+        abc = this->abc.str();
+        return true;
+    }
+
+private:
+    struct VoiceAnalysis {
+        SymbolTable table;
+        BufferedErrorSink errors;
+        std::size_t statements_seen{0};
+        bool failed{false};
+    };
+
+    void closeHeader() noexcept {
+        if (this->header_closed) {
+            return;
+        }
+        this->header_closed = true;
+        {
+            SemanticErrorRedirect redirect{this->errors};
+            this->failed = !this->program.resolve_declarations(this->table);
+        }
+        this->transposition.start(this->program, this->program.get_transposition() + this->semitones);
+
+        this->program.write_abc_header(this->abc, this->beat);
+        this->header_length = this->abc.tellp();
+        this->state = AbcBarState{this->program.bar_length()};
+        start_abc_bars(this->state, nullptr, true);
+
+        // El mapa comienza con la cabecera, como en build_tempo_map
+        const TempoDeclaration* tempo = nullptr;
+        const TimeSignatureDeclaration* time_signature = nullptr;
+        for (const auto& decl : this->program.get_declarations()) {
+            if (auto found = dynamic_cast<const TempoDeclaration*>(decl)) {
+                tempo = found;
+            } else if (auto found = dynamic_cast<const TimeSignatureDeclaration*>(decl)) {
+                time_signature = found;
+            }
+        }
+        this->writing = tempo != nullptr && time_signature != nullptr;
+        if (this->writing) {
+            this->tempo_map.reset(tempo->get_tempo_value(), time_signature->get_numerator(),
+                                  time_signature->get_denominator());
+            this->tempo_map.build();
+        }
+    }
+
+    void addStatement(Statement& statement) noexcept {
+        if (this->failed) {
+            return;
+        }
+        {
+            SemanticErrorRedirect redirect{this->errors};
+            SourceLocationScope location{statement.get_source_location()};
+            if (!statement.resolve_names(this->table)) {
+                this->failed = true;
+                return;
+            }
+        }
+        this->transposition.add(statement, 0);
+        if (!this->writing) {
+            return;
+        }
+
+        if (auto tempo = dynamic_cast<const TempoChangeStatement*>(&statement)) {
+            this->tempo_map.add_tempo_change(this->position, tempo->get_tempo_value());
+            this->extendTempoMap();
+        } else if (auto time_signature = dynamic_cast<const TimeSignatureChangeStatement*>(&statement)) {
+            this->tempo_map.add_time_signature_change(this->position, time_signature->get_numerator(),
+                                                      time_signature->get_denominator());
+            this->extendTempoMap();
+        } else {
+            this->position += TempoMap::ticks_from_beats(statement.played_beats());
+        }
+        if (this->writing) {
+            statement.to_abc_on_grid(this->abc, this->beat, this->state);
+        }
+    }
+
+    void extendTempoMap() noexcept {
+        // Si el cambio no cae en una barra, resolve_voices reporta el error al
+        // final; mientras tanto no se escribe más
+        std::size_t segments = this->tempo_map.get_segments().size();
+        BufferedErrorSink reported_later;
+        SemanticErrorRedirect redirect{reported_later};
+        if (!this->tempo_map.build()) {
+            this->writing = false;
+            return;
+        }
+
+        // Varios cambios en una posición forman un tramo, y si ya se escribió
+        // ese tramo el cambio nuevo no se vería
+        bool merged = this->tempo_map.get_segments().size() == segments;
+        if (merged && this->state.tempo_map != nullptr && this->state.segment + 1 == segments) {
+            this->rewrite = true;
+            this->writing = false;
+            return;
+        }
+        extend_abc_bars(this->state, this->tempo_map);
+    }
+
+    void addVoices() noexcept {
+        // Con voces, lo escrito del nivel superior no forma parte del ABC
+        std::size_t first = this->voices.size();
+        if (first == 0) {
+            std::string header = this->abc.str().substr(0, static_cast<std::size_t>(this->header_length));
+            this->abc.str(header);
+            this->abc.seekp(0, std::ios_base::end);
+            this->writing = false;
+        }
+        if (!this->failed) {
+            SemanticErrorRedirect redirect{this->errors};
+            this->failed = !this->program.declare_voices(this->table, first);
+        }
+        for (std::size_t i = first; i < this->program.get_voices().size(); ++i) {
+            this->voices.push_back(std::unique_ptr<VoiceAnalysis>(new VoiceAnalysis{this->table, {}, 0, false}));
+            this->voices.back()->table.enter_scope();
+        }
+    }
+
+    void addVoiceStatement(Statement& statement, std::size_t index) noexcept {
+        VoiceAnalysis& voice = *this->voices[index];
+        if (this->failed || voice.failed) {
+            return;
+        }
+        {
+            SemanticErrorRedirect redirect{voice.errors};
+            SourceLocationScope location{statement.get_source_location()};
+            if (!statement.resolve_names(voice.table)) {
+                voice.failed = true;
+                return;
+            }
+        }
+        this->transposition.add(statement, index + 1);
+    }
+
+    MusicProgram& program;
+    int semitones;
+    SymbolTable table;
+    BufferedErrorSink errors;
+    IncrementalTransposition transposition;
+
+    bool deferred{false};
+    bool header_closed{false};
+    bool failed{false};
+    std::size_t declarations_seen{0};
+    std::size_t statements_seen{0};
+    std::vector<std::unique_ptr<VoiceAnalysis>> voices;
+
+    // ABC del nivel superior, escrito a medida que llegan las sentencias
+    std::ostringstream abc;
+    std::streampos header_length{0};
+    double beat{0.0};
+    AbcBarState state;
+    TempoMap tempo_map;
+    long position{0};
+    bool writing{false};
+    bool rewrite{false};
+};
+
+void compilePipelined(const char* buffer, std::size_t length, int semitones, bool emit,
+                      PipelineResult& result) noexcept {
+    auto start = PipelineClock::now();
+    auto queues = std::make_unique<PipelineQueues>();
+    PipelineStats& stats = result.stats;
+
+    std::thread scanner{scanStage, buffer, length, std::ref(queues->tokens), std::ref(stats.scanner)};
+    std::thread parser{parseStage, std::ref(*queues), std::ref(result.syntax_errors), std::ref(stats.parser)};
+
+    // Etapa 3: arma el Program y traduce y analiza cada instrucción al recibirla
+    result.program = new Program();
+    ProgramLowering lowering;
+    StreamingAnalysis analysis{lowering.current(), semitones};
+    for (;;) {
+        ParsedInstruction item = queues->instructions.front(stats.emitter.wait_ms);
+        queues->instructions.release();
+        if (item.instruction == nullptr) {
+            break;
+        }
+        result.program->addInstruction(item.instruction);
+        if (emit && !analysis.isDeferred()) {
+            lowering.add(item.instruction);
+            analysis.update();
+        }
+    }
+    scanner.join();
+    parser.join();
+
+    // Queda lo que necesita el programa completo. Con errores sintácticos el
+    // programa principal no ejecuta el análisis semántico
+    result.valid = false;
+    auto analysis_start = PipelineClock::now();
+    if (emit && result.syntax_errors.empty()) {
+        std::ostringstream semantic_errors;
+        if (!analysis.isDeferred()) {
+            stats.notes = lowering.current().get_note_pool()->stats();
+            SemanticErrorRedirect redirect{semantic_errors};
+            result.valid = analysis.finish(result.abc);
+        } else {
+            std::unique_ptr<MusicProgram> music{lowerProgram(*result.program)};
+            stats.notes = music->get_note_pool()->stats();
+            {
+                SemanticErrorRedirect redirect{semantic_errors};
+                result.valid = analyzeMusicProgram(*music, semitones);
+            }
+            if (result.valid) {
+                std::ostringstream abc;
+                double beat = 0.0;
+                music->to_abc(abc, beat);
+                result.abc = abc.str();
+            }
+        }
+        result.semantic_errors = semantic_errors.str();
+    }
+
+    auto end = PipelineClock::now();
+    stats.analysis_ms = std::chrono::duration<double, std::milli>(end - analysis_start).count();
+    stats.total_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    stats.emitter.busy_ms = stats.total_ms - stats.emitter.wait_ms;
+    stats.tokens = queues->tokens.getStats();
+    stats.instructions = queues->instructions.getStats();
+}
+
+static void writeStage(std::ostream& out, const char* name, const PipelineStageStats& stage,
+                       double total_ms) noexcept {
+    double utilization = (total_ms > 0.0) ? 100.0 * stage.busy_ms / total_ms : 0.0;
+    out << "Etapa " << name << ": " << stage.busy_ms << " ms trabajando (" << utilization
+        << "%), " << stage.wait_ms << " ms esperando\n";
+}
+
+static void writeQueue(std::ostream& out, const char* name, const QueueStats& queue) noexcept {
+    out << "Cola de " << name << ": ocupación media " << queue.meanOccupancy() << " de "
+        << queue.capacity << " (máxima " << queue.max_occupancy << "), " << queue.items
+        << " elementos, llena " << queue.full_waits << " veces, vacía " << queue.empty_waits
+        << " veces\n";
+}
+
+void writePipelineStats(std::ostream& out, const PipelineStats& stats) noexcept {
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(1);
+    writeStage(out, "escáner", stats.scanner, stats.total_ms);
+    writeStage(out, "parser", stats.parser, stats.total_ms);
+    writeStage(out, "emisor", stats.emitter, stats.total_ms);
+    out << "  de ellos " << stats.analysis_ms << " ms tras el fin de la entrada (verificaciones del programa completo)\n";
+    std::string tokens = "tokens (lotes de " + std::to_string(TOKEN_BATCH_SIZE) + ")";
+    writeQueue(out, tokens.c_str(), stats.tokens);
+    writeQueue(out, "instrucciones", stats.instructions);
+    if (stats.notes.notes > 0) {
+        writeNotePoolStats(out, stats.notes);
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "expression.hpp"
+#include "spsc_queue.hpp"
+#include "syntax_error.hpp"
+#include "../AST/note_pool.hpp"
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Tiempo de una etapa: trabajando y esperando a sus colas (vacía la de
+// entrada o llena la de salida)
+struct PipelineStageStats {
+    double busy_ms{0.0};
+    double wait_ms{0.0};
+};
+
+struct PipelineStats {
+    double total_ms{0.0};
+    PipelineStageStats scanner;
+    PipelineStageStats parser;
+    PipelineStageStats emitter;
+    double analysis_ms{0.0};   // parte del emisor tras el fin de la entrada (lo que necesita el programa completo)
+    QueueStats tokens;         // lotes de tokens, del escáner al parser
+    QueueStats instructions;   // instrucciones, del parser al emisor
+    NotePoolStats notes;       // nodos de nota compartidos, si se pidió la traducción
+};
+
+struct PipelineResult {
+    // Instrucciones analizadas, siempre (con errores, solo las válidas)
+    Program* program{nullptr};
+    std::vector<SyntaxError> syntax_errors;
+
+    // Solo si se pidió la traducción: si el programa es válido, el ABC; si
+    // no, los mensajes semánticos tal como el programa principal los escribe
+    bool valid{false};
+    std::string abc;
+    std::string semantic_errors;
+
+    PipelineStats stats;
+};
+
+// Compilación segmentada de una sola entrada: las fases se solapan en lugar
+// de dividir el archivo. El escáner (un hilo) empuja lotes de tokens de
+// tamaño fijo a una cola sin bloqueos de un productor y un consumidor; el
+// parser descendente (otro hilo) los consume y empuja cada instrucción de
+// nivel superior a una segunda cola; el emisor (el hilo que llama) arma el
+// Program y, si emit, traduce cada instrucción al AST, la verifica y la
+// escribe en ABC a medida que llega (la tabla de símbolos, el mapa de tempo
+// y la transposición avanzan con cada sentencia). Al final quedan solo las
+// verificaciones que necesitan el programa completo: las declaraciones
+// obligatorias, la rejilla y la alineación de las voces y el rango de la
+// transposición; con voces, también su ABC. Si aparece una declaración
+// después de las notas, el programa se analiza completo al final. El árbol,
+// los errores y el ABC son los mismos que con el parser descendente secuencial.
+void compilePipelined(const char* buffer, std::size_t length, int semitones, bool emit,
+                      PipelineResult& result) noexcept;
+
+// Escribe la ocupación de cada etapa y de cada cola, para ver dónde se
+// detiene la tubería (modo --pipeline --tiempo del programa principal)
+void writePipelineStats(std::ostream& out, const PipelineStats& stats) noexcept;
@@ -0,0 +1,158 @@
+#include "protocol.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Tamaño inicial del buffer de un FrameReader
+static constexpr std::size_t initial_size = 64 * 1024;
+
+// Implementación de FrameReader
+FrameReader::FrameReader(int fd) noexcept : fd{fd}, buffer(initial_size) {}
+
+bool FrameReader::fill() noexcept {
+    // Mover los datos pendientes al inicio antes de leer más. Un mensaje
+    // grande agranda el buffer de una vez; al vaciarse vuelve al tamaño inicial
+    if (begin > 0) {
+        std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+    }
+    if (end == 0 && wanted == 0 && buffer.size() > initial_size) {
+        buffer.resize(initial_size);
+        buffer.shrink_to_fit();
+    }
+    if (end == buffer.size() || wanted > buffer.size()) {
+        buffer.resize(std::max(buffer.size() * 2, wanted));
+    }
+
+    for (;;) {
+        ssize_t count = ::read(fd, buffer.data() + end, buffer.size() - end);
+        if (count > 0) {
+            end += static_cast<std::size_t>(count);
+            return true;
+        }
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        // Sin bloqueo y sin datos todavía: la conexión sigue abierta
+        return count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+}
+
+FrameStatus FrameReader::take(int& code, std::string& body) noexcept {
+    // Cabecera: hasta el primer salto de línea
+    const char* first = buffer.data() + begin;
+    const char* newline = static_cast<const char*>(std::memchr(first, '\n', end - begin));
+    if (newline == nullptr) {
+        return (end - begin > 64) ? FrameStatus::MALFORMED : FrameStatus::INCOMPLETE;
+    }
+
+    std::string header(first, newline);
+    char* rest;
+    long parsed_code = std::strtol(header.c_str(), &rest, 10);
+    if (rest == header.c_str() || *rest != ' ') {
+        return FrameStatus::MALFORMED;
+    }
+    char* size_end;
+    unsigned long long size = std::strtoull(rest + 1, &size_end, 10);
+    if (size_end == rest + 1 || *size_end != '\0' || size > max_frame_size) {
+        return FrameStatus::MALFORMED;
+    }
+
+    // Cuerpo: el mensaje queda en el buffer hasta estar completo
+    std::size_t header_length = static_cast<std::size_t>(newline - first) + 1;
+    if (end - begin - header_length < size) {
+        wanted = header_length + size;
+        return FrameStatus::INCOMPLETE;
+    }
+    code = static_cast<int>(parsed_code);
+    body.assign(newline + 1, size);
+    begin += header_length + size;
+    wanted = 0;
+    return FrameStatus::COMPLETE;
+}
+
+bool FrameReader::read(int& code, std::string& body) noexcept {
+    for (;;) {
+        FrameStatus status = take(code, body);
+        if (status != FrameStatus::INCOMPLETE) {
+            return status == FrameStatus::COMPLETE;
+        }
+        if (!fill()) {
+            return false;
+        }
+    }
+}
+
+bool writeFrame(int fd, int code, const std::string& body) noexcept {
+    char header[48];
+    int header_length = std::snprintf(header, sizeof header, "%d %zu\n", code, body.size());
+
+    // Cabecera y cuerpo en una sola llamada mientras sea posible
+    iovec parts[2] = {
+        {header, static_cast<std::size_t>(header_length)},
+        {const_cast<char*>(body.data()), body.size()},
+    };
+    iovec* part = parts;
+    int remaining = 2;
+    while (remaining > 0) {
+        ssize_t written = ::writev(fd, part, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        std::size_t count = static_cast<std::size_t>(written);
+        while (remaining > 0 && count >= part->iov_len) {
+            count -= part->iov_len;
+            ++part;
+            --remaining;
+        }
+        if (remaining > 0) {
+            part->iov_base = static_cast<char*>(part->iov_base) + count;
+            part->iov_len -= count;
+        }
+    }
+    return true;
+}
+
+// Implementación de FrameWriter
+FrameWriter::FrameWriter(int fd) noexcept : fd{fd} {}
+
+void FrameWriter::add(int code, const std::string& body) noexcept {
+    char header[48];
+    int header_length = std::snprintf(header, sizeof header, "%d %zu\n", code, body.size());
+    buffer.append(header, static_cast<std::size_t>(header_length));
+    buffer += body;
+}
+
+bool FrameWriter::flush() noexcept {
+    while (begin < buffer.size()) {
+        ssize_t written = ::write(fd, buffer.data() + begin, buffer.size() - begin);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        begin += static_cast<std::size_t>(written);
+    }
+
+    // Todo escrito: una respuesta grande no deja el buffer tomado
+    buffer.clear();
+    begin = 0;
+    if (buffer.capacity() > initial_size) {
+        buffer.shrink_to_fit();
+    }
+    return true;
+}
+
+bool FrameWriter::pending() const noexcept {
+    return begin < buffer.size();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Protocolo del servidor de compilación. Cada mensaje es una cabecera de
+// texto "<código> <bytes>\n" seguida de exactamente <bytes> bytes de cuerpo.
+// En una petición el código son los semitonos a transponer y el cuerpo la
+// partitura (.mus); en una respuesta el código es 0 si el cuerpo es el ABC
+// compilado y 1 si son los mensajes de error. Una conexión puede enviar
+// cualquier cantidad de peticiones, que se responden en orden.
+
+// Tamaño máximo de un cuerpo; una cabecera mayor se trata como mal formada
+constexpr std::size_t max_frame_size = 64u << 20;
+
+// Resultado de extraer un mensaje de lo que ya se leyó
+enum class FrameStatus { COMPLETE, INCOMPLETE, MALFORMED };
+
+// Lector de mensajes sobre un descriptor (socket o tubería), con su propio
+// buffer para no leer la cabecera de a un byte
+class FrameReader {
+public:
+    explicit FrameReader(int fd) noexcept;
+
+    // Lee el siguiente mensaje. Devuelve false al fin de la entrada, ante un
+    // error de lectura o ante una cabecera mal formada.
+    bool read(int& code, std::string& body) noexcept;
+
+    // Para esperar con poll: fill lee una vez lo que haya (en un descriptor
+    // que bloquea, espera si no hay nada) y devuelve false al fin de la
+    // entrada o ante un error; take extrae el siguiente mensaje si ya está
+    // completo, sin leer
+    bool fill() noexcept;
+    FrameStatus take(int& code, std::string& body) noexcept;
+
+private:
+    int fd;
+    std::vector<char> buffer;
+    std::size_t begin{0};
+    std::size_t end{0};
+    std::size_t wanted{0};   // Bytes del mensaje incompleto, si ya se leyó su cabecera
+};
+
+// Escribe un mensaje completo; false si el otro extremo cerró la conexión
+bool writeFrame(int fd, int code, const std::string& body) noexcept;
+
+// Escritor de mensajes sobre un descriptor que no bloquea (O_NONBLOCK): add
+// arma el mensaje en su buffer y flush escribe lo que el descriptor acepte,
+// así que un cliente que no lee no detiene a quien escribe
+class FrameWriter {
+public:
+    explicit FrameWriter(int fd) noexcept;
+
+    void add(int code, const std::string& body) noexcept;
+
+    // Escribe lo pendiente sin bloquear. Devuelve false si el otro extremo
+    // cerró la conexión o hubo un error; pending indica si quedó algo
+    bool flush() noexcept;
+    bool pending() const noexcept;
+
+private:
+    int fd;
+    std::string buffer;
+    std::size_t begin{0};   // Bytes de buffer ya escritos
+};
@@ -0,0 +1,456 @@
+#include "recursive_descent.hpp"
+
+// Requerido para usar el mismo YYSTYPE que el parser
+#define YYSTYPE Expression*
+#include "token.h"
+#include "../AST/music_rules.hpp"
+
+// Nombre de un token en los mensajes de error, igual que en Bison
+static std::string tokenName(int token) {
+    switch (token) {
+        case YYEOF: return "end of file";
+        case TOKEN_COMENTARIO: return "TOKEN_COMENTARIO";
+        case TOKEN_TONALIDAD: return "TOKEN_TONALIDAD";
+        case TOKEN_TEMPO: return "TOKEN_TEMPO";
+        case TOKEN_COMPAS: return "TOKEN_COMPAS";
+        case TOKEN_BLANCA: return "TOKEN_BLANCA";
+        case TOKEN_NEGRA: return "TOKEN_NEGRA";
+        case TOKEN_CORCHEA: return "TOKEN_CORCHEA";
+        case TOKEN_SEMICORCHEA: return "TOKEN_SEMICORCHEA";
+        case TOKEN_MAYOR: return "TOKEN_MAYOR";
+        case TOKEN_MENOR: return "TOKEN_MENOR";
+        case TOKEN_NUMERO: return "TOKEN_NUMERO";
+        case TOKEN_BARRA: return "TOKEN_BARRA";
+        case TOKEN_NOTA_DO: return "TOKEN_NOTA_DO";
+        case TOKEN_NOTA_RE: return "TOKEN_NOTA_RE";
+        case TOKEN_NOTA_MI: return "TOKEN_NOTA_MI";
+        case TOKEN_NOTA_FA: return "TOKEN_NOTA_FA";
+        case TOKEN_NOTA_SOL: return "TOKEN_NOTA_SOL";
+        case TOKEN_NOTA_LA: return "TOKEN_NOTA_LA";
+        case TOKEN_NOTA_SI: return "TOKEN_NOTA_SI";
+        case TOKEN_SOSTENIDO: return "TOKEN_SOSTENIDO";
+        case TOKEN_BEMOL: return "TOKEN_BEMOL";
+        case TOKEN_NOTA_COMPLETA: return "TOKEN_NOTA_COMPLETA";
+        case TOKEN_IDENTIFIER: return "TOKEN_IDENTIFIER";
+        case TOKEN_VOZ: return "TOKEN_VOZ";
+        case TOKEN_REPETIR: return "TOKEN_REPETIR";
+        case TOKEN_LLAVE_ABRE: return "TOKEN_LLAVE_ABRE";
+        case TOKEN_LLAVE_CIERRA: return "TOKEN_LLAVE_CIERRA";
+        case TOKEN_MOTIVO: return "TOKEN_MOTIVO";
+        case TOKEN_TRANSPONER: return "TOKEN_TRANSPONER";
+        case TOKEN_CORCHETE_ABRE: return "TOKEN_CORCHETE_ABRE";
+        case TOKEN_CORCHETE_CIERRA: return "TOKEN_CORCHETE_CIERRA";
+        default: return "invalid token";
+    }
+}
+
+// Nombre de la nota base de la tonalidad, o vacío si el token no es una nota base
+static std::string baseNoteName(int token) {
+    switch (token) {
+        case TOKEN_NOTA_DO: return "Do";
+        case TOKEN_NOTA_RE: return "Re";
+        case TOKEN_NOTA_MI: return "Mi";
+        case TOKEN_NOTA_FA: return "Fa";
+        case TOKEN_NOTA_SOL: return "Sol";
+        case TOKEN_NOTA_LA: return "La";
+        case TOKEN_NOTA_SI: return "Si";
+        default: return "";
+    }
+}
+
+// Implementación de RecursiveDescentParser
+RecursiveDescentParser::RecursiveDescentParser(TokenSource& source, std::vector<SyntaxError>& errors) noexcept
+    : source{source}, errors{errors} {}
+
+void RecursiveDescentParser::start(bool at_program_start) noexcept {
+    first_instruction = at_program_start;
+    advance();
+}
+
+bool RecursiveDescentParser::atEnd() const noexcept {
+    return token == YYEOF;
+}
+
+Program* RecursiveDescentParser::parse() noexcept {
+    std::vector<Expression*> instructions;
+    start();
+    parseInto(instructions);
+
+    Program* program = new Program();
+    for (auto instruction : instructions) {
+        program->addInstruction(instruction);
+    }
+    return program;
+}
+
+void RecursiveDescentParser::parseInto(std::vector<Expression*>& instructions,
+                                       std::vector<InstructionLocation>* locations) noexcept {
+    parseInto([&](Expression* instruction, const InstructionLocation& location) {
+        instructions.push_back(instruction);
+        if (locations != nullptr) {
+            locations->push_back(location);
+        }
+    });
+}
+
+void RecursiveDescentParser::parseInto(
+    const std::function<void(Expression*, const InstructionLocation&)>& consume) noexcept {
+    // Una entrada vacía es un error, como en la gramática (programa : instruccion).
+    // Hay cinco instrucciones posibles: Bison no las enumera
+    if (first_instruction && atEnd()) {
+        unexpected({});
+    }
+
+    while (!atEnd() && !source.atBoundary()) {
+        // Una llave de cierre sin bloque abierto se reporta y se descarta
+        // (elemento : TOKEN_LLAVE_CIERRA)
+        if (token == TOKEN_LLAVE_CIERRA) {
+            recordSyntaxError(errors, line, column, "syntax error, unexpected TOKEN_LLAVE_CIERRA");
+            advance();
+            first_instruction = false;
+            continue;
+        }
+
+        InstructionLocation location{line, column};
+        Expression* instruction = parseInstruction();
+        if (instruction != nullptr) {
+            consume(instruction, location);
+        }
+    }
+}
+
+Expression* RecursiveDescentParser::parseInstruction() noexcept {
+    Expression* instruction = nullptr;
+
+    switch (token) {
+        case TOKEN_TEMPO: instruction = parseTempo(); break;
+        case TOKEN_COMPAS: instruction = parseTimeSignature(); break;
+        case TOKEN_TONALIDAD: instruction = parseKey(); break;
+        case TOKEN_TRANSPONER: instruction = parseTranspose(); break;
+        case TOKEN_VOZ: instruction = parseVoice(); break;
+        case TOKEN_NOTA_COMPLETA: instruction = parseNote(); break;
+        case TOKEN_CORCHETE_ABRE: instruction = parseChord(); break;
+        case TOKEN_REPETIR: instruction = parseRepeat(); break;
+        case TOKEN_MOTIVO: instruction = parseMotif(); break;
+        case TOKEN_IDENTIFIER: instruction = parseMotifReference(); break;
+        default:
+            // Diez inicios de instrucción posibles, más la llave de cierre:
+            // Bison no los enumera
+            unexpected({});
+            synchronize();
+            break;
+    }
+
+    first_instruction = false;
+    return instruction;
+}
+
+// tempo : TOKEN_TEMPO numero
+Expression* RecursiveDescentParser::parseTempo() noexcept {
+    advance();
+    if (token != TOKEN_NUMERO) {
+        unexpected({TOKEN_NUMERO});
+        synchronize();
+        return nullptr;
+    }
+
+    Expression* tempo = new Tempo(new Number(numberValue(source.getText())));
+    advance();
+    return tempo;
+}
+
+// transposicion : TOKEN_TRANSPONER numero
+Expression* RecursiveDescentParser::parseTranspose() noexcept {
+    advance();
+    if (token != TOKEN_NUMERO) {
+        unexpected({TOKEN_NUMERO});
+        synchronize();
+        return nullptr;
+    }
+
+    Expression* transpose = new Transpose(new Number(numberValue(source.getText())));
+    advance();
+    return transpose;
+}
+
+// compas : TOKEN_COMPAS numero TOKEN_BARRA numero
+Expression* RecursiveDescentParser::parseTimeSignature() noexcept {
+    advance();
+    if (token != TOKEN_NUMERO) {
+        unexpected({TOKEN_NUMERO});
+        synchronize();
+        return nullptr;
+    }
+    int numerator = numberValue(source.getText());
+
+    advance();
+    if (token != TOKEN_BARRA) {
+        unexpected({TOKEN_BARRA});
+        synchronize();
+        return nullptr;
+    }
+
+    advance();
+    if (token != TOKEN_NUMERO) {
+        unexpected({TOKEN_NUMERO});
+        synchronize();
+        return nullptr;
+    }
+    int denominator = numberValue(source.getText());
+    advance();
+
+    return new TimeSignature(new Number(numerator), new Number(denominator));
+}
+
+// tonalidad : TOKEN_TONALIDAD (nota_base | nota_alterada) (TOKEN_MAYOR | TOKEN_MENOR)
+Expression* RecursiveDescentParser::parseKey() noexcept {
+    advance();
+    std::string note = baseNoteName(token);
+    if (note.empty()) {
+        // Siete notas base posibles: Bison no las enumera
+        unexpected({});
+        synchronize();
+        return nullptr;
+    }
+
+    advance();
+    if (token == TOKEN_SOSTENIDO || token == TOKEN_BEMOL) {
+        note += (token == TOKEN_SOSTENIDO) ? "#" : "b";
+        advance();
+        if (token != TOKEN_MAYOR && token != TOKEN_MENOR) {
+            unexpected({TOKEN_MAYOR, TOKEN_MENOR});
+            synchronize();
+            return nullptr;
+        }
+    } else if (token != TOKEN_MAYOR && token != TOKEN_MENOR) {
+        unexpected({TOKEN_MAYOR, TOKEN_MENOR, TOKEN_SOSTENIDO, TOKEN_BEMOL});
+        synchronize();
+        return nullptr;
+    }
+
+    Key::KeyType type = (token == TOKEN_MAYOR) ? Key::KeyType::MAJOR : Key::KeyType::MINOR;
+    advance();
+    return new Key(note, type);
+}
+
+// voz : TOKEN_VOZ TOKEN_IDENTIFIER
+Expression* RecursiveDescentParser::parseVoice() noexcept {
+    advance();
+    if (token != TOKEN_IDENTIFIER) {
+        unexpected({TOKEN_IDENTIFIER});
+        synchronize();
+        return nullptr;
+    }
+
+    Expression* voice = new Voice(source.getText());
+    advance();
+    return voice;
+}
+
+// repeticion : TOKEN_REPETIR numero TOKEN_LLAVE_ABRE cuerpo TOKEN_LLAVE_CIERRA
+Expression* RecursiveDescentParser::parseRepeat() noexcept {
+    advance();
+    if (token != TOKEN_NUMERO) {
+        unexpected({TOKEN_NUMERO});
+        synchronize();
+        return nullptr;
+    }
+    Number* count = new Number(numberValue(source.getText()));
+
+    advance();
+    if (token != TOKEN_LLAVE_ABRE) {
+        unexpected({TOKEN_LLAVE_ABRE});
+        synchronize();
+        count->destroy();
+        return nullptr;
+    }
+
+    Block* body = parseBlock();
+    if (body == nullptr) {
+        count->destroy();
+        return nullptr;
+    }
+    return new Repeat(count, body);
+}
+
+// motivo : TOKEN_MOTIVO TOKEN_IDENTIFIER TOKEN_LLAVE_ABRE cuerpo TOKEN_LLAVE_CIERRA
+Expression* RecursiveDescentParser::parseMotif() noexcept {
+    advance();
+    if (token != TOKEN_IDENTIFIER) {
+        unexpected({TOKEN_IDENTIFIER});
+        synchronize();
+        return nullptr;
+    }
+    std::string name = source.getText();
+
+    advance();
+    if (token != TOKEN_LLAVE_ABRE) {
+        unexpected({TOKEN_LLAVE_ABRE});
+        synchronize();
+        return nullptr;
+    }
+
+    Block* body = parseBlock();
+    if (body == nullptr) {
+        return nullptr;
+    }
+    return new Motif(name, body);
+}
+
+// referencia : TOKEN_IDENTIFIER
+Expression* RecursiveDescentParser::parseMotifReference() noexcept {
+    Expression* reference = new MotifReference(source.getText());
+    advance();
+    return reference;
+}
+
+// cuerpo : (nota | acorde | repeticion | motivo | referencia)*, a partir de TOKEN_LLAVE_ABRE
+Block* RecursiveDescentParser::parseBlock() noexcept {
+    if (block_depth == MAX_BLOCK_DEPTH) {
+        skipNestedBlock();
+        return nullptr;
+    }
+    advance();
+
+    Block* body = new Block();
+    ++block_depth;
+    while (token != TOKEN_LLAVE_CIERRA) {
+        if (token == TOKEN_NOTA_COMPLETA) {
+            body->addInstruction(parseNote());
+        } else if (token == TOKEN_CORCHETE_ABRE) {
+            body->addInstruction(parseChord());
+        } else if (token == TOKEN_REPETIR) {
+            body->addInstruction(parseRepeat());
+        } else if (token == TOKEN_MOTIVO) {
+            body->addInstruction(parseMotif());
+        } else if (token == TOKEN_IDENTIFIER) {
+            body->addInstruction(parseMotifReference());
+        } else {
+            // Cinco inicios de instrucción posibles, más la llave de cierre:
+            // Bison no los enumera
+            unexpected({});
+
+            // Un bloque sin cerrar al final del archivo termina el análisis, como en Bison
+            if (atEnd()) {
+                --block_depth;
+                body->destroy();
+                return nullptr;
+            }
+            synchronize();
+        }
+    }
+    --block_depth;
+    advance();
+
+    return body;
+}
+
+// Un bloque más profundo que MAX_BLOCK_DEPTH agotaría la pila (aquí y en el
+// análisis): se reporta en su llave de apertura y se descarta, sin
+// recursión, hasta la llave que lo cierra
+void RecursiveDescentParser::skipNestedBlock() noexcept {
+    errors.push_back({line, column, "Bloques anidados demasiado profundos (más de " +
+                                        std::to_string(MAX_BLOCK_DEPTH) + ")"});
+    int open = 0;
+    do {
+        if (token == TOKEN_LLAVE_ABRE) {
+            ++open;
+        } else if (token == TOKEN_LLAVE_CIERRA) {
+            --open;
+        }
+        advance();
+    } while (open > 0 && token != YYEOF);
+
+    // Sin cerrar al final del archivo, igual que un bloque abierto
+    if (open > 0) {
+        unexpected({});
+    }
+}
+
+// nota : TOKEN_NOTA_COMPLETA (TOKEN_BLANCA | TOKEN_NEGRA | TOKEN_CORCHEA | TOKEN_SEMICORCHEA)
+Expression* RecursiveDescentParser::parseNote() noexcept {
+    std::string full_note = source.getText();
+    advance();
+
+    Duration duration;
+    switch (token) {
+        case TOKEN_BLANCA: duration = Duration::BLANCA; break;
+        case TOKEN_NEGRA: duration = Duration::NEGRA; break;
+        case TOKEN_CORCHEA: duration = Duration::CORCHEA; break;
+        case TOKEN_SEMICORCHEA: duration = Duration::SEMICORCHEA; break;
+        default:
+            unexpected({TOKEN_BLANCA, TOKEN_NEGRA, TOKEN_CORCHEA, TOKEN_SEMICORCHEA});
+            synchronize();
+            return nullptr;
+    }
+    advance();
+
+    return new Note(extraer_nombre_nota(full_note.c_str()), extraer_octava(full_note.c_str()), duration);
+}
+
+// acorde : TOKEN_CORCHETE_ABRE TOKEN_NOTA_COMPLETA+ TOKEN_CORCHETE_CIERRA
+//          (TOKEN_BLANCA | TOKEN_NEGRA | TOKEN_CORCHEA | TOKEN_SEMICORCHEA)
+Expression* RecursiveDescentParser::parseChord() noexcept {
+    advance();
+    if (token != TOKEN_NOTA_COMPLETA) {
+        unexpected({TOKEN_NOTA_COMPLETA});
+        synchronize();
+        return nullptr;
+    }
+
+    Chord* chord = new Chord();
+    while (token == TOKEN_NOTA_COMPLETA) {
+        std::string full_note = source.getText();
+        chord->addNote(extraer_nombre_nota(full_note.c_str()), extraer_octava(full_note.c_str()));
+        advance();
+    }
+    if (token != TOKEN_CORCHETE_CIERRA) {
+        unexpected({TOKEN_NOTA_COMPLETA, TOKEN_CORCHETE_CIERRA});
+        synchronize();
+        chord->destroy();
+        return nullptr;
+    }
+
+    advance();
+    switch (token) {
+        case TOKEN_BLANCA: chord->setDuration(Duration::BLANCA); break;
+        case TOKEN_NEGRA: chord->setDuration(Duration::NEGRA); break;
+        case TOKEN_CORCHEA: chord->setDuration(Duration::CORCHEA); break;
+        case TOKEN_SEMICORCHEA: chord->setDuration(Duration::SEMICORCHEA); break;
+        default:
+            unexpected({TOKEN_BLANCA, TOKEN_NEGRA, TOKEN_CORCHEA, TOKEN_SEMICORCHEA});
+            synchronize();
+            chord->destroy();
+            return nullptr;
+    }
+    advance();
+
+    return chord;
+}
+
+void RecursiveDescentParser::advance() noexcept {
+    previous_token = token;
+    previous_line = line;
+    previous_last_column = last_column;
+
+    token = source.next();
+    line = source.getLine();
+    column = source.getColumn();
+    last_column = source.getLastColumn();
+}
+
+void RecursiveDescentParser::unexpected(const std::vector<int>& expected) noexcept {
+    std::string message = "syntax error, unexpected " + tokenName(token);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        message += (i == 0 ? ", expecting " : " or ") + tokenName(expected[i]);
+    }
+    recordUnexpectedToken(errors, line, column, previous_token, previous_line,
+                          previous_last_column, message);
+}
+
+void RecursiveDescentParser::synchronize() noexcept {
+    bool keep = (block_depth > 0) ? isBodyInstructionStart(token) : isInstructionStart(token);
+    if (token != YYEOF && token != TOKEN_LLAVE_CIERRA && !keep) {
+        advance();
+    }
+}
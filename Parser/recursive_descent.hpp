@@ -0,0 +1,114 @@
+#pragma once
+
+#include "expression.hpp"
+#include "syntax_error.hpp"
+#include <functional>
+#include <string>
+#include <vector>
+
+// Ubicación del primer token de una instrucción (línea y columna desde 1)
+struct InstructionLocation {
+    int line;
+    int column;
+};
+
+// Fuente de tokens para el parser descendente recursivo
+class TokenSource {
+public:
+    virtual ~TokenSource() = default;
+
+    // Avanza al siguiente token; los errores léxicos los reporta la fuente
+    virtual int next() noexcept = 0;
+
+    // Lexema y ubicación del último token devuelto por next()
+    virtual const char* getText() const noexcept = 0;
+    virtual int getLine() const noexcept = 0;
+    virtual int getColumn() const noexcept = 0;
+    virtual int getLastColumn() const noexcept = 0;
+
+    // Indica que el token actual ya pertenece a otro fragmento de la entrada
+    // (ver parallel_front_end.hpp); una fuente sobre la entrada completa nunca lo hace
+    virtual bool atBoundary() const noexcept {
+        return false;
+    }
+};
+
+// Fuente de tokens sobre el escáner global (yylex, yytext y yylloc),
+// el mismo que alimenta al parser generado por Bison
+class GlobalTokenSource : public TokenSource {
+public:
+    int next() noexcept override;
+    const char* getText() const noexcept override;
+    int getLine() const noexcept override;
+    int getColumn() const noexcept override;
+    int getLastColumn() const noexcept override;
+};
+
+// Parser descendente recursivo para la gramática de parser.bison. Construye
+// el mismo árbol (Program) y reporta los mismos errores, con la misma
+// recuperación, pero sin tablas LALR ni pila de valores: cada instrucción se
+// reconoce mirando un solo token.
+class RecursiveDescentParser {
+public:
+    RecursiveDescentParser(TokenSource& source, std::vector<SyntaxError>& errors) noexcept;
+
+    // Analiza la entrada completa. Siempre devuelve un Program con las
+    // instrucciones válidas; los errores quedan en el vector recibido.
+    Program* parse() noexcept;
+
+    // Lee el primer token. at_program_start indica si la entrada comienza el
+    // programa (falso para los fragmentos que continúan uno anterior)
+    void start(bool at_program_start = true) noexcept;
+
+    // Analiza instrucciones hasta el fin de la entrada o del fragmento. Si
+    // recibe locations, agrega la ubicación de cada instrucción agregada.
+    void parseInto(std::vector<Expression*>& instructions,
+                   std::vector<InstructionLocation>* locations = nullptr) noexcept;
+
+    // Igual que la anterior, pero entrega cada instrucción a consume a medida
+    // que se reconoce, para procesarla mientras se analiza el resto
+    void parseInto(const std::function<void(Expression*, const InstructionLocation&)>& consume) noexcept;
+
+    // Analiza una sola instrucción a partir del token actual (nullptr si hubo error)
+    Expression* parseInstruction() noexcept;
+
+    bool atEnd() const noexcept;
+
+private:
+    Expression* parseTempo() noexcept;
+    Expression* parseTimeSignature() noexcept;
+    Expression* parseKey() noexcept;
+    Expression* parseTranspose() noexcept;
+    Expression* parseVoice() noexcept;
+    Expression* parseRepeat() noexcept;
+    Expression* parseMotif() noexcept;
+    Expression* parseMotifReference() noexcept;
+    Block* parseBlock() noexcept;
+    void skipNestedBlock() noexcept;
+    Expression* parseNote() noexcept;
+    Expression* parseChord() noexcept;
+
+    void advance() noexcept;
+
+    // Reporta el token actual como inesperado; expected lista los tokens
+    // esperados en el formato de Bison (vacío si son más de cuatro)
+    void unexpected(const std::vector<int>& expected) noexcept;
+
+    // Descarta el token inesperado salvo que inicie una instrucción (del
+    // bloque actual, si hay uno abierto), cierre un bloque o sea el fin
+    void synchronize() noexcept;
+
+    TokenSource& source;
+    std::vector<SyntaxError>& errors;
+    bool first_instruction{true};
+    int block_depth{0};
+
+    int token{0};
+    int line{0};
+    int column{0};
+
+    int previous_token{0};
+    int previous_line{0};
+    int previous_last_column{0};
+    int last_column{0};
+};
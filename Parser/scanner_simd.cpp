@@ -0,0 +1,69 @@
+// Interfaz compatible con Flex (yylex, yytext, yylineno, yyin, yylloc) sobre
+// el escáner escrito a mano de Scanner/fast_scanner.c. Se enlaza en lugar de
+// scanner.o cuando se compila con SCANNER=simd.
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "expression.hpp"
+#include "token.h"
+#include "../Scanner/fast_scanner.h"
+
+FILE* yyin{nullptr};
+char* yytext{nullptr};
+int yyleng{0};
+int yylineno{1};
+
+extern int yyerror(const char* msg);
+
+static fast_scanner_t scanner;
+static std::vector<char> input;
+static bool input_loaded{false};
+static std::vector<char> text_buffer(64);
+
+// Lee la entrada completa a memoria: el escáner trabaja sobre un solo buffer
+static void load_input() {
+    FILE* file = (yyin != nullptr) ? yyin : stdin;
+    char chunk[1 << 16];
+    size_t read;
+
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        input.insert(input.end(), chunk, chunk + read);
+    }
+    fast_scanner_init(&scanner, input.data(), input.size(), 1);
+    input_loaded = true;
+}
+
+// Copia el lexema actual a yytext y su ubicación a yylloc
+static void update_token() {
+    if (scanner.length + 1 > text_buffer.size()) {
+        text_buffer.resize((scanner.length + 1) * 2);
+    }
+    std::memcpy(text_buffer.data(), scanner.text, scanner.length);
+    text_buffer[scanner.length] = '\0';
+    yytext = text_buffer.data();
+    yyleng = static_cast<int>(scanner.length);
+    yylineno = scanner.token_line;
+
+    yylloc.first_line = yylloc.last_line = scanner.token_line;
+    yylloc.first_column = scanner.token_column;
+    yylloc.last_column = scanner.token_column + static_cast<int>(scanner.length) - 1;
+}
+
+int yylex() {
+    if (!input_loaded) {
+        load_input();
+    }
+
+    for (;;) {
+        int token = fast_scanner_next(&scanner);
+        update_token();
+
+        if (token != FAST_SCANNER_ERROR) {
+            return token;
+        }
+
+        char msg[100];
+        snprintf(msg, sizeof(msg), "Carácter no reconocido: %s", yytext);
+        yyerror(msg);
+    }
+}
@@ -0,0 +1,831 @@
+#include "score_document.hpp"
+#include "lowering.hpp"
+#include "parallel_front_end.hpp"
+#include "../AST/declaration.hpp"
+#include "../AST/note_pool.hpp"
+#include "../AST/statement.hpp"
+#include "../AST/voice.hpp"
+#include "../Semantic_Analysis/symbol_table.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <tuple>
+
+// Requerido para usar el mismo YYSTYPE que el parser
+#define YYSTYPE Expression*
+#include "token.h"
+
+// Cantidad de corcheas, sin decimales si es entera (las duraciones son
+// múltiplos de media corchea)
+static std::string beatsToString(double beats) noexcept {
+    char text[32];
+    if (beats == std::floor(beats)) {
+        std::snprintf(text, sizeof(text), "%.0f", beats);
+    } else {
+        std::snprintf(text, sizeof(text), "%.1f", beats);
+    }
+    return text;
+}
+
+static bool locationBefore(const SourceLocation& a, const SourceLocation& b) noexcept {
+    return a.line < b.line || (a.line == b.line && a.column < b.column);
+}
+
+// Si dos mapas tienen los mismos tramos y las mismas barras (los segundos no
+// intervienen en la rejilla de compases)
+static bool sameBarGrid(const TempoMap& a, const TempoMap& b) noexcept {
+    const auto& first = a.get_segments();
+    const auto& second = b.get_segments();
+    return std::equal(first.begin(), first.end(), second.begin(), second.end(),
+                      [](const TempoSegment& x, const TempoSegment& y) {
+                          return x.tick == y.tick && x.bar_ticks == y.bar_ticks && x.meter_tick == y.meter_tick &&
+                                 x.meter_measure == y.meter_measure;
+                      });
+}
+
+// Implementación de ScoreDocument
+ScoreDocument::ScoreDocument(const std::string& text) noexcept
+    : note_pool{std::make_shared<NotePool>()} {
+    replaceText(text);
+}
+
+ScoreDocument::~ScoreDocument() noexcept {
+    for (auto& segment : segments) {
+        destroySegment(segment);
+    }
+}
+
+void ScoreDocument::replaceText(const std::string& new_text) noexcept {
+    for (auto& segment : segments) {
+        destroySegment(segment);
+    }
+
+    text = new_text;
+    computeLineStarts();
+    lines.assign(line_starts.size(), LineInfo{});
+    LineNesting nesting;
+    for (std::size_t line = 0; line < lines.size(); ++line) {
+        lines[line] = scanLine(line, nesting);
+        nesting = lines[line].nesting_after;
+    }
+
+    segments = parseSegments(0, lines.size());
+    reparsed_segments = segments.size();
+    reused_segments = 0;
+    verified_segments = 0;
+    analyze();
+}
+
+void ScoreDocument::applyEdit(std::size_t start_line, std::size_t start_column,
+                              std::size_t end_line, std::size_t end_column,
+                              const std::string& new_text) noexcept {
+    // Posiciones fuera del documento se ajustan al final de la línea o del texto
+    auto clamp = [this](std::size_t& line, std::size_t& column) {
+        if (line >= lines.size()) {
+            line = lines.size() - 1;
+            column = getLine(line).size();
+        }
+        column = std::min(column, getLine(line).size());
+    };
+    clamp(start_line, start_column);
+    clamp(end_line, end_column);
+    if (end_line < start_line || (end_line == start_line && end_column < start_column)) {
+        std::swap(start_line, end_line);
+        std::swap(start_column, end_column);
+    }
+
+    std::size_t begin = line_starts[start_line] + start_column;
+    std::size_t end = line_starts[end_line] + end_column;
+    text.replace(begin, end - begin, new_text);
+
+    // Inicios de línea: se reemplazan los de las líneas editadas y se
+    // desplazan los siguientes
+    std::vector<std::size_t> inserted_starts;
+    for (std::size_t i = 0; i < new_text.size(); ++i) {
+        if (new_text[i] == '\n') {
+            inserted_starts.push_back(begin + i + 1);
+        }
+    }
+    std::size_t shift = new_text.size() - (end - begin);
+    for (std::size_t line = end_line + 1; line < line_starts.size(); ++line) {
+        line_starts[line] += shift;
+    }
+    line_starts.erase(line_starts.begin() + start_line + 1, line_starts.begin() + end_line + 1);
+    line_starts.insert(line_starts.begin() + start_line + 1, inserted_starts.begin(), inserted_starts.end());
+
+    // Volver a escanear las líneas editadas
+    std::size_t inserted = inserted_starts.size();
+    long delta = static_cast<long>(inserted) - static_cast<long>(end_line - start_line);
+    LineNesting old_nesting = lines[end_line].nesting_after;
+    lines.erase(lines.begin() + start_line, lines.begin() + end_line + 1);
+    lines.insert(lines.begin() + start_line, inserted + 1, LineInfo{});
+
+    LineNesting nesting = nestingBefore(start_line);
+    std::size_t edit_end = start_line + inserted;
+    for (std::size_t line = start_line; line <= edit_end; ++line) {
+        lines[line] = scanLine(line, nesting);
+        nesting = lines[line].nesting_after;
+    }
+
+    // y las siguientes mientras cambie el anidamiento con que comienzan
+    std::size_t last_changed = edit_end;
+    for (std::size_t line = edit_end + 1; line < lines.size() && nesting != old_nesting; ++line) {
+        old_nesting = lines[line].nesting_after;
+        lines[line] = scanLine(line, nesting);
+        nesting = lines[line].nesting_after;
+        last_changed = line;
+    }
+
+    // Segmentos afectados, en las líneas anteriores a la edición: el que
+    // contiene la primera línea editada, el anterior (su último token de
+    // lookahead está en ese segmento) y hasta el que contiene la última
+    // línea cambiada
+    std::size_t old_last = (last_changed > edit_end) ? last_changed - delta : end_line;
+    auto containing = [this](std::size_t line) {
+        auto it = std::upper_bound(segments.begin(), segments.end(), line,
+                                   [](std::size_t value, const Segment& segment) {
+                                       return value < segment.first_line;
+                                   });
+        return static_cast<std::size_t>(it - segments.begin()) - 1;
+    };
+    std::size_t first = containing(start_line);
+    if (first > 0) {
+        --first;
+    }
+    std::size_t last = containing(old_last);
+
+    std::size_t reparse_begin = segments[first].first_line;
+    std::size_t reparse_end = (last + 1 < segments.size())
+        ? segments[last + 1].first_line + delta
+        : lines.size();
+
+    for (std::size_t i = first; i <= last; ++i) {
+        destroySegment(segments[i]);
+    }
+    std::vector<Segment> parsed = parseSegments(reparse_begin, reparse_end);
+    for (std::size_t i = last + 1; i < segments.size(); ++i) {
+        segments[i].first_line += delta;
+    }
+    segments.erase(segments.begin() + first, segments.begin() + last + 1);
+    segments.insert(segments.begin() + first, std::make_move_iterator(parsed.begin()),
+                    std::make_move_iterator(parsed.end()));
+
+    // La verificación se rehace desde el primer segmento reemplazado: los
+    // siguientes se desplazaron o dependen de lo que cambió
+    reparsed_segments = parsed.size();
+    reused_segments = segments.size() - parsed.size();
+    verified_segments = std::min(verified_segments, first);
+    analyze();
+}
+
+const std::string& ScoreDocument::getText() const noexcept {
+    return text;
+}
+
+std::size_t ScoreDocument::getLineCount() const noexcept {
+    return lines.size();
+}
+
+std::string_view ScoreDocument::getLine(std::size_t line) const noexcept {
+    if (line >= line_starts.size()) {
+        return {};
+    }
+    std::size_t begin = line_starts[line];
+    std::size_t end = (line + 1 < line_starts.size()) ? line_starts[line + 1] - 1 : text.size();
+    return std::string_view{text}.substr(begin, end - begin);
+}
+
+const std::vector<CompileDiagnostic>& ScoreDocument::getDiagnostics() const noexcept {
+    return diagnostics;
+}
+
+std::string ScoreDocument::programToString() const noexcept {
+    // Program sobre las instrucciones de los segmentos, que siguen siendo de
+    // ellos: no se llama a destroy()
+    Program borrowed;
+    for (const auto& segment : segments) {
+        for (auto instruction : segment.instructions) {
+            borrowed.addInstruction(instruction);
+        }
+    }
+    return borrowed.to_string();
+}
+
+const std::vector<MeasureSymbol>& ScoreDocument::getMeasures() const noexcept {
+    return measures;
+}
+
+std::size_t ScoreDocument::getReparsedSegments() const noexcept {
+    return reparsed_segments;
+}
+
+std::size_t ScoreDocument::getReusedSegments() const noexcept {
+    return reused_segments;
+}
+
+void ScoreDocument::computeLineStarts() noexcept {
+    line_starts.assign(1, 0);
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\n') {
+            line_starts.push_back(i + 1);
+        }
+    }
+}
+
+ScoreDocument::LineInfo ScoreDocument::scanLine(std::size_t line, LineNesting nesting_before) const noexcept {
+    std::string_view content = getLine(line);
+    fast_scanner_t scanner;
+    fast_scanner_init(&scanner, content.data(), content.size(), 1);
+    int token = fast_scanner_next(&scanner);
+    return LineInfo{token, lineNesting(content.data(), 0, content.size(), nesting_before)};
+}
+
+LineNesting ScoreDocument::nestingBefore(std::size_t line) const noexcept {
+    return (line == 0) ? LineNesting{} : lines[line - 1].nesting_after;
+}
+
+bool ScoreDocument::startsSegment(std::size_t line) const noexcept {
+    return line == 0 || (nestingBefore(line).outside() && isChunkStart(lines[line].first_token));
+}
+
+std::vector<ScoreDocument::Segment> ScoreDocument::parseSegments(std::size_t first_line,
+                                                                 std::size_t end_line) const noexcept {
+    std::vector<Segment> result;
+    for (std::size_t line = first_line; line < end_line; ++line) {
+        if (line == first_line || startsSegment(line)) {
+            result.push_back(Segment{line, 0, {}, {}, {}});
+        }
+        ++result.back().line_count;
+    }
+
+    for (auto& segment : result) {
+        std::size_t next = segment.first_line + segment.line_count;
+        std::size_t begin = line_starts[segment.first_line];
+        std::size_t end = (next < line_starts.size()) ? line_starts[next] : text.size();
+
+        ChunkTokenSource source{text.data(), text.size(), begin, end, segment.errors};
+        RecursiveDescentParser parser{source, segment.errors};
+        parser.start(segment.first_line == 0);
+        parser.parseInto(segment.instructions, &segment.locations);
+    }
+    return result;
+}
+
+void ScoreDocument::destroySegment(Segment& segment) noexcept {
+    destroyLowered(segment);
+    for (auto instruction : segment.instructions) {
+        instruction->destroy();
+    }
+    segment.instructions.clear();
+}
+
+void ScoreDocument::destroyLowered(Segment& segment) noexcept {
+    for (auto& lowered : segment.lowered_instructions) {
+        if (lowered.declaration != nullptr) {
+            lowered.declaration->destroy();
+            delete lowered.declaration;
+        }
+        if (lowered.statement != nullptr) {
+            lowered.statement->destroy();
+            delete lowered.statement;
+        }
+    }
+    segment.lowered_instructions.clear();
+    segment.declarations.clear();
+    segment.voice_starts.clear();
+    segment.lowered = false;
+    segment.linked = false;
+}
+
+void ScoreDocument::lowerSegment(Segment& segment, const LoweringState& entry) noexcept {
+    destroyLowered(segment);
+    segment.lowering_entry = entry;
+    LoweringState state = entry;
+    int offset = static_cast<int>(segment.first_line);
+    for (std::size_t i = 0; i < segment.instructions.size(); ++i) {
+        SourceLocation location{segment.locations[i].line + offset, segment.locations[i].column};
+        LoweredInstruction lowered = lowerInstruction(segment.instructions[i], state, *note_pool, location);
+        if (lowered.declaration != nullptr) {
+            segment.declarations.push_back(i);
+        } else if (auto voice = dynamic_cast<const Voice*>(segment.instructions[i])) {
+            segment.voice_starts.push_back(voice->getName());
+        }
+        segment.lowered_instructions.push_back(lowered);
+    }
+    segment.lowering_exit = state;
+    segment.lowered = true;
+}
+
+std::size_t ScoreDocument::voiceTrack(const std::string& voice) const noexcept {
+    auto found = std::find(voice_names.begin(), voice_names.end(), voice);
+    return static_cast<std::size_t>(found - voice_names.begin()) + 1;
+}
+
+std::size_t ScoreDocument::entryTrack(const Segment& segment) const noexcept {
+    return segment.lowering_entry.voice.empty() ? 0 : voiceTrack(segment.lowering_entry.voice);
+}
+
+void ScoreDocument::analyze() noexcept {
+    diagnostics.clear();
+
+    // Errores sintácticos con líneas absolutas (a lo sumo uno por línea)
+    std::vector<SyntaxError> syntax_errors;
+    for (const auto& segment : segments) {
+        int offset = static_cast<int>(segment.first_line);
+        for (const auto& error : segment.errors) {
+            recordSyntaxError(syntax_errors, error.line + offset, error.column, error.message);
+        }
+    }
+    for (auto& error : syntax_errors) {
+        diagnostics.push_back({CompileDiagnostic::Phase::SYNTAX, error.line, error.column,
+                               std::move(error.message)});
+    }
+
+    // Traducción al AST: solo los segmentos nuevos y aquellos a los que la
+    // traducción llega en otro estado (si antes aparece un "Tempo", el del
+    // segmento pasa a ser un cambio). La verificación se retoma en el primero
+    std::size_t first = verified_segments;
+    LoweringState state;
+    for (std::size_t i = 0; i < segments.size(); ++i) {
+        if (!segments[i].lowered || segments[i].lowering_entry != state) {
+            lowerSegment(segments[i], state);
+            first = std::min(first, i);
+        }
+        state = segments[i].lowering_exit;
+    }
+
+    // Programa con las declaraciones de todo el documento, las voces (sin sus
+    // sentencias) y, si hay voces, las sentencias fuera de ellas: lo que usan
+    // las fases de MusicProgram::resolve_names que no recorren las voces. Las
+    // declaraciones y sentencias son de los segmentos: se devuelven al final
+    MusicProgram header;
+    std::vector<std::string> texts;
+    voice_names.clear();
+    for (const auto& segment : segments) {
+        int offset = static_cast<int>(segment.first_line);
+        for (auto index : segment.declarations) {
+            Declaration* declaration = segment.lowered_instructions[index].declaration;
+            declaration->set_source_location({segment.locations[index].line + offset, segment.locations[index].column});
+            header.add_declaration(declaration);
+            texts.push_back(declaration->to_string());
+        }
+        for (const auto& voice : segment.voice_starts) {
+            if (std::find(voice_names.begin(), voice_names.end(), voice) == voice_names.end()) {
+                voice_names.push_back(voice);
+                header.add_voice(new MusicVoice(voice));
+            }
+        }
+    }
+    for (std::size_t i = 0; !voice_names.empty() && i < segments.size(); ++i) {
+        const Segment& segment = segments[i];
+        std::size_t j = 0;
+        for (; segment.lowering_entry.voice.empty() && j < segment.instructions.size(); ++j) {
+            if (dynamic_cast<const Voice*>(segment.instructions[j]) != nullptr) {
+                break;
+            }
+            header.add_statement(segment.lowered_instructions[j].statement);
+        }
+        if (j < segment.instructions.size() || !segment.lowering_exit.voice.empty()) {
+            break;
+        }
+    }
+
+    // Las declaraciones valen para todas las sentencias: si cambian se
+    // verifica todo de nuevo
+    if (texts != declaration_texts) {
+        declaration_texts = std::move(texts);
+        first = 0;
+    }
+
+    std::vector<CompileDiagnostic> semantic;
+    SymbolTable declared;
+    bool declarations_valid;
+    {
+        DiagnosticErrorSink sink{semantic};
+        SemanticErrorRedirect redirect{sink};
+        declarations_valid = header.resolve_declarations(declared);
+    }
+    resolveFrom(first, declared, declarations_valid, header);
+    for (const auto& segment : segments) {
+        semantic.insert(semantic.end(), segment.semantic_errors.begin(), segment.semantic_errors.end());
+    }
+
+    // Lo que necesita el programa completo, como en MusicProgram::resolve_voices:
+    // el mapa de tempo, la rejilla de cada voz y su alineación, y las
+    // declaraciones obligatorias
+    bool voices_valid = std::none_of(end_state.tracks.begin() + 1, end_state.tracks.end(),
+                                     [](const TrackState& track) { return track.failed; });
+    bool grid_checked = false;
+    tempo_map = TempoMap{};
+    if (!end_state.stopped && voices_valid) {
+        DiagnosticErrorSink sink{semantic};
+        SemanticErrorRedirect redirect{sink};
+        bool valid = buildTempoMap(header, tempo_map);
+        if (valid && !voice_names.empty()) {
+            std::vector<long> ticks;
+            for (std::size_t track = 1; track < end_state.tracks.size(); ++track) {
+                ticks.push_back(TempoMap::ticks_from_beats(end_state.tracks[track].beats));
+            }
+            grid_checked = !tempo_map.empty();
+            valid = (!grid_checked || checkBarGridFrom(first, tempo_map, header, semantic)) &&
+                    header.check_voice_alignment(tempo_map, ticks);
+        }
+        if (valid) {
+            MusicProgram::check_required_declarations(declared);
+        }
+    }
+    if (!grid_checked) {
+        grid_segments = 0;
+    }
+
+    if (syntax_errors.empty()) {
+        // En el orden del archivo: las voces informan sus errores agrupados por voz
+        std::stable_sort(semantic.begin(), semantic.end(),
+                         [](const CompileDiagnostic& a, const CompileDiagnostic& b) {
+                             return std::tie(a.line, a.column, a.message) < std::tie(b.line, b.column, b.message);
+                         });
+        diagnostics.insert(diagnostics.end(), semantic.begin(), semantic.end());
+    }
+
+    // Rejilla de compases: el mapa de tempo del análisis o, si el análisis
+    // se detuvo antes de armarlo, solo el compás de la cabecera (el tempo no
+    // interviene en los compases)
+    if (tempo_map.empty()) {
+        for (const auto declaration : header.get_declarations()) {
+            if (auto time_signature = dynamic_cast<const TimeSignatureDeclaration*>(declaration)) {
+                tempo_map.reset(120, time_signature->get_numerator(), time_signature->get_denominator());
+                tempo_map.build();
+                break;
+            }
+        }
+    }
+    measureFrom(first);
+
+    std::vector<Declaration*> declarations;
+    std::vector<Statement*> statements;
+    std::vector<MusicVoice*> voices;
+    header.release(declarations, statements, voices);
+    for (auto voice : voices) {
+        delete voice;
+    }
+}
+
+void ScoreDocument::resolveFrom(std::size_t first, const SymbolTable& declared, bool declarations_valid,
+                                MusicProgram& header) noexcept {
+    Checkpoint state;
+    state.stopped = !declarations_valid;
+    if (first > 0) {
+        state = segments[first - 1].exit;
+    }
+
+    // Tablas de símbolos al comenzar first: las declaraciones y los motivos
+    // definidos antes, fuera de las voces y en el ámbito de cada voz
+    SymbolTable table{declared};
+    std::vector<SymbolTable> voice_tables;
+    if (!state.stopped) {
+        for (std::size_t i = 0; i < first; ++i) {
+            for (const auto& [track, motif] : segments[i].motifs) {
+                if (track == 0) {
+                    table.insert(MotifStatement::symbol_name(motif->get_name()), motif);
+                }
+            }
+        }
+        if (state.in_voices) {
+            // Ya se verificó al comenzar las voces: solo agrega sus nombres
+            header.declare_voices(table, 0);
+            for (std::size_t track = 1; track < state.tracks.size(); ++track) {
+                voice_tables.push_back(table);
+                voice_tables.back().enter_scope();
+            }
+            for (std::size_t i = 0; i < first; ++i) {
+                for (const auto& [track, motif] : segments[i].motifs) {
+                    if (track > 0) {
+                        voice_tables[track - 1].insert(MotifStatement::symbol_name(motif->get_name()), motif);
+                    }
+                }
+            }
+        }
+    }
+
+    for (std::size_t i = first; i < segments.size(); ++i) {
+        Segment& segment = segments[i];
+        segment.motifs.clear();
+        segment.changes.clear();
+        segment.semantic_errors.clear();
+        segment.placements.clear();
+
+        // Lo que un análisis anterior enlazó puede apuntar a motivos que ya
+        // no existen: las sentencias vuelven a estar como recién traducidas
+        bool reset = segment.linked;
+        segment.linked = false;
+
+        DiagnosticErrorSink sink{segment.semantic_errors};
+        SemanticErrorRedirect redirect{sink};
+        int offset = static_cast<int>(segment.first_line);
+        std::size_t track = entryTrack(segment);
+        for (std::size_t j = 0; j < segment.instructions.size(); ++j) {
+            if (auto voice = dynamic_cast<const Voice*>(segment.instructions[j])) {
+                // La primera voz cierra el nivel superior (ver MusicProgram::declare_voices)
+                track = voiceTrack(voice->getName());
+                if (!state.in_voices) {
+                    state.in_voices = true;
+                    state.stopped = state.stopped || !header.declare_voices(table, 0);
+                }
+                while (state.tracks.size() <= track) {
+                    state.tracks.emplace_back();
+                    if (!state.stopped) {
+                        voice_tables.push_back(table);
+                        voice_tables.back().enter_scope();
+                    }
+                }
+                continue;
+            }
+
+            Statement* statement = segment.lowered_instructions[j].statement;
+            if (statement == nullptr) {
+                continue;
+            }
+            SourceLocation location{segment.locations[j].line + offset, segment.locations[j].column};
+            statement->set_source_location(location);
+            if (reset) {
+                statement->reset_names();
+            }
+
+            // Como MusicProgram::resolve_names: un error fuera de las voces
+            // detiene todo, uno en una voz solo el resto de esa voz
+            TrackState& current = state.tracks[track];
+            if (!state.stopped && !current.failed) {
+                SourceLocationScope scope{location};
+                if (!statement->resolve_names(track == 0 ? table : voice_tables[track - 1])) {
+                    if (track == 0) {
+                        state.stopped = true;
+                    } else {
+                        current.failed = true;
+                    }
+                } else if (auto motif = dynamic_cast<const MotifStatement*>(statement)) {
+                    segment.motifs.emplace_back(track, motif);
+                }
+                segment.linked = true;
+            }
+
+            double beats = statement->played_beats();
+            segment.placements.push_back({location, statement, track, current.beats, beats});
+            if (dynamic_cast<const TempoChangeStatement*>(statement) != nullptr ||
+                dynamic_cast<const TimeSignatureChangeStatement*>(statement) != nullptr) {
+                segment.changes.push_back({track, current.ticks, statement});
+            } else {
+                current.ticks += TempoMap::ticks_from_beats(beats);
+            }
+            current.beats += beats;
+        }
+        segment.exit = state;
+    }
+
+    end_state = state;
+    verified_segments = segments.size();
+}
+
+bool ScoreDocument::buildTempoMap(const MusicProgram& header, TempoMap& map) const noexcept {
+    const TempoDeclaration* tempo = nullptr;
+    const TimeSignatureDeclaration* time_signature = nullptr;
+    for (const auto declaration : header.get_declarations()) {
+        if (auto found = dynamic_cast<const TempoDeclaration*>(declaration)) {
+            tempo = found;
+        } else if (auto found = dynamic_cast<const TimeSignatureDeclaration*>(declaration)) {
+            time_signature = found;
+        }
+    }
+
+    // Si falta alguna, check_required_declarations lo reporta
+    map = TempoMap{};
+    if (tempo == nullptr || time_signature == nullptr) {
+        return true;
+    }
+
+    // Los cambios de cada pista en orden, pista por pista: en una misma
+    // posición vale el último, como en MusicProgram::build_tempo_map
+    std::vector<std::vector<const TrackChange*>> tracks(voice_names.size() + 1);
+    for (const auto& segment : segments) {
+        for (const auto& change : segment.changes) {
+            tracks[change.track].push_back(&change);
+        }
+    }
+    map.reset(tempo->get_tempo_value(), time_signature->get_numerator(), time_signature->get_denominator());
+    for (const auto& changes : tracks) {
+        for (const auto change : changes) {
+            if (auto tempo_change = dynamic_cast<const TempoChangeStatement*>(change->change)) {
+                map.add_tempo_change(change->tick, tempo_change->get_tempo_value());
+            } else if (auto meter = dynamic_cast<const TimeSignatureChangeStatement*>(change->change)) {
+                map.add_time_signature_change(change->tick, meter->get_numerator(), meter->get_denominator());
+            }
+        }
+    }
+    return map.build();
+}
+
+bool ScoreDocument::checkBarGridFrom(std::size_t first, const TempoMap& grid, const MusicProgram& header,
+                                     std::vector<CompileDiagnostic>& errors) noexcept {
+    // Con otras barras se verifica todo de nuevo
+    if (!sameBarGrid(grid, grid_map)) {
+        grid_map = grid;
+        first = 0;
+    }
+    first = std::min(first, grid_segments);
+
+    std::vector<GridState> state;
+    if (first > 0) {
+        state = segments[first - 1].grid_exit;
+    }
+    for (std::size_t i = first; i < segments.size(); ++i) {
+        Segment& segment = segments[i];
+        segment.grid_errors.clear();
+
+        DiagnosticErrorSink sink{segment.grid_errors};
+        SemanticErrorRedirect redirect{sink};
+        for (const auto& placement : segment.placements) {
+            if (placement.track == 0) {
+                continue;
+            }
+            if (state.size() < placement.track) {
+                state.resize(placement.track);
+            }
+            GridState& voice = state[placement.track - 1];
+            const MusicVoice* checker = header.get_voices()[placement.track - 1];
+            if (!voice.failed && !checker->check_bar_grid(*placement.statement, grid, voice.position)) {
+                voice.failed = true;
+            }
+        }
+        segment.grid_exit = state;
+    }
+    grid_segments = segments.size();
+
+    for (const auto& segment : segments) {
+        errors.insert(errors.end(), segment.grid_errors.begin(), segment.grid_errors.end());
+    }
+    return std::none_of(state.begin(), state.end(), [](const GridState& voice) { return voice.failed; });
+}
+
+void ScoreDocument::measureFrom(std::size_t first) noexcept {
+    // Con otras barras cambian todos los compases. Si no, desde first y el
+    // segmento con instrucciones anterior, cuya última sentencia ocupa las
+    // líneas hasta la primera instrucción de los siguientes
+    if (!sameBarGrid(tempo_map, measure_map)) {
+        measure_map = tempo_map;
+        first = 0;
+    }
+    first = std::min(first, measure_segments);
+    if (first > 0) {
+        do {
+            --first;
+        } while (first > 0 && segments[first].locations.empty());
+    }
+
+    int last_token_line = static_cast<int>(lines.size());
+    while (last_token_line > 1 && lines[last_token_line - 1].first_token == YYEOF) {
+        --last_token_line;
+    }
+
+    // Compases de cada sentencia: desde su línea hasta la anterior a la
+    // siguiente instrucción. Los de una misma pista se unen
+    for (std::size_t i = first; i < segments.size() && !tempo_map.empty(); ++i) {
+        Segment& segment = segments[i];
+        segment.measures.clear();
+
+        int offset = static_cast<int>(segment.first_line);
+        int following = last_token_line + 1;
+        for (std::size_t k = i + 1; k < segments.size(); ++k) {
+            if (!segments[k].locations.empty()) {
+                following = segments[k].locations.front().line + static_cast<int>(segments[k].first_line);
+                break;
+            }
+        }
+
+        std::vector<std::size_t> last_measure(voice_names.size() + 1, 0);   // índice + 1
+        for (const auto& placement : segment.placements) {
+            if (placement.beats <= 0.0) {
+                continue;
+            }
+            auto next = std::upper_bound(segment.locations.begin(), segment.locations.end(),
+                                         placement.location.line - offset,
+                                         [](int line, const InstructionLocation& location) {
+                                             return line < location.line;
+                                         });
+            int last_line = (next != segment.locations.end()) ? next->line + offset - 1 : following - 1;
+            last_line = std::max(last_line, placement.location.line);
+
+            long start = TempoMap::ticks_from_beats(placement.start);
+            long end = TempoMap::ticks_from_beats(placement.start + placement.beats);
+            int first_measure = static_cast<int>(tempo_map.tick_to_measure(start));
+            int final_measure = static_cast<int>(tempo_map.tick_to_measure(end - 1));
+            std::size_t& last = last_measure[placement.track];
+            for (int number = first_measure; number <= final_measure; ++number) {
+                if (last != 0 && segment.measures[last - 1].number == number) {
+                    segment.measures[last - 1].last_line = std::max(segment.measures[last - 1].last_line, last_line);
+                } else {
+                    segment.measures.push_back({placement.track, number, placement.location.line, last_line});
+                    last = segment.measures.size();
+                }
+            }
+        }
+    }
+    if (tempo_map.empty()) {
+        for (auto& segment : segments) {
+            segment.measures.clear();
+        }
+    }
+    measure_segments = segments.size();
+
+    // Los de cada pista en orden, pista por pista, uniendo el compás que un
+    // segmento continúa del anterior
+    std::vector<std::vector<MeasureSymbol>> tracks(voice_names.size() + 1);
+    for (const auto& segment : segments) {
+        for (const auto& measure : segment.measures) {
+            auto& track = tracks[measure.track];
+            if (!track.empty() && track.back().number == measure.number) {
+                track.back().last_line = std::max(track.back().last_line, measure.last_line);
+            } else {
+                std::string voice = (measure.track == 0) ? std::string{} : voice_names[measure.track - 1];
+                track.push_back({voice, measure.number, measure.first_line, measure.last_line});
+            }
+        }
+    }
+    measures.clear();
+    for (auto& track : tracks) {
+        measures.insert(measures.end(), std::make_move_iterator(track.begin()),
+                        std::make_move_iterator(track.end()));
+    }
+}
+
+std::string ScoreDocument::describeAt(int line, int column) const noexcept {
+    // Segmento que contiene la línea: el último que comienza en ella o antes
+    std::size_t row = static_cast<std::size_t>(std::max(line - 1, 0));
+    auto it = std::upper_bound(segments.begin(), segments.end(), row,
+                               [](std::size_t value, const Segment& segment) {
+                                   return value < segment.first_line;
+                               });
+    if (it == segments.begin()) {
+        return "";
+    }
+
+    // Última instrucción ubicada antes de la posición: en ese segmento o, si
+    // la posición está antes de su primera, al final del anterior que tenga alguna
+    std::size_t index = static_cast<std::size_t>(it - segments.begin()) - 1;
+    const Segment* segment = &segments[index];
+    SourceLocation relative{line - static_cast<int>(segment->first_line), column};
+    auto found = std::upper_bound(segment->locations.begin(), segment->locations.end(), relative,
+                                  [](const SourceLocation& value, const InstructionLocation& location) {
+                                      return locationBefore(value, SourceLocation{location.line, location.column});
+                                  });
+    while (found == segment->locations.begin()) {
+        if (index == 0) {
+            return "";
+        }
+        segment = &segments[--index];
+        found = segment->locations.end();
+    }
+
+    // Solo si es una sentencia (no una declaración ni una voz)
+    std::size_t instruction = static_cast<std::size_t>(found - segment->locations.begin()) - 1;
+    const Statement* statement = segment->lowered_instructions[instruction].statement;
+    if (statement == nullptr) {
+        return "";
+    }
+    auto placed = std::lower_bound(segment->placements.begin(), segment->placements.end(),
+                                   statement->get_source_location(),
+                                   [](const Placement& placement, const SourceLocation& value) {
+                                       return locationBefore(placement.location, value);
+                                   });
+    if (placed == segment->placements.end() || placed->statement != statement) {
+        return "";
+    }
+    const Placement& placement = *placed;
+
+    std::string description;
+    if (auto motif = dynamic_cast<const MotifStatement*>(statement)) {
+        return "Motivo " + motif->get_name() + ": " + beatsToString(motif->body_beats()) +
+               " corcheas en cada referencia; no suena donde se define.";
+    }
+    if (auto sound = dynamic_cast<const SoundingStatement*>(statement)) {
+        description = sound->to_string();
+    } else if (auto repeat = dynamic_cast<const RepeatStatement*>(statement)) {
+        description = "Repetir " + std::to_string(repeat->get_count());
+    } else {
+        description = "Referencia al motivo " + statement->to_string();
+    }
+    description += ": " + beatsToString(placement.beats) + " corcheas";
+    if (placement.track > 0) {
+        description += " (voz " + voice_names[placement.track - 1] + ")";
+    }
+
+    if (!tempo_map.empty()) {
+        long start = TempoMap::ticks_from_beats(placement.start);
+        long measure = tempo_map.tick_to_measure(start);
+        double offset = static_cast<double>(start - tempo_map.measure_to_tick(measure)) / TICKS_PER_BEAT;
+        double bar = static_cast<double>(tempo_map.segment_at(start).bar_ticks) / TICKS_PER_BEAT;
+        description += ". Compás " + std::to_string(measure) + ", corchea " + beatsToString(offset + 1.0) +
+                       " de " + beatsToString(bar) + ".";
+    } else {
+        description += ". Comienza en la corchea " + beatsToString(placement.start + 1.0) + ".";
+    }
+    return description;
+}
@@ -0,0 +1,244 @@
+#pragma once
+
+#include "compile.hpp"
+#include "expression.hpp"
+#include "lowering.hpp"
+#include "parallel_front_end.hpp"
+#include "recursive_descent.hpp"
+#include "syntax_error.hpp"
+#include "../AST/ast_node_interface.hpp"
+#include "../AST/tempo_map.hpp"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class MotifStatement;
+class MusicProgram;
+class NotePool;
+class Statement;
+class SymbolTable;
+
+// Compás de una voz (o del programa sin voces), para los símbolos del documento
+struct MeasureSymbol {
+    std::string voice;   // vacío fuera de las voces
+    int number;
+    int first_line;      // líneas desde 1
+    int last_line;
+};
+
+// Partitura abierta en el servidor de lenguaje, con análisis incremental.
+//
+// La gramática es orientada a líneas: el documento se divide en segmentos
+// que comienzan en una línea cuyo primer token abre una instrucción, fuera de
+// todo bloque entre llaves y de todo acorde (la misma regla que el front end
+// paralelo). De cada línea se guarda solo su primer token y el anidamiento al
+// final. Una edición vuelve a escanear las líneas editadas (y las siguientes
+// mientras cambie el anidamiento) y vuelve a analizar solo los
+// segmentos que las contienen, más el anterior, cuyo lookahead puede haber
+// cambiado. Los demás segmentos conservan sus nodos sin volver a crearlos.
+//
+// Cada segmento guarda también su traducción al AST, que se rehace solo si
+// el segmento es nuevo o si la traducción llega a él en otro estado, y lo
+// que dejó la verificación (resolve_names): el estado de cada voz al
+// comenzar (posición y si ya falló), los motivos que define, sus cambios de
+// tempo y compás, sus errores, la posición de sus sentencias y sus compases.
+// Tras una edición la verificación se retoma en el primer segmento afectado,
+// con la tabla de símbolos rearmada con los motivos de los anteriores; lo
+// que necesita el programa completo (el mapa de tempo, la alineación de las
+// voces, las declaraciones obligatorias) se arma con lo guardado. Si cambian
+// las declaraciones se verifica todo de nuevo.
+class ScoreDocument {
+public:
+    explicit ScoreDocument(const std::string& text) noexcept;
+    ~ScoreDocument() noexcept;
+
+    ScoreDocument(const ScoreDocument&) = delete;
+    ScoreDocument& operator=(const ScoreDocument&) = delete;
+
+    // Reemplaza el texto entre dos posiciones (líneas desde 0, columnas en
+    // bytes desde 0, como en LSP pero en bytes) y actualiza el análisis
+    void applyEdit(std::size_t start_line, std::size_t start_column,
+                   std::size_t end_line, std::size_t end_column, const std::string& text) noexcept;
+
+    // Reemplaza el documento completo
+    void replaceText(const std::string& text) noexcept;
+
+    const std::string& getText() const noexcept;
+    std::size_t getLineCount() const noexcept;
+
+    // Texto de una línea (desde 0), sin el salto de línea
+    std::string_view getLine(std::size_t line) const noexcept;
+
+    // Errores sintácticos de todos los segmentos y, si no los hay, los
+    // semánticos (con la ubicación de la instrucción que los produjo)
+    const std::vector<CompileDiagnostic>& getDiagnostics() const noexcept;
+
+    // Instrucciones del documento, en orden, como las escribe Program::to_string
+    std::string programToString() const noexcept;
+
+    // Descripción de la instrucción en la posición dada (línea y columna desde
+    // 1, en bytes): duración y posición en la rejilla de compases. Vacía si no
+    // hay una instrucción musical en esa posición.
+    std::string describeAt(int line, int column) const noexcept;
+
+    // Compases de cada voz, con las líneas que ocupan
+    const std::vector<MeasureSymbol>& getMeasures() const noexcept;
+
+    // Segmentos vueltos a analizar y reutilizados en la última actualización
+    std::size_t getReparsedSegments() const noexcept;
+    std::size_t getReusedSegments() const noexcept;
+
+private:
+    // Primer token de una línea y anidamiento (llaves, acorde) al final de ella
+    struct LineInfo {
+        int first_token;
+        LineNesting nesting_after;
+    };
+
+    // Estado de una pista (0: fuera de las voces; i + 1: la voz i, en orden
+    // de aparición) al avanzar por el documento
+    struct TrackState {
+        bool failed{false};   // la voz ya informó un error: lo que sigue no se resuelve
+        double beats{0.0};    // posición, en corcheas
+        long ticks{0};        // posición de sus cambios de tempo y compás
+    };
+
+    // Estado de la verificación al terminar un segmento, para retomarla en el siguiente
+    struct Checkpoint {
+        bool stopped{false};     // un error de las declaraciones o del nivel superior la detuvo
+        bool in_voices{false};   // ya apareció la primera voz
+        std::vector<TrackState> tracks = std::vector<TrackState>(1);
+    };
+
+    // Posición de una voz en la verificación de la rejilla de compases
+    struct GridState {
+        bool failed{false};
+        long position{0};
+    };
+
+    // Sentencia de nivel superior con su posición en la rejilla de compases
+    struct Placement {
+        SourceLocation location;
+        const Statement* statement;
+        std::size_t track;
+        double start;
+        double beats;
+    };
+
+    // Cambio de tempo o de compás, en la posición de su pista
+    struct TrackChange {
+        std::size_t track;
+        long tick;
+        const Statement* change;
+    };
+
+    // Compás de una pista (ver MeasureSymbol)
+    struct TrackMeasure {
+        std::size_t track;
+        int number;
+        int first_line;
+        int last_line;
+    };
+
+    // Instrucciones de un grupo de líneas. Las ubicaciones y los errores
+    // sintácticos tienen líneas relativas al segmento (desde 1), así que
+    // desplazar el segmento no requiere tocarlos. Lo que sigue a errors es
+    // del análisis (ver analyze), con líneas absolutas: se rehace para los
+    // segmentos desplazados.
+    struct Segment {
+        std::size_t first_line;
+        std::size_t line_count;
+        std::vector<Expression*> instructions;
+        std::vector<InstructionLocation> locations;
+        std::vector<SyntaxError> errors;
+
+        // Traducción al AST, una por instrucción, desde lowering_entry. De
+        // ellas, las declaraciones y los nombres de las voces que comienzan
+        bool lowered{false};
+        LoweringState lowering_entry;
+        LoweringState lowering_exit;
+        std::vector<LoweredInstruction> lowered_instructions;
+        std::vector<std::size_t> declarations;
+        std::vector<std::string> voice_starts;
+        bool linked{false};   // alguna sentencia guarda enlaces de resolve_names
+
+        // Verificación: lo que produjo el segmento y el estado al terminar
+        Checkpoint exit;
+        std::vector<std::pair<std::size_t, const MotifStatement*>> motifs;
+        std::vector<TrackChange> changes;
+        std::vector<CompileDiagnostic> semantic_errors;
+        std::vector<Placement> placements;
+
+        // Rejilla de compases de las voces y compases de las sentencias
+        std::vector<CompileDiagnostic> grid_errors;
+        std::vector<GridState> grid_exit;
+        std::vector<TrackMeasure> measures;
+    };
+
+    void computeLineStarts() noexcept;
+    LineInfo scanLine(std::size_t line, LineNesting nesting_before) const noexcept;
+    LineNesting nestingBefore(std::size_t line) const noexcept;
+    bool startsSegment(std::size_t line) const noexcept;
+
+    // Analiza las líneas [first_line, end_line) como segmentos nuevos
+    std::vector<Segment> parseSegments(std::size_t first_line, std::size_t end_line) const noexcept;
+    static void destroySegment(Segment& segment) noexcept;
+    static void destroyLowered(Segment& segment) noexcept;
+
+    // Traduce las instrucciones del segmento desde el estado dado
+    void lowerSegment(Segment& segment, const LoweringState& entry) noexcept;
+
+    // Análisis desde el primer segmento afectado: diagnósticos, posiciones y compases
+    void analyze() noexcept;
+
+    // Verifica las sentencias desde el segmento first, con las declaraciones
+    // ya resueltas en declared (o no, si fallaron) y header con las
+    // declaraciones, las voces y las sentencias fuera de ellas
+    void resolveFrom(std::size_t first, const SymbolTable& declared, bool declarations_valid,
+                     MusicProgram& header) noexcept;
+
+    // Mapa de tempo como el de MusicProgram::build_tempo_map, con los cambios
+    // guardados en los segmentos
+    bool buildTempoMap(const MusicProgram& header, TempoMap& map) const noexcept;
+
+    // Verifica la rejilla de compases de las voces desde el segmento first y
+    // agrega a errors los errores de todos los segmentos
+    bool checkBarGridFrom(std::size_t first, const TempoMap& grid, const MusicProgram& header,
+                          std::vector<CompileDiagnostic>& errors) noexcept;
+
+    // Compases de las sentencias desde el segmento first
+    void measureFrom(std::size_t first) noexcept;
+
+    // Pista en que comienza un segmento, y la de "Voz X"
+    std::size_t entryTrack(const Segment& segment) const noexcept;
+    std::size_t voiceTrack(const std::string& voice) const noexcept;
+
+    std::string text;
+    std::vector<std::size_t> line_starts;
+    std::vector<LineInfo> lines;
+    std::vector<Segment> segments;
+
+    std::vector<CompileDiagnostic> diagnostics;
+    TempoMap tempo_map;   // Rejilla de compases (vacía: sin compás declarado)
+    std::vector<MeasureSymbol> measures;
+
+    // Estado del análisis incremental: las notas de lo traducido, las voces
+    // en orden de aparición, las declaraciones de la última verificación, el
+    // estado tras el último segmento y los segmentos iniciales cuya
+    // verificación, rejilla y compases siguen valiendo (con grid_map y
+    // measure_map, las rejillas con que se calcularon)
+    std::shared_ptr<NotePool> note_pool;
+    std::vector<std::string> voice_names;
+    std::vector<std::string> declaration_texts;
+    Checkpoint end_state;
+    std::size_t verified_segments{0};
+    std::size_t grid_segments{0};
+    std::size_t measure_segments{0};
+    TempoMap grid_map;
+    TempoMap measure_map;
+
+    std::size_t reparsed_segments{0};
+    std::size_t reused_segments{0};
+};
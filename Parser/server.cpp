@@ -0,0 +1,340 @@
+#include "server.hpp"
+#include "compile.hpp"
+#include "protocol.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Buffers de un hilo del servidor, reutilizados entre peticiones. Cada
+// petición arma su propio árbol, AST y NotePool: solo el texto se reutiliza
+struct WorkerBuffers {
+    std::string source;
+    std::string abc;
+    std::string errors;
+};
+
+// Cantidad de peticiones atendidas, para el resumen al terminar
+static std::atomic<unsigned long> request_count{0};
+
+// Compila la partitura de buffers.source. Devuelve el código de la
+// respuesta: 0 con el ABC en buffers.abc, 1 con los errores en buffers.errors
+static int compileRequest(int semitones, WorkerBuffers& buffers) noexcept {
+    bool compiled = compileBuffer(buffers.source.data(), buffers.source.size(), semitones,
+                                  buffers.abc, buffers.errors);
+    ++request_count;
+    return compiled ? 0 : 1;
+}
+
+// Atiende las peticiones de una conexión hasta que el cliente la cierre
+static void serveConnection(int in, int out, WorkerBuffers& buffers) noexcept {
+    FrameReader reader{in};
+    int semitones;
+    while (reader.read(semitones, buffers.source)) {
+        int code = compileRequest(semitones, buffers);
+        if (!writeFrame(out, code, code == 0 ? buffers.abc : buffers.errors)) {
+            return;
+        }
+    }
+}
+
+// Extremo de escritura de la tubería con la que el manejador de señales
+// despierta al ciclo de eventos
+static int stop_pipe[2] = {-1, -1};
+
+extern "C" void requestStop(int) {
+    char signal_byte = 1;
+    ssize_t ignored = ::write(stop_pipe[1], &signal_byte, 1);
+    (void)ignored;
+}
+
+// Conexión de un cliente, sin bloqueo. Mientras un hilo atiende su petición
+// o su respuesta no terminó de escribirse no se lee la siguiente, así que
+// las respuestas salen en el orden de las peticiones
+struct Connection {
+    explicit Connection(int fd) noexcept : fd{fd}, reader{fd}, writer{fd} {}
+
+    int fd;
+    FrameReader reader;
+    FrameWriter writer;   // Respuesta que arma el hilo y escribe el ciclo de eventos
+    int semitones{0};
+    std::string source;   // Partitura de la petición en curso
+};
+
+// Peticiones completas esperando un hilo y conexiones con la respuesta ya
+// armada, que vuelven al ciclo de eventos para escribirla. Los hilos lo despiertan con
+// wake, una tubería que el ciclo espera junto con las conexiones
+class RequestQueue {
+public:
+    explicit RequestQueue(int wake) noexcept : wake{wake} {}
+
+    void push(Connection* connection) noexcept {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            pending.push_back(connection);
+        }
+        ready.notify_one();
+    }
+
+    // Siguiente petición, o nullptr si el servidor se está cerrando
+    Connection* pop() noexcept {
+        std::unique_lock<std::mutex> lock{mutex};
+        ready.wait(lock, [this] { return closed || !pending.empty(); });
+        if (closed) {
+            return nullptr;
+        }
+        Connection* connection = pending.front();
+        pending.pop_front();
+        return connection;
+    }
+
+    void finish(Connection* connection) noexcept {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            finished.push_back(connection);
+        }
+        char wake_byte = 1;
+        ssize_t ignored = ::write(wake, &wake_byte, 1);
+        (void)ignored;
+    }
+
+    // Conexiones devueltas por los hilos desde la última llamada
+    std::vector<Connection*> takeFinished() noexcept {
+        std::lock_guard<std::mutex> lock{mutex};
+        std::vector<Connection*> result;
+        result.swap(finished);
+        return result;
+    }
+
+    // Despierta a todos los hilos; las peticiones en espera se descartan
+    void close() noexcept {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            closed = true;
+            pending.clear();
+        }
+        ready.notify_all();
+    }
+
+private:
+    int wake;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<Connection*> pending;
+    std::vector<Connection*> finished;
+    bool closed{false};
+};
+
+// Quita de connections las que poll marcó (sus descriptores están en
+// sources desde first, en el mismo orden) y las devuelve
+static std::vector<Connection*> takeReady(std::vector<Connection*>& connections,
+                                          const std::vector<pollfd>& sources, std::size_t first) noexcept {
+    std::vector<Connection*> ready;
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < connections.size(); ++i) {
+        if (sources[first + i].revents != 0) {
+            ready.push_back(connections[i]);
+        } else {
+            connections[kept++] = connections[i];
+        }
+    }
+    connections.resize(kept);
+    return ready;
+}
+
+int runServer(const std::string& socket_path, unsigned workers) noexcept {
+    // Un cliente que cierra la conexión antes de leer la respuesta no debe
+    // terminar el servidor
+    std::signal(SIGPIPE, SIG_IGN);
+
+    if (socket_path == "-") {
+        WorkerBuffers buffers;
+        serveConnection(STDIN_FILENO, STDOUT_FILENO, buffers);
+        return 0;
+    }
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof address.sun_path) {
+        std::cerr << "Error: Ruta de socket demasiado larga: " << socket_path << std::endl;
+        return 1;
+    }
+    std::strcpy(address.sun_path, socket_path.c_str());
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    ::unlink(socket_path.c_str());
+    if (listener < 0 ||
+        ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof address) < 0 ||
+        ::listen(listener, SOMAXCONN) < 0) {
+        std::cerr << "Error: No se pudo escuchar en " << socket_path << ": "
+                  << std::strerror(errno) << std::endl;
+        if (listener >= 0) {
+            ::close(listener);
+        }
+        return 1;
+    }
+
+    if (::pipe(stop_pipe) < 0) {
+        std::cerr << "Error: No se pudo crear la tubería de control" << std::endl;
+        ::close(listener);
+        return 1;
+    }
+    struct sigaction action{};
+    action.sa_handler = requestStop;
+    sigemptyset(&action.sa_mask);
+    ::sigaction(SIGINT, &action, nullptr);
+    ::sigaction(SIGTERM, &action, nullptr);
+
+    // Sin bloquear: si la tubería está llena, el ciclo ya tiene un aviso pendiente
+    int wake_pipe[2];
+    if (::pipe2(wake_pipe, O_NONBLOCK | O_CLOEXEC) < 0) {
+        std::cerr << "Error: No se pudo crear la tubería de control" << std::endl;
+        ::close(listener);
+        return 1;
+    }
+
+    // Los hilos solo compilan: una conexión ocupa uno mientras se compila
+    // una petición, no mientras espera la siguiente ni mientras el cliente
+    // lee la respuesta, que escribe el ciclo de eventos
+    if (workers == 0) {
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    RequestQueue queue{wake_pipe[1]};
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < workers; ++i) {
+        threads.emplace_back([&queue]() {
+            WorkerBuffers buffers;
+            for (Connection* connection = queue.pop(); connection != nullptr; connection = queue.pop()) {
+                buffers.source.swap(connection->source);
+                int code = compileRequest(connection->semitones, buffers);
+                connection->writer.add(code, code == 0 ? buffers.abc : buffers.errors);
+                buffers.source.swap(connection->source);
+                queue.finish(connection);
+            }
+        });
+    }
+
+    std::cerr << "Servidor escuchando en " << socket_path << " con " << workers << " hilos" << std::endl;
+
+    // Conexiones abiertas, las que esperan su próxima petición y las que
+    // esperan para seguir escribiendo su respuesta
+    std::map<int, std::unique_ptr<Connection>> connections;
+    std::vector<Connection*> waiting;
+    std::vector<Connection*> writing;
+    auto closeConnection = [&connections](Connection* connection) {
+        ::close(connection->fd);
+        connections.erase(connection->fd);
+    };
+
+    // Una petición que ya llegó entera (varias pueden llegar juntas) va a la
+    // cola; si no, la conexión espera más datos
+    auto dispatch = [&](Connection* connection) {
+        switch (connection->reader.take(connection->semitones, connection->source)) {
+            case FrameStatus::COMPLETE: queue.push(connection); break;
+            case FrameStatus::INCOMPLETE: waiting.push_back(connection); break;
+            case FrameStatus::MALFORMED: closeConnection(connection); break;
+        }
+    };
+
+    // Escribe lo que el cliente acepte de la respuesta; al terminarla, pasa
+    // a la siguiente petición
+    auto respond = [&](Connection* connection) {
+        if (!connection->writer.flush()) {
+            closeConnection(connection);
+        } else if (connection->writer.pending()) {
+            writing.push_back(connection);
+        } else {
+            dispatch(connection);
+        }
+    };
+
+    // Ciclo de eventos hasta recibir SIGINT o SIGTERM
+    std::vector<pollfd> sources;
+    for (;;) {
+        sources.clear();
+        sources.push_back({listener, POLLIN, 0});
+        sources.push_back({stop_pipe[0], POLLIN, 0});
+        sources.push_back({wake_pipe[0], POLLIN, 0});
+        for (Connection* connection : waiting) {
+            sources.push_back({connection->fd, POLLIN, 0});
+        }
+        for (Connection* connection : writing) {
+            sources.push_back({connection->fd, POLLOUT, 0});
+        }
+
+        if (::poll(sources.data(), sources.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (sources[1].revents != 0) {
+            break;
+        }
+
+        // Conexiones listas para leer o para escribir: las demás siguen esperando
+        std::vector<Connection*> readable = takeReady(waiting, sources, 3);
+        std::vector<Connection*> writable = takeReady(writing, sources, 3 + readable.size() + waiting.size());
+        for (Connection* connection : readable) {
+            if (connection->reader.fill()) {
+                dispatch(connection);
+            } else {
+                closeConnection(connection);
+            }
+        }
+        for (Connection* connection : writable) {
+            respond(connection);
+        }
+
+        if (sources[2].revents != 0) {
+            char wake_bytes[64];
+            ssize_t ignored = ::read(wake_pipe[0], wake_bytes, sizeof wake_bytes);
+            (void)ignored;
+            for (Connection* connection : queue.takeFinished()) {
+                respond(connection);
+            }
+        }
+
+        if (sources[0].revents != 0) {
+            int client = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (client >= 0) {
+                auto connection = std::make_unique<Connection>(client);
+                waiting.push_back(connection.get());
+                connections.emplace(client, std::move(connection));
+            }
+        }
+    }
+
+    // Los hilos no escriben a los clientes, así que terminan en cuanto
+    // termina la compilación en curso; después se cierran las conexiones
+    ::close(listener);
+    ::unlink(socket_path.c_str());
+    queue.close();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (auto& entry : connections) {
+        ::close(entry.first);
+    }
+    ::close(wake_pipe[0]);
+    ::close(wake_pipe[1]);
+    ::close(stop_pipe[0]);
+    ::close(stop_pipe[1]);
+
+    std::cerr << "Servidor detenido; peticiones atendidas: " << request_count << std::endl;
+    return 0;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+
+// Servidor de compilación persistente. Evita el costo de iniciar un proceso,
+// inicializar iostream y abrir archivos en cada compilación: el proceso queda
+// residente y atiende peticiones con el protocolo de protocol.hpp.
+//
+// Con una ruta, escucha en un socket UNIX. Un ciclo de eventos espera con
+// poll en todas las conexiones, que no bloquean, y pasa cada petición
+// completa a una cola que atienden workers hilos (0 = uno por núcleo). Los
+// hilos solo compilan: dejan la respuesta en el buffer de salida de la
+// conexión y el ciclo de eventos la escribe a medida que el cliente la lee.
+// Así una conexión ocupa un hilo solo mientras se compila su petición: los
+// clientes que esperan sin enviar nada o que no leen su respuesta no dejan
+// sin atender a los demás, y no hace falta un límite de inactividad. Las
+// peticiones de una misma conexión se atienden de a una y se responden en
+// orden. Cada hilo reutiliza sus buffers de texto (ABC y errores); el árbol,
+// el AST y su NotePool se arman de nuevo en cada petición. Termina con SIGINT o SIGTERM, después de cerrar las conexiones
+// abiertas. Con "-" atiende una sola conexión sobre la entrada y la salida
+// estándar.
+int runServer(const std::string& socket_path, unsigned workers) noexcept;
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+
+// Estadísticas de una cola entre dos etapas. La ocupación se mide cada vez
+// que el consumidor toma un elemento: elementos en la cola en ese momento,
+// incluido el que toma
+struct QueueStats {
+    std::size_t capacity{0};
+    std::size_t items{0};
+    std::size_t occupancy_sum{0};
+    std::size_t max_occupancy{0};
+    std::size_t full_waits{0};    // el productor esperó porque la cola estaba llena
+    std::size_t empty_waits{0};   // el consumidor esperó porque la cola estaba vacía
+
+    double meanOccupancy() const noexcept {
+        return (items == 0) ? 0.0 : static_cast<double>(occupancy_sum) / static_cast<double>(items);
+    }
+};
+
+// Cola circular sin bloqueos para un solo productor y un solo consumidor.
+// Los elementos se escriben y leen en su lugar (acquire/commit y
+// front/release), así que un lote grande no se copia. Cada extremo guarda
+// una copia del índice del otro y solo lee el atómico cuando la copia
+// indica que la cola está llena o vacía. Al esperar, el hilo cede el
+// procesador y acumula el tiempo de espera en wait_ms, para calcular la
+// ocupación de cada etapa.
+template <typename T, std::size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "la capacidad debe ser una potencia de dos");
+
+public:
+    // Productor: espacio para el siguiente elemento, esperando si la cola está llena
+    T& acquire(double& wait_ms) noexcept {
+        std::size_t tail = this->tail.load(std::memory_order_relaxed);
+        if (tail - this->cached_head == Capacity) {
+            this->cached_head = this->head.load(std::memory_order_acquire);
+            if (tail - this->cached_head == Capacity) {
+                ++this->full_waits;
+                auto start = std::chrono::steady_clock::now();
+                do {
+                    std::this_thread::yield();
+                    this->cached_head = this->head.load(std::memory_order_acquire);
+                } while (tail - this->cached_head == Capacity);
+                wait_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+        }
+        return this->slots[tail & (Capacity - 1)];
+    }
+
+    // Productor: publica el elemento escrito tras acquire
+    void commit() noexcept {
+        this->tail.store(this->tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumidor: el siguiente elemento, esperando si la cola está vacía
+    T& front(double& wait_ms) noexcept {
+        std::size_t head = this->head.load(std::memory_order_relaxed);
+        if (this->cached_tail == head) {
+            this->cached_tail = this->tail.load(std::memory_order_acquire);
+            if (this->cached_tail == head) {
+                ++this->stats.empty_waits;
+                auto start = std::chrono::steady_clock::now();
+                do {
+                    std::this_thread::yield();
+                    this->cached_tail = this->tail.load(std::memory_order_acquire);
+                } while (this->cached_tail == head);
+                wait_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+        }
+
+        // La copia del índice del productor puede estar atrasada: para medir
+        // la ocupación se lee el atómico
+        std::size_t occupancy = this->tail.load(std::memory_order_relaxed) - head;
+        ++this->stats.items;
+        this->stats.occupancy_sum += occupancy;
+        if (occupancy > this->stats.max_occupancy) {
+            this->stats.max_occupancy = occupancy;
+        }
+        return this->slots[head & (Capacity - 1)];
+    }
+
+    // Consumidor: libera el elemento devuelto por front
+    void release() noexcept {
+        this->head.store(this->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Estadísticas de ambos extremos; solo es válido cuando los dos hilos terminaron
+    QueueStats getStats() const noexcept {
+        QueueStats result = this->stats;
+        result.capacity = Capacity;
+        result.full_waits = this->full_waits;
+        return result;
+    }
+
+private:
+    // Índices en líneas de caché distintas, para que el productor y el
+    // consumidor no invaliden la del otro en cada operación
+    alignas(64) std::atomic<std::size_t> head{0};
+    std::size_t cached_tail{0};
+    QueueStats stats;
+
+    alignas(64) std::atomic<std::size_t> tail{0};
+    std::size_t cached_head{0};
+    std::size_t full_waits{0};
+
+    alignas(64) T slots[Capacity];
+};
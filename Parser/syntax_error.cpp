@@ -0,0 +1,46 @@
+#include "syntax_error.hpp"
+#include "expression.hpp"
+
+// Requerido para usar el mismo YYSTYPE que el parser
+#define YYSTYPE Expression*
+#include "token.h"
+
+std::string syntaxErrorToString(const SyntaxError& error) noexcept {
+    return "Error de análisis (línea " + std::to_string(error.line) +
+           ", columna " + std::to_string(error.column) + "): " + error.message;
+}
+
+bool isInstructionStart(int token) noexcept {
+    return token == TOKEN_TEMPO || token == TOKEN_COMPAS || token == TOKEN_TONALIDAD ||
+           token == TOKEN_TRANSPONER || token == TOKEN_VOZ || isBodyInstructionStart(token);
+}
+
+bool isBodyInstructionStart(int token) noexcept {
+    return token == TOKEN_NOTA_COMPLETA || token == TOKEN_CORCHETE_ABRE || token == TOKEN_REPETIR ||
+           token == TOKEN_MOTIVO || token == TOKEN_IDENTIFIER;
+}
+
+bool isInstructionEnd(int token) noexcept {
+    return token == TOKEN_NUMERO || token == TOKEN_MAYOR || token == TOKEN_MENOR ||
+           token == TOKEN_BLANCA || token == TOKEN_NEGRA ||
+           token == TOKEN_CORCHEA || token == TOKEN_SEMICORCHEA || token == TOKEN_IDENTIFIER ||
+           token == TOKEN_LLAVE_ABRE || token == TOKEN_LLAVE_CIERRA;
+}
+
+void recordSyntaxError(std::vector<SyntaxError>& errors, int line, int column,
+                       const std::string& message) noexcept {
+    if (!errors.empty() && errors.back().line == line) {
+        return;
+    }
+    errors.push_back(SyntaxError{line, column, message});
+}
+
+void recordUnexpectedToken(std::vector<SyntaxError>& errors, int line, int column,
+                           int previous_token, int previous_line, int previous_last_column,
+                           const std::string& message) noexcept {
+    if (previous_token != 0 && !isInstructionEnd(previous_token) && previous_line < line) {
+        line = previous_line;
+        column = previous_last_column + 1;
+    }
+    recordSyntaxError(errors, line, column, message);
+}
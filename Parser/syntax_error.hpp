@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Error de análisis (léxico o sintáctico) con su ubicación en el archivo fuente
+struct SyntaxError {
+    int line;
+    int column;
+    std::string message;
+};
+
+// Errores recolectados por el parser durante la última llamada a yyparse()
+extern std::vector<SyntaxError> parser_errors;
+
+// Formatea un error como "Error de análisis (línea L, columna C): mensaje"
+std::string syntaxErrorToString(const SyntaxError& error) noexcept;
+
+// Tokens con los que puede comenzar una instrucción (puntos de resincronización)
+bool isInstructionStart(int token) noexcept;
+
+// Tokens con los que puede comenzar una instrucción dentro de un bloque
+bool isBodyInstructionStart(int token) noexcept;
+
+// Tokens con los que puede terminar una instrucción completa (o abrir y
+// cerrar un bloque, tras los cuales no queda nada pendiente en la línea)
+bool isInstructionEnd(int token) noexcept;
+
+// Registra un error; se reporta a lo sumo un error por línea, porque los
+// siguientes de la misma línea son consecuencia del primero
+void recordSyntaxError(std::vector<SyntaxError>& errors, int line, int column,
+                       const std::string& message) noexcept;
+
+// Registra un error sobre el token inesperado (lookahead). Si ese token abre
+// una línea nueva y el token anterior no cerraba una instrucción, el error
+// pertenece a la instrucción incompleta de la línea anterior (p. ej. "Fa4"
+// sin duración) y se ubica justo después del token anterior.
+void recordUnexpectedToken(std::vector<SyntaxError>& errors, int line, int column,
+                           int previous_token, int previous_line, int previous_last_column,
+                           const std::string& message) noexcept;
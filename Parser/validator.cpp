@@ -0,0 +1,534 @@
+#include "validator.hpp"
+#include "expression.hpp"
+#include "../AST/expression.hpp"
+#include "../Scanner/fast_scanner.h"
+#include "../Scanner/token.h"
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+// Posiciones dentro del compás, en semicorcheas desde la última barra (el
+// compás más largo, 12/2, tiene 96)
+using GridMask = std::bitset<128>;
+
+// Resumen de una secuencia de sentencias: su duración en semicorcheas, esa
+// duración módulo el compás, y las posiciones de inicio con las que alguna
+// de sus notas cruzaría una barra
+struct BlockSummary {
+    double length{0.0};
+    int residue{0};
+    GridMask crossing;
+};
+
+// Motivo visible: el nombre apunta al buffer de entrada
+struct MotifEntry {
+    std::string_view name;
+    BlockSummary summary;
+};
+
+// Voz: su posición en la rejilla y los motivos definidos en ella
+struct VoiceState {
+    std::string_view name;
+    std::vector<MotifEntry> motifs;
+    double length{0.0};
+    int residue{0};
+};
+
+// Mismo lenguaje que RecursiveDescentParser, pero sin recuperación de
+// errores ni nodos: cada método devuelve false ante el primer error
+class ValidatingParser {
+public:
+    ValidatingParser(const char* buffer, std::size_t length, int semitones) noexcept
+        : semitones{semitones} {
+        fast_scanner_init(&scanner, buffer, length, 1);
+    }
+
+    CheckResult run() noexcept {
+        advance();
+        // Una entrada vacía es un error, como en la gramática
+        if (token == TOKEN_EOF) {
+            return CheckResult::INVALID;
+        }
+        while (token != TOKEN_EOF) {
+            if (!parseInstruction()) {
+                return CheckResult::INVALID;
+            }
+        }
+        if (!finish()) {
+            return CheckResult::INVALID;
+        }
+        return undecided ? CheckResult::UNDECIDED : CheckResult::VALID;
+    }
+
+private:
+    void advance() noexcept {
+        token = fast_scanner_next(&scanner);
+    }
+
+    std::string_view text() const noexcept {
+        return std::string_view{scanner.text, scanner.length};
+    }
+
+    // Valor del número actual, como numberValue en el parser
+    int number() noexcept {
+        char digits[32];
+        if (scanner.length >= sizeof(digits)) {
+            undecided = true;
+            return 0;
+        }
+        std::memcpy(digits, scanner.text, scanner.length);
+        digits[scanner.length] = '\0';
+        return numberValue(digits);
+    }
+
+    // La rejilla se conoce desde la declaración del compás. Si una sentencia
+    // llega antes, la verificación rápida no puede ubicarla
+    bool gridKnown() noexcept {
+        if (bar == 0) {
+            undecided = true;
+            return false;
+        }
+        return true;
+    }
+
+    // Mueve las posiciones de inicio de un bloque que comienza offset
+    // semicorcheas después del inicio de la secuencia que lo contiene
+    GridMask rotate(const GridMask& mask, int offset) const noexcept {
+        if (offset == 0 || mask.none()) {
+            return mask;
+        }
+        return ((mask >> offset) | (mask << (bar - offset))) & full_bar;
+    }
+
+    // Agrega un elemento (nota, acorde, repetición o referencia) a la secuencia
+    // actual: un bloque se resume; en una voz se verifica la barra de inmediato
+    bool append(BlockSummary* block, const BlockSummary& item) noexcept {
+        if (block != nullptr) {
+            if (bar != 0) {
+                block->crossing |= rotate(item.crossing, block->residue);
+                block->residue = (block->residue + item.residue) % bar;
+            }
+            block->length += item.length;
+            return true;
+        }
+
+        if (voice == nullptr) {
+            top_level_plays = top_level_plays || item.length > 0.0;
+            return true;
+        }
+        // Si hubo notas antes del compás, el residuo de la voz no es fiable:
+        // el resultado ya es UNDECIDED y compileBuffer verificará la rejilla
+        if (bar != 0 && !undecided) {
+            if (item.crossing[voice->residue]) {
+                return false;
+            }
+            voice->residue = (voice->residue + item.residue) % bar;
+        }
+        voice->length += item.length;
+        return true;
+    }
+
+    bool parseInstruction() noexcept {
+        switch (token) {
+            case TOKEN_TEMPO: return parseTempo();
+            case TOKEN_COMPAS: return parseTimeSignature();
+            case TOKEN_TONALIDAD: return parseKey();
+            case TOKEN_TRANSPONER: return parseTranspose();
+            case TOKEN_VOZ: return parseVoice();
+            case TOKEN_NOTA_COMPLETA: return parseNote(nullptr);
+            case TOKEN_CORCHETE_ABRE: return parseChord(nullptr);
+            case TOKEN_REPETIR: return parseRepeat(nullptr);
+            case TOKEN_MOTIVO: return parseMotif();
+            case TOKEN_IDENTIFIER: return parseMotifReference(nullptr);
+            default: return false;
+        }
+    }
+
+    // Los Tempo y Compas después del primero son cambios a mitad de la partitura
+    bool parseTempo() noexcept {
+        advance();
+        if (token != TOKEN_NUMERO) {
+            return false;
+        }
+        int tempo = number();
+        has_tempo = true;
+        advance();
+        return valid_tempo(tempo);
+    }
+
+    bool parseTimeSignature() noexcept {
+        advance();
+        if (token != TOKEN_NUMERO) {
+            return false;
+        }
+        int numerator = number();
+        advance();
+        if (token != TOKEN_BARRA) {
+            return false;
+        }
+        advance();
+        if (token != TOKEN_NUMERO) {
+            return false;
+        }
+        int denominator = number();
+        advance();
+
+        if (!valid_numerator(numerator) || !valid_denominator(denominator)) {
+            return false;
+        }
+
+        // Un cambio de compás mueve la rejilla de todas las voces desde su
+        // posición, que depende del orden de las voces: lo verifica compileBuffer
+        if (has_time_signature) {
+            undecided = true;
+            return true;
+        }
+        has_time_signature = true;
+
+        // Semicorcheas por compás y posiciones de inicio con las que cruza
+        // una nota de cada duración
+        bar = numerator * 16 / denominator;
+        for (int i = 0; i < bar; ++i) {
+            full_bar.set(i);
+        }
+        for (int duration : {1, 2, 4, 8}) {
+            for (int start = std::max(0, bar - duration + 1); start < bar; ++start) {
+                note_crossing[duration].set(start);
+            }
+        }
+        return true;
+    }
+
+    bool parseKey() noexcept {
+        advance();
+        char root[8] = "";
+        switch (token) {
+            case TOKEN_NOTA_DO: std::strcpy(root, "Do"); break;
+            case TOKEN_NOTA_RE: std::strcpy(root, "Re"); break;
+            case TOKEN_NOTA_MI: std::strcpy(root, "Mi"); break;
+            case TOKEN_NOTA_FA: std::strcpy(root, "Fa"); break;
+            case TOKEN_NOTA_SOL: std::strcpy(root, "Sol"); break;
+            case TOKEN_NOTA_LA: std::strcpy(root, "La"); break;
+            case TOKEN_NOTA_SI: std::strcpy(root, "Si"); break;
+            default: return false;
+        }
+
+        advance();
+        if (token == TOKEN_SOSTENIDO || token == TOKEN_BEMOL) {
+            std::strcat(root, (token == TOKEN_SOSTENIDO) ? "#" : "b");
+            advance();
+        }
+        if (token != TOKEN_MAYOR && token != TOKEN_MENOR) {
+            return false;
+        }
+        advance();
+
+        if (has_key || !is_valid_note_name(root)) {
+            return false;
+        }
+        has_key = true;
+        return true;
+    }
+
+    bool parseTranspose() noexcept {
+        advance();
+        if (token != TOKEN_NUMERO || has_transposition) {
+            return false;
+        }
+        transposition = number();
+        has_transposition = true;
+        advance();
+        return true;
+    }
+
+    bool parseVoice() noexcept {
+        advance();
+        if (token != TOKEN_IDENTIFIER) {
+            return false;
+        }
+
+        // Volver a declarar una voz continúa la misma parte
+        std::string_view name = text();
+        auto it = std::find_if(voices.begin(), voices.end(),
+                               [name](const VoiceState& state) { return state.name == name; });
+        if (it == voices.end()) {
+            voices.push_back(VoiceState{name, {}, 0.0, 0});
+            it = voices.end() - 1;
+        }
+        voice = &*it;
+        advance();
+        return true;
+    }
+
+    // Duración en semicorcheas del token actual, o 0 si no es una duración
+    int durationTicks() const noexcept {
+        switch (token) {
+            case TOKEN_BLANCA: return duration_ticks(DurationType::BLANCA);
+            case TOKEN_NEGRA: return duration_ticks(DurationType::NEGRA);
+            case TOKEN_CORCHEA: return duration_ticks(DurationType::CORCHEA);
+            case TOKEN_SEMICORCHEA: return duration_ticks(DurationType::SEMICORCHEA);
+            default: return 0;
+        }
+    }
+
+    // Verifica una nota escrita ("Do#4") y registra su altura, para
+    // verificar la transposición al final
+    bool checkPitch(std::string_view full_note) noexcept {
+        // Nombre, alteración opcional y un dígito de octava
+        std::string_view name = full_note.substr(0, full_note.size() - 1);
+        int octave = full_note.back() - '0';
+        if (!is_valid_note_name(name) || !valid_octave(octave)) {
+            return false;
+        }
+
+        NoteSpelling spelling{0, 0};
+        parse_note_name(name, spelling);
+        int pitch = pitch_number(spelling, octave);
+        lowest_pitch = std::min(lowest_pitch, pitch);
+        highest_pitch = std::max(highest_pitch, pitch);
+        return true;
+    }
+
+    // Una nota o un acorde que dura duration semicorcheas
+    bool appendSound(BlockSummary* block, int duration) noexcept {
+        BlockSummary item;
+        item.length = duration;
+        if (gridKnown()) {
+            item.residue = duration % bar;
+            item.crossing = note_crossing[duration];
+        }
+        return append(block, item);
+    }
+
+    bool parseNote(BlockSummary* block) noexcept {
+        std::string_view full_note = text();
+        advance();
+
+        int duration = durationTicks();
+        if (duration == 0) {
+            return false;
+        }
+        advance();
+
+        if (!checkPitch(full_note)) {
+            return false;
+        }
+        return appendSound(block, duration);
+    }
+
+    // Las notas del acorde se verifican al leerlas: a lo sumo
+    // CHORD_CAPACITY, con una sola duración
+    bool parseChord(BlockSummary* block) noexcept {
+        advance();
+        std::size_t count = 0;
+        while (token == TOKEN_NOTA_COMPLETA) {
+            if (++count > CHORD_CAPACITY || !checkPitch(text())) {
+                return false;
+            }
+            advance();
+        }
+        if (count == 0 || token != TOKEN_CORCHETE_CIERRA) {
+            return false;
+        }
+        advance();
+
+        int duration = durationTicks();
+        if (duration == 0) {
+            return false;
+        }
+        advance();
+        return appendSound(block, duration);
+    }
+
+    // cuerpo : (nota | acorde | repeticion | motivo | referencia)*, a partir de TOKEN_LLAVE_ABRE.
+    // Los motivos definidos en el cuerpo son locales a él. Más allá de
+    // MAX_BLOCK_DEPTH el parser descendente rechaza el bloque, y aquí la
+    // recursión agotaría la pila
+    bool parseBlock(BlockSummary& summary) noexcept {
+        if (block_scopes.size() == static_cast<std::size_t>(MAX_BLOCK_DEPTH)) {
+            return false;
+        }
+        advance();
+        block_scopes.push_back(block_motifs.size());
+        while (token != TOKEN_LLAVE_CIERRA) {
+            bool valid;
+            switch (token) {
+                case TOKEN_NOTA_COMPLETA: valid = parseNote(&summary); break;
+                case TOKEN_CORCHETE_ABRE: valid = parseChord(&summary); break;
+                case TOKEN_REPETIR: valid = parseRepeat(&summary); break;
+                case TOKEN_MOTIVO: valid = parseMotif(); break;
+                case TOKEN_IDENTIFIER: valid = parseMotifReference(&summary); break;
+                default: valid = false; break;
+            }
+            if (!valid) {
+                return false;
+            }
+        }
+        block_motifs.resize(block_scopes.back());
+        block_scopes.pop_back();
+        advance();
+        return true;
+    }
+
+    bool parseRepeat(BlockSummary* block) noexcept {
+        advance();
+        if (token != TOKEN_NUMERO) {
+            return false;
+        }
+        int count = number();
+        advance();
+        if (token != TOKEN_LLAVE_ABRE) {
+            return false;
+        }
+
+        BlockSummary body;
+        if (!parseBlock(body) || !valid_repeat_count(count) || body.length == 0.0) {
+            return false;
+        }
+        BlockSummary item;
+        item.length = count * body.length;
+        if (item.length > MAX_REPEAT_TICKS) {
+            return false;
+        }
+        if (!gridKnown()) {
+            return append(block, item);
+        }
+
+        // La vuelta k comienza k * residuo semicorcheas después: a lo sumo
+        // bar vueltas distintas
+        item.residue = static_cast<int>((static_cast<long long>(count % bar) * body.residue) % bar);
+        int distinct = std::min(count, bar);
+        for (int k = 0, offset = 0; k < distinct && body.crossing.any(); ++k) {
+            item.crossing |= rotate(body.crossing, offset);
+            offset = (offset + body.residue) % bar;
+        }
+        return append(block, item);
+    }
+
+    // Motivos del ámbito actual: el bloque abierto, la voz o el programa
+    std::vector<MotifEntry>& currentScope() noexcept {
+        if (!block_scopes.empty()) {
+            return block_motifs;
+        }
+        return (voice != nullptr) ? voice->motifs : global_motifs;
+    }
+
+    // La definición no suena: no se agrega a la secuencia
+    bool parseMotif() noexcept {
+        advance();
+        if (token != TOKEN_IDENTIFIER) {
+            return false;
+        }
+        std::string_view name = text();
+        advance();
+        if (token != TOKEN_LLAVE_ABRE) {
+            return false;
+        }
+
+        BlockSummary body;
+        if (!parseBlock(body) || body.length == 0.0) {
+            return false;
+        }
+
+        // Sin repetir el nombre en el mismo ámbito (en un bloque, desde su inicio)
+        std::vector<MotifEntry>& scope = currentScope();
+        std::size_t scope_begin = block_scopes.empty() ? 0 : block_scopes.back();
+        for (std::size_t i = scope_begin; i < scope.size(); ++i) {
+            if (scope[i].name == name) {
+                return false;
+            }
+        }
+        scope.push_back(MotifEntry{name, body});
+        return true;
+    }
+
+    bool parseMotifReference(BlockSummary* block) noexcept {
+        std::string_view name = text();
+        advance();
+
+        const MotifEntry* motif = lookup(name);
+        if (motif == nullptr) {
+            return false;
+        }
+        gridKnown();
+        return append(block, motif->summary);
+    }
+
+    // Definición visible más interna: bloques abiertos, voz y programa
+    const MotifEntry* lookup(std::string_view name) const noexcept {
+        const std::vector<MotifEntry>* scopes[] = {&block_motifs, (voice != nullptr) ? &voice->motifs : nullptr,
+                                                   &global_motifs};
+        for (const auto* scope : scopes) {
+            if (scope == nullptr) {
+                continue;
+            }
+            for (auto it = scope->rbegin(); it != scope->rend(); ++it) {
+                if (it->name == name) {
+                    return &*it;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    // Reglas que dependen del programa completo
+    bool finish() noexcept {
+        if (!has_tempo || !has_time_signature || !has_key) {
+            return false;
+        }
+
+        if (!voices.empty()) {
+            if (top_level_plays) {
+                return false;
+            }
+            for (const auto& state : voices) {
+                if (state.length != voices.front().length) {
+                    return false;
+                }
+            }
+        }
+
+        // Transposición: las alturas deben quedar en Do1-Si8
+        int total = transposition + semitones;
+        if (total != 0 && lowest_pitch <= highest_pitch) {
+            total = std::max(-HIGHEST_PITCH, std::min(total, HIGHEST_PITCH));
+            if (lowest_pitch + total < LOWEST_PITCH || highest_pitch + total > HIGHEST_PITCH) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    fast_scanner_t scanner;
+    int token{0};
+    int semitones;
+
+    bool has_tempo{false};
+    bool has_time_signature{false};
+    bool has_key{false};
+    bool has_transposition{false};
+    int transposition{0};
+
+    int bar{0};
+    GridMask full_bar;
+    GridMask note_crossing[9];
+
+    std::vector<MotifEntry> global_motifs;
+    std::vector<MotifEntry> block_motifs;
+    std::vector<std::size_t> block_scopes;   // Inicio de cada bloque abierto en block_motifs
+
+    std::vector<VoiceState> voices;
+    VoiceState* voice{nullptr};
+    bool top_level_plays{false};
+
+    int lowest_pitch{1000};
+    int highest_pitch{-1000};
+    bool undecided{false};
+};
+
+CheckResult checkBuffer(const char* buffer, std::size_t length, int semitones) noexcept {
+    ValidatingParser parser{buffer, length, semitones};
+    return parser.run();
+}
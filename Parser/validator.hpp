@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+
+// Resultado de la verificación rápida de una partitura
+enum class CheckResult {
+    VALID,      // Compila sin errores
+    INVALID,    // Tiene errores sintácticos o semánticos
+    UNDECIDED   // La verificación rápida no alcanza (p. ej. el compás se declara
+                // después de las notas): hay que compilar para saberlo
+};
+
+// Verifica una partitura sin construir el árbol del parser ni el AST. Un
+// parser que solo valida consume los tokens del escáner reentrante y aplica
+// las reglas semánticas a medida que llegan: cabeceras presentes, tonalidad
+// y transposición sin repetir, tempo 20-200 (también en los cambios de tempo), numerador 2-12 y denominador 2, 4, 8 o 16, notas y
+// octavas válidas, motivos definidos antes de usarse, repeticiones y motivos
+// con notas y a lo sumo MAX_BLOCK_DEPTH niveles de bloques, rejilla de compases y alineación de las voces, y el rango de la
+// transposición (la declarada más semitones). Cada bloque se resume en su
+// duración y en el conjunto de posiciones dentro del compás en que puede
+// comenzar sin que una nota cruce una barra, así que las repeticiones no se
+// expanden. Un cambio de compás mueve la rejilla de todas las voces, así
+// que deja el resultado en UNDECIDED. No reporta errores: ante INVALID o UNDECIDED, compileBuffer
+// (compile.hpp) da los mismos diagnósticos que el compilador.
+CheckResult checkBuffer(const char* buffer, std::size_t length, int semitones) noexcept;
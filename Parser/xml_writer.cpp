@@ -0,0 +1,146 @@
+#include "xml_writer.hpp"
+#include <charconv>
+#include <ostream>
+
+XmlWriter::XmlWriter(std::ostream& out) noexcept
+    : out{out} {
+    this->buffer.reserve(FLUSH_SIZE + FLUSH_SIZE / 4);
+}
+
+XmlWriter::~XmlWriter() noexcept {
+    this->flush();
+}
+
+void XmlWriter::declaration(std::string_view doctype) noexcept {
+    this->started = true;
+    this->buffer += "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>";
+    if (!doctype.empty()) {
+        this->buffer += "\n<!DOCTYPE ";
+        this->buffer += doctype;
+        this->buffer += '>';
+    }
+}
+
+void XmlWriter::open(const char* name) noexcept {
+    this->end_start_tag();
+    if (!this->elements.empty()) {
+        this->elements.back().children = true;
+    }
+    this->new_line();
+    this->buffer += '<';
+    this->buffer += name;
+    this->elements.push_back(Open{name, false});
+    this->start_tag = true;
+}
+
+void XmlWriter::attribute(const char* name, std::string_view value) noexcept {
+    this->buffer += ' ';
+    this->buffer += name;
+    this->buffer += "=\"";
+    this->append_escaped(value, true);
+    this->buffer += '"';
+}
+
+void XmlWriter::attribute(const char* name, long value) noexcept {
+    this->buffer += ' ';
+    this->buffer += name;
+    this->buffer += "=\"";
+    this->append_number(value);
+    this->buffer += '"';
+}
+
+void XmlWriter::text(std::string_view value) noexcept {
+    this->end_start_tag();
+    this->append_escaped(value, false);
+}
+
+void XmlWriter::text(long value) noexcept {
+    this->end_start_tag();
+    this->append_number(value);
+}
+
+void XmlWriter::close() noexcept {
+    Open element = this->elements.back();
+    this->elements.pop_back();
+    if (this->start_tag) {
+        this->buffer += "/>";
+        this->start_tag = false;
+    } else {
+        // Solo los elementos con hijos cierran en su propia línea
+        if (element.children) {
+            this->new_line();
+        }
+        this->buffer += "</";
+        this->buffer += element.name;
+        this->buffer += '>';
+    }
+    if (this->elements.empty()) {
+        this->buffer += '\n';
+    }
+
+    if (this->buffer.size() >= FLUSH_SIZE) {
+        this->flush();
+    }
+}
+
+void XmlWriter::element(const char* name) noexcept {
+    this->open(name);
+    this->close();
+}
+
+void XmlWriter::element(const char* name, std::string_view value) noexcept {
+    this->open(name);
+    this->text(value);
+    this->close();
+}
+
+void XmlWriter::element(const char* name, long value) noexcept {
+    this->open(name);
+    this->text(value);
+    this->close();
+}
+
+void XmlWriter::flush() noexcept {
+    this->out.write(this->buffer.data(), static_cast<std::streamsize>(this->buffer.size()));
+    this->buffer.clear();
+}
+
+void XmlWriter::end_start_tag() noexcept {
+    if (this->start_tag) {
+        this->buffer += '>';
+        this->start_tag = false;
+    }
+}
+
+void XmlWriter::new_line() noexcept {
+    if (this->started) {
+        this->buffer += '\n';
+    }
+    this->started = true;
+    this->buffer.append(2 * this->elements.size(), ' ');
+}
+
+void XmlWriter::append_escaped(std::string_view value, bool attribute) noexcept {
+    // Los tramos sin caracteres especiales se copian de una vez
+    std::string_view special = attribute ? "&<>\"" : "&<>";
+    for (;;) {
+        std::size_t position = value.find_first_of(special);
+        this->buffer.append(value.substr(0, position));
+        if (position == std::string_view::npos) {
+            return;
+        }
+        switch (value[position]) {
+            case '&': this->buffer += "&amp;"; break;
+            case '<': this->buffer += "&lt;"; break;
+            case '>': this->buffer += "&gt;"; break;
+            default: this->buffer += "&quot;"; break;
+        }
+        value.remove_prefix(position + 1);
+    }
+}
+
+void XmlWriter::append_number(long value) noexcept {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    this->buffer.append(digits, result.ptr);
+}
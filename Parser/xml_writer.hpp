@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Escritor de XML al estilo SAX: cada elemento se escribe al abrirlo y al
+// cerrarlo, sin armar un árbol del documento. El texto se acumula en un
+// buffer que crece si un elemento lo necesita y se vuelca al flujo cada vez
+// que supera FLUSH_SIZE, así que la memoria no depende del largo del
+// documento. Los elementos con hijos se indentan con dos espacios por nivel;
+// los que solo tienen texto van en una línea.
+class XmlWriter {
+public:
+    static constexpr std::size_t FLUSH_SIZE = 64 * 1024;
+
+    explicit XmlWriter(std::ostream& out) noexcept;
+
+    // Vuelca lo pendiente (los elementos abiertos quedan sin cerrar)
+    ~XmlWriter() noexcept;
+
+    XmlWriter(const XmlWriter&) = delete;
+    XmlWriter& operator=(const XmlWriter&) = delete;
+
+    // Declaración XML y, si doctype no está vacío, "<!DOCTYPE doctype>"
+    void declaration(std::string_view doctype) noexcept;
+
+    // Abre un elemento; los atributos se agregan antes de su contenido. name
+    // debe vivir hasta cerrarlo (en general, un literal)
+    void open(const char* name) noexcept;
+    void attribute(const char* name, std::string_view value) noexcept;
+    void attribute(const char* name, long value) noexcept;
+
+    // Texto del elemento abierto, con &, < y > escapados
+    void text(std::string_view value) noexcept;
+    void text(long value) noexcept;
+
+    // Cierra el último elemento abierto ("<name/>" si quedó vacío)
+    void close() noexcept;
+
+    // Un elemento completo: vacío, con texto o con un número
+    void element(const char* name) noexcept;
+    void element(const char* name, std::string_view value) noexcept;
+    void element(const char* name, long value) noexcept;
+
+    // Escribe el buffer en el flujo y lo vacía (conserva la capacidad)
+    void flush() noexcept;
+
+private:
+    // Elemento abierto y si ya tiene elementos hijos
+    struct Open {
+        const char* name;
+        bool children;
+    };
+
+    void end_start_tag() noexcept;
+    void new_line() noexcept;
+    void append_escaped(std::string_view value, bool attribute) noexcept;
+    void append_number(long value) noexcept;
+
+    std::ostream& out;
+    std::string buffer;
+    std::vector<Open> elements;
+    bool start_tag{false};   // El último "<name" todavía admite atributos
+    bool started{false};     // Ya se escribió algo: cada línea nueva empieza con '\n'
+};
@@ -0,0 +1,44 @@
+// Mide la velocidad del escáner (MB/s) sobre un archivo de entrada.
+// Se enlaza con lex.yy.c (Flex) o con fast_scanner.c (escáner SIMD).
+#include <stdio.h>
+#include <time.h>
+#include "token.h"
+
+extern int yylex();
+extern FILE* yyin;
+
+int yyerror(const char* msg) {
+    (void)msg;
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Uso: %s archivo.mus\n", argv[0]);
+        return 1;
+    }
+
+    FILE* file = fopen(argv[1], "r");
+    if (!file) {
+        fprintf(stderr, "No se pudo abrir el archivo: %s\n", argv[1]);
+        return 1;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    yyin = file;
+
+    struct timespec start, end;
+    long tokens = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (yylex() != TOKEN_EOF) {
+        ++tokens;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    fclose(file);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%s: %ld tokens, %.1f MB en %.3f s, %.1f MB/s\n", argv[0], tokens,
+           size / 1e6, seconds, seconds > 0 ? size / 1e6 / seconds : 0.0);
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Genera un corpus .mus pseudoaleatorio para la prueba diferencial entre
+// escáneres: mezcla instrucciones válidas con casos límite del léxico
+// (alteraciones sin octava, identificadores, comentarios, caracteres inválidos,
+// acordes mal cerrados).
+// Con un tercer argumento "valido" genera solo partituras que compilan, para
+// comparar la verificación rápida (--check) con la velocidad del escáner.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* const notes[] = {"Do", "Re", "Mi", "Fa", "Sol", "La", "Si", "C", "D", "E", "F", "G", "A", "B"};
+static const char* const accidentals[] = {"", "", "", "#", "b"};
+
+// Nota con octava 1-8. Si valid_only, descarta las alteraciones que no
+// existen en la lista de notas válidas (Mi#, Fab, E#, Fb)
+static const char* random_note(char* buffer, int valid_only) {
+    const char* name = notes[rand() % 14];
+    const char* accidental = accidentals[rand() % 5];
+    if (valid_only && ((accidental[0] == '#' && (strcmp(name, "Mi") == 0 || strcmp(name, "E") == 0)) ||
+                       (accidental[0] == 'b' && (strcmp(name, "Fa") == 0 || strcmp(name, "F") == 0)))) {
+        accidental = "";
+    }
+    sprintf(buffer, "%s%s%d", name, accidental, 1 + rand() % 8);
+    return buffer;
+}
+
+int main(int argc, char** argv) {
+    long lines = (argc > 1) ? atol(argv[1]) : 100000;
+    unsigned seed = (argc > 2) ? (unsigned)atoi(argv[2]) : 42u;
+    int valid_only = (argc > 3) && strcmp(argv[3], "valido") == 0;
+    srand(seed);
+
+    static const char* const durations[] = {"Blanca", "Negra", "Corchea", "Semicorchea"};
+    static const char* const odd[] = {
+        "Sol##4 Negra", "Re# Corchea", "Mi4 Blancaa*", "Dob Negra", "Sib4x Blanca", "_motivo1",
+        "Tempo -30", "Compas 7/8", "Tonalidad Fa# m", "Tonalidad Sib M", "Negras", "\tDo4\tNegra",
+        "La4 Negra Corchea", "// comentario largo con Tempo 120 y Do4 Negra dentro",
+        "Do4 Negra// pegado", "M m b #", "C4/D4", "-", "¿?", "Do4 Negra \r",
+        "Voz Violin", "Voz", "Voz Do4 Negra", "Voz Viola_2",
+        "} }", "Repetir 2 Do4 Negra", "Repetir 3 { Do4 Negra }", "Repetir x { Do4 Negra }",
+        "Motivo Tema { Do4 Negra Mi4 Negra }", "Tema", "Motivo { Do4 Negra }", "Motivo Tema Do4 Negra",
+        "Motivo Coda { Motivo Eco { Sol4 Corchea } Eco Eco }",
+        "Transponer +2", "Transponer -5", "Transponer", "Transponer + 3", "Tempo +90",
+        "[Do4 Mi4 Sol4] Negra", "[Do4 Mi4 Negra", "[] Blanca", "[Re4 Fa#4] Redonda", "Do4 ] Negra",
+        "[Do4\nMi4 Sol4] Blanca", "[Do4 Mi4 Sol4 Do5 Mi5 Sol5 Do6 Mi6 Sol6] Corchea", "[Do4 [Mi4] Negra",
+    };
+
+    // Profundidad de los bloques Repetir abiertos
+    int depth = 0;
+    char note[8];
+
+    printf("Tempo 120\nCompas 4/4\nTonalidad Do M\n\n");
+    for (long i = 0; i < lines; ++i) {
+        int kind = rand() % 20;
+        if (kind == 3 && depth < 3) {
+            printf("Repetir %d {\n", 2 + rand() % 3);
+            ++depth;
+            // Un cuerpo vacío es un error semántico
+            if (valid_only) {
+                printf("%s %s\n", random_note(note, 1), durations[rand() % 4]);
+            }
+        } else if (kind == 4 && depth > 0) {
+            printf("}\n");
+            --depth;
+        } else if (kind == 0 && !valid_only) {
+            printf("%s\n", odd[rand() % (sizeof(odd) / sizeof(odd[0]))]);
+        } else if (kind == 1) {
+            printf("// compas %ld\n", i);
+        } else if (kind == 2) {
+            printf("\n   \n");
+        } else if (kind == 5) {
+            // Acorde de dos a cuatro notas
+            int count = 2 + rand() % 3;
+            printf("[");
+            for (int n = 0; n < count; ++n) {
+                printf(n == 0 ? "%s" : " %s", random_note(note, valid_only));
+            }
+            printf("] %s\n", durations[rand() % 4]);
+        } else {
+            printf("%s %s\n", random_note(note, valid_only), durations[rand() % 4]);
+        }
+    }
+    for (; depth > 0; --depth) {
+        printf("}\n");
+    }
+    return 0;
+}
@@ -0,0 +1,276 @@
+#include "fast_scanner.h"
+#include "token.h"
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Palabra reservada del lenguaje
+typedef struct {
+    const char* text;
+    size_t length;
+    token_t token;
+} keyword_t;
+
+// Tabla de hash perfecto para las palabras reservadas: la posición es
+// (primer carácter + 8 * longitud) & 127, sin colisiones para este conjunto
+#define KEYWORD_HASH(first, length) ((((unsigned char)(first)) + 8u * (unsigned)(length)) & 127u)
+
+static const keyword_t keywords[128] = {
+    [10]  = {"Repetir", 7, TOKEN_REPETIR},
+    [28]  = {"Tonalidad", 9, TOKEN_TONALIDAD},
+    [36]  = {"Transponer", 10, TOKEN_TRANSPONER},
+    [43]  = {"Semicorchea", 11, TOKEN_SEMICORCHEA},
+    [73]  = {"A", 1, TOKEN_NOTA_LA},
+    [74]  = {"B", 1, TOKEN_NOTA_SI},
+    [75]  = {"C", 1, TOKEN_NOTA_DO},
+    [76]  = {"D", 1, TOKEN_NOTA_RE},
+    [77]  = {"E", 1, TOKEN_NOTA_MI},
+    [78]  = {"F", 1, TOKEN_NOTA_FA},
+    [79]  = {"G", 1, TOKEN_NOTA_SOL},
+    [84]  = {"Do", 2, TOKEN_NOTA_DO},
+    [85]  = {"M", 1, TOKEN_MAYOR},
+    [86]  = {"Fa", 2, TOKEN_NOTA_FA},
+    [92]  = {"La", 2, TOKEN_NOTA_LA},
+    [93]  = {"Mi", 2, TOKEN_NOTA_MI},
+    [98]  = {"Re", 2, TOKEN_NOTA_RE},
+    [99]  = {"Si", 2, TOKEN_NOTA_SI},
+    [106] = {"b", 1, TOKEN_BEMOL},
+    [107] = {"Sol", 3, TOKEN_NOTA_SOL},
+    [110] = {"Voz", 3, TOKEN_VOZ},
+    [114] = {"Blanca", 6, TOKEN_BLANCA},
+    [115] = {"Compas", 6, TOKEN_COMPAS},
+    [117] = {"m", 1, TOKEN_MENOR},
+    [118] = {"Negra", 5, TOKEN_NEGRA},
+    [123] = {"Corchea", 7, TOKEN_CORCHEA},
+    [124] = {"Tempo", 5, TOKEN_TEMPO},
+    [125] = {"Motivo", 6, TOKEN_MOTIVO},
+};
+
+static token_t keyword_lookup(const char* text, size_t length) {
+    const keyword_t* keyword = &keywords[KEYWORD_HASH(text[0], length)];
+    if (keyword->length == length && memcmp(keyword->text, text, length) == 0) {
+        return keyword->token;
+    }
+    return TOKEN_EOF;
+}
+
+static int is_word_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static int is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Actualiza línea y columna tras consumir [from, to), que puede contener saltos de línea
+static void advance_position(fast_scanner_t* scanner, const char* from, const char* to) {
+    for (const char* p = from; p < to; ++p) {
+        if (*p == '\n') {
+            ++scanner->line;
+            scanner->column = 1;
+        } else {
+            ++scanner->column;
+        }
+    }
+}
+
+// Salta espacios, tabulaciones y saltos de línea, de 16 en 16 bytes con SSE2
+static const char* skip_blanks(fast_scanner_t* scanner, const char* p) {
+#ifdef __SSE2__
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    while (p + 16 <= scanner->end) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)p);
+        __m128i is_newline = _mm_cmpeq_epi8(chunk, newline);
+        __m128i is_blank = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space),
+                                                     _mm_cmpeq_epi8(chunk, tab)),
+                                        is_newline);
+        unsigned blank_mask = (unsigned)_mm_movemask_epi8(is_blank);
+        unsigned newline_mask = (unsigned)_mm_movemask_epi8(is_newline);
+
+        // Cantidad de blancos al inicio del bloque
+        unsigned skipped = (blank_mask == 0xFFFFu) ? 16u : (unsigned)__builtin_ctz(~blank_mask);
+        newline_mask &= (skipped == 16u) ? 0xFFFFu : ((1u << skipped) - 1u);
+
+        if (newline_mask != 0) {
+            unsigned last_newline = 31u - (unsigned)__builtin_clz(newline_mask);
+            scanner->line += __builtin_popcount(newline_mask);
+            scanner->column = (int)(skipped - last_newline);
+        } else {
+            scanner->column += (int)skipped;
+        }
+
+        p += skipped;
+        if (skipped < 16u) {
+            return p;
+        }
+    }
+#endif
+    while (p < scanner->end && (*p == ' ' || *p == '\t' || *p == '\n')) {
+        advance_position(scanner, p, p + 1);
+        ++p;
+    }
+    return p;
+}
+
+// Busca el siguiente salto de línea (fin de un comentario), de 16 en 16 bytes con SSE2
+static const char* find_newline(const fast_scanner_t* scanner, const char* p) {
+#ifdef __SSE2__
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    while (p + 16 <= scanner->end) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)p);
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#endif
+    while (p < scanner->end && *p != '\n') {
+        ++p;
+    }
+    return p;
+}
+
+// Longitud de una nota con octava ("Do#4", "Sib3", "C5"...) al inicio de p, o 0.
+// Los nombres que comparten inicial ("Do"/"D", "Fa"/"F") no pueden coincidir
+// ambos, porque tras el nombre solo se admite alteración u octava.
+static size_t complete_note_length(const char* p, const char* end) {
+    size_t name_length = 0;
+    size_t available = (size_t)(end - p);
+
+    switch (p[0]) {
+        case 'D': name_length = (available > 1 && p[1] == 'o') ? 2 : 1; break;
+        case 'F': name_length = (available > 1 && p[1] == 'a') ? 2 : 1; break;
+        case 'R': name_length = (available > 1 && p[1] == 'e') ? 2 : 0; break;
+        case 'M': name_length = (available > 1 && p[1] == 'i') ? 2 : 0; break;
+        case 'L': name_length = (available > 1 && p[1] == 'a') ? 2 : 0; break;
+        case 'S':
+            if (available > 2 && p[1] == 'o' && p[2] == 'l') {
+                name_length = 3;
+            } else if (available > 1 && p[1] == 'i') {
+                name_length = 2;
+            }
+            break;
+        case 'A': case 'B': case 'C': case 'E': case 'G': name_length = 1; break;
+        default: break;
+    }
+
+    if (name_length == 0) {
+        return 0;
+    }
+
+    const char* q = p + name_length;
+    if (q < end && (*q == '#' || *q == 'b')) {
+        ++q;
+    }
+    return (q < end && is_digit(*q)) ? (size_t)(q + 1 - p) : 0;
+}
+
+void fast_scanner_init(fast_scanner_t* scanner, const char* buffer, size_t length, int first_line) {
+    scanner->begin = buffer;
+    scanner->end = buffer + length;
+    scanner->pos = buffer;
+    scanner->line = first_line;
+    scanner->column = 1;
+    scanner->text = buffer;
+    scanner->length = 0;
+    scanner->token_line = first_line;
+    scanner->token_column = 1;
+}
+
+int fast_scanner_next(fast_scanner_t* scanner) {
+    const char* p = scanner->pos;
+    const char* end = scanner->end;
+
+    for (;;) {
+        p = skip_blanks(scanner, p);
+        if (p >= end) {
+            scanner->pos = p;
+            scanner->text = p;
+            scanner->length = 0;
+            scanner->token_line = scanner->line;
+            scanner->token_column = scanner->column;
+            return TOKEN_EOF;
+        }
+
+        // Comentario hasta el fin de la línea
+        if (p[0] == '/' && p + 1 < end && p[1] == '/') {
+            const char* comment_end = find_newline(scanner, p + 2);
+            scanner->column += (int)(comment_end - p);
+            p = comment_end;
+            continue;
+        }
+        break;
+    }
+
+    const char* start = p;
+    int token = FAST_SCANNER_ERROR;
+    char c = *p;
+
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_') {
+        // Se aplica la regla de Flex: gana el lexema más largo y, en empate,
+        // la regla que aparece primero (palabras reservadas, nota con octava, identificador)
+        const char* word_end = p + 1;
+        while (word_end < end && is_word_char(*word_end)) {
+            ++word_end;
+        }
+        size_t word_length = (size_t)(word_end - p);
+        size_t note_length = complete_note_length(p, end);
+        token_t keyword = keyword_lookup(p, word_length);
+
+        if (note_length > word_length) {
+            token = TOKEN_NOTA_COMPLETA;
+            p += note_length;
+        } else if (keyword != TOKEN_EOF) {
+            token = keyword;
+            p = word_end;
+        } else if (note_length == word_length) {
+            token = TOKEN_NOTA_COMPLETA;
+            p = word_end;
+        } else {
+            token = TOKEN_IDENTIFIER;
+            p = word_end;
+        }
+    } else if (is_digit(c) || ((c == '-' || c == '+') && p + 1 < end && is_digit(p[1]))) {
+        ++p;
+        while (p < end && is_digit(*p)) {
+            ++p;
+        }
+        token = TOKEN_NUMERO;
+    } else if (c == '/') {
+        token = TOKEN_BARRA;
+        ++p;
+    } else if (c == '#') {
+        token = TOKEN_SOSTENIDO;
+        ++p;
+    } else if (c == '{') {
+        token = TOKEN_LLAVE_ABRE;
+        ++p;
+    } else if (c == '}') {
+        token = TOKEN_LLAVE_CIERRA;
+        ++p;
+    } else if (c == '[') {
+        token = TOKEN_CORCHETE_ABRE;
+        ++p;
+    } else if (c == ']') {
+        token = TOKEN_CORCHETE_CIERRA;
+        ++p;
+    } else {
+        // Carácter no reconocido: se consume un byte, como la regla "." de Flex
+        ++p;
+    }
+
+    scanner->text = start;
+    scanner->length = (size_t)(p - start);
+    scanner->token_line = scanner->line;
+    scanner->token_column = scanner->column;
+    scanner->column += (int)(p - start);
+    scanner->pos = p;
+    return token;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Valor devuelto por fast_scanner_next() ante un carácter no reconocido;
+// el carácter queda en text/length y el análisis puede continuar
+#define FAST_SCANNER_ERROR (-1)
+
+// Escáner escrito a mano, alternativo al generado por Flex. Reconoce los
+// mismos tokens (token_t de token.h) sobre un buffer en memoria y no usa
+// estado global, por lo que varias instancias pueden trabajar en paralelo.
+typedef struct {
+    const char* begin;
+    const char* end;
+    const char* pos;
+
+    // Posición (línea, columna) del siguiente carácter por leer
+    int line;
+    int column;
+
+    // Último lexema reconocido (no termina en '\0')
+    const char* text;
+    size_t length;
+    int token_line;
+    int token_column;
+} fast_scanner_t;
+
+// Prepara el escáner sobre [buffer, buffer + length), comenzando en first_line
+void fast_scanner_init(fast_scanner_t* scanner, const char* buffer, size_t length, int first_line);
+
+// Devuelve el siguiente token, TOKEN_EOF al final o FAST_SCANNER_ERROR
+int fast_scanner_next(fast_scanner_t* scanner);
+
+#ifdef __cplusplus
+}
+#endif
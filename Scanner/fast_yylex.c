@@ -0,0 +1,72 @@
+// Interfaz compatible con Flex (yylex, yytext, yylineno, yyin) sobre el
+// escáner escrito a mano; permite enlazar main.c con cualquiera de los dos
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fast_scanner.h"
+#include "token.h"
+
+FILE* yyin = NULL;
+char* yytext = NULL;
+int yyleng = 0;
+int yylineno = 1;
+
+extern int yyerror(const char* msg);
+
+static fast_scanner_t scanner;
+static char* input = NULL;
+static int input_loaded = 0;
+static char* text_buffer = NULL;
+static size_t text_capacity = 0;
+
+// Lee la entrada completa a memoria: el escáner trabaja sobre un solo buffer
+static size_t load_input(void) {
+    FILE* file = (yyin != NULL) ? yyin : stdin;
+    size_t capacity = 1 << 16;
+    size_t size = 0;
+    size_t read;
+
+    input = (char*)malloc(capacity);
+    while (input != NULL && (read = fread(input + size, 1, capacity - size, file)) > 0) {
+        size += read;
+        if (size == capacity) {
+            capacity *= 2;
+            input = (char*)realloc(input, capacity);
+        }
+    }
+    return (input != NULL) ? size : 0;
+}
+
+// Copia el lexema actual a yytext terminado en '\0'
+static void update_text(void) {
+    if (scanner.length + 1 > text_capacity) {
+        text_capacity = (scanner.length + 1) * 2;
+        text_buffer = (char*)realloc(text_buffer, text_capacity);
+    }
+    memcpy(text_buffer, scanner.text, scanner.length);
+    text_buffer[scanner.length] = '\0';
+    yytext = text_buffer;
+    yyleng = (int)scanner.length;
+    yylineno = scanner.token_line;
+}
+
+int yylex(void) {
+    if (!input_loaded) {
+        size_t size = load_input();
+        fast_scanner_init(&scanner, input, size, 1);
+        input_loaded = 1;
+    }
+
+    for (;;) {
+        int token = fast_scanner_next(&scanner);
+        update_text();
+
+        if (token != FAST_SCANNER_ERROR) {
+            return token;
+        }
+
+        char msg[100];
+        snprintf(msg, sizeof(msg), "Carácter no reconocido: %s", yytext);
+        yyerror(msg);
+    }
+}
@@ -25,7 +25,15 @@ typedef enum
   TOKEN_SOSTENIDO = 277,
   TOKEN_BEMOL = 278,
   TOKEN_NOTA_COMPLETA = 279,
-  TOKEN_IDENTIFIER = 280
+  TOKEN_IDENTIFIER = 280,
+  TOKEN_VOZ = 281,
+  TOKEN_REPETIR = 282,
+  TOKEN_LLAVE_ABRE = 283,
+  TOKEN_LLAVE_CIERRA = 284,
+  TOKEN_MOTIVO = 285,
+  TOKEN_TRANSPONER = 286,
+  TOKEN_CORCHETE_ABRE = 287,
+  TOKEN_CORCHETE_CIERRA = 288
 }
 token_t;
 
@@ -57,6 +65,14 @@ static inline const char* token_str(token_t t)
     case TOKEN_BEMOL: return "<BEMOL>";
     case TOKEN_NOTA_COMPLETA: return "<NOTA_COMPLETA>";
     case TOKEN_IDENTIFIER: return "<IDENTIFICADOR>";
+    case TOKEN_VOZ: return "<VOZ>";
+    case TOKEN_REPETIR: return "<REPETIR>";
+    case TOKEN_LLAVE_ABRE: return "<LLAVE_ABRE>";
+    case TOKEN_LLAVE_CIERRA: return "<LLAVE_CIERRA>";
+    case TOKEN_MOTIVO: return "<MOTIVO>";
+    case TOKEN_TRANSPONER: return "<TRANSPONER>";
+    case TOKEN_CORCHETE_ABRE: return "<CORCHETE_ABRE>";
+    case TOKEN_CORCHETE_CIERRA: return "<CORCHETE_CIERRA>";
     default: return "<DESCONOCIDO>";
   }
 } 
\ No newline at end of file
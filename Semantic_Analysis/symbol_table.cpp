@@ -1,8 +1,9 @@
 #include "symbol_table.hpp"
 
-std::shared_ptr<Symbol> Symbol::build(std::string_view name) noexcept{
+std::shared_ptr<Symbol> Symbol::build(std::string_view name, const Statement* definition) noexcept{
     auto symbol = std::make_shared<Symbol>();
     symbol->name = name;
+    symbol->definition = definition;
     return symbol;
 }
 
@@ -35,13 +36,13 @@ SymbolTable::TableType::size_type SymbolTable::scope_level() const noexcept{
     return this->scopes.size();
 }
 
-bool SymbolTable::insert(const std::string& name) noexcept{
+bool SymbolTable::insert(const std::string& name, const Statement* definition) noexcept{
     if (this->scopes.empty())
     {
         return false;
     }
 
-    auto symbol = Symbol::build(name);
+    auto symbol = Symbol::build(name, definition);
     TableType& current_scope = this->scopes.back();
 
     if (SymbolTable::find_in_scope(name, current_scope) != nullptr)
@@ -6,11 +6,18 @@
 #include <unordered_map>
 #include <vector>
 
+class Statement;
+
 // Estructura que representa un símbolo en la tabla
 struct Symbol{
     std::string name;
+
+    // Sentencia que define el símbolo (un motivo), o nullptr para las
+    // marcas de declaraciones y voces
+    const Statement* definition{nullptr};
     
-    static std::shared_ptr<Symbol> build(std::string_view name) noexcept;
+    static std::shared_ptr<Symbol> build(std::string_view name,
+                                         const Statement* definition = nullptr) noexcept;
 };
 
 // Clase que implementa la tabla de símbolos
@@ -28,7 +35,7 @@ public:
     TableType::size_type scope_level() const noexcept;
 
     // Métodos principales
-    bool insert(const std::string& name) noexcept;
+    bool insert(const std::string& name, const Statement* definition = nullptr) noexcept;
     bool contains(const std::string& name) noexcept;
     std::shared_ptr<Symbol> lookup(const std::string& name) noexcept;
     std::shared_ptr<Symbol> current_scope_lookup(const std::string& name) noexcept;